@@ -0,0 +1,342 @@
+﻿// === bench/bench_control.cpp ===
+// The control endpoint over a real Unix socket: the protocol, and many
+// clients at once the way scripts and launchers would drive it.
+#include "harness.h"
+#include "fixtures.h"
+#include "control_server.h"
+#include "window_registry.h"
+#include "activator.h"
+#include "utf8.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Records what the server asked for instead of doing it
+class RecordingActions : public ControlActions {
+public:
+    void Activate(WindowId id) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_activated.push_back(id);
+    }
+    void Overlay(bool show) override { (show ? shows : hides).fetch_add(1); }
+    void ReloadSettings() override { reloads.fetch_add(1); }
+    void Quit() override { quits.fetch_add(1); }
+
+    std::vector<WindowId> Activated() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_activated;
+    }
+
+    std::atomic<int> shows{ 0 }, hides{ 0 }, reloads{ 0 }, quits{ 0 };
+
+private:
+    std::mutex            m_mutex;
+    std::vector<WindowId> m_activated;
+};
+
+// A blocking client, as a script would write it; reads give up after a
+// couple of seconds so a broken server fails the check instead of hanging it
+class Client {
+public:
+    ~Client() {
+        if (m_fd >= 0)
+            close(m_fd);
+    }
+
+    bool Connect(const std::string& path) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path.c_str());
+        m_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        timeval timeout{ 2, 0 };
+        setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        return m_fd >= 0 && connect(m_fd, (const sockaddr*)&addr, sizeof(addr)) == 0;
+    }
+
+    bool Send(const std::string& s) {
+        for (size_t at = 0; at < s.size();) {
+            const ssize_t n = send(m_fd, s.data() + at, s.size() - at, MSG_NOSIGNAL);
+            if (n <= 0)
+                return false;
+            at += (size_t)n;
+        }
+        return true;
+    }
+
+    // The next line, without its '\n'; false at the end or on a timeout
+    bool Line(std::string& out) {
+        for (;;) {
+            const size_t eol = m_buf.find('\n', m_at);
+            if (eol != std::string::npos) {
+                out.assign(m_buf, m_at, eol - m_at);
+                m_at = eol + 1;
+                return true;
+            }
+            m_buf.erase(0, m_at);
+            m_at = 0;
+            char chunk[65536];
+            const ssize_t n = recv(m_fd, chunk, sizeof(chunk), 0);
+            if (n <= 0)
+                return false;
+            m_buf.append(chunk, (size_t)n);
+        }
+    }
+
+    // A list reply: "ok <n>" and the n rows; returns n, -1 on anything else
+    int List(std::vector<std::string>* rows = nullptr) {
+        std::string line;
+        if (!Line(line) || line.compare(0, 3, "ok ") != 0)
+            return -1;
+        const int n = std::atoi(line.c_str() + 3);
+        for (int i = 0; i < n; ++i) {
+            if (!Line(line))
+                return -1;
+            if (rows)
+                rows->push_back(line);
+        }
+        return n;
+    }
+
+private:
+    int         m_fd = -1;
+    std::string m_buf;
+    size_t      m_at = 0;
+};
+
+static std::string SocketPath(const char* what) {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path();
+    return (dir / ("wws_bench_" + std::to_string(getpid()) + "_" + what + ".sock")).string();
+}
+
+// The rows list should give for reg, built the long way
+static std::vector<std::string> ExpectedRows(const WindowRegistry& reg) {
+    std::vector<std::string> rows;
+    const std::vector<WindowRecord> windows = reg.Snapshot();
+    for (size_t i = 0; i < windows.size(); ++i) {
+        std::string row = std::to_string(i) + " " + std::to_string(windows[i].id) + " ";
+        std::string title;
+        AppendUtf8(title, windows[i].title);
+        std::replace(title.begin(), title.end(), '\n', ' ');
+        rows.push_back(row + title);
+    }
+    return rows;
+}
+
+static void CheckControl(Bench& b) {
+    const std::string what = "control/check: ";
+    WindowRegistry reg;
+    RecordingActions actions;
+    ControlServer server(reg, actions);
+    FakeWindowEventSource src;
+    WindowEventTee sinks(reg, server);   // the registry first, as in the app
+    src.Start(sinks);
+    const std::vector<std::wstring>& titles = RealWorldTitles();
+    for (size_t i = 0; i < 20; ++i)
+        src.Create(100 + i, titles[i % titles.size()]);
+    src.Create(200, L"two\nlines");
+    src.Focus(105);
+
+    // --- the protocol, in process ---
+    std::string out;
+    bool subscribe = false;
+    auto serve = [&](const std::string& in) {
+        out.clear();
+        return server.Serve(in, out, subscribe);
+    };
+    serve("list\n");
+    std::string expected = "ok " + std::to_string(reg.Snapshot().size()) + "\n";
+    for (const std::string& row : ExpectedRows(reg))
+        expected += row + "\n";
+    b.Expect(out == expected, what + "list doesn't match the registry");
+    const uint64_t refills = server.GetStats().refills;
+    serve("list\n");
+    b.Expect(server.GetStats().refills == refills, what + "an unchanged registry was snapshotted again");
+    src.Rename(101, L"renamed");
+    serve("list\n");
+    b.Expect(server.GetStats().refills == refills + 1 && out.find(" 101 renamed\n") != std::string::npos,
+             what + "list missed a change to the registry");
+
+    serve("switch 1\nswitch id 110\nswitch 99\nswitch id 999\nswitch x\n");
+    b.Expect(out == "ok\nok\nerr no such window\nerr no such window\nerr bad index\n",
+             what + "switch replies");
+    const std::vector<WindowId> activated = actions.Activated();
+    b.Expect(activated.size() == 2 && activated[0] == reg.At(1) && activated[1] == 110,
+             what + "switch activated the wrong windows");
+
+    const size_t used = serve("ping\noverlay show\noverlay hide\nreload\nquit\nbogus\nsubscribe\nping");
+    b.Expect(out == "ok\nok\nok\nok\nok\nerr unknown request\nok\n" && subscribe,
+             what + "pipelined requests weren't answered in order");
+    b.Expect(used == std::string("ping\noverlay show\noverlay hide\nreload\nquit\nbogus\nsubscribe\n").size(),
+             what + "an unfinished line was used");
+    b.Expect(actions.shows == 1 && actions.hides == 1 && actions.reloads == 1 && actions.quits == 1,
+             what + "overlay, reload or quit didn't reach the actions");
+
+    // --- over the socket ---
+    const std::string path = SocketPath("check");
+    {
+        // left behind by a WWS that died: nobody listens on it
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path.c_str());
+        const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        (void)!bind(fd, (const sockaddr*)&addr, sizeof(addr));
+        close(fd);
+    }
+    b.Expect(server.Start(path), what + "a stale socket wasn't taken over");
+    struct stat st{};
+    b.Expect(stat(path.c_str(), &st) == 0 && (st.st_mode & 077) == 0,
+             what + "other users can connect to the socket");
+    ControlServer second(reg, actions);
+    b.Expect(!second.Start(path), what + "a second server took over a live socket");
+
+    Client watcher, client;
+    std::string line;
+    b.Expect(watcher.Connect(path) && watcher.Send("subscribe\n") && watcher.Line(line) && line == "ok",
+             what + "subscribe");
+    b.Expect(client.Connect(path) && client.Send("list\n") && client.List() == (int)reg.Snapshot().size(),
+             what + "list over the socket");
+    src.Focus(103);
+    src.Focus(200);
+    std::string first, next;
+    const bool pushed = watcher.Line(first) && watcher.Line(next);
+    std::string title103;
+    AppendUtf8(title103, titles[3]);
+    b.Expect(pushed && first == "focus 103 " + title103 && next == "focus 200 two lines",
+             what + "focus changes didn't reach the subscriber (got '" + first + "')");
+    b.Expect(client.Send("ping\n") && client.Line(line) && line == "ok",
+             what + "a client that didn't subscribe got a push");
+
+    Client flooder;
+    b.Expect(flooder.Connect(path) && flooder.Send(std::string(ControlServer::kMaxLine + 100, 'x')) &&
+             flooder.Line(line) && line == "err line too long" && !flooder.Line(line),
+             what + "an overlong line didn't close the connection");
+
+    server.Stop();
+    b.Expect(!std::filesystem::exists(path), what + "the socket outlived the server");
+}
+
+// clients threads each sending batch requests per write and reading the
+// replies back, for timeMs; reports the throughput and the round trips
+static void LoadTest(Bench& b, const std::string& path, int clients, int batch, size_t windows, double timeMs) {
+    using clock = std::chrono::steady_clock;
+    std::string request;
+    for (int i = 0; i < batch; ++i)
+        request += "list\n";
+    std::atomic<int> ready{ 0 }, failed{ 0 };
+    std::atomic<bool> go{ false }, stop{ false };
+    std::vector<std::vector<double>> latency(clients);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < clients; ++t) {
+        threads.emplace_back([&, t] {
+            Client c;
+            const bool connected = c.Connect(path);
+            std::vector<double>& mine = latency[t];
+            mine.reserve(1 << 14);
+            ready.fetch_add(1);
+            while (!go)
+                std::this_thread::yield();
+            if (!connected) {
+                failed.fetch_add(1);
+                return;
+            }
+            while (!stop.load(std::memory_order_relaxed)) {
+                const auto t0 = clock::now();
+                if (!c.Send(request)) {
+                    failed.fetch_add(1);
+                    return;
+                }
+                for (int i = 0; i < batch; ++i) {
+                    if (c.List() != (int)windows) {
+                        failed.fetch_add(1);
+                        return;
+                    }
+                }
+                mine.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - t0).count());
+            }
+        });
+    }
+    while (ready < clients)
+        std::this_thread::yield();
+    const auto t0 = clock::now();
+    go = true;
+    std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(timeMs));
+    stop = true;
+    for (std::thread& t : threads)
+        t.join();
+    const double seconds = std::chrono::duration<double>(clock::now() - t0).count();
+
+    std::vector<double> all;
+    for (const std::vector<double>& l : latency)
+        all.insert(all.end(), l.begin(), l.end());
+    const std::string name = "control/load/" + std::to_string(clients) + "clients" +
+                             (batch > 1 ? "/batch" + std::to_string(batch) : std::string());
+    b.Expect(failed == 0, name + ": " + std::to_string(failed.load()) + " clients failed");
+    b.Metric(name + "/throughput", (double)all.size() * batch / seconds, "req/s");
+    if (!all.empty()) {
+        std::vector<double> sorted = all;
+        const size_t k = std::min(sorted.size() - 1, sorted.size() * 999 / 1000);
+        std::nth_element(sorted.begin(), sorted.begin() + k, sorted.end());
+        b.Metric(name + "/p999", sorted[k] / 1000.0, "us");
+    }
+    b.Samples(name, std::move(all));
+}
+
+static void BenchLoad(Bench& b) {
+    WindowRegistry reg;
+    RecordingActions actions;
+    ControlServer server(reg, actions);
+    FakeWindowEventSource src;
+    src.Start(reg);
+    const size_t windows = 50;
+    const std::vector<std::wstring> titles = MakeTitles(windows);
+    for (size_t i = 0; i < windows; ++i)
+        src.Create(WindowIdFor(i), titles[i]);
+
+    // the work behind one request, without the socket: served from the
+    // snapshot, so nothing is allocated once out has grown
+    std::string out;
+    bool subscribe = false;
+    b.Run("control/serve/list", [&] {
+        out.clear();
+        server.Serve("list\n", out, subscribe);
+        DoNotOptimize(out.data());
+    });
+    b.ExpectNoAllocs("control/serve/list");
+    b.Metric("control/serve/list_bytes", (double)out.size(), "bytes");
+
+    const std::string path = SocketPath("load");
+    if (!server.Start(path)) {
+        b.Expect(false, "control/load: cannot listen on " + path);
+        return;
+    }
+    const double timeMs = b.Quick() ? 30.0 : b.Options().minTimeMs;
+    const std::vector<int> clients = b.Quick() ? std::vector<int>{ 1, 16 } : std::vector<int>{ 1, 16, 64, 256 };
+    for (int n : clients) {
+        const std::string name = "control/load/" + std::to_string(n) + "clients";
+        if (b.Wants(name))
+            LoadTest(b, path, n, 1, windows, timeMs);
+        if (b.Wants(name + "/batch"))
+            LoadTest(b, path, n, 16, windows, timeMs);
+    }
+    const ControlServer::Stats stats = server.GetStats();
+    b.Metric("control/load/requests_per_write", stats.batches ? (double)stats.requests / stats.batches : 0.0, "req");
+    b.Metric("control/load/refills", (double)stats.refills, "snapshots");
+    server.Stop();
+}
+
+void BenchControl(Bench& b) {
+    if (b.Wants("control/check")) CheckControl(b);
+    if (b.Wants("control/serve/") || b.Wants("control/load/")) BenchLoad(b);
+}
@@ -0,0 +1,554 @@
+﻿// === bench/bench_keys.cpp ===
+#include "harness.h"
+#include "clock.h"
+#include "key_bindings.h"
+#include "key_channel.h"
+#include "key_trace.h"
+#include "switcher.h"
+#include "switcher_scheduler.h"
+#include "settings.h"
+
+#include <atomic>
+#include <filesystem>
+#include <random>
+#include <thread>
+
+static constexpr uint64_t kMs = 1000000;
+
+static void BenchSwitcher(Bench& b) {
+    const SwitcherConfig cfg;
+    std::vector<KeyEvent> trace = GenerateKeyTrace(b.Quick() ? 10000 : 100000);
+    for (KeyEvent& ev : trace)
+        ev.cls = SwitcherMachine::Classify(ev.vk, cfg);
+    const uint64_t span = trace.back().timeNs - trace.front().timeNs + 1000 * kMs;
+
+    // the trace replayed over and over, shifted so time keeps moving forward
+    SwitcherMachine machine(cfg);
+    SwitcherAction actions[SwitcherMachine::kMaxActions];
+    size_t i = 0;
+    uint64_t offset = 0, fired = 0;
+    b.Run("keys/switcher/on_key", [&] {
+        KeyEvent ev = trace[i];
+        ev.timeNs += offset;
+        fired += (uint64_t)machine.OnKey(ev, actions);
+        if (++i == trace.size()) {
+            i = 0;
+            offset += span;
+        }
+    });
+    DoNotOptimize(fired);
+
+    uint16_t key = 0;
+    b.Run("keys/switcher/classify", [&] {
+        DoNotOptimize(SwitcherMachine::Classify(key, cfg));
+        ++key;
+    });
+}
+
+static void BenchChannel(Bench& b) {
+    KeyEventChannel channel;
+    KeyEvent ev{ 0, vk::LMenu, KeyClass::Initiator, true };
+    KeyEvent out;
+    b.Run("keys/channel/push_pop", [&] {
+        channel.Push(ev);
+        channel.WaitPop(out, 0);
+    });
+}
+
+// Hook thread -> worker. The worker is usually asleep, so this is mostly the
+// cost of waking it.
+static void BenchHandoff(Bench& b) {
+    const size_t events = b.Quick() ? 500 : 5000;
+    const SteadyClock clock;
+    KeyEventChannel channel;
+    std::vector<double> latency;
+    latency.reserve(events);
+    std::thread worker([&] {
+        KeyEvent got;
+        while (channel.Pop(got))
+            latency.push_back((double)(clock.NowNs() - got.timeNs));
+    });
+    for (size_t k = 0; k < events; ++k) {
+        channel.Push({ clock.NowNs(), vk::LShift, KeyClass::Modifier, (k & 1) == 0 });
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    channel.Close();
+    worker.join();
+    b.Samples("keys/channel/handoff_latency", std::move(latency));
+}
+
+// Flat out, no sleeping between pushes; drops are expected whenever the
+// worker falls a full queue behind. Every 64th push is timed on its own, so
+// a push that stalls (a full queue, a contended wake) shows in p99 rather
+// than vanishing into the throughput; timing them all would slow the burst.
+static void BenchBurst(Bench& b) {
+    const size_t burst = b.Quick() ? 100000 : 1000000;
+    const size_t stride = 64;
+    const SteadyClock clock;
+    KeyEventChannel channel;
+    std::atomic<size_t> popped{ 0 };
+    std::thread worker([&] {
+        KeyEvent got;
+        while (channel.Pop(got))
+            popped.fetch_add(1, std::memory_order_relaxed);
+    });
+    std::vector<double> latency;
+    latency.reserve(burst / stride + 1);
+    const uint64_t t0 = clock.NowNs();
+    for (size_t k = 0; k < burst; ++k) {
+        const KeyEvent ev{ t0, vk::LShift, KeyClass::Modifier, (k & 1) == 0 };
+        if (k % stride != 0) {
+            channel.Push(ev);
+            continue;
+        }
+        const uint64_t p0 = clock.NowNs();
+        channel.Push(ev);
+        latency.push_back((double)(clock.NowNs() - p0));
+    }
+    channel.Close();
+    worker.join();
+    const double seconds = (double)(clock.NowNs() - t0) / 1e9;
+    b.Samples("keys/channel/burst_push_latency", std::move(latency));
+    b.Metric("keys/channel/burst_throughput", (double)popped.load() / seconds, "events/s");
+    b.Metric("keys/channel/burst_dropped", (double)channel.Dropped(), "events");
+}
+
+// How late HoldStart fires after the hold deadline, through the real worker
+// loop (channel wait with a timeout)
+static void BenchHold(Bench& b) {
+    SwitcherConfig cfg;
+    cfg.tapTimeoutMs = 2;
+    const SteadyClock clock;
+    SwitcherMachine machine(cfg);
+    KeyEventChannel channel;
+
+    std::atomic<uint64_t> holdAt{ 0 };
+    std::atomic<bool> committed{ false };
+    SwitcherScheduler sched(machine, channel, clock, [&](const SwitcherAction& a) {
+        if (a.type == SwitcherActionType::HoldStart)
+            holdAt.store(clock.NowNs(), std::memory_order_release);
+        else if (a.type == SwitcherActionType::Commit)
+            committed.store(true, std::memory_order_release);
+    });
+    std::thread worker([&] { sched.Run(); });
+
+    const size_t holds = b.Quick() ? 20 : 200;
+    std::vector<double> late;
+    late.reserve(holds);
+    for (size_t k = 0; k < holds; ++k) {
+        holdAt.store(0);
+        committed.store(false);
+        uint64_t t = clock.NowNs();
+        channel.Push({ t, cfg.initiator, KeyClass::Initiator, true });
+        channel.Push({ t, cfg.modifier, KeyClass::Modifier, true });
+        // sleep rather than spin, so the worker has the CPU to itself
+        while (holdAt.load(std::memory_order_acquire) == 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        late.push_back((double)(holdAt.load() - (t + (uint64_t)cfg.tapTimeoutMs * kMs)));
+
+        t = clock.NowNs();
+        channel.Push({ t, cfg.modifier, KeyClass::Modifier, false });
+        channel.Push({ t, cfg.initiator, KeyClass::Initiator, false });
+        while (!committed.load(std::memory_order_acquire))
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    channel.Close();
+    worker.join();
+    b.Samples("keys/hold/deadline_lateness", std::move(late));
+}
+
+// Hold timing on a ManualClock, through the scheduler's non-blocking Poll():
+// nothing fires a millisecond before either deadline, HoldStart fires on it,
+// and the release that follows commits
+static void CheckHold(Bench& b) {
+    const std::string what = "keys/hold: ";
+    const SwitcherConfig cfg;
+    const uint64_t start = 1000 * kMs;
+    ManualClock clock(start);
+    SwitcherMachine machine(cfg);
+    KeyEventChannel channel;
+    std::vector<SwitcherActionType> seen;
+    SwitcherScheduler sched(machine, channel, clock, [&](const SwitcherAction& a) { seen.push_back(a.type); });
+    auto key = [&](uint16_t vk, KeyClass cls, bool down) {
+        channel.Push({ clock.NowNs(), vk, cls, down });
+        sched.Poll();
+    };
+    // moves the clock to start + ms and lets the scheduler look
+    auto at = [&](uint64_t ms) {
+        clock.Set(start + ms * kMs);
+        sched.Poll();
+    };
+    auto only = [&](SwitcherActionType type) { return seen.size() == 1 && seen[0] == type; };
+
+    // initiator and modifier held: the tap deadline
+    {
+        clock.Set(start);
+        key(cfg.initiator, KeyClass::Initiator, true);
+        key(cfg.modifier, KeyClass::Modifier, true);
+        at((uint64_t)cfg.tapTimeoutMs - 1);
+        b.Expect(seen.empty(), what + "acted a millisecond before tapTimeoutMs");
+        at((uint64_t)cfg.tapTimeoutMs);
+        b.Expect(only(SwitcherActionType::HoldStart) && machine.State() == SwitcherState::Listing,
+                 what + "no HoldStart at tapTimeoutMs with both keys down");
+        seen.clear();
+        at((uint64_t)cfg.tapTimeoutMs + 1000);
+        key(cfg.modifier, KeyClass::Modifier, false);
+        key(cfg.initiator, KeyClass::Initiator, false);
+        b.Expect(only(SwitcherActionType::Commit) && machine.State() == SwitcherState::Idle,
+                 what + "releasing after a hold did not just commit");
+        at((uint64_t)cfg.tapTimeoutMs + 5000);
+        b.Expect(seen.size() == 1, what + "a deadline fired again after the commit");
+    }
+
+    // a tap, then the initiator held on its own: the overlay deadline
+    {
+        seen.clear();
+        clock.Set(start);
+        key(cfg.initiator, KeyClass::Initiator, true);
+        key(cfg.modifier, KeyClass::Modifier, true);
+        at(10);
+        key(cfg.modifier, KeyClass::Modifier, false);
+        at(10 + (uint64_t)cfg.overlayTimeoutMs - 1);
+        b.Expect(seen.empty(), what + "acted a millisecond before overlayTimeoutMs");
+        at(10 + (uint64_t)cfg.overlayTimeoutMs);
+        b.Expect(only(SwitcherActionType::HoldStart) && machine.State() == SwitcherState::Listing,
+                 what + "no HoldStart at overlayTimeoutMs after a tap");
+        seen.clear();
+        at(10 + (uint64_t)cfg.overlayTimeoutMs + 1000);
+        key(cfg.initiator, KeyClass::Initiator, false);
+        b.Expect(only(SwitcherActionType::Commit) && machine.State() == SwitcherState::Idle,
+                 what + "releasing after a tap and hold did not just commit");
+        at(10 + (uint64_t)cfg.overlayTimeoutMs + 5000);
+        b.Expect(seen.size() == 1, what + "a deadline fired again after the commit");
+    }
+    channel.Close();
+}
+
+// --- key bindings ---
+
+namespace vkx {
+constexpr uint8_t LControl = 0xA2;
+constexpr uint8_t LWin = 0x5B;
+constexpr uint8_t Tab = 0x09;
+constexpr uint8_t Space = 0x20;
+}
+
+static KeyBinding Bind(const char* keys, BindingAction action = BindingAction::Select, int index = 1) {
+    KeyBinding b;
+    ParseKeys(keys, b.keys);
+    b.action = action;
+    b.index = index;
+    return b;
+}
+
+// A heavy config: chords on letters, digits and F-keys under the less
+// common modifier combinations, and two-chord sequences behind Ctrl+K and
+// Ctrl+Q, none conflicting
+static std::vector<KeyBinding> MakeBindings(size_t count) {
+    static const uint8_t singleMods[] = { keymod::Ctrl | keymod::Alt, keymod::Ctrl | keymod::Shift, keymod::Win,
+                                          keymod::Ctrl | keymod::Alt | keymod::Shift, keymod::Win | keymod::Shift };
+    static const uint8_t secondMods[] = { 0, keymod::Ctrl, keymod::Shift };
+    std::vector<uint8_t> keys;
+    for (uint8_t k = 'A'; k <= 'Z'; ++k) keys.push_back(k);
+    for (uint8_t k = '0'; k <= '9'; ++k) keys.push_back(k);
+    for (uint8_t k = 0x70; k <= 0x87; ++k) keys.push_back(k);
+
+    std::vector<KeyBinding> out;
+    for (uint8_t mods : singleMods)
+        for (uint8_t k : keys) {
+            if (out.size() == count)
+                return out;
+            KeyBinding b;
+            b.keys = { { mods, k } };
+            b.index = (int)(out.size() % 9) + 1;
+            out.push_back(b);
+        }
+    for (uint8_t prefix : { (uint8_t)'K', (uint8_t)'Q' })
+        for (uint8_t mods : secondMods)
+            for (uint8_t k : keys) {
+                if (out.size() == count)
+                    return out;
+                KeyBinding b;
+                b.keys = { { keymod::Ctrl, prefix }, { mods, k } };
+                b.index = (int)(out.size() % 9) + 1;
+                out.push_back(b);
+            }
+    return out;
+}
+
+struct RawKey {
+    uint64_t timeNs;
+    uint8_t  vk;
+    bool     down;
+};
+
+// Someone typing: mostly plain and shifted letters, some editor shortcuts
+// no binding takes, and one in fifty strokes a chord from bindings
+static std::vector<RawKey> MakeTyping(size_t strokes, const std::vector<KeyBinding>& bindings, uint32_t seed = 3) {
+    std::mt19937 rng(seed);
+    std::vector<RawKey> out;
+    out.reserve(strokes * 6);
+    uint64_t t = 0;
+    auto press = [&](uint8_t vk, bool down) { out.push_back({ t += 40 * kMs, vk, down }); };
+    auto chord = [&](uint8_t mods, uint8_t vk) {
+        if (mods & keymod::Ctrl)  press(vkx::LControl, true);
+        if (mods & keymod::Shift) press(vk::LShift, true);
+        if (mods & keymod::Alt)   press(vk::LMenu, true);
+        if (mods & keymod::Win)   press(vkx::LWin, true);
+        press(vk, true);
+        press(vk, false);
+        if (mods & keymod::Win)   press(vkx::LWin, false);
+        if (mods & keymod::Alt)   press(vk::LMenu, false);
+        if (mods & keymod::Shift) press(vk::LShift, false);
+        if (mods & keymod::Ctrl)  press(vkx::LControl, false);
+    };
+    for (size_t i = 0; i < strokes; ++i) {
+        const uint32_t r = rng() % 100;
+        if (r < 2) {
+            for (const KeyChord& c : bindings[rng() % bindings.size()].keys)
+                chord(c.mods, c.vk);
+        } else if (r < 6) {
+            chord(keymod::Ctrl, "CVZS"[rng() % 4]);
+        } else if (r < 15) {
+            chord(keymod::Shift, (uint8_t)('A' + rng() % 26));
+        } else {
+            const uint8_t vk = (r < 30) ? vkx::Space : (uint8_t)('A' + rng() % 26);
+            chord(0, vk);
+        }
+    }
+    return out;
+}
+
+static void BenchBindings(Bench& b) {
+    const std::vector<KeyBinding> many = MakeBindings(500);
+    const std::vector<RawKey> typing = MakeTyping(b.Quick() ? 20000 : 200000, many);
+
+    b.Run("keys/bindings/compile/500", [&] {
+        KeyBindingSet set(many);
+        DoNotOptimize(set.Nodes());
+    });
+
+    // the hook's per-key work, on the same stream with a config that binds
+    // one chord and with one binding five hundred
+    for (size_t count : { (size_t)1, many.size() }) {
+        auto set = std::make_shared<const KeyBindingSet>(std::vector<KeyBinding>(many.begin(), many.begin() + count));
+        KeyBindingMatcher matcher;
+        matcher.SetBindings(set, 1000);
+        size_t i = 0, fired = 0;
+        uint64_t offset = 0;
+        const std::string name = "keys/bindings/event/" + std::to_string(count);
+        b.Run(name, [&] {
+            const RawKey& k = typing[i];
+            fired += matcher.OnKey(k.vk, k.down, k.timeNs + offset).result == KeyBindingMatcher::Result::Fire;
+            if (++i == typing.size()) {
+                i = 0;
+                offset += typing.back().timeNs;
+            }
+        });
+        b.ExpectNoAllocs(name);
+        DoNotOptimize(fired);
+        b.Metric("keys/bindings/nodes/" + std::to_string(count), (double)set->Nodes(), "nodes");
+    }
+
+    // nothing but bound chords, every key resolving through the tables
+    {
+        std::vector<RawKey> chords;
+        uint64_t t = 0;
+        for (const KeyBinding& kb : many)
+            for (const KeyChord& c : kb.keys) {
+                const uint8_t mod = (c.mods & keymod::Win) ? vkx::LWin : (c.mods & keymod::Ctrl) ? vkx::LControl : vk::LMenu;
+                const bool extraShift = (c.mods & keymod::Shift) != 0;
+                const bool extraAlt = (c.mods & keymod::Alt) && mod != vk::LMenu;
+                const bool any = c.mods != 0 && c.mods != keymod::Shift;
+                if (any) chords.push_back({ t += kMs, mod, true });
+                if (extraShift) chords.push_back({ t += kMs, vk::LShift, true });
+                if (extraAlt) chords.push_back({ t += kMs, vk::LMenu, true });
+                chords.push_back({ t += kMs, c.vk, true });
+                chords.push_back({ t += kMs, c.vk, false });
+                if (extraAlt) chords.push_back({ t += kMs, vk::LMenu, false });
+                if (extraShift) chords.push_back({ t += kMs, vk::LShift, false });
+                if (any) chords.push_back({ t += kMs, mod, false });
+            }
+        KeyBindingMatcher matcher;
+        matcher.SetBindings(std::make_shared<const KeyBindingSet>(many), 1000);
+        size_t i = 0, fired = 0;
+        uint64_t offset = 0;
+        b.Run("keys/bindings/bound/500", [&] {
+            const RawKey& k = chords[i];
+            fired += matcher.OnKey(k.vk, k.down, k.timeNs + offset).result == KeyBindingMatcher::Result::Fire;
+            if (++i == chords.size()) {
+                i = 0;
+                offset += chords.back().timeNs;
+            }
+        });
+        b.ExpectNoAllocs("keys/bindings/bound/500");
+        DoNotOptimize(fired);
+    }
+}
+
+static void CheckBindings(Bench& b) {
+    const std::string what = "keys/bindings: ";
+    using R = KeyBindingMatcher::Result;
+
+    // names
+    {
+        std::vector<KeyChord> keys;
+        b.Expect(ParseKeys("win+1", keys) && keys.size() == 1 && keys[0].mods == keymod::Win && keys[0].vk == '1',
+                 what + "Win+1");
+        b.Expect(ParseKeys(" Ctrl + K ,Ctrl+Shift+F12", keys) && FormatKeys(keys) == "Ctrl+K, Ctrl+Shift+F12",
+                 what + "a sequence, written back the same");
+        b.Expect(!ParseKeys("Ctrl", keys) && !ParseKeys("Ctrl+Foo", keys) && !ParseKeys("", keys) &&
+                 !ParseKeys("Ctrl+K,", keys) && !ParseKeys("F25", keys) && !ParseKeys("Hyper+A", keys),
+                 what + "accepted a key that doesn't exist");
+    }
+
+    // compiling: prefixes and duplicates can never fire
+    {
+        const KeyBindingSet set({ Bind("Ctrl+K, Ctrl+W"), Bind("Ctrl+K"), Bind("Ctrl+K, Ctrl+W, X"),
+                                  Bind("Ctrl+K, Ctrl+W"), Bind("Win+2", BindingAction::Select, 2),
+                                  Bind("Tab", BindingAction::Overlay), Bind("Win+Q", BindingAction::Select, 300) });
+        b.Expect(set.Bindings().size() == 2 && set.Dropped() == 5, what + "conflicting or unusable bindings kept");
+        b.Expect(set.IsTrigger('K') && set.IsTrigger('W') && set.IsTrigger('2') && !set.IsTrigger('X'),
+                 what + "trigger keys");
+    }
+
+    // matching: exact modifiers, swallowing, Win+1..9
+    {
+        std::vector<KeyBinding> list;
+        for (int n = 1; n <= 9; ++n)
+            list.push_back(Bind(("Win+" + std::to_string(n)).c_str(), BindingAction::Select, n));
+        KeyBindingMatcher m;
+        m.SetBindings(std::make_shared<const KeyBindingSet>(list), 1000);
+        uint64_t t = 0;
+        b.Expect(m.OnKey('3', true, ++t).result == R::Pass && m.OnKey('3', false, ++t).result == R::Pass,
+                 what + "a bound key without its modifier passes");
+        m.OnKey(vkx::LWin, true, ++t);
+        const KeyBindingMatcher::Output fire = m.OnKey('3', true, ++t);
+        b.Expect(fire.result == R::Fire && BindingActionOf(fire.command) == BindingAction::Select &&
+                 BindingIndexOf(fire.command) == 3, what + "Win+3 selects the third window");
+        b.Expect(m.OnKey('3', true, ++t).result == R::Swallow, what + "auto-repeat of a select fired again");
+        b.Expect(m.OnKey('3', false, ++t).result == R::Swallow, what + "the release of a fired key leaked");
+        b.Expect(m.OnKey('A', true, ++t).result == R::Pass && m.OnKey('A', false, ++t).result == R::Pass,
+                 what + "Win+A isn't bound");
+        m.OnKey(vk::RShift, true, ++t);
+        b.Expect(m.OnKey('3', true, ++t).result == R::Pass, what + "Win+Shift+3 isn't Win+3");
+        m.OnKey('3', false, ++t);
+        m.OnKey(vk::RShift, false, ++t);
+        b.Expect(m.OnKey(vkx::LWin, false, ++t).result == R::Pass, what + "modifiers always pass");
+    }
+
+    // sequences: completion, timeout, a broken one restarting
+    {
+        KeyBindingMatcher m;
+        m.SetBindings(std::make_shared<const KeyBindingSet>(std::vector<KeyBinding>{
+                          Bind("Ctrl+K, Ctrl+W", BindingAction::Select, 4), Bind("Ctrl+K, P", BindingAction::Select, 5),
+                          Bind("Ctrl+J", BindingAction::Select, 6) }), 500);
+        uint64_t t = 0;
+        auto stroke = [&](uint8_t mods, uint8_t vk, uint64_t gapMs = 10) {
+            t += gapMs * kMs;
+            if (mods & keymod::Ctrl) m.OnKey(vkx::LControl, true, t);
+            const KeyBindingMatcher::Output out = m.OnKey(vk, true, t);
+            m.OnKey(vk, false, t);
+            if (mods & keymod::Ctrl) m.OnKey(vkx::LControl, false, t);
+            return out;
+        };
+        b.Expect(stroke(keymod::Ctrl, 'K').result == R::Swallow && !m.Idle(), what + "a sequence's first chord");
+        const KeyBindingMatcher::Output w = stroke(keymod::Ctrl, 'W');
+        b.Expect(w.result == R::Fire && BindingIndexOf(w.command) == 4 && m.Idle(), what + "Ctrl+K, Ctrl+W");
+        stroke(keymod::Ctrl, 'K');
+        b.Expect(stroke(0, 'P').result == R::Fire, what + "Ctrl+K, P");
+        stroke(keymod::Ctrl, 'K');
+        b.Expect(stroke(0, 'P', 600).result == R::Pass && m.Idle(), what + "a sequence outlived its timeout");
+        stroke(keymod::Ctrl, 'K');
+        b.Expect(stroke(0, 'X').result == R::Pass && m.Idle(), what + "an unbound key ends a sequence");
+        stroke(keymod::Ctrl, 'K');
+        const KeyBindingMatcher::Output j = stroke(keymod::Ctrl, 'J');
+        b.Expect(j.result == R::Fire && BindingIndexOf(j.command) == 6, what + "a broken sequence's key starts over");
+    }
+
+    // an overlay binding through the switcher: show, cycle, commit on release
+    {
+        KeyBindingMatcher m;
+        m.SetBindings(std::make_shared<const KeyBindingSet>(std::vector<KeyBinding>{
+                          Bind("Ctrl+Tab", BindingAction::Overlay), Bind("Win+2", BindingAction::Select, 2) }), 1000);
+        SwitcherMachine machine{ SwitcherConfig() };
+        std::vector<SwitcherActionType> seen;
+        int index = -1;
+        uint64_t t = 0;
+        auto key = [&](uint8_t vk, bool down) {
+            t += 5 * kMs;
+            const KeyClass cls = SwitcherMachine::Classify(vk, machine.Config());
+            SwitcherAction actions[SwitcherMachine::kMaxActions];
+            if (cls != KeyClass::Other) {
+                const int n = machine.OnKey({ t, vk, cls, down }, actions);
+                for (int a = 0; a < n; ++a) seen.push_back(actions[a].type);
+            }
+            const KeyBindingMatcher::Output out = m.OnKey(vk, down, t);
+            if (out.result == R::Fire || out.result == R::Release) {
+                const int n = machine.OnKey({ t, out.command, KeyClass::Binding, out.result == R::Fire }, actions);
+                for (int a = 0; a < n; ++a) {
+                    seen.push_back(actions[a].type);
+                    index = actions[a].index;
+                }
+            }
+        };
+        key(vkx::LControl, true);
+        key(vkx::Tab, true);
+        key(vkx::Tab, true);     // auto-repeat
+        key(vkx::Tab, false);
+        key(vkx::Tab, true);
+        key(vkx::Tab, false);
+        key(vkx::LControl, false);
+        const std::vector<SwitcherActionType> expected = { SwitcherActionType::HoldStart, SwitcherActionType::Cycle,
+                                                          SwitcherActionType::Cycle, SwitcherActionType::Commit };
+        b.Expect(seen == expected && machine.State() == SwitcherState::Idle && m.Idle(),
+                 what + "Ctrl+Tab shows, cycles and commits");
+
+        seen.clear();
+        key(vkx::LWin, true);
+        key('2', true);
+        key('2', false);
+        key(vkx::LWin, false);
+        b.Expect(seen.size() == 1 && seen[0] == SwitcherActionType::QuickSelect && index == 2,
+                 what + "Win+2 quick-selects the second window");
+
+        // taps own the keys: a select during quick-select does nothing
+        seen.clear();
+        key(vk::LMenu, true);
+        key(vk::LShift, true);
+        key(vk::LShift, false);
+        key(vkx::LWin, true);
+        key('2', true);
+        key('2', false);
+        key(vkx::LWin, false);
+        key(vk::LMenu, false);
+        b.Expect(seen.size() == 1 && seen[0] == SwitcherActionType::Tap, what + "a binding interrupted a tap");
+    }
+
+    // wws_config.json round trip
+    {
+        HotkeyConfig cfg;
+        cfg.keyBindings.set = std::make_shared<const KeyBindingSet>(std::vector<KeyBinding>{
+            Bind("Win+1", BindingAction::Select, 1), Bind("Ctrl+K, Shift+F5", BindingAction::Select, 7),
+            Bind("Ctrl+Alt+Tab", BindingAction::Overlay) });
+        cfg.keyBindings.sequenceTimeoutMs = 750;
+        const std::string path = (std::filesystem::temp_directory_path() / "wws_bench_bindings.json").string();
+        HotkeyConfig loaded;
+        b.Expect(SaveSettings(cfg, path) && LoadSettings(path, loaded), what + "cannot save and load bindings");
+        b.Expect(loaded == cfg && loaded.keyBindings.set && loaded.keyBindings.set->Bindings().size() == 3,
+                 what + "bindings changed on the way through the file");
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+}
+
+void BenchKeys(Bench& b) {
+    if (b.Wants("keys/switcher/"))        BenchSwitcher(b);
+    if (b.Wants("keys/channel/push_pop")) BenchChannel(b);
+    if (b.Wants("keys/channel/handoff"))  BenchHandoff(b);
+    if (b.Wants("keys/channel/burst"))    BenchBurst(b);
+    if (b.Wants("keys/hold/check"))       CheckHold(b);
+    if (b.Wants("keys/hold/deadline"))    BenchHold(b);
+    if (b.Wants("keys/bindings/"))        BenchBindings(b);
+    if (b.Wants("keys/bindings/check"))   CheckBindings(b);
+}
@@ -0,0 +1,1663 @@
+﻿// === bench/bench_overlay.cpp ===
+#include "harness.h"
+#include "fixtures.h"
+#include "frame_scheduler.h"
+#include "fetch_pool.h"
+#include "fuzzy_filter.h"
+#include "icon_atlas.h"
+#include "glyph_cache.h"
+#include "overlay_lifetime.h"
+#include "overlay_model.h"
+#include "overlay_view.h"
+#include "process_cache.h"
+#include "process_memory.h"
+#include "soft_renderer.h"
+#include "thumbnail_cache.h"
+#include "utf8.h"
+#include "imgui.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <numeric>
+#include <random>
+#include <thread>
+
+// --- titles ---
+
+// One snapshot row: the title and its "app - page" form into the arena
+static void BenchTitles(Bench& b) {
+    const std::wstring shortTitle = L"Inbox - Outlook";
+    const std::wstring longTitle =
+        L"Quarterly planning notes, second draft with comments from the whole team (shared) - "
+        L"Project Wiki - Mozilla Firefox";
+    const std::wstring noDash = L"Task Manager";
+    WindowSnapshot snap;
+    auto add = [&](const std::wstring& title) {
+        snap.Clear();
+        snap.Add(1, title, 0);
+        DoNotOptimize(snap.Display(0).size());
+    };
+    b.Run("overlay/title/app_page", [&] { add(shortTitle); });
+    b.Run("overlay/title/long", [&] { add(longTitle); });
+    b.Run("overlay/title/no_dash", [&] { add(noDash); });
+}
+
+// --- type-to-filter ---
+
+static void BenchFilter(Bench& b) {
+    const size_t n = b.Quick() ? 1000 : 10000;
+    const std::string suffix = "/" + std::to_string(n);
+    WindowSnapshot windows;
+    MakeSnapshot(n, windows);
+    FuzzyFilter filter;
+
+    b.Run("overlay/filter/build" + suffix, [&] { filter.Build(windows); });
+
+    // someone typing a query, timed per keystroke (mostly incremental)
+    const std::wstring typed = L"pull req chrome";
+    std::vector<double> keystrokes;
+    const int rounds = b.Quick() ? 5 : 50;
+    const uint64_t allocs0 = AllocCount();
+    for (int r = 0; r < rounds; ++r) {
+        filter.Build(windows);
+        std::wstring query;
+        for (wchar_t ch : typed) {
+            query += ch;
+            auto t0 = std::chrono::steady_clock::now();
+            DoNotOptimize(filter.Filter(query).size());
+            keystrokes.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - t0).count());
+        }
+    }
+    // Build's own allocations are in there too; they are few and fixed
+    const double allocs = (double)(AllocCount() - allocs0) / (double)keystrokes.size();
+    b.Samples("overlay/filter/keystroke" + suffix, std::move(keystrokes), allocs);
+
+    // queries that don't extend each other scan every entry
+    const std::wstring queries[2] = { L"ed", L"so" };
+    int q = 0;
+    b.Run("overlay/filter/full_scan" + suffix, [&] {
+        DoNotOptimize(filter.Filter(queries[q]).size());
+        q ^= 1;
+    });
+    b.Metric("overlay/filter/scanned" + suffix, (double)filter.Scanned(), "entries");
+}
+
+// --- headless frames ---
+
+// ImGui has its own allocator hooks; route them through the counters
+static void* ImGuiAlloc(size_t size, void*) { return CountingMalloc(size); }
+static void  ImGuiFree(void* p, void*) { CountingFree(p); }
+
+// A context with no platform or GPU behind it; the renderer only answers
+// texture requests, or draws on the CPU
+template <class Renderer>
+struct Headless {
+    Renderer renderer;
+
+    template <class... Args>
+    explicit Headless(Args&&... args) : renderer(std::forward<Args>(args)...) {
+        ImGui::SetAllocatorFunctions(ImGuiAlloc, ImGuiFree);
+        ImGui::CreateContext();
+        ImGuiIO& io = ImGui::GetIO();
+        io.DisplaySize = ImVec2(1920.0f, 1080.0f);
+        io.DeltaTime = 1.0f / 60.0f;
+        io.IniFilename = nullptr;
+        renderer.Init();
+    }
+    ~Headless() { ImGui::DestroyContext(); }
+};
+using HeadlessContext = Headless<NullTextureRenderer>;
+
+// Same layout as the overlay panel in gui.cpp, minus the settings column
+template <class Renderer>
+static void OverlayFrame(const WindowSnapshot& windows, const std::vector<uint32_t>& rows,
+                         OverlayListState& state, IconAtlas& icons, Renderer& renderer,
+                         TitleFitCache* fits = nullptr)
+{
+    ImGui::NewFrame();
+    icons.NewFrame();
+
+    const float pad = 10.0f;
+    const float exe_w = 120.0f;
+    const float list_w = 500.0f + exe_w;
+    const float list_h = OverlayListHeight(rows.size(), 1080.0f * 0.6f);
+    ImGui::SetNextWindowPos(ImVec2(300.0f, 100.0f));
+    ImGui::SetNextWindowSize(ImVec2(list_w + pad * 2, list_h + pad * 2));
+    ImGui::Begin("Overlay", nullptr,
+        ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove |
+        ImGuiWindowFlags_NoBackground | ImGuiWindowFlags_NoScrollbar);
+
+    OverlayListLayout layout;
+    layout.width = list_w;
+    layout.exeWidth = exe_w;
+    layout.maxTitle = kMaxTitle;
+    layout.icons = &icons;
+    layout.fits = fits;
+    DrawWindowList("##List", windows, rows, state, layout, list_h);
+
+    ImGui::End();
+    ImGui::Render();
+    renderer.Update();
+}
+
+// How much longer a 5000-window frame may take than a 10-window one. The
+// long list draws a screenful of rows (~37) against 10, about 3x the
+// work; unclipped it would be hundreds of times slower
+static const double kFrameTimeRatio = 8.0;
+
+static void BenchFrames(Bench& b) {
+    struct Drawn {
+        int    vertices = 0;
+        int    cmds = 0;
+        double nsPerFrame = 0.0;
+    };
+    Drawn few, full;       // 10 windows, and 100, which fill the list
+    for (size_t n : { (size_t)10, (size_t)100, (size_t)1000, (size_t)5000 }) {
+        const std::string name = "overlay/frame/" + std::to_string(n);
+        // the longer lists are checked against these two
+        if (!b.Wants(name) && !(n <= 100 && b.Wants("overlay/frame/")))
+            continue;
+        WindowSnapshot windows;
+        MakeSnapshot(n, windows);
+        std::vector<uint32_t> rows(n);
+        for (uint32_t i = 0; i < (uint32_t)n; ++i)
+            rows[i] = i;
+
+        HeadlessContext ctx;
+        FakeIconProvider provider;
+        IconAtlas icons(16, 512, 512);
+        icons.SetProvider(&provider);
+        icons.Attach();
+
+        // the selection walks the list like a held modifier would
+        OverlayListState state;
+        TitleFitCache fits;
+        auto frame = [&] {
+            state.selIndex = (state.selIndex + 1) % (int)n;
+            state.scrollToSelection = true;
+            OverlayFrame(windows, rows, state, icons, ctx.renderer, &fits);
+        };
+        for (int i = 0; i < 3; ++i)
+            frame();   // fonts, icons and windows settle
+        b.Run(name, frame);
+
+        const ImDrawData* dd = ImGui::GetDrawData();
+        int cmds = 0;
+        for (const ImDrawList* list : dd->CmdLists)
+            cmds += list->CmdBuffer.Size;
+        b.Metric(name + "/vertices", (double)dd->TotalVtxCount, "vtx");
+        b.Metric(name + "/indices", (double)dd->TotalIdxCount, "idx");
+        b.Metric(name + "/draw_cmds", (double)cmds, "cmds");
+
+        // the same frame for every n: top of the list, first row selected;
+        // a window's rows are the same whatever the count (fixed seed)
+        Drawn drawn;
+        const int timed = b.Quick() ? 50 : 500;
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < timed; ++i)
+            frame();
+        drawn.nsPerFrame = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - t0).count() / timed;
+        state = OverlayListState();
+        state.selIndex = 0;
+        state.scrollToSelection = true;
+        for (int i = 0; i < 2; ++i)
+            OverlayFrame(windows, rows, state, icons, ctx.renderer, &fits);
+        dd = ImGui::GetDrawData();
+        drawn.vertices = dd->TotalVtxCount;
+        for (const ImDrawList* list : dd->CmdLists)
+            drawn.cmds += list->CmdBuffer.Size;
+        icons.Detach();
+
+        if (n == 10)
+            few = drawn;
+        else if (n == 100)
+            full = drawn;
+        // 100 windows already fill the list; past that only the rows it
+        // shows may be drawn, the same ones at the top of the list
+        if (n > 100 && full.vertices) {
+            const int rowVtx = few.vertices / 10;
+            b.Expect(std::abs(drawn.vertices - full.vertices) <= rowVtx,
+                     name + ": " + std::to_string(drawn.vertices) + " vertices against " +
+                     std::to_string(full.vertices) + " for 100 windows; the list is no longer clipped");
+            b.Expect(drawn.cmds == full.cmds,
+                     name + ": " + std::to_string(drawn.cmds) + " draw commands against " +
+                     std::to_string(full.cmds) + " for 100 windows");
+        }
+        if (n == 5000 && few.nsPerFrame > 0.0)
+            b.Expect(drawn.nsPerFrame <= few.nsPerFrame * kFrameTimeRatio,
+                     name + ": a frame takes " + std::to_string(drawn.nsPerFrame / few.nsPerFrame) +
+                     "x as long as with 10 windows");
+    }
+}
+
+// --- icons ---
+
+static void BenchIcons(Bench& b) {
+    HeadlessContext ctx;
+    FakeIconProvider provider;
+
+    // steady state: every icon already packed
+    {
+        IconAtlas icons(16, 512, 512);
+        icons.SetProvider(&provider);
+        icons.Attach();
+        std::vector<std::wstring> paths;
+        for (size_t i = 0; i < 15; ++i)
+            paths.push_back(ExePathFor(i));
+        ImVec2 uv0, uv1;
+        for (const std::wstring& p : paths)
+            icons.Get(p, uv0, uv1);
+        size_t i = 0;
+        b.Run("overlay/icons/get_hit", [&] {
+            DoNotOptimize(icons.Get(paths[i], uv0, uv1));
+            i = (i + 1) % paths.size();
+        });
+        icons.Detach();
+    }
+
+    // far more exes than fit: scrolling through them keeps evicting
+    if (!b.Wants("overlay/icons/churn"))
+        return;
+    const size_t n = 600;
+    WindowSnapshot windows;
+    std::vector<uint32_t> rows(n);
+    for (size_t i = 0; i < n; ++i) {
+        auto info = std::make_shared<ProcessInfo>();
+        info->exePath = L"C:\\Apps\\tool" + std::to_wstring(i) + L".exe";
+        info->exeName = L"tool" + std::to_wstring(i) + L".exe";
+        windows.Add(i + 1, L"Window " + std::to_wstring(i), 0);
+        windows.SetProcess(i, std::move(info));
+        rows[i] = (uint32_t)i;
+    }
+    IconAtlas icons(16, 128, 128);
+    icons.SetProvider(&provider);
+    icons.Attach();
+    OverlayListState state;
+    b.Run("overlay/icons/churn_frame", [&] {
+        state.selIndex = (state.selIndex + 7) % (int)n;
+        state.scrollToSelection = true;
+        OverlayFrame(windows, rows, state, icons, ctx.renderer);
+    });
+    const IconAtlas::Stats s = icons.GetStats();
+    b.Metric("overlay/icons/churn_evictions", (double)s.evictions, "icons");
+    b.Metric("overlay/icons/churn_repacks", (double)s.repacks, "repacks");
+    b.Metric("overlay/icons/churn_upload_bytes", (double)s.uploadBytes, "bytes");
+    b.Metric("overlay/icons/churn_density", (double)s.density, "ratio");
+    b.Expect(s.evictions > 0, "overlay/icons/churn: 600 exes fit a 128px atlas without evicting");
+    b.Expect(s.density >= 0.5f, "overlay/icons/churn: density " + std::to_string(s.density) +
+             " after churning, below 0.5");
+    icons.Detach();
+}
+
+// Packing, eviction and upload guarantees of the icon atlas, one icon
+// request at a time in otherwise empty frames
+static void CheckIcons(Bench& b) {
+    HeadlessContext ctx;
+    FakeIconProvider provider;
+    const int size = 16, side = 128;
+    const size_t iconBytes = (size_t)size * size * 4;
+    const size_t atlasBytes = (size_t)side * side * 4;
+    // padded 17px cells, 7 to a row of 128: 49 icons fill it
+    const size_t fill = 49;
+    // 49 icons cover 0.77 of the atlas; the skyline packer may waste a little
+    const float kMinDensity = 0.7f;
+
+    IconAtlas icons(size, side, side);
+    icons.SetProvider(&provider);
+    icons.SetLoadBudget(1000);
+    icons.Attach();
+    auto path = [](size_t i) { return L"C:\\Apps\\tool" + std::to_wstring(i) + L".exe"; };
+    ImVec2 uv0, uv1;
+    auto frame = [&](auto&& draw) {
+        ImGui::NewFrame();
+        icons.NewFrame();
+        draw();
+        ImGui::Render();
+        ctx.renderer.Update();
+    };
+    auto drawRange = [&](size_t from, size_t to) {
+        return [&, from, to] {
+            for (size_t i = from; i < to; ++i)
+                icons.Get(path(i), uv0, uv1);
+        };
+    };
+    frame([] {});   // font and icon textures created
+    const size_t creates = ctx.renderer.Creates();
+
+    // uploads: each new icon sends its own sub-rectangle (the padding is only
+    // a gap between them) and never the whole atlas
+    {
+        size_t wrong = 0;
+        for (size_t i = 0; i < fill; ++i) {
+            const size_t sent = ctx.renderer.UploadBytes();
+            bool ok = false;
+            frame([&] {
+                const IconAtlas::Stats before = icons.GetStats();
+                ok = icons.Get(path(i), uv0, uv1);
+                const IconAtlas::Stats after = icons.GetStats();
+                ok = ok && after.uploadRects == before.uploadRects + 1 &&
+                     after.uploadBytes - before.uploadBytes == iconBytes;
+            });
+            wrong += !ok || ctx.renderer.UploadBytes() - sent != iconBytes;
+        }
+        b.Expect(wrong == 0, "overlay/icons: " + std::to_string(wrong) + " of " + std::to_string(fill) +
+                 " new icons did not upload exactly their own " + std::to_string(iconBytes) + " bytes");
+        b.Expect(ctx.renderer.Creates() == creates,
+                 "overlay/icons: adding icons re-created the whole atlas texture (" +
+                 std::to_string(atlasBytes) + " bytes)");
+    }
+
+    // density: the full atlas holds everything the packer was given
+    {
+        const IconAtlas::Stats s = icons.GetStats();
+        b.Metric("overlay/icons/check_density", (double)s.density, "ratio");
+        b.Expect(s.entries == fill && s.evictions == 0,
+                 "overlay/icons: " + std::to_string(s.entries) + " of " + std::to_string(fill) +
+                 " icons packed into a " + std::to_string(side) + "px atlas");
+        b.Expect(s.density >= kMinDensity, "overlay/icons: density " + std::to_string(s.density) +
+                 " after packing, below " + std::to_string(kMinDensity));
+    }
+
+    // eviction: 0-4 were last drawn while filling and 5-9 a frame ago; 10-48
+    // are drawn this frame along with a new icon that doesn't fit. The oldest
+    // go first, and nothing drawn this frame is touched.
+    {
+        frame(drawRange(5, fill));
+        bool placed = false;
+        frame([&] {
+            drawRange(10, fill)();
+            placed = icons.Get(path(fill), uv0, uv1);
+        });
+        const IconAtlas::Stats s = icons.GetStats();
+        b.Metric("overlay/icons/check_evictions", (double)s.evictions, "icons");
+        b.Expect(placed && s.evictions > 0, "overlay/icons: a full atlas did not make room for a new icon");
+        b.Expect(s.density >= kMinDensity * 3 / 4, "overlay/icons: density " + std::to_string(s.density) +
+                 " after evicting, below " + std::to_string(kMinDensity * 3 / 4));
+
+        // residents come back without a load, evicted ones need one
+        const size_t loads = provider.Loads();
+        size_t oldest = 0;
+        frame([&] {
+            drawRange(10, fill + 1)();
+            b.Expect(provider.Loads() == loads, "overlay/icons: " + std::to_string(provider.Loads() - loads) +
+                     " icons drawn in the evicting frame were evicted");
+            for (size_t i = 0; i < 5; ++i) {
+                const size_t before = provider.Loads();
+                icons.Get(path(i), uv0, uv1);
+                oldest += provider.Loads() != before;
+            }
+        });
+        b.Expect(oldest == std::min<size_t>(5, s.evictions),
+                 "overlay/icons: " + std::to_string(s.evictions) + " evicted but only " +
+                 std::to_string(oldest) + " of the 5 least recently drawn icons among them");
+        b.Expect(ctx.renderer.Creates() == creates,
+                 "overlay/icons: evicting re-created the whole atlas texture");
+    }
+    icons.Detach();
+
+    // no room while the whole atlas is on screen: the new icon keeps its
+    // pixels and waits, retrying every 2, 4, ... frames, without a load
+    {
+        IconAtlas full(size, side, side);
+        full.SetProvider(&provider);
+        full.SetLoadBudget(1000);
+        full.Attach();
+        auto frameFull = [&](auto&& draw) {
+            ImGui::NewFrame();
+            full.NewFrame();
+            draw();
+            ImGui::Render();
+            ctx.renderer.Update();
+        };
+        auto drawFull = [&](size_t from, size_t to) {
+            for (size_t k = from; k < to; ++k)
+                full.Get(path(k), uv0, uv1);
+        };
+        const std::wstring missing = L"C:\\Apps\\noicon.exe";
+        provider.SetMissing(missing);
+        frameFull([&] { full.Get(missing, uv0, uv1); });
+        frameFull([&] { drawFull(0, fill); });
+        const size_t loads = provider.Loads();
+        bool shown = false;
+        for (int i = 0; i < 8; ++i)
+            frameFull([&] {
+                drawFull(0, fill);
+                shown = shown || full.Get(path(fill), uv0, uv1);
+            });
+        const IconAtlas::Stats waited = full.GetStats();
+        b.Expect(!shown && waited.entries == fill, "overlay/icons: an icon on screen made room for a new one");
+        b.Expect(provider.Loads() == loads + 1, "overlay/icons: " + std::to_string(provider.Loads() - loads) +
+                 " loads of an icon waiting for room");
+        b.Expect(waited.repacks <= 4, "overlay/icons: " + std::to_string(waited.repacks) +
+                 " repacks in 8 frames for an icon that can't fit; no backoff");
+
+        // with some off screen again it goes in at the next retry, and the
+        // exe without an icon, not drawn since before them, goes too
+        for (int i = 0; i < 16 && !shown; ++i)
+            frameFull([&] {
+                drawFull(10, fill);
+                shown = full.Get(path(fill), uv0, uv1);
+            });
+        b.Expect(shown && provider.Loads() == loads + 1, "overlay/icons: a waiting icon never got its room");
+        frameFull([&] { full.Get(missing, uv0, uv1); });
+        b.Expect(provider.Loads() == loads + 2, "overlay/icons: an exe without an icon was never evicted");
+        full.Detach();
+    }
+}
+
+// --- glyphs ---
+
+// DroidSans from the ImGui tree (Latin, Greek, Cyrillic) so every machine
+// starts from the same main font, then whatever fallbacks this one has
+static std::vector<std::string> BenchFonts() {
+    std::vector<std::string> files = { std::string(WWS_BENCH_FONT_DIR) + "/DroidSans.ttf" };
+    for (std::string& f : GlyphCache::SystemFonts())
+        files.push_back(std::move(f));
+    return files;
+}
+
+static double NsSince(std::chrono::steady_clock::time_point t0) {
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+}
+
+// Time to the first frame of a fresh overlay, with the glyphs rasterized
+// by that frame (cold) or by Prepare() and a warm-up frame beforehand, and
+// how big the atlas gets for a desktop's worth of titles in each script
+static void BenchGlyphs(Bench& b) {
+    const size_t n = 200;
+    std::vector<uint32_t> rows(n);
+    std::iota(rows.begin(), rows.end(), 0u);
+    const int rounds = b.Quick() ? 3 : 10;
+    const TitleScript scripts[] = { TitleScript::Latin, TitleScript::Cyrillic, TitleScript::Greek,
+                                    TitleScript::Cjk, TitleScript::Emoji, TitleScript::Mixed };
+    for (TitleScript script : scripts) {
+        const std::string name = std::string("overlay/glyphs/") + TitleScriptName(script);
+        if (!b.Wants(name))
+            continue;
+        const std::vector<std::wstring> titles = MakeScriptTitles(n, script);
+        WindowSnapshot windows;
+        for (size_t i = 0; i < n; ++i)
+            windows.Add(WindowIdFor(i), titles[i], PidFor(i));
+
+        std::vector<double> cold, warmUp, warm;
+        size_t warmUploads = 0;
+        GlyphCache::Stats stats;
+        for (int r = 0; r < rounds; ++r) {
+            for (bool prewarm : { false, true }) {
+                HeadlessContext ctx;
+                GlyphCache glyphs(BenchFonts());
+                glyphs.Attach();
+                FakeIconProvider provider;
+                IconAtlas icons(16, 512, 512);
+                icons.SetProvider(&provider);
+                icons.Attach();
+                OverlayListState state;
+                auto t0 = std::chrono::steady_clock::now();
+                if (prewarm) {
+                    glyphs.Prepare(windows);
+                    OverlayFrame(windows, rows, state, icons, ctx.renderer);
+                    warmUp.push_back(NsSince(t0));
+                    const size_t uploads = ctx.renderer.UploadRects();
+                    t0 = std::chrono::steady_clock::now();
+                    OverlayFrame(windows, rows, state, icons, ctx.renderer);
+                    warm.push_back(NsSince(t0));
+                    warmUploads += ctx.renderer.UploadRects() - uploads;
+                    stats = glyphs.GetStats();
+                    // a snapshot of titles it has seen: one lookup per codepoint
+                    if (r == 0) {
+                        b.Run(name + "/prepare_again", [&] { DoNotOptimize(glyphs.Prepare(windows)); });
+                        b.ExpectNoAllocs(name + "/prepare_again");
+                    }
+                }
+                else {
+                    OverlayFrame(windows, rows, state, icons, ctx.renderer);
+                    cold.push_back(NsSince(t0));
+                }
+                icons.Detach();
+                glyphs.Detach();
+            }
+        }
+        b.Samples(name + "/first_frame_cold", std::move(cold));
+        b.Samples(name + "/warm_up", std::move(warmUp));
+        b.Samples(name + "/first_frame_warm", std::move(warm));
+        b.Metric(name + "/codepoints", (double)stats.codepoints, "chars");
+        b.Metric(name + "/rasterized", (double)stats.rasterized, "glyphs");
+        b.Metric(name + "/missing", (double)stats.missing, "chars");
+        b.Metric(name + "/fonts", (double)stats.fonts, "files");
+        b.Metric(name + "/atlas", (double)stats.atlasBytes, "bytes");
+        b.Expect(warmUploads == 0, name + ": the first frame after the warm-up still uploaded glyphs");
+        b.Expect(stats.codepoints > 0 && stats.rasterized + stats.missing <= stats.codepoints,
+                 name + ": glyph counts don't add up");
+    }
+}
+
+// Fallbacks are merged only for codepoints they have, and a codepoint no
+// file has neither merges them all nor reads them again
+static void CheckGlyphs(Bench& b) {
+    const std::string what = "overlay/glyphs/check: ";
+    const std::string dir = WWS_BENCH_FONT_DIR;
+    HeadlessContext ctx;
+    // ProggyClean is ASCII only; DroidSans has Cyrillic
+    GlyphCache glyphs({ dir + "/ProggyClean.ttf", dir + "/missing.ttf", dir + "/Karla-Regular.ttf",
+                        dir + "/DroidSans.ttf" });
+    glyphs.Attach();
+    const GlyphCache::Stats start = glyphs.GetStats();
+
+    glyphs.Prepare("\xE4\xB8\x80");   // U+4E00, in none of them
+    GlyphCache::Stats s = glyphs.GetStats();
+    b.Expect(s.missing == 1 && s.fonts == start.fonts, what + "a codepoint no file has merged fallbacks");
+    b.Expect(s.fallbacksRead == 2 && s.heldBytes > 0, what + "fallbacks not read for their cmaps");
+
+    glyphs.Prepare("\xE4\xB8\x81");   // U+4E01, the same again
+    const GlyphCache::Stats again = glyphs.GetStats();
+    b.Expect(again.fallbacksRead == 2 && again.missing == 2 && again.fonts == start.fonts,
+             what + "a second miss read the fallbacks again");
+
+    glyphs.Prepare("\xD0\x96");        // U+0416, Cyrillic Zhe
+    s = glyphs.GetStats();
+    b.Expect(s.fonts == start.fonts + 1 && s.rasterized == 1 && glyphs.Font()->IsGlyphInFont(0x416),
+             what + "the fallback that has a codepoint was not merged for it");
+    b.Expect(s.heldBytes < again.heldBytes, what + "a merged fallback still counted as held");
+    glyphs.Detach();
+    b.Expect(glyphs.GetStats().heldBytes == 0, what + "Detach() kept unmerged fallbacks");
+}
+
+// --- display text ---
+
+// One code point at a time, the obvious way, to hold Utf8FromWide() to
+static std::string ReferenceUtf8(const std::wstring& w) {
+    std::string out;
+    for (size_t i = 0; i < w.size(); ++i) {
+        uint32_t c = (uint32_t)w[i];
+        if (sizeof(wchar_t) == 2 && c >= 0xD800 && c < 0xDC00 && i + 1 < w.size() &&
+            (uint32_t)w[i + 1] >= 0xDC00 && (uint32_t)w[i + 1] < 0xE000)
+        {
+            c = 0x10000 + ((c - 0xD800) << 10) + ((uint32_t)w[i + 1] - 0xDC00);
+            ++i;
+        }
+        AppendUtf8(out, c);
+    }
+    return out;
+}
+
+// Runs of one encoded length with the odd other unit, surrogates (paired
+// and not) included, so SIMD blocks start and end everywhere
+static std::vector<std::wstring> FuzzWide(size_t count) {
+    std::mt19937 rng(7);
+    std::vector<std::wstring> out(count);
+    for (std::wstring& w : out) {
+        const size_t len = rng() % 40;
+        const int run = (int)(rng() % 4);
+        while (w.size() < len) {
+            const int kind = rng() % 8 == 0 ? (int)(rng() % 6) : run;
+            switch (kind) {
+            case 0: w += (wchar_t)(0x20 + rng() % 0x5F); break;
+            case 1: w += (wchar_t)(0x80 + rng() % 0x780); break;
+            case 2: w += (wchar_t)(0x800 + rng() % 0xD000); break;
+            case 3: w += (wchar_t)(0xE000 + rng() % 0x2000); break;
+            case 4: {
+                const uint32_t c = 0x10000 + rng() % 0x100000;
+                if (sizeof(wchar_t) == 2) {
+                    w += (wchar_t)(0xD800 + ((c - 0x10000) >> 10));
+                    w += (wchar_t)(0xDC00 + (c & 0x3FF));
+                }
+                else {
+                    w += (wchar_t)c;
+                }
+                break;
+            }
+            default: w += (wchar_t)(0xD800 + rng() % 0x800); break;   // lone
+            }
+        }
+    }
+    return out;
+}
+
+static void CheckText(Bench& b) {
+    const std::vector<std::wstring>& corpus = RealWorldTitles();
+    std::vector<std::wstring> inputs = FuzzWide(2000);
+    inputs.insert(inputs.end(), corpus.begin(), corpus.end());
+    bool same = true, roundTrip = true;
+    std::string buf;
+    for (const std::wstring& w : inputs) {
+        const std::string want = ReferenceUtf8(w);
+        buf.resize(w.size() * kUtf8PerWide);
+        const size_t vec = Utf8FromWide(w.data(), w.size(), &buf[0], true);
+        same = same && std::string_view(buf.data(), vec) == want;
+        const size_t plain = Utf8FromWide(w.data(), w.size(), &buf[0], false);
+        same = same && std::string_view(buf.data(), plain) == want;
+        std::string appended = "x";
+        AppendUtf8(appended, w);
+        same = same && appended == "x" + want;
+    }
+    for (const std::wstring& w : corpus) {
+        const std::string u = ReferenceUtf8(w);
+        roundTrip = roundTrip && WideFromUtf8(u.data(), u.size()) == w;
+    }
+    b.Expect(same, "overlay/text: the SSE2 or scalar transcoder disagrees with the reference");
+    b.Expect(roundTrip, "overlay/text: a real-world title doesn't survive UTF-8 and back");
+
+    HeadlessContext ctx;
+    GlyphCache glyphs(BenchFonts());
+    glyphs.Attach();
+    WindowSnapshot windows;
+    for (size_t i = 0; i < corpus.size(); ++i)
+        windows.Add(WindowIdFor(i), corpus[i], PidFor(i));
+    glyphs.Prepare(windows);
+
+    ImGui::NewFrame();
+    // what is drawn fits, and one more character wouldn't have
+    bool fits = true, maximal = true, whole = true;
+    for (float width : { 40.0f, 150.0f, 300.0f, 2000.0f }) {
+        for (size_t i = 0; i < windows.Size(); ++i) {
+            const std::string_view text = windows.Display(i);
+            const TitleFit fit = FitTitle(text, width, kMaxTitle);
+            std::string shown(text.substr(0, fit.len));
+            if (!fit.cut) {
+                whole = whole && fit.len == text.size();
+                fits = fits && ImGui::CalcTextSize(shown.c_str()).x <= width + 1.0f;
+                continue;
+            }
+            whole = whole && fit.len < text.size() && ((unsigned char)text[fit.len] & 0xC0) != 0x80;
+            fits = fits && ImGui::CalcTextSize((shown + "...").c_str()).x <= width + 1.0f;
+            const char* next = text.data() + fit.len;
+            DecodeUtf8(next, text.data() + text.size());
+            const std::string longer(text.data(), next);
+            maximal = maximal && ImGui::CalcTextSize((longer + "...").c_str()).x > width - 1.0f;
+        }
+    }
+    const std::string longAscii(300, 'i');
+    const TitleFit capped = FitTitle(longAscii, 1e6f, 10);
+    b.Expect(fits, "overlay/text: a title cut to a width is wider than it");
+    b.Expect(maximal, "overlay/text: a title was cut shorter than its width needs");
+    b.Expect(whole, "overlay/text: a title was cut that fits, or inside a character");
+    b.Expect(capped.cut && capped.len == 7, "overlay/text: maxChars no longer caps a title");
+
+    // measured once per row, again only when what it depends on changes
+    TitleFitCache cache;
+    auto pass = [&](const WindowSnapshot& w, float width) {
+        for (uint32_t i = 0; i < (uint32_t)w.Size(); ++i)
+            cache.Get(w, i, width, kMaxTitle);
+        return cache.Measured();
+    };
+    const size_t rows = windows.Size();
+    const bool first = pass(windows, 300.0f) == rows;
+    const bool again = pass(windows, 300.0f) == rows;
+    const bool widened = pass(windows, 320.0f) == rows * 2;
+    ImGui::PushFont(nullptr, ImGui::GetFontSize() + 4.0f);
+    const bool resized = pass(windows, 320.0f) == rows * 3;
+    ImGui::PopFont();
+    WindowSnapshot refilled;
+    refilled.Add(WindowIdFor(0), corpus[0], PidFor(0));
+    refilled.Clear();
+    for (size_t i = 0; i < corpus.size(); ++i)
+        refilled.Add(WindowIdFor(i), corpus[i], PidFor(i));
+    const bool refill = pass(refilled, 320.0f) == rows * 4 && pass(refilled, 320.0f) == rows * 4;
+    ImGui::EndFrame();
+    glyphs.Detach();
+    b.Expect(first && again, "overlay/text: a cached title was measured again");
+    b.Expect(widened && resized, "overlay/text: a new width or font size didn't re-measure the titles");
+    b.Expect(refill, "overlay/text: a refilled snapshot reused the old one's cuts");
+}
+
+// The real-world corpus through each stage of a snapshot's display text:
+// transcoding, the "app - page" rule and cutting to the list's width
+static void BenchText(Bench& b) {
+    const std::vector<std::wstring>& corpus = RealWorldTitles();
+    size_t units = 0, bytes = 0;
+    for (const std::wstring& w : corpus) {
+        units += w.size();
+        bytes += ReferenceUtf8(w).size();
+    }
+    b.Metric("overlay/text/corpus", (double)corpus.size(), "titles");
+    b.Metric("overlay/text/corpus_bytes", (double)bytes, "bytes");
+
+    std::string buf(units * kUtf8PerWide, '\0');
+    for (bool vectorized : { true, false }) {
+        if (vectorized && !Utf8Vectorized())
+            continue;
+        const std::string name = std::string("overlay/text/transcode") + (vectorized ? "" : "/scalar");
+        if (!b.Wants(name))
+            continue;
+        auto run = [&] {
+            size_t at = 0;
+            for (const std::wstring& w : corpus)
+                at += Utf8FromWide(w.data(), w.size(), &buf[at], vectorized);
+            DoNotOptimize(at);
+        };
+        b.Run(name, run);
+        b.ExpectNoAllocs(name);
+        const int reps = b.Quick() ? 2000 : 20000;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < reps; ++i)
+            run();
+        b.Metric(name + "/throughput", (double)bytes * reps / (NsSince(t0) / 1e9) / 1e6, "MB/s");
+    }
+
+    // a snapshot's worth: transcoding into the arena plus "app - page"
+    WindowSnapshot windows;
+    auto fill = [&] {
+        windows.Clear();
+        for (size_t i = 0; i < corpus.size(); ++i)
+            windows.Add(WindowIdFor(i), corpus[i], PidFor(i));
+    };
+    fill();
+    b.Run("overlay/text/snapshot", fill);
+    b.ExpectNoAllocs("overlay/text/snapshot");
+
+    if (!b.Wants("overlay/text/fit/"))
+        return;
+    HeadlessContext ctx;
+    GlyphCache glyphs(BenchFonts());
+    glyphs.Attach();
+    glyphs.Prepare(windows);
+    ImGui::NewFrame();
+    b.Run("overlay/text/fit/measure", [&] {
+        for (size_t i = 0; i < windows.Size(); ++i)
+            DoNotOptimize(FitTitle(windows.Display(i), 380.0f, kMaxTitle).len);
+    });
+    TitleFitCache cache;
+    b.Run("overlay/text/fit/cached", [&] {
+        for (uint32_t i = 0; i < (uint32_t)windows.Size(); ++i)
+            DoNotOptimize(cache.Get(windows, i, 380.0f, kMaxTitle).len);
+    });
+    b.ExpectNoAllocs("overlay/text/fit/measure");
+    b.ExpectNoAllocs("overlay/text/fit/cached");
+    size_t cut = 0;
+    for (uint32_t i = 0; i < (uint32_t)windows.Size(); ++i)
+        cut += cache.Get(windows, i, 380.0f, kMaxTitle).cut;
+    b.Metric("overlay/text/fit/cut", (double)cut, "titles");
+    ImGui::EndFrame();
+    glyphs.Detach();
+}
+
+// --- software rendering ---
+
+static constexpr uint32_t kSoftClear = 0xFF000000u;   // gui.cpp's colour key
+
+// Pixels where a and b differ by more than tolerance in some channel
+static size_t PixelsOff(const SoftFramebuffer& a, const SoftFramebuffer& b, int tolerance) {
+    if (a.width != b.width || a.height != b.height)
+        return a.pixels.size() + b.pixels.size();
+    size_t off = 0;
+    for (size_t i = 0; i < a.pixels.size(); ++i) {
+        for (int shift = 0; shift < 24; shift += 8) {
+            int d = (int)((a.pixels[i] >> shift) & 0xFF) - (int)((b.pixels[i] >> shift) & 0xFF);
+            if (std::abs(d) > tolerance) {
+                ++off;
+                break;
+            }
+        }
+    }
+    return off;
+}
+
+// The overlay with n rows, drawn at 1080p into fb by a renderer of its
+// own; timed as name when a bench is given
+static void SoftOverlay(size_t n, int threads, bool fastPath, SoftFramebuffer& fb,
+                        Bench* b = nullptr, const std::string& name = std::string())
+{
+    WindowSnapshot windows;
+    MakeSnapshot(n, windows);
+    std::vector<uint32_t> rows(n);
+    std::iota(rows.begin(), rows.end(), 0u);
+
+    Headless<SoftRenderer> ctx(threads);
+    ctx.renderer.SetQuadFastPath(fastPath);
+    FakeIconProvider provider;
+    IconAtlas icons(16, 512, 512);
+    icons.SetProvider(&provider);
+    icons.Attach();
+    OverlayListState state;
+    state.selIndex = 3;
+    for (int i = 0; i < 3; ++i)
+        OverlayFrame(windows, rows, state, icons, ctx.renderer);   // fonts and icons settle
+
+    fb.Resize(1920, 1080);
+    auto draw = [&] {
+        fb.Clear(kSoftClear);
+        ctx.renderer.Render(ImGui::GetDrawData(), fb);
+    };
+    draw();
+    if (b) {
+        b->Run(name, draw);
+        const SoftRenderer::Stats& s = ctx.renderer.LastStats();
+        b->Metric(name + "/quads", (double)s.quads, "quads");
+        b->Metric(name + "/triangles", (double)s.triangles, "tris");
+        b->Metric(name + "/binned", (double)s.binned, "prim-tiles");
+    }
+    icons.Detach();
+}
+
+// A few shapes with known pixels: solid and blended rectangles (quads)
+// and an anti-aliased triangle, through one path or the other
+static void SoftShapes(bool fastPath, SoftFramebuffer& fb) {
+    Headless<SoftRenderer> ctx(1);
+    ctx.renderer.SetQuadFastPath(fastPath);
+    ImGui::NewFrame();
+    ImDrawList* dl = ImGui::GetForegroundDrawList();
+    dl->AddRectFilled(ImVec2(10, 10), ImVec2(50, 50), IM_COL32(255, 0, 0, 255));
+    dl->AddRectFilled(ImVec2(30, 30), ImVec2(70, 70), IM_COL32(0, 0, 255, 128));
+    dl->AddTriangleFilled(ImVec2(100, 10), ImVec2(180, 10), ImVec2(100, 90), IM_COL32(0, 255, 0, 255));
+    ImGui::Render();
+    fb.Resize(256, 128);
+    fb.Clear(kSoftClear);
+    ctx.renderer.Render(ImGui::GetDrawData(), fb);
+}
+
+static void BenchSoft(Bench& b) {
+    const size_t n = 200;
+    const int cores = (int)std::max(1u, std::thread::hardware_concurrency());
+    SoftFramebuffer fb;
+    if (b.Wants("overlay/soft/frame/")) {
+        SoftOverlay(n, 1, true, fb, &b, "overlay/soft/frame/1080p_1_thread");
+        if (cores > 1)
+            SoftOverlay(n, cores, true, fb, &b, "overlay/soft/frame/1080p_" + std::to_string(cores) + "_threads");
+        SoftOverlay(n, 1, false, fb, &b, "overlay/soft/frame/1080p_triangles_only");
+    }
+
+    if (!b.Wants("overlay/soft/check"))
+        return;
+
+    // known pixels, on both paths
+    for (bool fastPath : { true, false }) {
+        SoftShapes(fastPath, fb);
+        const std::string what = fastPath ? "overlay/soft: shapes: " : "overlay/soft: shapes (triangles only): ";
+        b.Expect(fb.At(10, 10) == 0xFFFF0000u && fb.At(49, 20) == 0xFFFF0000u, what + "solid rectangle");
+        b.Expect(fb.At(9, 20) == kSoftClear && fb.At(50, 20) == kSoftClear && fb.At(20, 50) == kSoftClear,
+                 what + "rectangle edges");
+        b.Expect(fb.At(40, 40) == 0xFF7F0080u, what + "blend over red");
+        b.Expect(fb.At(60, 60) == 0xFF000080u, what + "blend over the clear colour");
+        b.Expect(fb.At(110, 20) == 0xFF00FF00u, what + "triangle inside");
+        b.Expect(fb.At(170, 80) == kSoftClear, what + "triangle outside");
+        uint32_t edge = fb.At(139, 50);   // centre on the hypotenuse: half covered
+        b.Expect(edge != kSoftClear && edge != 0xFF00FF00u, what + "anti-aliased edge");
+    }
+
+    // the tile threads each fill their own pixels: any count gives the same image
+    SoftFramebuffer one, several, triangles;
+    SoftOverlay(n, 1, true, one);
+    SoftOverlay(n, 3, true, several);
+    SoftOverlay(n, 1, false, triangles);
+    size_t drawn = 0;
+    for (uint32_t px : one.pixels)
+        drawn += px != kSoftClear;
+    b.Metric("overlay/soft/check/drawn", (double)drawn, "pixels");
+    b.Expect(drawn > 10000, "overlay/soft: the overlay frame is (nearly) empty");
+    b.Expect(PixelsOff(one, several, 0) == 0, "overlay/soft: frame differs with 3 tile threads");
+    // the same coverage; a texel boundary exactly on a pixel centre may round either way
+    const size_t off = PixelsOff(one, triangles, 2);
+    b.Metric("overlay/soft/check/fast_path_off", (double)off, "pixels");
+    b.Expect(off <= one.pixels.size() / 1000, "overlay/soft: quad fast path and triangles disagree");
+
+    if (b.Options().goldenDir.empty())
+        return;
+    // compared with a tolerance: another compiler may round a uv differently
+    const std::string golden = b.Options().goldenDir + "/overlay_200_1080p.ppm";
+    SoftFramebuffer expected;
+    if (!expected.ReadPpm(golden)) {
+        std::error_code ec;
+        std::filesystem::create_directories(b.Options().goldenDir, ec);
+        b.Expect(one.WritePpm(golden), "overlay/soft: cannot write " + golden);
+        return;
+    }
+    const size_t wrong = PixelsOff(one, expected, 8);
+    b.Metric("overlay/soft/check/golden_off", (double)wrong, "pixels");
+    if (wrong > one.pixels.size() / 1000) {
+        const std::string actual = b.Options().goldenDir + "/overlay_200_1080p.actual.ppm";
+        one.WritePpm(actual);
+        b.Expect(false, "overlay/soft: frame doesn't match " + golden + " (see " + actual + ")");
+    }
+}
+
+// --- steady state ---
+
+// The overlay path as gui.cpp drives it, against a registry and process
+// cache that are already warm. Once the buffers have grown none of it may
+// allocate; a benchmark here that does fails the run.
+static void BenchSteady(Bench& b) {
+    const size_t n = b.Quick() ? 200 : 1000;
+    FakeProcessInfoProvider provider;
+    AddProcesses(provider);
+    ProcessCache cache;
+    cache.Start(provider);
+
+    WindowRegistry registry;
+    FakeWindowEventSource source;
+    source.Start(registry);
+    const std::vector<std::wstring> titles = MakeTitles(n);
+    for (size_t i = 0; i < n; ++i) {
+        source.Create(WindowIdFor(i), titles[i], PidFor(i));
+        source.Focus(WindowIdFor(i));
+    }
+
+    // first show queues the fetches; wait until every row resolves
+    OverlayModel model;
+    auto resolved = [&] {
+        const WindowSnapshot& w = model.Windows();
+        for (size_t i = 0; i < w.Size(); ++i)
+            if (!w.Process(i))
+                return false;
+        return true;
+    };
+    model.Show(registry, cache);
+    for (int i = 0; i < 1000 && !resolved(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        model.ResolveProcesses(cache);
+    }
+
+    b.Run("overlay/steady/show", [&] { model.Show(registry, cache); });
+    b.Run("overlay/steady/cycle", [&] { model.Advance(); });
+
+    // typing a query and deleting it again, one keystroke per op
+    const std::wstring typed = L"pull req chrome";
+    size_t key = 0;
+    auto keystroke = [&] {
+        model.Input(key < typed.size() ? typed[key] : L'\b');
+        key = (key + 1) % (typed.size() * 2);
+    };
+    for (size_t i = 0; i < typed.size() * 2; ++i)
+        keystroke();
+    b.Run("overlay/steady/type", keystroke);
+    while (!model.Query().empty())
+        model.Input(L'\b');
+
+    if (b.Wants("overlay/steady/frame")) {
+        HeadlessContext ctx;
+        FakeIconProvider icons;
+        IconAtlas atlas(16, 512, 512);
+        atlas.SetProvider(&icons);
+        atlas.Attach();
+        TitleFitCache fits;
+        auto frame = [&] {
+            model.Advance();
+            model.ResolveProcesses(cache);
+            OverlayFrame(model.Windows(), model.Rows(), model.List(), atlas, ctx.renderer, &fits);
+        };
+        // once around the list, so ImGui's buffers have seen every row
+        for (size_t i = 0; i < n; ++i)
+            frame();
+        b.Run("overlay/steady/frame", frame);
+        atlas.Detach();
+    }
+
+    for (const char* name : { "overlay/steady/show", "overlay/steady/cycle",
+                              "overlay/steady/type", "overlay/steady/frame" })
+        b.ExpectNoAllocs(name);
+    b.Metric("overlay/steady/arena", (double)model.Windows().ArenaSize(), "bytes");
+    cache.Stop();
+}
+
+// --- slow applications ---
+
+// The overlay over 200 windows whose processes answer slowly (5 ms each),
+// two of them not at all, and likewise for icon extraction: the overlay
+// has to show within a frame and keep drawing at frame rate while the
+// rest fills in, the hung ones included once they return
+static void BenchSlowApps(Bench& b) {
+    const double budgetNs = 1e9 / 60.0;   // one frame at 60 Hz
+    const size_t n = 200;
+    std::vector<uint32_t> pids;
+    for (size_t i = 0; i < n; ++i)
+        if (std::find(pids.begin(), pids.end(), PidFor(i)) == pids.end())
+            pids.push_back(PidFor(i));
+    const uint32_t hungPids[2] = { PidFor(0), PidFor(1) };
+    const std::wstring hungIcons[2] = { ExePathFor(2), ExePathFor(3) };
+
+    FakeProcessInfoProvider processes;
+    AddProcesses(processes);
+    FakeIconProvider iconProvider;
+    for (size_t a = 0; a < pids.size(); ++a) {
+        processes.SetDelay(PidFor(a), 5);
+        iconProvider.SetDelay(ExePathFor(a), 5);
+    }
+    for (uint32_t pid : hungPids)
+        processes.Hang(pid);
+    for (const std::wstring& path : hungIcons)
+        iconProvider.Hang(path);
+
+    ProcessCache cache;
+    cache.Start(processes);
+    FetchPool iconLoads;
+    iconLoads.Start();
+
+    WindowRegistry registry;
+    FakeWindowEventSource source;
+    source.Start(registry);
+    const std::vector<std::wstring> titles = MakeTitles(n);
+    for (size_t i = 0; i < n; ++i) {
+        source.Create(WindowIdFor(i), titles[i], PidFor(i));
+        source.Focus(WindowIdFor(i));
+    }
+
+    HeadlessContext ctx;
+    IconAtlas atlas(16, 512, 512);
+    atlas.SetProvider(&iconProvider);
+    atlas.SetLoader(&iconLoads);
+    atlas.Attach();
+    OverlayModel model;
+    {
+        // a context that has drawn before, as in the app after its warm-up
+        WindowSnapshot none;
+        OverlayListState state;
+        OverlayFrame(none, {}, state, atlas, ctx.renderer);
+    }
+
+    auto resolved = [&](bool withHung) {
+        const WindowSnapshot& w = model.Windows();
+        for (size_t i = 0; i < w.Size(); ++i) {
+            const uint32_t pid = w.At(i).pid;
+            if (!w.Process(i) && (withHung || (pid != hungPids[0] && pid != hungPids[1])))
+                return false;
+        }
+        const size_t icons = pids.size() - (withHung ? 0 : 4);
+        return atlas.GetStats().entries >= icons;
+    };
+    std::vector<double> frames;
+    auto frame = [&] {
+        auto t0 = std::chrono::steady_clock::now();
+        model.ResolveProcesses(cache);
+        OverlayFrame(model.Windows(), model.Rows(), model.List(), atlas, ctx.renderer);
+        frames.push_back(NsSince(t0));
+    };
+    // frames until everything expected is there, for at most two seconds
+    auto fillIn = [&](bool withHung) {
+        auto t0 = std::chrono::steady_clock::now();
+        while (!resolved(withHung) && NsSince(t0) < 2e9) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            frame();
+        }
+        return resolved(withHung) ? NsSince(t0) : -1.0;
+    };
+
+    auto t0 = std::chrono::steady_clock::now();
+    model.Show(registry, cache);
+    OverlayFrame(model.Windows(), model.Rows(), model.List(), atlas, ctx.renderer);
+    const double first = NsSince(t0);
+    const double rest = fillIn(false);
+    const FetchPool::Stats pool = cache.PoolStats();
+    processes.Release();
+    iconProvider.Release();
+    const double late = fillIn(true);
+
+    b.Samples("overlay/slow/first_frame", { first });
+    b.Metric("overlay/slow/first_frame_rows", (double)model.Windows().Size(), "rows");
+    b.Samples("overlay/slow/frame", frames);
+    b.Metric("overlay/slow/fill_in", rest / 1e6, "ms");
+    b.Metric("overlay/slow/fill_in_after_release", late / 1e6, "ms");
+    b.Metric("overlay/slow/overdue_fetches", (double)(pool.overdue + iconLoads.GetStats().overdue), "jobs");
+    b.Metric("overlay/slow/peak_workers", (double)pool.peakWorkers, "threads");
+
+    const double worst = frames.empty() ? 0.0 : *std::max_element(frames.begin(), frames.end());
+    b.Expect(first < budgetNs, "overlay/slow: the first frame took longer than a frame at 60 Hz");
+    b.Expect(model.Windows().Size() == n, "overlay/slow: the first frame didn't list every window");
+    b.Expect(worst < budgetNs, "overlay/slow: a frame took longer than a frame at 60 Hz while filling in");
+    b.Expect(rest >= 0.0, "overlay/slow: rows of responsive apps waited on the hung ones");
+    b.Expect(pool.overdue >= 2 && pool.spawned >= 1, "overlay/slow: hung fetches weren't worked around");
+    b.Expect(late >= 0.0, "overlay/slow: hung apps never filled in after they answered");
+
+    cache.Stop();
+    iconLoads.Stop();
+    atlas.Detach();
+}
+
+// --- frame scheduling ---
+
+static void BenchScheduler(Bench& b) {
+    ManualClock clock(1000000000);
+    FrameScheduler sched(clock);
+    b.Run("overlay/scheduler/dirty_frame", [&] {
+        sched.MarkDirty(FrameReason_Selection);
+        if (sched.BeginFrame())
+            sched.EndFrame(true);
+        clock.AdvanceMs(1);
+    });
+    b.Run("overlay/scheduler/time_until_frame", [&] { DoNotOptimize(sched.TimeUntilFrameNs()); });
+}
+
+// The counters on a ManualClock: changes coalesce into one frame, an idle
+// scheduler neither asks for frames nor counts wakeups, and animation never
+// builds more frames than its rate allows
+static void CheckScheduler(Bench& b) {
+    const std::string what = "overlay/scheduler/check: ";
+    ManualClock clock(1000000000);
+    FrameScheduler sched(clock);
+    size_t wakes = 0;
+    sched.SetWakeCallback([&] { ++wakes; });
+
+    // many changes before the owner gets to it: one frame with all their reasons
+    {
+        const uint32_t reasons[] = { FrameReason_Selection, FrameReason_Snapshot, FrameReason_Selection,
+                                     FrameReason_Input, FrameReason_Resize, FrameReason_Settings };
+        for (uint32_t r : reasons)
+            sched.MarkDirty(r);
+        uint32_t got = 0;
+        const bool built = sched.BeginFrame(&got);
+        if (built)
+            sched.EndFrame(true);
+        b.Expect(built && got == (FrameReason_Selection | FrameReason_Snapshot | FrameReason_Input |
+                                  FrameReason_Resize | FrameReason_Settings),
+                 what + "6 changes did not build a frame with all their reasons");
+        b.Expect(!sched.BeginFrame(), what + "a second frame was built for the same changes");
+        b.Expect(sched.Totals().framesBuilt == 1 && wakes == 1,
+                 what + std::to_string(sched.Totals().framesBuilt) + " frames and " + std::to_string(wakes) +
+                 " wakes for 6 changes, instead of one each");
+    }
+
+    // idle: ten seconds of nothing, the owner looking every 10 ms as a
+    // message loop would, never finds a frame due or counts a wakeup
+    {
+        const uint64_t wakeups = sched.Totals().wakeups;
+        size_t due = 0;
+        for (int ms = 0; ms < 10000; ms += 10) {
+            clock.AdvanceMs(10);
+            due += sched.TimeUntilFrameNs() != FrameScheduler::kNever || sched.BeginFrame();
+        }
+        const FrameScheduler::Counters rates = sched.PerSecond();
+        b.Expect(due == 0, what + std::to_string(due) + " frames came due while idle");
+        b.Expect(sched.Totals().wakeups == wakeups && wakes == 1 && rates.wakeups == 0 && rates.framesBuilt == 0,
+                 what + "wakeups were counted while idle");
+    }
+
+    // animating at a capped rate for two seconds, the owner looking every
+    // millisecond: at most rate x seconds frames, and not many fewer
+    {
+        const int fps = 30, seconds = 2;
+        sched.SetAnimating(true, fps);
+        const uint64_t built = sched.Totals().framesBuilt;
+        for (int ms = 0; ms < seconds * 1000; ++ms) {
+            if (sched.TimeUntilFrameNs() == 0) {
+                sched.NoteWakeup();
+                if (sched.BeginFrame())
+                    sched.EndFrame(true);
+            }
+            clock.AdvanceMs(1);
+        }
+        sched.SetAnimating(false);
+        const uint64_t frames = sched.Totals().framesBuilt - built;
+        b.Metric("overlay/scheduler/check_animated_frames", (double)frames, "frames");
+        b.Expect(frames <= (uint64_t)(fps * seconds),
+                 what + std::to_string(frames) + " frames in " + std::to_string(seconds) + " s at " +
+                 std::to_string(fps) + " fps");
+        b.Expect(frames >= (uint64_t)(fps * seconds * 9 / 10),
+                 what + "only " + std::to_string(frames) + " frames in " + std::to_string(seconds) + " s at " +
+                 std::to_string(fps) + " fps");
+        b.Expect(sched.TimeUntilFrameNs() == FrameScheduler::kNever, what + "frames still due after animation stopped");
+    }
+}
+
+// --- resident mode ---
+
+// Shows as gui.cpp runs them with overlayIdleReleaseMs set, on the CPU
+// renderer: cold ones create the context, fonts and framebuffer first and
+// release them after; warm ones find them up. The working set is sampled
+// with nothing up, with a show up and after the release.
+static void BenchLifetime(Bench& b) {
+    if (b.Wants("overlay/lifetime/show")) {
+        const size_t n = 200;
+        WindowSnapshot windows;
+        MakeSnapshot(n, windows);
+        std::vector<uint32_t> rows(n);
+        std::iota(rows.begin(), rows.end(), 0u);
+        FakeIconProvider provider;
+        const int rounds = b.Quick() ? 3 : 10;
+        OverlayLifetime lifetime;
+        lifetime.SetIdleRelease(1);
+        std::vector<double> cold, warm;
+        size_t resident = 0, up = 0, released = 0;
+
+        for (int r = 0; r < rounds; ++r) {
+            if (r == 0)
+                resident = ProcessWorkingSetBytes();
+            auto t0 = std::chrono::steady_clock::now();
+            lifetime.ShowRequested();
+            auto ctx = std::make_unique<Headless<SoftRenderer>>(1);
+            GlyphCache glyphs(BenchFonts());
+            glyphs.Attach();
+            IconAtlas icons(16, 512, 512);
+            icons.SetProvider(&provider);
+            icons.Attach();
+            SoftFramebuffer fb;
+            lifetime.Created(NsSince(t0), false, 0);
+            OverlayListState state;
+            auto show = [&] {
+                glyphs.Prepare(windows);
+                OverlayFrame(windows, rows, state, icons, ctx->renderer);
+                fb.Resize(1920, 1080);
+                fb.Clear(kSoftClear);
+                ctx->renderer.Render(ImGui::GetDrawData(), fb);
+                lifetime.Presented();
+            };
+            show();
+            cold.push_back(NsSince(t0));
+            lifetime.Hidden();
+
+            t0 = std::chrono::steady_clock::now();
+            lifetime.ShowRequested();
+            show();
+            warm.push_back(NsSince(t0));
+            lifetime.Hidden();
+            if (r == 0)
+                up = ProcessWorkingSetBytes();
+
+            icons.Detach();
+            glyphs.Detach();
+            ctx.reset();
+            fb = SoftFramebuffer();
+            lifetime.Released(0);
+            if (r == 0)
+                released = ProcessWorkingSetBytes();
+        }
+        const OverlayLifetime::Stats stats = lifetime.GetStats();
+        b.Samples("overlay/lifetime/show/cold", std::move(cold));
+        b.Samples("overlay/lifetime/show/warm", std::move(warm));
+        b.Metric("overlay/lifetime/show/create", stats.create.MeanMs(), "ms");
+        b.Metric("overlay/lifetime/show/working_set_resident", (double)resident, "bytes");
+        b.Metric("overlay/lifetime/show/working_set_up", (double)up, "bytes");
+        b.Metric("overlay/lifetime/show/working_set_released", (double)released, "bytes");
+        b.Expect(stats.cold.count == (uint64_t)rounds && stats.warm.count == (uint64_t)rounds,
+                 "overlay/lifetime: shows weren't counted as cold and warm");
+    }
+
+    if (!b.Wants("overlay/lifetime/check"))
+        return;
+    ManualClock clock(1000000000);
+    OverlayLifetime life(clock);
+    const uint64_t ms = 1000000;
+
+    // kept for good without an idle release
+    life.Created(5 * ms, false, 0);
+    clock.AdvanceMs(3600 * 1000);
+    b.Expect(!life.ShouldRelease() && life.TimeUntilReleaseNs() == OverlayLifetime::kNever,
+             "overlay/lifetime: released without an idle release set");
+
+    // idle period, restarted by use
+    life.SetIdleRelease(1000);
+    life.Used();
+    b.Expect(life.TimeUntilReleaseNs() == 1000 * ms, "overlay/lifetime: wrong time until release");
+    clock.AdvanceMs(999);
+    b.Expect(!life.ShouldRelease(), "overlay/lifetime: released before the idle period");
+    life.Used();
+    clock.AdvanceMs(999);
+    b.Expect(!life.ShouldRelease(), "overlay/lifetime: use didn't restart the idle period");
+    clock.AdvanceMs(1);
+    b.Expect(life.ShouldRelease(), "overlay/lifetime: not released after the idle period");
+
+    // never while shown; a warm show's latency runs to the first present
+    life.ShowRequested();
+    clock.AdvanceMs(3);
+    life.Presented();
+    clock.AdvanceMs(5000);
+    b.Expect(!life.ShouldRelease(), "overlay/lifetime: released while shown");
+    life.Presented();
+    life.Hidden();
+    b.Expect(life.TimeUntilReleaseNs() == 1000 * ms, "overlay/lifetime: hiding didn't start the idle period");
+    OverlayLifetime::Stats s = life.GetStats();
+    b.Expect(s.warm.count == 1 && s.warm.lastNs == 3 * ms && s.cold.count == 0,
+             "overlay/lifetime: warm show latency");
+
+    // a cold show waits for the resources
+    clock.AdvanceMs(1000);
+    life.Released(0);
+    b.Expect(!life.Alive() && life.TimeUntilReleaseNs() == OverlayLifetime::kNever,
+             "overlay/lifetime: released resources still due for release");
+    life.ShowRequested();
+    clock.AdvanceMs(30);
+    life.Created(30 * ms, false, 0);
+    clock.AdvanceMs(10);
+    life.Presented();
+    life.Hidden();
+    s = life.GetStats();
+    b.Expect(s.cold.count == 1 && s.cold.lastNs == 40 * ms, "overlay/lifetime: cold show latency");
+
+    // a warm-up a show then uses makes that show warm; one it doesn't is wasted
+    clock.AdvanceMs(1000);
+    life.Released(0);
+    life.Created(30 * ms, true, 0);
+    life.ShowRequested();
+    life.Presented();
+    life.Hidden();
+    clock.AdvanceMs(1000);
+    life.Released(0);
+    life.Created(30 * ms, true, 0);
+    clock.AdvanceMs(1000);
+    b.Expect(life.ShouldRelease(), "overlay/lifetime: an unused warm-up is never released");
+    life.Released(0);
+    s = life.GetStats();
+    b.Expect(s.speculative == 2 && s.speculativeUsed == 1 && s.warm.count == 2 && s.cold.count == 1,
+             "overlay/lifetime: warm-ups miscounted");
+
+    // hidden before anything was presented: no latency
+    life.Created(30 * ms, false, 0);
+    life.ShowRequested();
+    life.Hidden();
+    life.Presented();
+    s = life.GetStats();
+    b.Expect(s.warm.count == 2 && s.creates == 5 && s.releases == 4,
+             "overlay/lifetime: a show hidden before its first frame was counted");
+}
+
+// --- thumbnails ---
+
+// A smooth RGBA gradient with every channel moving, alpha included
+static void GradientImage(int w, int h, std::vector<uint32_t>& out) {
+    out.resize((size_t)w * h);
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            const uint32_t r = (uint32_t)(x * 255 / std::max(1, w - 1));
+            const uint32_t g = (uint32_t)(y * 255 / std::max(1, h - 1));
+            const uint32_t bl = (r + g) / 2;
+            const uint32_t a = 255 - g / 4;
+            out[(size_t)y * w + x] = r | g << 8 | bl << 16 | a << 24;
+        }
+    }
+}
+
+// Largest channel difference from the area average each output pixel
+// covers, in doubles
+static int WorstAgainstArea(const std::vector<uint32_t>& src, int srcW, int srcH,
+                            const std::vector<uint32_t>& dst, int dstW, int dstH)
+{
+    int worst = 0;
+    for (int y = 0; y < dstH; ++y) {
+        const int y0 = y * srcH / dstH, y1 = std::max(y0 + 1, (y + 1) * srcH / dstH);
+        for (int x = 0; x < dstW; ++x) {
+            const int x0 = x * srcW / dstW, x1 = std::max(x0 + 1, (x + 1) * srcW / dstW);
+            for (int ch = 0; ch < 32; ch += 8) {
+                double sum = 0.0;
+                for (int sy = y0; sy < y1; ++sy)
+                    for (int sx = x0; sx < x1; ++sx)
+                        sum += (double)((src[(size_t)sy * srcW + sx] >> ch) & 0xFF);
+                const double want = sum / (double)((y1 - y0) * (x1 - x0));
+                const int got = (int)((dst[(size_t)y * dstW + x] >> ch) & 0xFF);
+                worst = std::max(worst, (int)std::lround(std::fabs(want - got)));
+            }
+        }
+    }
+    return worst;
+}
+
+// Same layout as the overlay's strip in gui.cpp, on its own
+template <class Renderer>
+static void ThumbnailFrame(const WindowSnapshot& windows, const std::vector<uint32_t>& rows, int selIndex,
+                           ThumbnailCache& thumbs, Renderer& renderer)
+{
+    ImGui::NewFrame();
+    thumbs.NewFrame();
+    ImGui::SetNextWindowPos(ImVec2(300.0f, 100.0f));
+    ImGui::SetNextWindowSize(ImVec2(640.0f, 200.0f));
+    ImGui::Begin("Overlay", nullptr,
+        ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove |
+        ImGuiWindowFlags_NoBackground | ImGuiWindowFlags_NoScrollbar);
+    DrawThumbnailStrip("##Thumbs", windows, rows, selIndex, thumbs, 2, 620.0f);
+    ImGui::End();
+    ImGui::Render();
+    renderer.Update();
+}
+
+static void CheckDownscale(Bench& b) {
+    DownscaleScratch scratch;
+    const int sizes[][2] = { { 3840, 2160 }, { 1920, 1080 }, { 1366, 768 }, { 333, 777 },
+                             { 2000, 3 }, { 161, 101 }, { 7, 5 }, { 5000, 40 } };
+    bool same = true, inside = true, close = true, solid = true;
+    int worst = 0;
+    std::vector<uint32_t> src, vec, plain;
+    for (const auto& sz : sizes) {
+        const int w = sz[0], h = sz[1];
+        int dw, dh;
+        FitWithin(w, h, 160, 100, dw, dh);
+        GradientImage(w, h, src);
+
+        // written into the middle of a bigger buffer, like a cell of the
+        // atlas: nothing around it may change
+        const int stride = dw + 3;
+        const uint32_t guard = 0x5A5A5A5Au;
+        vec.assign((size_t)stride * (dh + 2), guard);
+        plain.assign(vec.size(), guard);
+        DownscaleRgba(src.data(), w, h, (size_t)w, vec.data() + stride + 1, dw, dh, (size_t)stride, scratch, true);
+        DownscaleRgba(src.data(), w, h, (size_t)w, plain.data() + stride + 1, dw, dh, (size_t)stride, scratch, false);
+        same = same && vec == plain;
+        std::vector<uint32_t> packed((size_t)dw * dh);
+        for (int y = 0; y < dh + 2; ++y) {
+            for (int x = 0; x < stride; ++x) {
+                const bool cell = y >= 1 && y <= dh && x >= 1 && x <= dw;
+                const uint32_t px = vec[(size_t)y * stride + x];
+                if (cell)
+                    packed[(size_t)(y - 1) * dw + (x - 1)] = px;
+                else
+                    inside = inside && px == guard;
+            }
+        }
+        const int off = WorstAgainstArea(src, w, h, packed, dw, dh);
+        worst = std::max(worst, off);
+        close = close && off <= 4;
+
+        std::vector<uint32_t> flat((size_t)w * h, 0x80C0FF20u);
+        std::vector<uint32_t> out((size_t)dw * dh);
+        DownscaleRgba(flat.data(), w, h, (size_t)w, out.data(), dw, dh, (size_t)dw, scratch);
+        solid = solid && std::all_of(out.begin(), out.end(), [](uint32_t px) { return px == 0x80C0FF20u; });
+    }
+    b.Metric("overlay/thumbs/downscale/worst_error", (double)worst, "levels");
+    b.Expect(same, "overlay/thumbs: the SSE2 and scalar downscalers disagree");
+    b.Expect(inside, "overlay/thumbs: a downscale wrote outside its rectangle");
+    b.Expect(close, "overlay/thumbs: a downscale strayed from the area average");
+    b.Expect(solid, "overlay/thumbs: a solid colour didn't stay exact");
+    b.Expect(scratch.Bytes() < 64 * 1024, "overlay/thumbs: downscaling a 5000 px wide window kept more than rows");
+}
+
+static void BenchDownscale(Bench& b) {
+    // the sizes a thumbnail is usually made from, to a 160 x 100 cell
+    const int sizes[][2] = { { 1920, 1080 }, { 3840, 2160 } };
+    for (const auto& sz : sizes) {
+        const int w = sz[0], h = sz[1];
+        std::vector<uint32_t> src;
+        GradientImage(w, h, src);
+        int dw, dh;
+        FitWithin(w, h, 160, 100, dw, dh);
+        std::vector<uint32_t> dst((size_t)dw * dh);
+        DownscaleScratch scratch;
+        for (bool vectorized : { true, false }) {
+            if (vectorized && !DownscaleVectorized())
+                continue;
+            const std::string name = "overlay/thumbs/downscale/" + std::to_string(h) + "p" +
+                                     (vectorized ? "" : "/scalar");
+            if (!b.Wants(name))
+                continue;
+            auto run = [&] {
+                DownscaleRgba(src.data(), w, h, (size_t)w, dst.data(), dw, dh, (size_t)dw, scratch, vectorized);
+                DoNotOptimize(dst[0]);
+            };
+            run();   // scratch grows once
+            b.Run(name, run);
+            b.ExpectNoAllocs(name);
+            const int reps = b.Quick() ? 10 : 60;
+            auto t0 = std::chrono::steady_clock::now();
+            for (int i = 0; i < reps; ++i)
+                run();
+            const double secs = NsSince(t0) / 1e9;
+            b.Metric(name + "/throughput", (double)w * h * reps / secs / 1e6, "MP/s");
+        }
+    }
+}
+
+static void CheckThumbnails(Bench& b) {
+    HeadlessContext ctx;
+    const size_t n = 200;
+    WindowSnapshot windows;
+    MakeSnapshot(n, windows);
+    std::vector<uint32_t> rows(n);
+    std::iota(rows.begin(), rows.end(), 0u);
+    const int sizes[][2] = { { 640, 400 }, { 1920, 1080 }, { 3840, 2160 }, { 1280, 1024 }, { 300, 900 } };
+    FakeThumbnailSource source;
+    for (size_t i = 0; i < n; ++i)
+        source.SetSize(windows.At(i).id, sizes[i % 5][0], sizes[i % 5][1]);
+
+    // memory ceiling: walking a long list of big windows keeps evicting,
+    // captures included nothing ever goes over the budget, and windows too
+    // big for the capture share go without
+    {
+        const size_t budget = 4u << 20;
+        ManualClock clock(1);
+        ThumbnailCache thumbs(160, 100, budget, 3u << 20, clock);
+        thumbs.SetSource(&source);
+        thumbs.SetRefresh(0);
+        thumbs.Attach();
+        size_t over = 0, peak = 0;
+        int sel = 0;
+        for (int frame = 0; frame < 400; ++frame) {
+            sel = (sel + 3) % (int)n;
+            ThumbnailFrame(windows, rows, sel, thumbs, ctx.renderer);
+            const ThumbnailCache::Stats s = thumbs.GetStats();
+            peak = std::max(peak, s.peakBytes);
+            over += s.peakBytes > budget;
+        }
+        const ThumbnailCache::Stats s = thumbs.GetStats();
+        b.Metric("overlay/thumbs/ceiling/peak_retained", (double)peak, "bytes");
+        b.Metric("overlay/thumbs/ceiling/budget", (double)budget, "bytes");
+        b.Metric("overlay/thumbs/ceiling/slots", (double)s.slots, "cells");
+        b.Metric("overlay/thumbs/ceiling/largest_capture", (double)s.largestCapture, "bytes");
+        b.Metric("overlay/thumbs/ceiling/evictions", (double)s.evictions, "thumbs");
+        b.Metric("overlay/thumbs/ceiling/oversized", (double)s.oversized, "windows");
+        b.Expect(over == 0, "overlay/thumbs: the cache went over its memory budget");
+        b.Expect(s.oversized > 0 && s.largestCapture <= (3u << 20),
+                 "overlay/thumbs: a capture bigger than its share was made");
+        b.Expect(s.evictions > 0 && s.entries <= s.slots, "overlay/thumbs: a full cache didn't evict");
+        b.Expect(s.captures > s.slots, "overlay/thumbs: walking the list didn't capture new windows");
+        thumbs.Detach();
+    }
+
+    // lazy: only what is drawn is captured, twice per frame at most, and
+    // again once stale
+    {
+        ManualClock clock(1);
+        ThumbnailCache thumbs(160, 100, 4u << 20, 3u << 20, clock);
+        FakeThumbnailSource lazy;
+        thumbs.SetSource(&lazy);
+        thumbs.SetRefresh(1000);
+        thumbs.Attach();
+        ThumbnailFrame(windows, rows, 0, thumbs, ctx.renderer);   // rows 0..2
+        const bool budgeted = lazy.Captures() == 2 && thumbs.Pending();
+        for (int i = 0; i < 5; ++i)
+            ThumbnailFrame(windows, rows, 0, thumbs, ctx.renderer);
+        const size_t settled = lazy.Captures();
+        clock.AdvanceMs(999);
+        ThumbnailFrame(windows, rows, 0, thumbs, ctx.renderer);
+        const size_t early = lazy.Captures();
+        clock.AdvanceMs(1);
+        for (int i = 0; i < 3; ++i)
+            ThumbnailFrame(windows, rows, 0, thumbs, ctx.renderer);
+        const ThumbnailCache::Stats s = thumbs.GetStats();
+        b.Expect(budgeted, "overlay/thumbs: the first frame went over its capture budget");
+        b.Expect(settled == 3 && !thumbs.Pending(), "overlay/thumbs: windows off screen were captured");
+        b.Expect(early == settled, "overlay/thumbs: a thumbnail was captured again before it was stale");
+        b.Expect(lazy.Captures() == 6 && s.refreshes == 3, "overlay/thumbs: stale thumbnails weren't captured again");
+
+        // a window that can't be captured is asked again only once stale
+        lazy.SetMissing(windows.At(rows[10]).id);
+        ThumbnailFrame(windows, rows, 10, thumbs, ctx.renderer);
+        ThumbnailFrame(windows, rows, 10, thumbs, ctx.renderer);
+        ThumbnailFrame(windows, rows, 10, thumbs, ctx.renderer);
+        ImVec2 uv0, uv1, size;
+        const bool none = !thumbs.Get(windows.At(rows[10]).id, uv0, uv1, size);
+        b.Expect(none && thumbs.GetStats().failures == 1, "overlay/thumbs: a failed capture was retried every frame");
+        thumbs.Detach();
+    }
+
+    // eviction: a full cache takes the least recently drawn cell, never
+    // one drawn this frame
+    {
+        ManualClock clock(1);
+        const size_t cell = (size_t)(160 + 1) * (100 + 1) * 4;
+        const size_t room = 40u << 20;   // a 4K capture
+        const size_t budget = room + ThumbnailCache::kMaxInFlight * 160 * 100 * 4 + 64 * 1024 + 4 * cell;
+        ThumbnailCache thumbs(160, 100, budget, room, clock);
+        thumbs.SetSource(&source);
+        thumbs.SetCaptureBudget(100);
+        thumbs.SetRefresh(0);
+        thumbs.Attach();
+        ImVec2 uv0, uv1, size;
+        auto id = [&](size_t i) { return windows.At(i).id; };
+        thumbs.NewFrame();
+        for (size_t i = 0; i < 4; ++i)
+            thumbs.Get(id(i), uv0, uv1, size);
+        const bool sized = thumbs.Slots() == 4 && thumbs.GetStats().entries == 4;
+        const bool spared = !thumbs.Get(id(4), uv0, uv1, size) && thumbs.GetStats().evictions == 0;
+        thumbs.NewFrame();
+        thumbs.Get(id(1), uv0, uv1, size);
+        thumbs.Get(id(2), uv0, uv1, size);
+        thumbs.Get(id(3), uv0, uv1, size);
+        thumbs.NewFrame();
+        const bool taken = thumbs.Get(id(5), uv0, uv1, size);
+        const bool kept = thumbs.Get(id(1), uv0, uv1, size) && thumbs.Get(id(2), uv0, uv1, size) &&
+                          thumbs.Get(id(3), uv0, uv1, size);
+        const bool dropped = !thumbs.Get(id(0), uv0, uv1, size);
+        b.Expect(sized, "overlay/thumbs: the cell grid isn't what the budget allows");
+        b.Expect(spared, "overlay/thumbs: a thumbnail drawn this frame was evicted");
+        b.Expect(taken && kept && dropped, "overlay/thumbs: eviction didn't take the least recently drawn");
+        const bool fits = size.x <= 160.0f && size.y <= 100.0f && uv1.x > uv0.x && uv1.y > uv0.y;
+        b.Expect(fits, "overlay/thumbs: a thumbnail came back bigger than its cell");
+        thumbs.Detach();
+    }
+
+    // off the UI thread: frames only ask, the cells fill in later, and a
+    // capture waits while the others leave no room for it (rows 0..2 are
+    // 640 x 400, 1920 x 1080 and 3840 x 2160; the share fits the biggest
+    // alone)
+    {
+        FetchPool loads;
+        loads.Start();
+        const size_t budget = 40u << 20;
+        ThumbnailCache thumbs(160, 100, budget, 36u << 20);
+        thumbs.SetSource(&source);
+        thumbs.SetLoader(&loads);
+        thumbs.Attach();
+        ImVec2 uv0, uv1, size;
+        auto shown = [&] {
+            for (int i = 0; i < 3; ++i)
+                if (!thumbs.Get(windows.At(rows[i]).id, uv0, uv1, size))
+                    return false;
+            return true;
+        };
+        auto t0 = std::chrono::steady_clock::now();
+        ThumbnailFrame(windows, rows, 0, thumbs, ctx.renderer);
+        while (NsSince(t0) < 2e9) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            thumbs.NewFrame();
+            if (shown())
+                break;
+        }
+        b.Expect(shown(), "overlay/thumbs: thumbnails captured on workers never showed up");
+        b.Expect(thumbs.GetStats().peakBytes <= budget, "overlay/thumbs: workers' captures went over budget");
+        loads.Stop();
+        thumbs.Detach();
+    }
+}
+
+void BenchOverlay(Bench& b) {
+    if (b.Wants("overlay/title/"))     BenchTitles(b);
+    if (b.Wants("overlay/filter/"))    BenchFilter(b);
+    if (b.Wants("overlay/frame/"))     BenchFrames(b);
+    if (b.Wants("overlay/icons/check")) CheckIcons(b);
+    if (b.Wants("overlay/icons/"))     BenchIcons(b);
+    if (b.Wants("overlay/glyphs/"))    BenchGlyphs(b);
+    if (b.Wants("overlay/glyphs/check")) CheckGlyphs(b);
+    if (b.Wants("overlay/text/check")) CheckText(b);
+    if (b.Wants("overlay/text/"))      BenchText(b);
+    if (b.Wants("overlay/soft/"))      BenchSoft(b);
+    if (b.Wants("overlay/steady/"))    BenchSteady(b);
+    if (b.Wants("overlay/slow/"))      BenchSlowApps(b);
+    if (b.Wants("overlay/scheduler/")) BenchScheduler(b);
+    if (b.Wants("overlay/scheduler/check")) CheckScheduler(b);
+    if (b.Wants("overlay/lifetime/"))  BenchLifetime(b);
+    if (b.Wants("overlay/thumbs/check")) {
+        CheckDownscale(b);
+        CheckThumbnails(b);
+    }
+    if (b.Wants("overlay/thumbs/downscale/")) BenchDownscale(b);
+}
@@ -0,0 +1,178 @@
+﻿// === bench/bench_settings.cpp ===
+#include "harness.h"
+#include "settings.h"
+#include "switcher.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+// Configs whose fields all follow from the initiator, so a reader can tell
+// one that mixes two publishes
+static SwitcherConfig StressConfig(uint16_t n) {
+    SwitcherConfig cfg;
+    cfg.initiator = n;
+    cfg.modifier = (uint16_t)(n ^ 0x5A5A);
+    cfg.tapTimeoutMs = n * 3;
+    cfg.overlayTimeoutMs = n * 7;
+    return cfg;
+}
+
+static bool Consistent(const SwitcherConfig& cfg) {
+    return cfg == StressConfig(cfg.initiator);
+}
+
+// Settings that differ from the defaults in the switcher's part only
+static HotkeyConfig Keys(uint16_t initiator, uint16_t modifier, int tapMs, int overlayMs) {
+    HotkeyConfig cfg;
+    cfg.switcher = { initiator, modifier, tapMs, overlayMs };
+    return cfg;
+}
+
+template <class F>
+static bool WaitFor(F&& done, int timeoutMs) {
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > until)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Readers hammer the live config while a writer flips it
+static void BenchLiveStress(Bench& b) {
+    Published<SwitcherConfig> live(StressConfig(1));
+    const int readers = 2;
+    const auto runFor = std::chrono::milliseconds(b.Quick() ? 100 : 1000);
+    std::atomic<bool> stop{ false };
+    std::atomic<int> started{ 0 };
+    std::atomic<uint64_t> reads{ 0 }, torn{ 0 };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < readers; ++i) {
+        threads.emplace_back([&] {
+            Published<SwitcherConfig>::Reader reader(live);
+            started.fetch_add(1);
+            uint64_t n = 0, bad = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                auto cfg = reader.Get();
+                bad += !Consistent(*cfg);
+                ++n;
+            }
+            reads.fetch_add(n);
+            torn.fetch_add(bad);
+        });
+    }
+    while (started.load() < readers)
+        std::this_thread::yield();
+
+    uint64_t publishes = 0;
+    auto until = std::chrono::steady_clock::now() + runFor;
+    while (std::chrono::steady_clock::now() < until) {
+        live.Publish(StressConfig((uint16_t)(2 + publishes % 1000)));
+        ++publishes;
+        if (publishes % 64 == 0)
+            std::this_thread::yield();   // let the readers run on a single core
+    }
+    stop = true;
+    for (std::thread& t : threads)
+        t.join();
+
+    const double secs = std::chrono::duration<double>(runFor).count();
+    b.Metric("settings/live/stress/reads", (double)reads.load() / secs, "reads/s");
+    b.Metric("settings/live/stress/publishes", (double)publishes / secs, "publishes/s");
+    b.Expect(reads.load() > 0 && publishes > 0, "settings/live/stress: nothing ran");
+    b.Expect(torn.load() == 0, "settings/live/stress: a reader saw a torn config");
+    // with the readers gone, the next publish frees everything retired
+    live.Publish(StressConfig(1));
+    b.Expect(live.Retired() == 0, "settings/live/stress: retired configs never freed");
+}
+
+// Async saves land, the watcher picks up edits from outside, and our own
+// saves don't come back as reloads
+static void BenchStore(Bench& b, const std::string& path) {
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    SettingsStore store(path);
+    b.Expect(store.Load() == HotkeyConfig(), "settings/store: no file should load the defaults");
+
+    const HotkeyConfig first = Keys(vk::RMenu, vk::LShift, 200, 400);
+    const HotkeyConfig second = Keys(vk::LMenu, vk::RShift, 210, 410);
+    const uint64_t bindingsVersion = store.KeyBindings().Version();
+    store.SaveAsync(first);
+    store.SaveAsync(second);
+    store.Flush();
+    HotkeyConfig onDisk;
+    b.Expect(LoadSettings(path, onDisk) && onDisk == second, "settings/store: last SaveAsync not on disk");
+    b.Expect(store.Current() == second && store.Switcher().Load() == second.switcher,
+             "settings/store: SaveAsync did not publish");
+    b.Expect(store.KeyBindings().Version() == bindingsVersion,
+             "settings/store: a switcher edit republished the key bindings");
+    b.Expect(!std::filesystem::exists(path + ".tmp"), "settings/store: temp file left behind");
+
+    if (!store.Watch()) {
+        b.Expect(false, "settings/watch: could not watch the file");
+        return;
+    }
+    const HotkeyConfig edited = Keys(vk::RMenu, vk::RShift, 260, 520);
+    auto t0 = std::chrono::steady_clock::now();
+    SaveSettings(edited, path);   // as another process would
+    bool reloaded = WaitFor([&] { return store.Current() == edited; }, 2000);
+    b.Metric("settings/watch/latency",
+             std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count(), "ms");
+    b.Expect(reloaded, "settings/watch: an edit on disk was not reloaded");
+
+    // a save of ours, then a live edit: the save must not undo the edit
+    const HotkeyConfig saved = Keys(vk::LMenu, vk::LShift, 270, 530);
+    const HotkeyConfig unsaved = Keys(vk::LMenu, vk::LShift, 280, 540);
+    store.SaveAsync(saved);
+    store.Publish(unsaved);
+    store.Flush();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));   // past the debounce
+    b.Expect(store.Reloads() == 1 && store.Current() == unsaved,
+             "settings/watch: our own save came back as a reload");
+    store.StopWatching();
+
+    // an edit from outside, overwritten by a save of ours: a reload racing
+    // the save must not publish either file over the live config
+    const HotkeyConfig outside = Keys(vk::RMenu, vk::LShift, 290, 550);
+    const HotkeyConfig mine = Keys(vk::RMenu, vk::RShift, 300, 560);
+    SaveSettings(outside, path);
+    store.SaveAsync(mine);
+    store.Reload();
+    store.Flush();
+    store.Reload();
+    b.Expect(store.Reloads() == 1 && store.Current() == mine,
+             "settings/watch: a reload during a save published a stale file");
+}
+
+void BenchSettings(Bench& b) {
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "wws_bench_config.json").string();
+    const HotkeyConfig cfg = Keys(vk::RMenu, vk::RShift, 250, 450);
+
+    // what the settings panel does on every change, and startup
+    b.Run("settings/save", [&] { SaveSettings(cfg, path); });
+    b.Run("settings/load", [&] { DoNotOptimize(LoadSettings(path)); });
+    b.Run("settings/round_trip", [&] {
+        SaveSettings(cfg, path);
+        DoNotOptimize(LoadSettings(path));
+    });
+
+    // what the hook pays per key
+    Published<SwitcherConfig> live(cfg.switcher);
+    Published<SwitcherConfig>::Reader reader(live);
+    b.Run("settings/live/read", [&] { DoNotOptimize(reader.Get()->tapTimeoutMs); });
+    b.ExpectNoAllocs("settings/live/read");
+    int flip = 0;
+    b.Run("settings/live/publish", [&] { live.Publish(StressConfig((uint16_t)(++flip & 1))); });
+
+    if (b.Wants("settings/live/stress"))
+        BenchLiveStress(b);
+    if (b.Wants("settings/store") || b.Wants("settings/watch"))
+        BenchStore(b, path);
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
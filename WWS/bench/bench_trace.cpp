@@ -0,0 +1,116 @@
+﻿// === bench/bench_trace.cpp ===
+#include "harness.h"
+#include "trace.h"
+#include "json.hpp"
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+// Tracers of our own, except for the macro, which only knows GetTracer()
+void BenchTrace(Bench& b) {
+#ifdef WWS_ENABLE_TRACING
+    b.Metric("trace/enabled", 1.0, "bool");
+#else
+    b.Metric("trace/enabled", 0.0, "bool");
+#endif
+    Tracer tracer;
+    tracer.ThisThread();   // the first span allocates the ring
+    uint64_t t = 1000;
+    b.Run("trace/span", [&] {
+        tracer.Span("span", t, t + 500, 7);
+        t += 1000;
+    });
+    b.ExpectNoAllocs("trace/span");
+#ifdef WWS_ENABLE_TRACING
+    // what a call site pays (clock reads included)
+    GetTracer().ThisThread();
+    b.Run("trace/scope_macro", [&] { WWS_TRACE_SCOPE("scope"); });
+#endif
+    b.Run("trace/latency_record", [&] {
+        tracer.RecordLatency(TraceLatency_KeyToPresent, t % 50000000, t);
+        t += 1000;
+    });
+
+    // latencies spread evenly over 1..100 ms land within a bucket of the truth
+    if (b.Wants("trace/percentile")) {
+        Tracer lat;
+        for (uint64_t ms = 1; ms <= 100; ++ms)
+            lat.RecordLatency(TraceLatency_KeyToPresent, ms * 1000000, 1);
+        LatencyHistogram h;
+        lat.Latency(TraceLatency_KeyToPresent, h);
+        const double p50 = (double)h.PercentileNs(0.5) / 1e6;
+        const double p99 = (double)h.PercentileNs(0.99) / 1e6;
+        b.Metric("trace/percentile/p50", p50, "ms");
+        b.Metric("trace/percentile/p99", p99, "ms");
+        b.Expect(h.Count() == 100 && p50 >= 50.0 && p50 < 50.0 * 1.125 && p99 >= 99.0 && p99 <= 100.0,
+                 "trace/percentile: p50/p99 off for 1..100 ms");
+    }
+
+    // the rolling window: a gap of two windows or more leaves nothing of
+    // the old ones, and a cancelled measurement never closes
+    if (b.Wants("trace/latency/check")) {
+        const uint64_t w = Tracer::kLatencyWindowNs;
+        Tracer lat;
+        LatencyHistogram h;
+        lat.RecordLatency(TraceLatency_KeyToPresent, 1000000, 1);
+        lat.RecordLatency(TraceLatency_KeyToPresent, 2000000, 1 + w);
+        lat.Latency(TraceLatency_KeyToPresent, h);
+        b.Expect(h.Count() == 2, "trace/latency/check: the previous window was dropped after one window");
+        lat.RecordLatency(TraceLatency_KeyToPresent, 3000000, 1 + 4 * w);
+        lat.Latency(TraceLatency_KeyToPresent, h);
+        b.Expect(h.Count() == 1 && h.MaxNs() >= 3000000 && h.MaxNs() < 4000000,
+                 "trace/latency/check: records from several windows ago survived a gap");
+        lat.RecordLatency(TraceLatency_KeyToPresent, 4000000, 1 + 5 * w);
+        lat.Latency(TraceLatency_KeyToPresent, h);
+        b.Expect(h.Count() == 2, "trace/latency/check: windows lost their alignment after a gap");
+
+        lat.LatencyBegin(TraceLatency_KeyToForeground, 100);
+        lat.LatencyCancel(TraceLatency_KeyToForeground);
+        lat.LatencyBegin(TraceLatency_KeyToForeground, 1000);
+        lat.LatencyEnd(TraceLatency_KeyToForeground, 1500);
+        lat.Latency(TraceLatency_KeyToForeground, h);
+        b.Expect(h.Count() == 1 && h.MaxNs() < 1000, "trace/latency/check: a cancelled start was measured from");
+    }
+
+    // full rings on a few threads, exported; the JSON has to load back.
+    // The writers overlap so none of them inherits a finished one's ring.
+    if (!b.Wants("trace/export"))
+        return;
+    Tracer full;
+    const int threads = 4;
+    std::atomic<int> started{ 0 };
+    std::vector<std::thread> writers;
+    for (int i = 0; i < threads; ++i) {
+        writers.emplace_back([&full, &started, i] {
+            full.SetThreadName(i ? "writer" : "main");
+            started.fetch_add(1);
+            while (started.load() < threads)
+                std::this_thread::yield();
+            for (uint64_t k = 0; k < TraceRing::kCapacity * 2; ++k)
+                full.Span("work", k * 100, k * 100 + 50, k);
+        });
+    }
+    for (std::thread& w : writers)
+        w.join();
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "wws_bench_trace.json").string();
+    b.Run("trace/export", [&] { full.WriteChromeJson(path); });
+    b.Metric("trace/export/bytes", (double)std::filesystem::file_size(path), "bytes");
+
+    size_t events = 0;
+    try {
+        std::ifstream in(path);
+        nlohmann::json j = nlohmann::json::parse(in);
+        events = j.at("traceEvents").size();
+    }
+    catch (const std::exception&) {
+    }
+    // a full ring gives up its oldest slot (it may be mid-write); plus the
+    // thread name
+    b.Expect(events == threads * TraceRing::kCapacity,
+             "trace/export: JSON does not load back with every record");
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
@@ -0,0 +1,962 @@
+﻿// === bench/bench_windows.cpp ===
+#include "harness.h"
+#include "fixtures.h"
+#include "window_filter.h"
+#include "window_rules.h"
+#include "window_registry.h"
+#include "window_snapshot.h"
+#include "process_cache.h"
+#include "frecency_store.h"
+#include "activator.h"
+#include "settings.h"
+#include "utf8.h"
+#include "clock.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cwctype>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <random>
+#include <thread>
+
+// Plain-field stand-in for a live HWND
+struct FakeWindow {
+    bool         visible;
+    uint32_t     exStyle;
+    uint32_t     style;
+    bool         rootOwner;
+    std::wstring title;
+    std::wstring windowClass;
+    std::wstring exe;
+
+    bool     Visible() const     { return visible; }
+    uint32_t ExStyle() const     { return exStyle; }
+    uint32_t Style() const       { return style; }
+    bool     IsRootOwner() const { return rootOwner; }
+    void     Title(std::wstring& out) const { out = title; }
+    void     ClassName(std::wstring& out) const { out = windowClass; }
+    void     Exe(std::wstring& out) const { out = exe; }
+};
+
+// Window classes of the fixture apps, in their order
+static const wchar_t* const kClasses[] = {
+    L"Chrome_WidgetWin_1", L"Chrome_WidgetWin_1", L"MozillaWindowClass", L"Notepad",
+    L"Chrome_WidgetWin_1", L"CASCADIA_HOSTING_WINDOW_CLASS", L"CabinetWClass", L"Chrome_WidgetWin_0",
+    L"Chrome_WidgetWin_1", L"rctrl_renwnd32", L"OpusApp", L"XLMAIN", L"TaskManagerWindow",
+    L"SDL_app", L"Qt5152QWindowIcon",
+};
+
+// Roughly what EnumWindows hands back on a busy desktop: mostly hidden
+// helper windows, some tool/owned/captionless ones, a few real ones
+static std::vector<FakeWindow> MakeDesktop(size_t count) {
+    std::mt19937 rng(7);
+    std::vector<std::wstring> titles = MakeTitles(count);
+    std::vector<FakeWindow> out(count);
+    for (size_t i = 0; i < count; ++i) {
+        FakeWindow& w = out[i];
+        const std::wstring path = ExePathFor(i);
+        w = { true, 0, ws::Caption, true, titles[i],
+              kClasses[i % (sizeof(kClasses) / sizeof(kClasses[0]))], path.substr(path.rfind(L'\\') + 1) };
+        switch (rng() % 20) {
+        case 0: case 1: case 2: case 3: case 4: case 5:
+        case 6: case 7: case 8: case 9: case 10: case 11:
+            w.visible = false;                 break;
+        case 12: w.exStyle = ws::ExToolWindow; break;
+        case 13: w.rootOwner = false;          break;
+        case 14: w.style = 0;                  break;
+        case 15: w.title.clear();              break;
+        case 16: w.title = L"   ";             break;
+        default:                               break;
+        }
+    }
+    return out;
+}
+
+static void BenchPredicate(Bench& b) {
+    const std::vector<FakeWindow> desktop = MakeDesktop(1000);
+    size_t i = 0, kept = 0;
+    std::wstring title;
+    b.Run("windows/filter/predicate", [&] {
+        kept += IsSwitchableWindow(desktop[i], title);
+        i = (i + 1 == desktop.size()) ? 0 : i + 1;
+    });
+    DoNotOptimize(kept);
+}
+
+static void BenchRegistry(Bench& b) {
+    const size_t n = b.Quick() ? 200 : 1000;
+    const std::vector<std::wstring> titles = MakeTitles(n);
+    WindowRegistry reg;
+    FakeWindowEventSource src;
+    src.Start(reg);
+    for (size_t i = 0; i < n; ++i)
+        src.Create(i + 1, titles[i], (uint32_t)(i % 40 + 1));
+
+    std::mt19937 rng(3);
+    const std::string suffix = "/" + std::to_string(n);
+    b.Run("windows/registry/focus" + suffix, [&] { src.Focus(rng() % n + 1); });
+    b.Run("windows/registry/rename" + suffix, [&] {
+        size_t k = rng() % n;
+        src.Rename(k + 1, titles[(k + 1) % n]);
+    });
+    WindowId next = n + 1;
+    b.Run("windows/registry/create_destroy" + suffix, [&] {
+        src.Create(next, titles[next % n]);
+        src.Destroy(next);
+        ++next;
+    });
+    std::vector<WindowRecord> snap;
+    b.Run("windows/registry/snapshot" + suffix, [&] {
+        reg.Snapshot(snap);
+        DoNotOptimize(snap.data());
+    });
+    b.Run("windows/registry/at1" + suffix, [&] { DoNotOptimize(reg.At(1)); });
+}
+
+// A seeded random mix of creates, destroys, focus changes and minimizes
+// against a plain std::list MRU model: after every event the snapshot must
+// list the same windows, titles included, in the same order
+static void CheckRegistry(Bench& b) {
+    const std::string what = "windows/registry/check: ";
+    struct Ref {
+        WindowId     id;
+        std::wstring title;
+        bool         minimized = false;
+    };
+    std::list<Ref> model;   // most recent first
+    auto find = [&](WindowId id) {
+        return std::find_if(model.begin(), model.end(), [id](const Ref& r) { return r.id == id; });
+    };
+
+    WindowRegistry reg;
+    FakeWindowEventSource src;
+    src.Start(reg);
+    const size_t events = b.Quick() ? 5000 : 50000;
+    const WindowId ids = 200;   // small enough that most events hit a known window
+    std::mt19937 rng(11);
+    std::vector<WindowRecord> snap;
+    size_t mismatches = 0, firstBad = 0;
+    for (size_t k = 0; k < events; ++k) {
+        const WindowId id = rng() % ids + 1;
+        auto it = find(id);
+        switch (rng() % 4) {
+        case 0: {
+            std::wstring title = L"Window " + std::to_wstring(id) + L" #" + std::to_wstring(k);
+            src.Create(id, title);
+            if (it == model.end())
+                it = model.insert(model.end(), Ref{ id, L"" });
+            it->title = std::move(title);
+            break;
+        }
+        case 1:
+            src.Destroy(id);
+            if (it != model.end())
+                model.erase(it);
+            break;
+        case 2:
+            src.Focus(id);
+            if (it == model.end())
+                it = model.insert(model.end(), Ref{ id, L"" });
+            it->minimized = false;
+            model.splice(model.begin(), model, it);
+            break;
+        case 3:
+            src.Minimize(id);
+            if (it != model.end())
+                it->minimized = true;
+            break;
+        }
+
+        reg.Snapshot(snap);
+        bool same = reg.Size() == model.size();
+        auto r = model.begin();
+        for (const WindowRecord& w : snap) {
+            while (r != model.end() && r->minimized)
+                ++r;
+            same = same && r != model.end() && w.id == r->id && w.title == r->title && !w.minimized;
+            if (r != model.end())
+                ++r;
+        }
+        while (r != model.end() && r->minimized)
+            ++r;
+        same = same && r == model.end();
+        if (!same && mismatches++ == 0)
+            firstBad = k;
+    }
+    b.Metric("windows/registry/check_windows", (double)model.size(), "windows");
+    b.Expect(mismatches == 0, what + std::to_string(mismatches) + " of " + std::to_string(events) +
+             " events left the snapshot unlike the MRU model, first at event " + std::to_string(firstBad));
+
+    // a renamed window keeps its pin
+    {
+        WindowRegistry pins;
+        FakeWindowEventSource pinSrc;
+        pinSrc.Start(pins);
+        pinSrc.Create(1, L"Editor");
+        pinSrc.Create(2, L"Music", 0, true);
+        pinSrc.Rename(2, L"Music - playing");
+        const std::vector<WindowRecord> listed = pins.Snapshot();
+        b.Expect(listed.size() == 2 && listed[1].id == 2 && listed[1].pinned, what + "renaming unpinned a window");
+    }
+}
+
+static void BenchProcessCache(Bench& b) {
+    const uint32_t n = 200;
+    FakeProcessInfoProvider provider;
+    for (uint32_t pid = 1; pid <= 2 * n; ++pid)
+        provider.Add(pid, pid * 10, ExePathFor(pid));
+    ProcessCache cache;
+    cache.Start(provider);
+
+    // miss -> entry visible, through the fetch thread
+    std::vector<double> latency;
+    for (uint32_t pid = n + 1; pid <= 2 * n; ++pid) {
+        uint64_t version = cache.Version();
+        auto t0 = std::chrono::steady_clock::now();
+        cache.Lookup(pid);
+        while (cache.Version() == version)
+            std::this_thread::yield();
+        latency.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - t0).count());
+    }
+    b.Samples("windows/process_cache/fetch_latency", std::move(latency));
+
+    uint32_t pid = 0;
+    b.Run("windows/process_cache/lookup_hit", [&] {
+        DoNotOptimize(cache.Lookup(n + 1 + pid));
+        pid = (pid + 1) % n;
+    });
+    cache.Stop();
+}
+
+// A job past its deadline counts as hung while it runs, even with the
+// queue empty and a worker to spare
+static void CheckFetchPool(Bench& b) {
+    const std::string what = "windows/fetch_pool/check: ";
+    FetchPool pool(2, 4, 20000000ull);   // 20 ms
+    pool.Start();
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool release = false;
+    pool.Submit([&] {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return release; });
+    });
+    bool hung = false;
+    for (int i = 0; i < 2000 && !hung; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        hung = pool.GetStats().hung == 1;
+    }
+    const FetchPool::Stats during = pool.GetStats();
+    b.Expect(hung && during.overdue == 1 && during.spawned == 0,
+             what + "a job past its deadline with the queue empty was not seen");
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        release = true;
+    }
+    cv.notify_all();
+    pool.Stop();
+    const FetchPool::Stats after = pool.GetStats();
+    b.Expect(after.jobs == 1 && after.overdue == 1 && after.hung == 0,
+             what + "the overdue job was counted more than once, or stayed hung");
+}
+
+// A process that exits between its query and the exit watch
+class ExitingProvider : public FakeProcessInfoProvider {
+public:
+    uint32_t exitOn = 0;
+    bool Query(uint32_t pid, ProcessInfo& info) override {
+        const bool ok = FakeProcessInfoProvider::Query(pid, info);
+        if (ok && pid == exitOn)
+            Exit(pid);
+        return ok;
+    }
+};
+
+static void CheckProcessCache(Bench& b) {
+    const std::string what = "windows/process_cache/check: ";
+    ExitingProvider provider;
+    provider.Add(7, 70, L"C:\\Apps\\old.exe");
+    provider.exitOn = 7;
+    ProcessCache cache;
+    cache.Start(provider);
+    auto fetched = [&](uint32_t pid) {
+        for (int i = 0; i < 2000; ++i) {
+            if (auto info = cache.Lookup(pid))
+                return info;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return std::shared_ptr<const ProcessInfo>();
+    };
+    auto settled = [&](uint64_t jobs) {
+        for (int i = 0; i < 2000 && cache.PoolStats().jobs < jobs; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    };
+
+    cache.Lookup(7);
+    settled(1);
+    b.Expect(cache.Size() == 0, what + "a process gone before its exit watch stayed cached");
+
+    // the pid comes back as another process
+    provider.exitOn = 0;
+    provider.Add(7, 71, L"C:\\Apps\\new.exe");
+    auto info = fetched(7);
+    b.Expect(info && info->startTime == 71 && info->exeName == L"new.exe",
+             what + "a reused pid showed the dead process");
+    provider.Exit(7);
+    b.Expect(cache.Size() == 0, what + "an exit left its entry behind");
+    cache.Stop();
+}
+
+// A year of someone's switching: a few hundred windows, a handful of them
+// most of the time (Zipf-ish), ~250 switches a day
+static const uint64_t kYearStartSec = 1735689600;   // 2025-01-01
+static const uint64_t kDaySec = 24 * 3600;
+
+static uint64_t RecordYear(FrecencyStore& store, const std::vector<FrecencyKeys>& keys, size_t perDay) {
+    std::mt19937 rng(11);
+    std::vector<double> weights(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i)
+        weights[i] = 1.0 / (double)(i + 1);
+    std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+    uint64_t n = 0;
+    for (uint64_t day = 0; day < 365; ++day) {
+        for (size_t i = 0; i < perDay; ++i, ++n) {
+            const uint64_t sec = kYearStartSec + day * kDaySec + 9 * 3600 + i * (8 * 3600 / perDay);
+            store.Record(keys[pick(rng)], sec);
+        }
+    }
+    return n;
+}
+
+static void BenchFrecency(Bench& b) {
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "wws_bench_frecency.bin").string();
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+
+    const size_t distinct = 400;
+    const std::vector<std::wstring> titles = MakeTitles(distinct);
+    std::vector<FrecencyKeys> keys;
+    for (const std::wstring& t : titles)
+        keys.push_back(FrecencyKeys::FromTitle(t));
+
+    FrecencyStore store;
+    b.Expect(store.Open(path), "windows/frecency: store file not mapped");
+    auto t0 = std::chrono::steady_clock::now();
+    const uint64_t activations = RecordYear(store, keys, b.Quick() ? 50 : 250);
+    const double yearNs = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+    b.Metric("windows/frecency/year/activations", (double)activations, "count");
+    b.Metric("windows/frecency/year/ns_per_record", yearNs / (double)activations, "ns");
+    b.Metric("windows/frecency/year/slots_used", (double)store.Used(), "count");
+
+    // steady state: more of the same, a switch every ~2 minutes
+    uint64_t sec = kYearStartSec + 366 * kDaySec;
+    size_t k = 0;
+    b.Run("windows/frecency/record", [&] {
+        store.Record(keys[k], sec += 120);
+        k = (k * 7 + 1) % distinct;
+    });
+    b.ExpectNoAllocs("windows/frecency/record");
+    b.Run("windows/frecency/rank", [&] {
+        DoNotOptimize(store.Rank(keys[k]));
+        k = (k + 1) % distinct;
+    });
+
+    // startup: map the file and check the header, nothing to parse
+    const double rank0 = store.Rank(keys[0]);
+    const uint32_t used = store.Used();
+    store.Close();
+    std::vector<double> opens;
+    for (int i = 0; i < (b.Quick() ? 10 : 100); ++i) {
+        FrecencyStore reopened;
+        auto o0 = std::chrono::steady_clock::now();
+        reopened.Open(path);
+        DoNotOptimize(reopened.Rank(keys[0]));
+        opens.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - o0).count());
+    }
+    b.Samples("windows/frecency/open", std::move(opens));
+    store.Open(path);
+    b.Expect(store.Used() == used && store.Rank(keys[0]) == rank0,
+             "windows/frecency: history not the same after reopening");
+
+    // ordering a desktop's worth of windows from that history
+    const size_t n = 200;
+    ManualClock wall((kYearStartSec + 367 * kDaySec) * 1000000000ull);
+    FrecencyStore live(wall);
+    live.Open(path);
+    WindowRegistry reg;
+    FakeWindowEventSource src;
+    src.Start(reg);
+    for (size_t i = 0; i < n; ++i)
+        src.Create(i + 1, titles[i], (uint32_t)(i % 40 + 1));
+    reg.SetFrecency(&live);
+    reg.SetFrecencyOrder(true);
+    WindowSnapshot snap;
+    const std::string suffix = "/" + std::to_string(n);
+    b.Run("windows/frecency/snapshot" + suffix, [&] { reg.Snapshot(snap); });
+    b.ExpectNoAllocs("windows/frecency/snapshot" + suffix);
+    b.Run("windows/frecency/at1" + suffix, [&] { DoNotOptimize(reg.At(1)); });
+    std::mt19937 rng(3);
+    b.Run("windows/frecency/focus" + suffix, [&] {
+        wall.AdvanceMs(1000);
+        src.Focus(rng() % n + 1);
+    });
+    b.ExpectNoAllocs("windows/frecency/focus" + suffix);
+    reg.SetFrecency(nullptr);
+    live.Close();
+    store.Close();
+    std::filesystem::remove(path, ec);
+}
+
+// Ranking, keys and the file format doing what the overlay relies on
+static void CheckFrecency(Bench& b) {
+    const std::string what = "windows/frecency/check: ";
+    const uint64_t now = kYearStartSec + 30 * kDaySec;
+
+    // the parts of a title that churn don't split its history
+    const FrecencyKeys inbox = FrecencyKeys::FromTitle(L"Inbox (3) - Outlook");
+    b.Expect(inbox.pattern == FrecencyKeys::FromTitle(L"inbox (12) - Outlook").pattern, what + "digit runs");
+    b.Expect(FrecencyKeys::FromTitle(L"\x25CF main.cpp - WWS - Visual Studio Code").pattern ==
+             FrecencyKeys::FromTitle(L"main.cpp - WWS - Visual Studio Code").pattern, what + "unsaved marker");
+    b.Expect(inbox.app == FrecencyKeys::FromTitle(L"Calendar - Outlook").app &&
+             inbox.pattern != FrecencyKeys::FromTitle(L"Calendar - Outlook").pattern, what + "app key");
+
+    FrecencyStore store;
+    store.OpenInMemory(64);
+    const FrecencyKeys daily = FrecencyKeys::FromTitle(L"Daily - Editor");
+    const FrecencyKeys once = FrecencyKeys::FromTitle(L"Once - Viewer");
+    const FrecencyKeys stale = FrecencyKeys::FromTitle(L"Stale - Tool");
+    for (int d = 20; d >= 1; --d)
+        store.Record(daily, now - d * kDaySec);
+    store.Record(once, now - 60);
+    for (int i = 0; i < 20; ++i)
+        store.Record(stale, now - 200 * kDaySec + i);
+    b.Expect(store.Rank(daily) > store.Rank(once), what + "frequent ranks above a single recent switch");
+    b.Expect(store.Rank(once) > store.Rank(stale), what + "recent ranks above long unused");
+    // 1 for the title, kAppWeight for the app
+    b.Expect(std::fabs(store.Score(once, now) - 1.5) < 0.01, what + "a fresh switch scores 1.5");
+    b.Expect(std::fabs(store.Score(once, now + FrecencyStore::kHalfLifeSec) - 0.75) < 0.01, what + "half-life");
+    b.Expect(store.Rank(FrecencyKeys::FromTitle(L"Never - Seen")) < store.Rank(stale), what + "never used ranks last");
+
+    // a full table evicts the weakest; the ones in use survive
+    for (int i = 0; i < 1000; ++i)
+        store.Record(FrecencyKeys::FromTitle(L"Noise " + std::to_wstring(i) + L" x"), now - 100 * kDaySec);
+    b.Expect(store.Used() <= store.Slots() && store.Rank(daily) > store.Rank(stale), what + "eviction");
+
+    // flipping between two windows leaves everyone else where they were
+    ManualClock wall(now * 1000000000ull);
+    FrecencyStore live(wall);
+    live.OpenInMemory();
+    WindowRegistry reg;
+    FakeWindowEventSource src;
+    src.Start(reg);
+    // one app each, or switching to one window would lift its app's others
+    for (WindowId id = 1; id <= 8; ++id)
+        src.Create(id, L"Document - App " + std::to_wstring(id));
+    reg.SetFrecency(&live);
+    reg.SetFrecencyOrder(true);
+    for (WindowId id = 8; id >= 1; --id)
+        for (WindowId k = 0; k < id; ++k) {
+            wall.AdvanceMs(60000);
+            src.Focus(id);
+            src.Focus(8 - (id % 8));   // something else in between, so each counts
+        }
+    src.Focus(1);
+    auto others = [&] {
+        std::vector<WindowId> out;
+        for (const WindowRecord& w : reg.Snapshot())
+            if (w.id != 1 && w.id != 2)
+                out.push_back(w.id);
+        return out;
+    };
+    const std::vector<WindowId> before = others();
+    for (int i = 0; i < 20; ++i) {
+        wall.AdvanceMs(1000);
+        src.Focus(i % 2 ? 1 : 2);
+    }
+    b.Expect(others() == before, what + "flipping two windows moves the rest");
+    b.Expect(reg.At(0) == 1 && reg.MruAt(1) == 2, what + "active window first, MRU still there");
+    reg.SetFrecencyOrder(false);
+    b.Expect(reg.At(1) == 2, what + "MRU order when off");
+
+    // anything that isn't a store is started over, not trusted
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "wws_bench_frecency_bad.bin").string();
+    {
+        FILE* f = std::fopen(path.c_str(), "wb");
+        std::fputs("not a frecency store", f);
+        std::fclose(f);
+    }
+    FrecencyStore bad;
+    b.Expect(bad.Open(path, 64) && bad.Used() == 0 && bad.Slots() == 64, what + "garbage file reset");
+    bad.Record(daily, now);
+    bad.Close();
+    b.Expect(bad.Open(path, 4096) && bad.Slots() == 64 && bad.Used() == 2, what + "reopened keeps its size");
+    bad.Close();
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
+
+// --- activation ---
+
+// Collects an activator's results, in the order it reports them
+struct ActivationLog {
+    std::mutex                    mutex;
+    std::vector<ActivationResult> results;
+
+    void Attach(Activator& a) {
+        a.SetResultCallback([this](const ActivationResult& r) {
+            std::lock_guard<std::mutex> lock(mutex);
+            results.push_back(r);
+        });
+    }
+    std::vector<ActivationResult> Take() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return std::move(results);
+    }
+};
+
+static double MsSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void BenchActivation(Bench& b) {
+    // request to confirmed, through the pool and the fake's foreground event
+    Activator activator(50000000ull);
+    FakeActivationBackend backend(activator);
+    const WindowId n = 64;
+    for (WindowId id = 1; id <= n; ++id)
+        backend.Add(id);
+    ActivationLog log;
+    log.Attach(activator);
+    activator.Start(backend);
+    // from the hook's side only the handoff counts: Request() returning
+    std::vector<double> latency, handoff;
+    for (int i = 0; i < (b.Quick() ? 100 : 1000); ++i) {
+        auto t0 = std::chrono::steady_clock::now();
+        activator.Request((WindowId)(i % n) + 1);
+        handoff.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - t0).count());
+        activator.WaitIdle(1000000000ull);
+        for (const ActivationResult& r : log.Take())
+            if (r.outcome == ActivationOutcome::Confirmed && r.attempts)
+                latency.push_back((double)(r.doneNs - r.requestNs));
+    }
+    b.Samples("windows/activation/confirm_latency", std::move(latency));
+    b.Samples("windows/activation/request", std::move(handoff));
+    activator.Stop();
+}
+
+// Ordering, coalescing, escalation and timeouts against the fake backend
+static void CheckActivation(Bench& b) {
+    const std::string what = "windows/activation/check: ";
+    const uint64_t timeoutNs = 20000000ull;   // 20 ms per attempt
+    Activator activator(timeoutNs);
+    FakeActivationBackend backend(activator);
+    ActivationLog log;
+    log.Attach(activator);
+    for (WindowId id = 1; id <= 8; ++id)
+        backend.Add(id);
+    backend.Add(10, 2);     // only the last strategy works
+    backend.Add(11, 99);    // nothing works
+    backend.Add(12);        // will hang
+    activator.Start(backend);
+    auto idle = [&] { return activator.WaitIdle(2000000000ull); };
+
+    // plain switch, then one to the window already in front
+    activator.Request(1);
+    b.Expect(idle(), what + "idle after one request");
+    activator.Request(1);
+    idle();
+    auto results = log.Take();
+    b.Expect(results.size() == 2 && results[0].outcome == ActivationOutcome::Confirmed &&
+             results[0].attempts == 1 && results[0].strategy == 0, what + "first attempt confirmed");
+    b.Expect(results.size() == 2 && results[1].outcome == ActivationOutcome::Confirmed &&
+             results[1].attempts == 0, what + "already in front");
+
+    // rapid commits: the first is under way, the ones that come in while
+    // it is being given up on never start, the last one wins. The result
+    // callback holds the activator at that point, to make it deterministic.
+    std::mutex gateMutex;
+    std::condition_variable gateCv;
+    bool held = false, open = false;
+    activator.SetResultCallback([&](const ActivationResult& r) {
+        std::unique_lock<std::mutex> lock(gateMutex);
+        if (r.id == 2) {
+            held = true;
+            gateCv.notify_all();
+            gateCv.wait(lock, [&] { return open; });
+        }
+        std::lock_guard<std::mutex> logLock(log.mutex);
+        log.results.push_back(r);
+    });
+    backend.SetDelay(10);
+    activator.Request(2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(3));
+    activator.Request(3);
+    {
+        std::unique_lock<std::mutex> lock(gateMutex);
+        gateCv.wait(lock, [&] { return held; });
+    }
+    activator.Request(4);
+    activator.Request(5);
+    {
+        std::lock_guard<std::mutex> lock(gateMutex);
+        open = true;
+    }
+    gateCv.notify_all();
+    idle();
+    log.Attach(activator);
+    results = log.Take();
+    std::vector<WindowId> order;
+    for (const ActivationResult& r : results)
+        order.push_back(r.id);
+    b.Expect(order == std::vector<WindowId>({ 2, 3, 4, 5 }), what + "results in request order");
+    b.Expect(results.size() == 4 && results[0].outcome == ActivationOutcome::Superseded &&
+             results[1].outcome == ActivationOutcome::Coalesced && results[2].outcome == ActivationOutcome::Coalesced &&
+             results[3].outcome == ActivationOutcome::Confirmed,
+             what + "under way superseded, waiting coalesced, newest confirmed");
+    // a superseded attempt must not take the foreground back later
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    b.Expect(backend.Foreground() == 5, what + "newest request ends in front");
+    for (const FakeActivationBackend::Call& c : backend.Calls())
+        b.Expect(!(c.applied && (c.id == 3 || c.id == 4)), what + "coalesced request never attempted");
+    backend.SetDelay(0);
+
+    // escalation: polite strategies are ignored, the last one works
+    activator.Request(10);
+    idle();
+    results = log.Take();
+    b.Expect(results.size() == 1 && results[0].outcome == ActivationOutcome::Confirmed &&
+             results[0].attempts == 3 && results[0].strategy == 2, what + "escalates to the strategy that works");
+    b.Expect(results.size() == 1 && results[0].attemptNs[0] >= timeoutNs && results[0].attemptNs[1] >= timeoutNs,
+             what + "each failed attempt waits out its timeout");
+
+    // nothing works: bounded by the attempts' timeouts
+    auto t0 = std::chrono::steady_clock::now();
+    activator.Request(11);
+    idle();
+    const double tookMs = MsSince(t0);
+    results = log.Take();
+    b.Expect(results.size() == 1 && results[0].outcome == ActivationOutcome::TimedOut &&
+             results[0].attempts == ActivationResult::kMaxAttempts, what + "times out after every attempt");
+    b.Expect(tookMs < (double)ActivationResult::kMaxAttempts * timeoutNs / 1e6 + 50.0, what + "timeout is bounded");
+
+    // a hung application: times out, and doesn't hold up the next switch
+    backend.Hang(12);
+    t0 = std::chrono::steady_clock::now();
+    activator.Request(12);
+    idle();
+    activator.Request(6);
+    idle();
+    results = log.Take();
+    b.Expect(results.size() == 2 && results[0].outcome == ActivationOutcome::TimedOut, what + "hung window times out");
+    b.Expect(results.size() == 2 && results[1].outcome == ActivationOutcome::Confirmed, what + "next switch works while one hangs");
+    b.Expect(MsSince(t0) < (double)ActivationResult::kMaxAttempts * timeoutNs / 1e6 + 100.0, what + "hang is bounded");
+    backend.Release();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    b.Expect(backend.Foreground() == 6, what + "released hang doesn't steal the foreground");
+
+    // a window closed in the meantime
+    backend.Remove(7);
+    activator.Request(7);
+    idle();
+    results = log.Take();
+    b.Expect(results.size() == 1 && results[0].outcome == ActivationOutcome::Gone && results[0].attempts == 1,
+             what + "closed window reported gone");
+
+    const Activator::Stats stats = activator.GetStats();
+    b.Metric("windows/activation/check/attempts", (double)stats.attempts, "count");
+    activator.Stop();
+}
+
+// --- filter rules ---
+
+// What a config with a few hundred rules looks like: mostly excludes of
+// noise by exe or title (few of which match any one window), pins by
+// title, includes of tool windows by class
+static std::vector<WindowRule> MakeRules(size_t count, uint32_t seed = 11) {
+    static const char* const words[] = { "notification", "popup", "toast", "overlay", "updater",
+                                         "helper", "Inbox", "Meeting notes", "Build log", "Design doc" };
+    static const char* const exes[] = { "chrome.exe", "slack.exe", "Teams.exe", "OneDrive.exe",
+                                        "steam.exe", "zoom.exe", "OUTLOOK.EXE", "notepad.exe" };
+    static const char* const classes[] = { "Chrome_WidgetWin_1", "ConsoleWindowClass", "#32770",
+                                           "SDL_app", "TaskManagerWindow", "tooltips_class32" };
+    std::mt19937 rng(seed);
+    std::vector<WindowRule> rules(count);
+    for (size_t i = 0; i < count; ++i) {
+        WindowRule& r = rules[i];
+        const std::string n = std::to_string(rng() % 100);
+        switch (rng() % 10) {
+        case 0: case 1: case 2: case 3:
+            r.action = WindowRuleAction::Exclude;
+            r.exe = exes[rng() % 8];
+            r.title = std::string(words[rng() % 10]) + " " + n;
+            break;
+        case 4: case 5:
+            r.action = WindowRuleAction::Exclude;
+            r.title = std::string(words[rng() % 10]) + n;
+            break;
+        case 6:
+            r.action = WindowRuleAction::Pin;
+            r.title = std::string(words[6 + rng() % 4]) + " " + n;
+            break;
+        case 7:
+            r.action = WindowRuleAction::Pin;
+            r.exe = exes[rng() % 8];
+            r.title = std::string("Inbox ") + n;
+            break;
+        case 8:
+            r.action = WindowRuleAction::Include;
+            r.windowClass = classes[rng() % 6];
+            r.exStyleMask = r.exStyle = ws::ExToolWindow;
+            break;
+        default:
+            r.action = WindowRuleAction::Exclude;
+            r.windowClass = classes[rng() % 6];
+            r.styleMask = ws::Caption;   // captionless
+            break;
+        }
+    }
+    return rules;
+}
+
+// The rules applied the obvious way: every rule in turn, every string
+// searched separately. What the compiled set must agree with.
+static bool ContainsFolded(const std::wstring& text, const std::wstring& pattern) {
+    auto fold = [](wchar_t c) { return (c >= L'A' && c <= L'Z') ? (wchar_t)(c - L'A' + L'a') : c; };
+    return std::search(text.begin(), text.end(), pattern.begin(), pattern.end(),
+                       [&](wchar_t a, wchar_t b) { return fold(a) == fold(b); }) != text.end();
+}
+
+struct NaiveRule {
+    WindowRule   rule;
+    std::wstring title, windowClass, exe;
+};
+
+static std::vector<NaiveRule> MakeNaive(const std::vector<WindowRule>& rules) {
+    std::vector<NaiveRule> out;
+    for (const WindowRule& r : rules) {
+        if (r.title.empty() && r.windowClass.empty() && r.exe.empty() && !r.styleMask && !r.exStyleMask)
+            continue;
+        out.push_back({ r, WideFromUtf8(r.title.data(), r.title.size()),
+                        WideFromUtf8(r.windowClass.data(), r.windowClass.size()),
+                        WideFromUtf8(r.exe.data(), r.exe.size()) });
+    }
+    return out;
+}
+
+static WindowVerdict NaiveVerdict(const FakeWindow& w, const std::vector<NaiveRule>& rules) {
+    if (!w.visible)
+        return WindowVerdict::Reject;
+    if (std::all_of(w.title.begin(), w.title.end(), [](wchar_t c) { return std::iswspace((wint_t)c) != 0; }))
+        return WindowVerdict::Reject;
+    for (const NaiveRule& n : rules) {
+        const WindowRule& r = n.rule;
+        if ((w.style & r.styleMask) != (r.style & r.styleMask) ||
+            (w.exStyle & r.exStyleMask) != (r.exStyle & r.exStyleMask))
+            continue;
+        if (!ContainsFolded(w.title, n.title) || !ContainsFolded(w.windowClass, n.windowClass) ||
+            !ContainsFolded(w.exe, n.exe))
+            continue;
+        switch (r.action) {
+        case WindowRuleAction::Include: return WindowVerdict::Keep;
+        case WindowRuleAction::Exclude: return WindowVerdict::Reject;
+        case WindowRuleAction::Pin:     return WindowVerdict::Pin;
+        }
+    }
+    const bool builtIn = !(w.exStyle & ws::ExToolWindow) && (w.style & ws::Caption) && w.rootOwner;
+    return builtIn ? WindowVerdict::Keep : WindowVerdict::Reject;
+}
+
+static void BenchRules(Bench& b) {
+    const size_t windows = b.Quick() ? 1000 : 10000;
+    const size_t ruleCount = 300;
+    const std::string shape = "/" + std::to_string(ruleCount) + "x" + std::to_string(windows);
+    const std::vector<FakeWindow> desktop = MakeDesktop(windows);
+    const std::vector<WindowRule> rules = MakeRules(ruleCount);
+
+    b.Run("windows/rules/compile/" + std::to_string(ruleCount), [&] {
+        WindowRuleSet compiled(rules);
+        DoNotOptimize(compiled.States());
+    });
+
+    // one enumeration: every window decided, as EnumWindows would see them
+    const WindowRuleSet compiled(rules);
+    WindowRuleSet::Scratch scratch;
+    std::wstring title;
+    size_t kept = 0;
+    b.Run("windows/rules/pass" + shape, [&] {
+        for (const FakeWindow& w : desktop)
+            kept += compiled.Evaluate(w, title, scratch) != WindowVerdict::Reject;
+    });
+    b.ExpectNoAllocs("windows/rules/pass" + shape);
+    b.Run("windows/rules/builtin/" + std::to_string(windows), [&] {
+        for (const FakeWindow& w : desktop)
+            kept += IsSwitchableWindow(w, title);
+    });
+    const std::vector<NaiveRule> naive = MakeNaive(rules);
+    b.Run("windows/rules/naive" + shape, [&] {
+        for (const FakeWindow& w : desktop)
+            kept += NaiveVerdict(w, naive) != WindowVerdict::Reject;
+    });
+    DoNotOptimize(kept);
+
+    scratch.fetches = 0;
+    size_t verdicts[3] = {};
+    for (const FakeWindow& w : desktop)
+        ++verdicts[(int)compiled.Evaluate(w, title, scratch)];
+    b.Metric("windows/rules/states", (double)compiled.States(), "states");
+    b.Metric("windows/rules/classes", (double)compiled.Classes(), "classes");
+    b.Metric("windows/rules/patterns", (double)compiled.Patterns(), "patterns");
+    b.Metric("windows/rules/fetches", (double)scratch.fetches / windows, "strings/window");
+    b.Metric("windows/rules/kept", (double)verdicts[(int)WindowVerdict::Keep], "windows");
+    b.Metric("windows/rules/pinned", (double)verdicts[(int)WindowVerdict::Pin], "windows");
+}
+
+static void CheckRules(Bench& b) {
+    const std::string what = "windows/rules: ";
+    std::wstring title;
+    WindowRuleSet::Scratch scratch;
+    auto rule = [](WindowRuleAction action, const char* title, const char* cls = "", const char* exe = "") {
+        WindowRule r;
+        r.action = action;
+        r.title = title;
+        r.windowClass = cls;
+        r.exe = exe;
+        return r;
+    };
+    auto window = [](const wchar_t* title, const wchar_t* cls = L"Cls", const wchar_t* exe = L"app.exe") {
+        return FakeWindow{ true, 0, ws::Caption, true, title, cls, exe };
+    };
+    using A = WindowRuleAction;
+    using V = WindowVerdict;
+
+    // overlapping patterns all found in one pass (the textbook he/she/his/hers)
+    {
+        const WindowRuleSet set({ rule(A::Exclude, "hers"), rule(A::Pin, "she"), rule(A::Exclude, "his") });
+        b.Expect(set.Evaluate(window(L"ushers"), title, scratch) == V::Reject, what + "overlapping patterns, first rule wins");
+        b.Expect(set.Evaluate(window(L"usher"), title, scratch) == V::Pin, what + "pattern found through a failure link");
+        b.Expect(set.Evaluate(window(L"this"), title, scratch) == V::Reject, what + "pattern at the end");
+        b.Expect(set.Evaluate(window(L"hero"), title, scratch) == V::Keep, what + "no match keeps the built-in verdict");
+    }
+    // ASCII case folding, non-ASCII exact, all conditions of a rule together
+    {
+        const WindowRuleSet set({ rule(A::Exclude, "INBOX", "", "outlook.exe"), rule(A::Pin, "Übersicht") });
+        b.Expect(set.Evaluate(window(L"Inbox - Mail", L"C", L"OUTLOOK.EXE"), title, scratch) == V::Reject,
+                 what + "case-insensitive title and exe");
+        b.Expect(set.Evaluate(window(L"Inbox - Mail", L"C", L"thunderbird.exe"), title, scratch) == V::Keep,
+                 what + "a rule needs all its conditions");
+        b.Expect(set.Evaluate(window(L"Die Übersicht"), title, scratch) == V::Pin, what + "non-ASCII pattern");
+    }
+    // includes and style tests; strings fetched only when they can matter
+    {
+        WindowRule tool = rule(A::Include, "", "ConsoleWindowClass");
+        tool.exStyleMask = tool.exStyle = ws::ExToolWindow;
+        WindowRule popups = rule(A::Exclude, "", "", "popup.exe");
+        popups.styleMask = ws::Popup;
+        popups.style = ws::Popup;
+        const WindowRuleSet set({ tool, popups });
+        FakeWindow console = window(L"cmd", L"ConsoleWindowClass");
+        console.exStyle = ws::ExToolWindow;
+        b.Expect(set.Evaluate(console, title, scratch) == V::Keep, what + "include a tool window by class");
+        console.windowClass = L"Other";
+        b.Expect(set.Evaluate(console, title, scratch) == V::Reject, what + "include needs its class");
+        scratch.fetches = 0;
+        b.Expect(set.Evaluate(window(L"Editor"), title, scratch) == V::Keep && scratch.fetches == 0,
+                 what + "no string fetched when no rule's styles fit");
+        FakeWindow hidden = window(L"cmd", L"ConsoleWindowClass");
+        hidden.visible = false;
+        hidden.exStyle = ws::ExToolWindow;
+        b.Expect(set.Evaluate(hidden, title, scratch) == V::Reject && scratch.fetches == 0,
+                 what + "invisible windows are never looked at");
+        FakeWindow popup = window(L"Popup", L"C", L"popup.exe");
+        popup.style |= ws::Popup;
+        b.Expect(set.Evaluate(popup, title, scratch) == V::Reject && scratch.fetches == 1,
+                 what + "exclude by style and exe");
+        b.Expect(set.Evaluate(window(L"   "), title, scratch) == V::Reject, what + "blank titles are never listed");
+        b.Expect(WindowRuleSet({ WindowRule() }).Empty(), what + "a rule without conditions is dropped");
+    }
+
+    // the compiled set and the rule-by-rule reading agree on a whole desktop
+    {
+        const std::vector<FakeWindow> desktop = MakeDesktop(5000);
+        const std::vector<WindowRule> rules = MakeRules(400, 5);
+        const WindowRuleSet set(rules);
+        const std::vector<NaiveRule> naive = MakeNaive(rules);
+        size_t differ = 0, matched = 0;
+        for (const FakeWindow& w : desktop) {
+            const V v = set.Evaluate(w, title, scratch);
+            differ += v != NaiveVerdict(w, naive);
+            matched += v != (IsSwitchableWindow(w, title) ? V::Keep : V::Reject);
+        }
+        b.Metric("windows/rules/check/changed", (double)matched, "windows");
+        b.Expect(differ == 0, what + "compiled rules disagree with evaluating them one by one");
+        b.Expect(matched > 0, what + "the generated rules never change a verdict");
+    }
+
+    // wws_config.json round trip, compiled again on load
+    {
+        WindowRule styled = rule(A::Include, "", "ConsoleWindowClass");
+        styled.exStyleMask = styled.exStyle = ws::ExToolWindow;
+        styled.styleMask = ws::Caption;
+        HotkeyConfig cfg;
+        cfg.windowRules = std::make_shared<const WindowRuleSet>(std::vector<WindowRule>{
+            rule(A::Pin, "Inbox", "", "OUTLOOK.EXE"), styled, rule(A::Exclude, "Übersicht") });
+        const std::string path = (std::filesystem::temp_directory_path() / "wws_bench_rules.json").string();
+        HotkeyConfig loaded;
+        b.Expect(SaveSettings(cfg, path) && LoadSettings(path, loaded), what + "cannot save and load rules");
+        b.Expect(loaded.windowRules && loaded.windowRules->Rules() == cfg.windowRules->Rules() && loaded == cfg,
+                 what + "rules changed on the way through the file");
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+
+    // pinned windows in the registry, and re-deciding after a rule change
+    {
+        WindowRegistry reg;
+        FakeWindowEventSource src;
+        src.Start(reg);
+        for (WindowId id = 1; id <= 5; ++id)
+            src.Create(id, L"w" + std::to_wstring(id), 0, id == 4);
+        src.Focus(2);
+        // MRU: 2 1 3 4 5; 4 is pinned
+        b.Expect(reg.At(0) == 2 && reg.At(1) == 4 && reg.At(2) == 1 && reg.At(3) == 3,
+                 what + "a pinned window comes right after the active one");
+        b.Expect(reg.MruAt(1) == 1, what + "pins don't change the previous window");
+        std::vector<WindowRecord> now(3);
+        now[0].id = 2; now[0].title = L"w2";
+        now[1].id = 5; now[1].title = L"w5"; now[1].pinned = true;
+        now[2].id = 6; now[2].title = L"w6";
+        reg.Reconcile(now);
+        b.Expect(reg.Size() == 3 && reg.At(0) == 2 && reg.At(1) == 5 && reg.At(2) == 6,
+                 what + "reconcile drops, pins and adds");
+        src.Create(7, L"w7", 0, true);
+        b.Expect(reg.At(1) == 5 && reg.At(2) == 7 && reg.At(3) == 6, what + "pins keep their MRU order");
+        src.Rename(5, L"w5 renamed");
+        b.Expect(reg.At(1) == 7 && reg.At(2) == 5, what + "a rename without the pin unpins");
+    }
+}
+
+void BenchWindows(Bench& b) {
+    if (b.Wants("windows/filter/"))        BenchPredicate(b);
+    if (b.Wants("windows/rules/"))         BenchRules(b);
+    if (b.Wants("windows/rules/check"))    CheckRules(b);
+    if (b.Wants("windows/registry/"))      BenchRegistry(b);
+    if (b.Wants("windows/registry/check")) CheckRegistry(b);
+    if (b.Wants("windows/process_cache/")) BenchProcessCache(b);
+    if (b.Wants("windows/process_cache/check")) CheckProcessCache(b);
+    if (b.Wants("windows/fetch_pool/check")) CheckFetchPool(b);
+    if (b.Wants("windows/frecency/"))      BenchFrecency(b);
+    if (b.Wants("windows/frecency/check")) CheckFrecency(b);
+    if (b.Wants("windows/activation/"))    BenchActivation(b);
+    if (b.Wants("windows/activation/check")) CheckActivation(b);
+}
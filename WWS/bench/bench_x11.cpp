@@ -0,0 +1,126 @@
+﻿// === bench/bench_x11.cpp ===
+// Needs an X server: run under Xvfb (xvfb-run -s "-screen 0 1920x1080x24"
+// wws_bench --filter x11/). Without a window manager nobody maintains the
+// client list, so the benchmark creates its own windows and publishes them
+// in _NET_CLIENT_LIST_STACKING itself.
+#include "harness.h"
+#include "fixtures.h"
+#include "x11_window_system.h"
+#include "utf8.h"
+
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+
+// Unmapped windows carrying what a real client sets; a few are tool or
+// transient windows so the filter has something to reject
+static std::vector<xcb_window_t> CreateClients(X11WindowSystem& ws, size_t count) {
+    xcb_connection_t* c = ws.Connection();
+    const xcb_screen_t* screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+    const std::vector<std::wstring> titles = MakeTitles(count);
+    const uint32_t pid = (uint32_t)getpid();
+    std::vector<xcb_window_t> ids(count);
+    for (size_t i = 0; i < count; ++i) {
+        xcb_window_t w = xcb_generate_id(c);
+        ids[i] = w;
+        xcb_create_window(c, XCB_COPY_FROM_PARENT, w, ws.Root(), 0, 0, 1, 1, 0,
+                          XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual, 0, nullptr);
+        std::string title;
+        AppendUtf8(title, titles[i]);
+        xcb_change_property(c, XCB_PROP_MODE_REPLACE, w, ws.AtomOf(X11WindowSystem::NetWmName),
+                            ws.AtomOf(X11WindowSystem::Utf8String), 8, (uint32_t)title.size(), title.data());
+        xcb_change_property(c, XCB_PROP_MODE_REPLACE, w, ws.AtomOf(X11WindowSystem::NetWmPid),
+                            XCB_ATOM_CARDINAL, 32, 1, &pid);
+        xcb_atom_t type = ws.AtomOf(X11WindowSystem::NetWmWindowTypeNormal);
+        xcb_change_property(c, XCB_PROP_MODE_REPLACE, w, ws.AtomOf(X11WindowSystem::NetWmWindowType),
+                            XCB_ATOM_ATOM, 32, 1, &type);
+        if (i % 10 == 3) {
+            xcb_atom_t state = ws.AtomOf(X11WindowSystem::NetWmStateSkipTaskbar);
+            xcb_change_property(c, XCB_PROP_MODE_REPLACE, w, ws.AtomOf(X11WindowSystem::NetWmState),
+                                XCB_ATOM_ATOM, 32, 1, &state);
+        }
+        if (i % 10 == 7 && i > 0)
+            xcb_change_property(c, XCB_PROP_MODE_REPLACE, w, XCB_ATOM_WM_TRANSIENT_FOR,
+                                XCB_ATOM_WINDOW, 32, 1, &ids[i - 1]);
+    }
+    xcb_change_property(c, XCB_PROP_MODE_REPLACE, ws.Root(), ws.AtomOf(X11WindowSystem::NetClientListStacking),
+                        XCB_ATOM_WINDOW, 32, (uint32_t)ids.size(), ids.data());
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), nullptr));   // wait until it's all there
+    return ids;
+}
+
+static void DestroyClients(X11WindowSystem& ws, const std::vector<xcb_window_t>& ids) {
+    xcb_connection_t* c = ws.Connection();
+    xcb_delete_property(c, ws.Root(), ws.AtomOf(X11WindowSystem::NetClientListStacking));
+    for (xcb_window_t w : ids)
+        xcb_destroy_window(c, w);
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), nullptr));
+}
+
+// What the snapshot would cost with one blocking request per property,
+// the way the Win32 enumeration works
+static size_t SerialSnapshot(X11WindowSystem& ws) {
+    xcb_connection_t* c = ws.Connection();
+    auto get = [&](xcb_window_t w, xcb_atom_t prop, xcb_atom_t type, uint32_t len) {
+        return xcb_get_property_reply(c, xcb_get_property(c, 0, w, prop, type, 0, len), nullptr);
+    };
+    xcb_get_property_reply_t* list =
+        get(ws.Root(), ws.AtomOf(X11WindowSystem::NetClientListStacking), XCB_ATOM_WINDOW, 4096);
+    size_t bytes = 0;
+    if (list) {
+        const xcb_window_t* w = (const xcb_window_t*)xcb_get_property_value(list);
+        const int n = xcb_get_property_value_length(list) / 4;
+        for (int i = 0; i < n; ++i) {
+            xcb_get_property_reply_t* r[] = {
+                get(w[i], ws.AtomOf(X11WindowSystem::NetWmName), ws.AtomOf(X11WindowSystem::Utf8String), 1024),
+                get(w[i], XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 1024),
+                get(w[i], ws.AtomOf(X11WindowSystem::NetWmPid), XCB_ATOM_CARDINAL, 1),
+                get(w[i], ws.AtomOf(X11WindowSystem::NetWmState), XCB_ATOM_ATOM, 32),
+                get(w[i], ws.AtomOf(X11WindowSystem::NetWmWindowType), XCB_ATOM_ATOM, 8),
+                get(w[i], XCB_ATOM_WM_TRANSIENT_FOR, XCB_ATOM_WINDOW, 1),
+            };
+            for (xcb_get_property_reply_t* p : r) {
+                bytes += p ? (size_t)xcb_get_property_value_length(p) : 0;
+                free(p);
+            }
+        }
+    }
+    free(list);
+    return bytes;
+}
+
+void BenchX11(Bench& b) {
+    X11WindowSystem ws;
+    if (!ws.Connect()) {
+        std::fprintf(stderr, "x11/: no X display, skipped (run under Xvfb)\n");
+        return;
+    }
+
+    // a real window manager keeps its own list; otherwise bring our own
+    std::vector<WindowRecord> snap;
+    std::vector<xcb_window_t> ours;
+    ws.Snapshot(snap);
+    if (snap.empty())
+        ours = CreateClients(ws, b.Quick() ? 100 : 500);
+
+    const uint64_t rt0 = ws.RoundTrips();
+    ws.Snapshot(snap);
+    const uint64_t roundTrips = ws.RoundTrips() - rt0;
+    const std::string suffix = "/" + std::to_string(ours.empty() ? snap.size() : ours.size());
+
+    b.Run("x11/snapshot" + suffix, [&] { ws.Snapshot(snap); });
+    b.Metric("x11/snapshot" + suffix + "/round_trips", (double)roundTrips, "round-trips");
+    b.Metric("x11/snapshot" + suffix + "/switchable", (double)snap.size(), "windows");
+
+    if (b.Wants("x11/snapshot_serial")) {
+        b.Run("x11/snapshot_serial" + suffix, [&] { DoNotOptimize(SerialSnapshot(ws)); });
+        const size_t clients = ours.empty() ? snap.size() : ours.size();
+        b.Metric("x11/snapshot_serial" + suffix + "/round_trips", (double)(1 + clients * 6), "round-trips");
+    }
+
+    if (!snap.empty())
+        b.Run("x11/activate", [&] { ws.Activate(snap.front().id); });
+
+    if (!ours.empty())
+        DestroyClients(ws, ours);
+}
@@ -0,0 +1,210 @@
+﻿// === bench/fixtures.cpp ===
+#include "fixtures.h"
+#include "process_cache.h"
+
+#include <memory>
+#include <random>
+
+static const wchar_t* const kApps[] = {
+    L"Visual Studio Code", L"Google Chrome", L"Mozilla Firefox", L"Notepad", L"Slack",
+    L"Windows Terminal", L"File Explorer", L"Spotify", L"Discord", L"Microsoft Outlook",
+    L"Microsoft Word", L"Microsoft Excel", L"Task Manager", L"Steam", L"OBS Studio",
+};
+static const wchar_t* const kExes[] = {
+    L"Code.exe", L"chrome.exe", L"firefox.exe", L"notepad.exe", L"slack.exe",
+    L"WindowsTerminal.exe", L"explorer.exe", L"Spotify.exe", L"Discord.exe", L"OUTLOOK.EXE",
+    L"WINWORD.EXE", L"EXCEL.EXE", L"Taskmgr.exe", L"steam.exe", L"obs64.exe",
+};
+static const wchar_t* const kWords[] = {
+    L"main.cpp", L"README.md", L"Issue #4211", L"Pull request", L"Quarterly report",
+    L"Budget 2024", L"Meeting notes", L"Inbox", L"Settings", L"Build log",
+    L"Design doc", L"Übersicht", L"日本語のページ", L"window_registry.h", L"Release checklist",
+};
+static constexpr size_t kAppCount = sizeof(kApps) / sizeof(kApps[0]);
+static constexpr size_t kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+
+std::vector<std::wstring> MakeTitles(size_t count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<std::wstring> titles(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::wstring& t = titles[i];
+        t = kWords[rng() % kWordCount];
+        t += L" ";
+        t += std::to_wstring(rng() % 1000);
+        if (rng() % 2) {
+            t += L" - ";
+            t += kWords[rng() % kWordCount];
+        }
+        t += L" - ";
+        t += kApps[i % kAppCount];
+    }
+    return titles;
+}
+
+// --- titles in other scripts ---
+
+static const wchar_t* const kLatinWords[] = {
+    L"Café", L"résumé", L"Überweisung", L"prüfen", L"Año", L"señal", L"façade", L"naïve",
+    L"Łódź", L"Şehir", L"Dvořák", L"Ærø", L"smörgåsbord", L"crème brûlée",
+};
+static const wchar_t* const kCyrillicWords[] = {
+    L"Привет", L"мир", L"Документы", L"Новости", L"Почта", L"Отчёт", L"Загрузки",
+    L"Настройки", L"Київ", L"Београд", L"Юля", L"щётка",
+};
+static const wchar_t* const kGreekWords[] = {
+    L"Καλημέρα", L"κόσμε", L"Έγγραφα", L"Ειδήσεις", L"Ρυθμίσεις", L"Ψάρι", L"ωραία",
+};
+static const wchar_t* const kEmojiWords[] = {
+    L"🎉", L"🔥", L"✅", L"🚀", L"📁", L"💬", L"⚠️", L"🐛", L"🎵", L"☕",
+};
+
+template <size_t N>
+static void AddWords(std::wstring& t, std::mt19937& rng, const wchar_t* const (&words)[N], int count) {
+    for (int w = 0; w < count; ++w) {
+        if (w)
+            t += L' ';
+        t += words[rng() % N];
+    }
+}
+
+const char* TitleScriptName(TitleScript script) {
+    switch (script) {
+    case TitleScript::Latin:    return "latin";
+    case TitleScript::Cyrillic: return "cyrillic";
+    case TitleScript::Greek:    return "greek";
+    case TitleScript::Cjk:      return "cjk";
+    case TitleScript::Emoji:    return "emoji";
+    case TitleScript::Mixed:    return "mixed";
+    }
+    return "?";
+}
+
+std::vector<std::wstring> MakeScriptTitles(size_t count, TitleScript script, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<std::wstring> titles(count);
+    for (size_t i = 0; i < count; ++i) {
+        TitleScript s = script == TitleScript::Mixed ? (TitleScript)(rng() % 5) : script;
+        std::wstring& t = titles[i];
+        switch (s) {
+        case TitleScript::Latin:    AddWords(t, rng, kLatinWords, 3); break;
+        case TitleScript::Cyrillic: AddWords(t, rng, kCyrillicWords, 3); break;
+        case TitleScript::Greek:    AddWords(t, rng, kGreekWords, 3); break;
+        case TitleScript::Emoji:
+            AddWords(t, rng, kEmojiWords, 1);
+            t += L' ';
+            t += kWords[rng() % kWordCount];
+            break;
+        default:
+            // eight ideographs from the 3000 after U+4E00, which is about
+            // how many distinct ones a busy CJK desktop shows
+            for (int c = 0; c < 8; ++c)
+                t += (wchar_t)(0x4E00 + rng() % 3000);
+            break;
+        }
+        t += L" - ";
+        t += kApps[i % kAppCount];
+    }
+    return titles;
+}
+
+const std::vector<std::wstring>& RealWorldTitles() {
+    static const std::vector<std::wstring> titles = {
+        L"Inbox (3) - someone@example.com - Gmail - Google Chrome",
+        L"Pull requests · gxrwes/WesWindowSwitcher - Mozilla Firefox",
+        L"main.cpp - WesWindowSwitcher - Visual Studio Code",
+        L"Quarterly planning notes, second draft with comments from the whole team (shared) - Project Wiki - Mozilla Firefox",
+        L"Windows PowerShell",
+        L"Administrator: Command Prompt",
+        L"Calculator",
+        L"Spotify Premium",
+        L"#general | Acme Engineering - Slack",
+        L"Document1 - Word",
+        L"Budget 2024.xlsx - Excel",
+        L"Résumé_final_v3.docx - Word",
+        L"Café Müller – Speisekarte.pdf - Adobe Acrobat Reader",
+        L"Straße und Wegenetz — Übersicht - Mozilla Firefox",
+        L"Nouvel onglet - Google Chrome",
+        L"Conférence de presse : les réactions en direct - Le Monde - Microsoft Edge",
+        L"Входящие - Почта Mail.ru - Яндекс Браузер",
+        L"Отчёт_за_квартал.docx - Word",
+        L"Главная страница — Википедия - Mozilla Firefox",
+        L"Київ: новини дня - Google Chrome",
+        L"Καλημέρα κόσμε - Έγγραφα Google - Google Chrome",
+        L"Ρυθμίσεις συστήματος",
+        L"受信トレイ - Outlook",
+        L"新しいタブ - Google Chrome",
+        L"東京都の天気予報 - Yahoo!天気・災害 - Microsoft Edge",
+        L"無題 - メモ帳",
+        L"百度一下，你就知道 - Google Chrome",
+        L"微信",
+        L"我的文档 - 文件资源管理器",
+        L"네이버 메일 - Whale",
+        L"카카오톡",
+        L"ข่าววันนี้ - Thairath - Google Chrome",
+        L"हिन्दी समाचार - नवभारत टाइम्स - Mozilla Firefox",
+        L"الصفحة الرئيسية - ويكيبيديا - Google Chrome",
+        L"תיבת דואר נכנס - Gmail - Mozilla Firefox",
+        L"Yeni sekme - Opera",
+        L"Wiadomości - Onet.pl - Microsoft Edge",
+        L"Česká televize – zprávy - Mozilla Firefox",
+        L"Tiếng Việt – Báo Mới - Cốc Cốc",
+        L"🎉 Release party! - Discord",
+        L"🔥 Hot fixes (12) - Jira - Google Chrome",
+        L"✅ Done - Todoist",
+        L"💬 Chat with 👩‍💻 Dana - Microsoft Teams",
+        L"🚀 Deploy #4821 succeeded · Actions - GitHub - Mozilla Firefox",
+        L"README.md — ~/src/wws — Sublime Text (UNREGISTERED)",
+        L"vim ~/.config/nvim/init.lua",
+        L"user@host: ~/projects/wws/build",
+        L"YouTube - Lo-fi beats to code to 📻 - Google Chrome",
+        L"Zoom Meeting",
+        L"Task Manager",
+        L"Settings",
+        L"Steam",
+        L"OBS 30.0.2 - Profile: Untitled - Scenes: Untitled",
+        L"Untitled - Paint",
+        L"Photos - IMG_20240312_184455.jpg",
+        L"Picture-in-picture",
+        L"C:\\Users\\Public\\Downloads\\installer_x64_setup (1).exe",
+        L"Ελληνικά, Русский, 日本語 and English in one title - Notes",
+        L"Mathematical 𝐁𝐨𝐥𝐝 and 𝔉𝔯𝔞𝔨𝔱𝔲𝔯 letters - Wikipedia - Mozilla Firefox",
+        L"Emoji ZWJ test: 👨‍👩‍👧‍👦 🏳️‍🌈 🇺🇦 - Google Chrome",
+    };
+    return titles;
+}
+
+WindowId WindowIdFor(size_t i) {
+    return 0x10000 + i * 16;
+}
+
+uint32_t PidFor(size_t i) {
+    return (uint32_t)(1000 + (i % kAppCount) * 4);
+}
+
+std::wstring ExePathFor(size_t i) {
+    return std::wstring(L"C:\\Program Files\\") + kApps[i % kAppCount] + L"\\" + kExes[i % kAppCount];
+}
+
+void AddProcesses(FakeProcessInfoProvider& provider) {
+    for (size_t a = 0; a < kAppCount; ++a)
+        provider.Add(PidFor(a), 1, ExePathFor(a));
+}
+
+void MakeSnapshot(size_t count, WindowSnapshot& out, uint32_t seed) {
+    std::vector<std::shared_ptr<const ProcessInfo>> procs(kAppCount);
+    for (size_t a = 0; a < kAppCount; ++a) {
+        auto p = std::make_shared<ProcessInfo>();
+        p->pid = PidFor(a);
+        p->startTime = 1;
+        p->exePath = ExePathFor(a);
+        p->exeName = kExes[a];
+        procs[a] = std::move(p);
+    }
+
+    const std::vector<std::wstring> titles = MakeTitles(count, seed);
+    out.Clear();
+    for (size_t i = 0; i < count; ++i) {
+        out.Add(WindowIdFor(i), titles[i], PidFor(i));
+        out.SetProcess(i, procs[i % kAppCount]);
+    }
+}
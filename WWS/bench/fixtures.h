@@ -0,0 +1,34 @@
+// === bench/fixtures.h ===
+#pragma once
+
+#include "window_snapshot.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Plausible desktop titles ("<doc> - <site> - <App>"), deterministic per seed
+std::vector<std::wstring> MakeTitles(size_t count, uint32_t seed = 1);
+
+// Titles in one script, or a mix of all of them, for font and glyph work
+enum class TitleScript { Latin, Cyrillic, Greek, Cjk, Emoji, Mixed };
+const char*               TitleScriptName(TitleScript script);
+std::vector<std::wstring> MakeScriptTitles(size_t count, TitleScript script, uint32_t seed = 1);
+
+// Titles as real apps write them, in a dozen languages: browsers, mail,
+// editors, chat, terminals; mixed scripts, emoji and the odd overlong one
+const std::vector<std::wstring>& RealWorldTitles();
+
+class FakeProcessInfoProvider;
+
+// Fills out with windows with those titles and process info attached
+// (a few dozen distinct exes, like a real desktop)
+void MakeSnapshot(size_t count, WindowSnapshot& out, uint32_t seed = 1);
+
+// The id, pid and exe path MakeSnapshot gives window i
+WindowId     WindowIdFor(size_t i);
+uint32_t     PidFor(size_t i);
+std::wstring ExePathFor(size_t i);
+
+// Registers every PidFor() process, so a ProcessCache can resolve them
+void AddProcesses(FakeProcessInfoProvider& provider);
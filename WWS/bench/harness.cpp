@@ -0,0 +1,194 @@
+﻿// === bench/harness.cpp ===
+#include "harness.h"
+#include "json.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <new>
+
+#ifndef WWS_VERSION
+#define WWS_VERSION "unknown"
+#endif
+#ifndef WWS_BUILD_TYPE
+#define WWS_BUILD_TYPE ""
+#endif
+
+using json = nlohmann::json;
+
+// --- allocation counting ---
+
+static std::atomic<uint64_t> g_allocs{ 0 };
+
+uint64_t AllocCount() {
+    return g_allocs.load(std::memory_order_relaxed);
+}
+
+void* CountingMalloc(size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+void CountingFree(void* p) {
+    std::free(p);
+}
+
+static void* AlignedAlloc(size_t size, size_t align) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+#ifdef _WIN32
+    return _aligned_malloc(size ? size : 1, align);
+#else
+    void* p = nullptr;
+    return posix_memalign(&p, std::max(align, sizeof(void*)), size ? size : 1) == 0 ? p : nullptr;
+#endif
+}
+
+static void AlignedFree(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void* operator new(size_t size) {
+    if (void* p = CountingMalloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return ::operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return CountingMalloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return CountingMalloc(size); }
+void  operator delete(void* p) noexcept { CountingFree(p); }
+void  operator delete[](void* p) noexcept { CountingFree(p); }
+void  operator delete(void* p, size_t) noexcept { CountingFree(p); }
+void  operator delete[](void* p, size_t) noexcept { CountingFree(p); }
+
+void* operator new(size_t size, std::align_val_t a) {
+    if (void* p = AlignedAlloc(size, (size_t)a))
+        return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size, std::align_val_t a) { return ::operator new(size, a); }
+void  operator delete(void* p, std::align_val_t) noexcept { AlignedFree(p); }
+void  operator delete[](void* p, std::align_val_t) noexcept { AlignedFree(p); }
+void  operator delete(void* p, size_t, std::align_val_t) noexcept { AlignedFree(p); }
+void  operator delete[](void* p, size_t, std::align_val_t) noexcept { AlignedFree(p); }
+
+// --- results ---
+
+static double Percentile(const std::vector<double>& sorted, double q) {
+    if (sorted.empty())
+        return 0.0;
+    size_t i = (size_t)(q * (double)(sorted.size() - 1) + 0.5);
+    return sorted[std::min(i, sorted.size() - 1)];
+}
+
+static bool StartsWith(const std::string& s, const std::string& prefix) {
+    return s.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool Bench::Selected(const std::string& name) const {
+    return StartsWith(name, m_opts.filter);
+}
+
+bool Bench::Wants(const std::string& prefix) const {
+    return StartsWith(prefix, m_opts.filter) || StartsWith(m_opts.filter, prefix);
+}
+
+void Bench::PrintHeader() const {
+    std::printf("wws_bench %s (%s)%s\n", WWS_VERSION,
+        *WWS_BUILD_TYPE ? WWS_BUILD_TYPE : "no build type, timings unoptimised",
+        m_opts.quick ? " quick" : "");
+    std::printf("%-44s %12s %12s %12s %10s %12s\n",
+        "benchmark", "ns/op", "p50", "p99", "allocs/op", "iterations");
+}
+
+void Bench::Finish(const std::string& name, std::vector<double>& perOp, uint64_t iterations,
+    double totalNs, uint64_t allocs)
+{
+    std::sort(perOp.begin(), perOp.end());
+    BenchResult r;
+    r.name = name;
+    r.iterations = iterations;
+    r.nsPerOp = iterations ? totalNs / (double)iterations : 0.0;
+    r.p50 = Percentile(perOp, 0.50);
+    r.p99 = Percentile(perOp, 0.99);
+    r.allocsPerOp = iterations ? (double)allocs / (double)iterations : 0.0;
+    std::printf("%-44s %12.1f %12.1f %12.1f %10.2f %12llu\n", r.name.c_str(),
+        r.nsPerOp, r.p50, r.p99, r.allocsPerOp, (unsigned long long)r.iterations);
+    std::fflush(stdout);
+    m_results.push_back(std::move(r));
+}
+
+void Bench::Samples(const std::string& name, std::vector<double> ns, double allocsPerOp) {
+    if (!Selected(name) || ns.empty())
+        return;
+    double total = 0.0;
+    for (double v : ns)
+        total += v;
+    uint64_t count = ns.size();
+    Finish(name, ns, count, total, (uint64_t)(allocsPerOp * (double)count + 0.5));
+}
+
+void Bench::Metric(const std::string& name, double value, const std::string& unit) {
+    if (!Selected(name))
+        return;
+    std::printf("%-44s %12.3f %s\n", name.c_str(), value, unit.c_str());
+    std::fflush(stdout);
+    m_metrics.push_back({ name, value, unit });
+}
+
+void Bench::Expect(bool ok, const std::string& what) {
+    ++m_checks;
+    if (ok)
+        return;
+    std::fprintf(stderr, "FAIL %s\n", what.c_str());
+    m_failed = true;
+}
+
+void Bench::ExpectNoAllocs(const std::string& name) {
+    char what[160];
+    for (const BenchResult& r : m_results) {
+        if (r.name != name)
+            continue;
+        std::snprintf(what, sizeof(what), "%s: %.3f allocs/op, expected none", name.c_str(), r.allocsPerOp);
+        Expect(r.allocsPerOp == 0.0, what);
+    }
+}
+
+bool Bench::WriteJson(const std::string& path) const {
+    char when[32] = "";
+    std::time_t t = std::time(nullptr);
+    if (std::tm* tm = std::gmtime(&t))
+        std::strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%SZ", tm);
+
+    json j;
+    j["version"] = WWS_VERSION;
+    j["build_type"] = WWS_BUILD_TYPE;
+    j["timestamp"] = when;
+    j["quick"] = m_opts.quick;
+    j["results"] = json::array();
+    for (const BenchResult& r : m_results) {
+        j["results"].push_back({
+            { "name", r.name },
+            { "iterations", r.iterations },
+            { "ns_per_op", r.nsPerOp },
+            { "p50_ns", r.p50 },
+            { "p99_ns", r.p99 },
+            { "allocs_per_op", r.allocsPerOp },
+        });
+    }
+    j["metrics"] = json::array();
+    for (const BenchMetric& m : m_metrics)
+        j["metrics"].push_back({ { "name", m.name }, { "value", m.value }, { "unit", m.unit } });
+
+    std::ofstream ofs(path);
+    if (!ofs)
+        return false;
+    ofs << j.dump(2) << "\n";
+    return (bool)ofs;
+}
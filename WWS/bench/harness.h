@@ -0,0 +1,150 @@
+﻿// === bench/harness.h ===
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Keeps the compiler from optimising a result (and the work behind it) away
+template <class T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// Heap allocations made so far. The harness replaces the global operator
+// new, so everything that goes through it is counted; code with its own
+// allocator hooks (ImGui) can route them through CountingMalloc/Free.
+uint64_t AllocCount();
+void*    CountingMalloc(size_t size);
+void     CountingFree(void* p);
+
+struct BenchOptions {
+    std::string filter;              // run only names starting with this ("keys/")
+    double      minTimeMs = 200.0;   // per timed benchmark
+    bool        quick = false;       // smaller inputs and fewer samples, for smoke runs
+    std::string jsonPath;            // machine-readable results, "" for none
+    std::string goldenDir;           // reference images for overlay/soft/, "" for none
+};
+
+struct BenchResult {
+    std::string name;
+    uint64_t    iterations = 0;
+    double      nsPerOp = 0.0;       // mean
+    double      p50 = 0.0;           // over batches (timed) or samples (latency)
+    double      p99 = 0.0;
+    double      allocsPerOp = 0.0;
+};
+
+struct BenchMetric {
+    std::string name;
+    double      value = 0.0;
+    std::string unit;
+};
+
+// Collects and prints results. Run() times an operation in batches sized to
+// ~50us each, so p50/p99 are per-batch ns/op; Samples() reports latencies
+// the benchmark measured itself; Metric() records plain numbers (sizes,
+// counts, ratios) that should be tracked alongside the timings.
+class Bench {
+public:
+    explicit Bench(BenchOptions opts) : m_opts(std::move(opts)) {}
+
+    const BenchOptions& Options() const { return m_opts; }
+    bool Quick() const { return m_opts.quick; }
+
+    // Whether any benchmark whose name starts with prefix is selected; lets
+    // a group skip its setup
+    bool Wants(const std::string& prefix) const;
+
+    template <class F>
+    void Run(const std::string& name, F&& op);
+
+    void Samples(const std::string& name, std::vector<double> ns, double allocsPerOp = 0.0);
+    void Metric(const std::string& name, double value, const std::string& unit);
+
+    // Counts a check; fails the run (Failed(), and a non-zero exit) unless ok
+    void Expect(bool ok, const std::string& what);
+    // Fails the run if benchmark name made any heap allocation; for paths
+    // that must not allocate in steady state
+    void ExpectNoAllocs(const std::string& name);
+    bool Failed() const { return m_failed; }
+    size_t Checks() const { return m_checks; }
+
+    bool WriteJson(const std::string& path) const;
+    void PrintHeader() const;
+    size_t Count() const { return m_results.size() + m_metrics.size() + m_checks; }
+
+private:
+    static constexpr uint64_t kBatchNs = 50000;
+    static constexpr size_t   kMinBatches = 10;
+    static constexpr size_t   kMaxBatches = 4000;
+
+    bool Selected(const std::string& name) const;
+    void Finish(const std::string& name, std::vector<double>& perOp, uint64_t iterations,
+                double totalNs, uint64_t allocs);
+
+    BenchOptions             m_opts;
+    std::vector<BenchResult> m_results;
+    std::vector<BenchMetric> m_metrics;
+    bool                     m_failed = false;
+    size_t                   m_checks = 0;
+};
+
+template <class F>
+void Bench::Run(const std::string& name, F&& op) {
+    if (!Selected(name))
+        return;
+    using clock = std::chrono::steady_clock;
+    auto elapsed = [](clock::time_point t0) {
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - t0).count();
+    };
+
+    // grow the batch until one takes about kBatchNs (this doubles as warm-up)
+    uint64_t batch = 1;
+    for (;;) {
+        auto t0 = clock::now();
+        for (uint64_t i = 0; i < batch; ++i)
+            op();
+        double ns = elapsed(t0);
+        if (ns >= (double)kBatchNs || batch >= (1ull << 30))
+            break;
+        batch *= (ns * 8 < (double)kBatchNs) ? 8 : 2;
+    }
+
+    const double budgetNs = (m_opts.quick ? 20.0 : m_opts.minTimeMs) * 1e6;
+    std::vector<double> perOp;
+    perOp.reserve(kMaxBatches);   // nothing in the timed loop allocates for us
+    uint64_t iterations = 0;
+    double   totalNs = 0.0;
+    const uint64_t allocs0 = AllocCount();
+    while (perOp.size() < kMinBatches || (totalNs < budgetNs && perOp.size() < kMaxBatches)) {
+        auto t0 = clock::now();
+        for (uint64_t i = 0; i < batch; ++i)
+            op();
+        double ns = elapsed(t0);
+        perOp.push_back(ns / (double)batch);
+        iterations += batch;
+        totalNs += ns;
+    }
+    Finish(name, perOp, iterations, totalNs, AllocCount() - allocs0);
+}
+
+// --- groups, one per bench_*.cpp; names are "<group>/<what>[/<size>]" ---
+void BenchWindows(Bench& b);    // windows/   predicate, rules, registry, process cache, frecency, activation
+void BenchKeys(Bench& b);       // keys/      switcher, channel, hold timing, bindings
+void BenchOverlay(Bench& b);    // overlay/   titles, filter, frames, icons, glyphs, software rendering, steady state, scheduling, resident mode, thumbnails, display text
+void BenchSettings(Bench& b);   // settings/  JSON load/save
+void BenchTrace(Bench& b);      // trace/     span recording, latency histograms, export
+#ifdef WWS_BENCH_CONTROL
+void BenchControl(Bench& b);    // control/   the control socket: protocol, load from many clients
+#endif
+#ifdef WWS_BENCH_X11
+void BenchX11(Bench& b);        // x11/       XCB snapshots (needs an X server)
+#endif
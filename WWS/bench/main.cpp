@@ -0,0 +1,76 @@
+﻿// === bench/main.cpp ===
+// Micro-benchmarks for every hot path that builds without Windows.
+//
+//   wws_bench [--filter <prefix>] [--json <file>] [--min-time <ms>] [--quick]
+//             [--golden <dir>]
+//
+//   --filter    only run benchmarks whose name starts with prefix ("keys/")
+//   --json      also write the results as JSON, for comparing releases
+//   --min-time  time spent per timed benchmark, default 200 ms
+//   --quick     small inputs and short runs; a smoke test, not a measurement
+//   --golden    compare overlay/soft/ frames with the images in dir, writing
+//               the ones that are missing
+//
+// Exits non-zero if a check fails: a benchmark that must not allocate
+// (overlay/steady/, trace/span) did, or an output (trace/export,
+// overlay/soft/ pixels) is wrong.
+#include "harness.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static void Usage() {
+    std::fprintf(stderr,
+        "usage: wws_bench [--filter prefix] [--json file] [--min-time ms] [--quick] [--golden dir]\n");
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        const char* opt = argv[i];
+        if (!std::strcmp(opt, "--quick")) {
+            opts.quick = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            Usage();
+            return 2;
+        }
+        const char* val = argv[++i];
+        if      (!std::strcmp(opt, "--filter"))   opts.filter = val;
+        else if (!std::strcmp(opt, "--json"))     opts.jsonPath = val;
+        else if (!std::strcmp(opt, "--min-time")) opts.minTimeMs = std::atof(val);
+        else if (!std::strcmp(opt, "--golden"))   opts.goldenDir = val;
+        else {
+            Usage();
+            return 2;
+        }
+    }
+
+    Bench b(opts);
+    b.PrintHeader();
+    if (b.Wants("windows/"))  BenchWindows(b);
+    if (b.Wants("keys/"))     BenchKeys(b);
+    if (b.Wants("overlay/"))  BenchOverlay(b);
+    if (b.Wants("settings/")) BenchSettings(b);
+    if (b.Wants("trace/"))    BenchTrace(b);
+#ifdef WWS_BENCH_CONTROL
+    if (b.Wants("control/"))  BenchControl(b);
+#endif
+#ifdef WWS_BENCH_X11
+    if (b.Wants("x11/"))      BenchX11(b);
+#endif
+
+    if (b.Checks())
+        std::printf("%zu checks, %s\n", b.Checks(), b.Failed() ? "some failed" : "all passed");
+    if (b.Count() == 0) {
+        std::fprintf(stderr, "no benchmark matches '%s'\n", opts.filter.c_str());
+        return 1;
+    }
+    if (!opts.jsonPath.empty() && !b.WriteJson(opts.jsonPath)) {
+        std::fprintf(stderr, "cannot write %s\n", opts.jsonPath.c_str());
+        return 1;
+    }
+    return b.Failed() ? 1 : 0;
+}
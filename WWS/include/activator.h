@@ -0,0 +1,193 @@
+// === include/activator.h ===
+#pragma once
+
+#include "fetch_pool.h"
+#include "window_registry.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Lets a backend give up on an activation that is no longer wanted: checked
+// between its steps, so a call that was stuck doesn't steal the foreground
+// once it finally returns
+class ActivationToken {
+public:
+    bool Cancelled() const { return m_cancelled.load(std::memory_order_acquire); }
+    void Cancel() { m_cancelled.store(true, std::memory_order_release); }
+
+private:
+    std::atomic<bool> m_cancelled{ false };
+};
+
+// Ways of bringing a window to the front, from the politest up. One
+// implementation per platform, plus the fake below.
+class ActivationBackend {
+public:
+    virtual ~ActivationBackend() = default;
+
+    virtual int         Strategies() const = 0;
+    virtual const char* StrategyName(int strategy) const = 0;
+    // Tries strategy on id; success is only known from the foreground
+    // event that follows. False if id can't be activated at all (gone).
+    // May block, on a hung application.
+    virtual bool Attempt(WindowId id, int strategy, const ActivationToken& token) = 0;
+};
+
+enum class ActivationOutcome : uint8_t {
+    Confirmed,    // the foreground event arrived
+    TimedOut,     // every attempt ran out of time
+    Gone,         // the window doesn't exist any more
+    Superseded,   // a newer request came in while this one ran
+    Coalesced,    // a newer request came in before this one started
+};
+
+const char* ActivationOutcomeName(ActivationOutcome outcome);
+
+struct ActivationResult {
+    static constexpr int kMaxAttempts = 4;
+
+    WindowId          id = 0;
+    ActivationOutcome outcome = ActivationOutcome::TimedOut;
+    int               attempts = 0;
+    int               strategy = -1;        // the one confirmed, -1 if none
+    uint64_t          requestNs = 0;
+    uint64_t          doneNs = 0;
+    uint64_t          attemptNs[kMaxAttempts] = {};   // issue to confirmation or timeout
+};
+
+// Brings windows to the front off the input and render paths. Request()
+// only queues; a thread of the activator's own runs each request as up to
+// kMaxAttempts attempts of escalating strategy, each confirmed by the
+// foreground event (fed in through OnWindowEvent) or given up on after
+// attemptTimeoutNs. Attempts run on a FetchPool, so one blocked inside a
+// hung application costs its deadline, not the executor.
+//
+// Requests are handled in order and the newest wins: one still waiting is
+// replaced by the next (Coalesced), and one being attempted is abandoned
+// (Superseded) and its token cancelled.
+class Activator : public WindowEventSink {
+public:
+    static constexpr uint64_t kAttemptTimeoutNs = 60000000ull;   // 60 ms
+
+    explicit Activator(uint64_t attemptTimeoutNs = kAttemptTimeoutNs,
+                       int maxAttempts = ActivationResult::kMaxAttempts);
+    ~Activator() override { Stop(); }
+    Activator(const Activator&) = delete;
+    Activator& operator=(const Activator&) = delete;
+
+    void Start(ActivationBackend& backend);
+    // Finishes the request being attempted as Superseded and drops any
+    // waiting; waits for attempts still inside the backend
+    void Stop();
+
+    // Queues an activation of id and returns at once
+    void Request(WindowId id);
+    // Foreground events confirm attempts; everything else is ignored
+    void OnWindowEvent(const WindowEvent& ev) override;
+
+    // Called on the activator's thread with every finished request, in
+    // request order
+    void SetResultCallback(std::function<void(const ActivationResult&)> fn);
+    // Waits until nothing is queued or being attempted; false on timeout
+    bool WaitIdle(uint64_t timeoutNs);
+
+    struct Stats {
+        uint64_t requests = 0;
+        uint64_t confirmed = 0;
+        uint64_t timedOut = 0;
+        uint64_t gone = 0;
+        uint64_t superseded = 0;
+        uint64_t coalesced = 0;
+        uint64_t attempts = 0;
+        uint64_t confirmedBy[ActivationResult::kMaxAttempts] = {};   // per strategy
+    };
+    Stats GetStats() const;
+
+private:
+    struct Attempt;
+
+    void ThreadMain();
+    void Run(WindowId id, uint64_t requestNs, std::unique_lock<std::mutex>& lock);
+    void Finish(ActivationResult& r, std::unique_lock<std::mutex>& lock);
+
+    const uint64_t                 m_attemptTimeoutNs;
+    const int                      m_maxAttempts;
+    ActivationBackend*             m_backend = nullptr;
+    FetchPool                      m_pool;
+    std::thread                    m_thread;
+
+    mutable std::mutex             m_mutex;
+    std::condition_variable        m_cv;        // request, foreground, attempt returned, stop
+    std::condition_variable        m_idle;
+    WindowId                       m_pending = 0;
+    uint64_t                       m_pendingNs = 0;
+    std::deque<ActivationResult>   m_coalesced;   // replaced while waiting, to report
+    bool                           m_busy = false;
+    bool                           m_stop = false;
+    WindowId                       m_foreground = 0;
+    std::function<void(const ActivationResult&)> m_onResult;
+    Stats                          m_stats;
+};
+
+// Stands in for a window system in tests: a window comes to the front some
+// time after an attempt, and only for strategies at least as strong as it
+// needs; windows can be made to hang every attempt until Release(), or be
+// removed. Confirmations go out as Foreground events to the sink.
+class FakeActivationBackend : public ActivationBackend {
+public:
+    static constexpr int kStrategies = 3;
+
+    explicit FakeActivationBackend(WindowEventSink& sink) : m_sink(sink) {}
+
+    int         Strategies() const override { return kStrategies; }
+    const char* StrategyName(int strategy) const override;
+    bool        Attempt(WindowId id, int strategy, const ActivationToken& token) override;
+
+    void Add(WindowId id, int needsStrategy = 0);
+    void Remove(WindowId id);
+    void SetDelay(int ms);   // attempt to foreground event
+    void Hang(WindowId id);
+    void Release();
+
+    struct Call {
+        WindowId id;
+        int      strategy;
+        bool     applied;   // brought id to the front
+    };
+    std::vector<Call> Calls() const;
+    WindowId          Foreground() const;
+
+private:
+    WindowEventSink&                  m_sink;
+    mutable std::mutex                m_mutex;
+    std::condition_variable           m_released;
+    std::unordered_map<WindowId, int> m_windows;   // id -> weakest strategy that works
+    std::unordered_set<WindowId>      m_hung;
+    int                               m_delayMs = 0;
+    WindowId                          m_foreground = 0;
+    std::vector<Call>                 m_calls;
+};
+
+// Sends each event to two sinks, in order (the registry, then the activator)
+class WindowEventTee : public WindowEventSink {
+public:
+    WindowEventTee(WindowEventSink& first, WindowEventSink& second) : m_first(first), m_second(second) {}
+    void OnWindowEvent(const WindowEvent& ev) override {
+        m_first.OnWindowEvent(ev);
+        m_second.OnWindowEvent(ev);
+    }
+
+private:
+    WindowEventSink& m_first;
+    WindowEventSink& m_second;
+};
+
+// The app's activator
+Activator& GetActivator();
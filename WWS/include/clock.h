@@ -0,0 +1,48 @@
+// === include/clock.h ===
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Monotonic nanosecond clock, injectable so timing logic can be tested
+class Clock {
+public:
+    virtual ~Clock() = default;
+    virtual uint64_t NowNs() const = 0;
+};
+
+class SteadyClock : public Clock {
+public:
+    uint64_t NowNs() const override {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+// Only moves when told to
+class ManualClock : public Clock {
+public:
+    explicit ManualClock(uint64_t startNs = 0) : m_now(startNs) {}
+    uint64_t NowNs() const override { return m_now.load(std::memory_order_acquire); }
+    void     Set(uint64_t ns) { m_now.store(ns, std::memory_order_release); }
+    void     AdvanceMs(uint64_t ms) { m_now.fetch_add(ms * 1000000, std::memory_order_acq_rel); }
+
+private:
+    std::atomic<uint64_t> m_now;
+};
+
+// Nanoseconds since the Unix epoch, for times kept across runs (and
+// reboots); it can jump when the system time is set
+class WallClock : public Clock {
+public:
+    uint64_t NowNs() const override {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+};
+
+// The process-wide steady clock
+const Clock& SystemClock();
+// The process-wide wall clock
+const Clock& SystemWallClock();
@@ -0,0 +1,142 @@
+// === include/control_server.h ===
+#pragma once
+
+#include "window_registry.h"
+#include "window_snapshot.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// What a control client can make WWS do. Called on the server's threads:
+// implementations hand the work to whoever owns it (the activator, the UI
+// thread) and return at once.
+class ControlActions {
+public:
+    virtual ~ControlActions() = default;
+    virtual void Activate(WindowId id) = 0;
+    virtual void Overlay(bool show) = 0;
+    virtual void ReloadSettings() = 0;
+    virtual void Quit() = 0;
+};
+
+// Local endpoint for scripts, launchers and tests: a Unix socket on Linux,
+// a named pipe on Windows. One request per line, one reply per request, in
+// order:
+//
+//   ping                ok
+//   list                "ok <n>", then n lines "<index> <id> <title>" in list order
+//   switch <index>      ok once the activation is queued (0 is the active window)
+//   switch id <id>      the same by id, as list and focus give it
+//   overlay show|hide   ok
+//   reload              ok; rereads the settings file
+//   quit                ok; WWS exits
+//   subscribe           ok, then "focus <id> <title>" whenever a window comes to the front
+//
+// Anything else gets "err <why>". Titles are UTF-8 and run to the end of the
+// line. Requests can be pipelined: all that arrive together are answered
+// with one write.
+//
+// Nothing enumerates windows here. list is served from a snapshot of the
+// registry, refilled (and its reply text rebuilt) only when the registry has
+// changed since, so clients polling it cost one copy of a string.
+class ControlServer : public WindowEventSink {
+public:
+    static constexpr size_t kMaxLine = 4096;           // a longer request closes the connection
+    static constexpr size_t kMaxBacklog = 1u << 20;    // unread replies before a client is dropped
+
+    ControlServer(WindowRegistry& registry, ControlActions& actions);
+    ~ControlServer() override;
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    // Serves endpoint on a thread of its own (Windows: one more per client).
+    // False if it can't be made, or another WWS is already serving it; a
+    // socket left behind by one that died is taken over.
+    bool Start(const std::string& endpoint);
+    // Closes every connection and removes the endpoint
+    void Stop();
+    bool Running() const { return m_running.load(std::memory_order_acquire); }
+
+    // Foreground events go out to subscribers; feed it after the registry,
+    // so their titles are known
+    void OnWindowEvent(const WindowEvent& ev) override;
+
+    // The transport's half of the protocol: answers the complete lines at
+    // the start of in, appending the replies to out, and returns the bytes
+    // used. Sets subscribe on a "subscribe". Thread-safe.
+    size_t Serve(std::string_view in, std::string& out, bool& subscribe);
+
+    struct Stats {
+        uint64_t connections = 0;
+        uint64_t requests = 0;
+        uint64_t batches = 0;    // reads that had requests, each answered by one write
+        uint64_t errors = 0;
+        uint64_t pushes = 0;     // focus lines sent to subscribers
+        uint64_t refills = 0;    // snapshots taken for list
+    };
+    Stats GetStats() const;
+
+private:
+    struct Connection;
+
+    void ThreadMain();
+    void Handle(std::string_view line, std::string& out, bool& subscribe);
+    void Switch(std::string_view arg, std::string& out);
+    void Error(std::string& out, const char* why);
+    // Brings m_snapshot and m_listText up to the registry; m_mutex held
+    void Refresh();
+    // Drains m_focus into "focus" lines
+    void FocusLines(std::string& out);
+    void Wake();
+#ifdef _WIN32
+    void ConnectionMain(Connection& c);
+    bool Write(Connection& c, const std::string& data);
+    void Reap(bool all);
+#else
+    bool Receive(Connection& c);   // false once the connection is over
+    bool Send(Connection& c);      // false on error or too much unread
+#endif
+
+    WindowRegistry&       m_registry;
+    ControlActions&       m_actions;
+    std::string           m_endpoint;
+    std::thread           m_thread;
+    std::atomic<bool>     m_running{ false };
+
+    std::mutex            m_mutex;          // everything list is served from
+    WindowSnapshot        m_snapshot;
+    uint64_t              m_version = 0;    // registry version m_snapshot was taken at
+    bool                  m_filled = false;
+    std::string           m_listText;       // the whole reply
+
+    std::mutex            m_focusMutex;
+    std::vector<WindowId> m_focus;          // foreground changes not pushed yet
+
+    std::atomic<uint64_t> m_connections{ 0 };
+    std::atomic<uint64_t> m_requests{ 0 };
+    std::atomic<uint64_t> m_batches{ 0 };
+    std::atomic<uint64_t> m_errors{ 0 };
+    std::atomic<uint64_t> m_pushes{ 0 };
+    std::atomic<uint64_t> m_refills{ 0 };
+#ifdef _WIN32
+    void*                 m_pipe = nullptr;   // first instance, until the thread takes it
+    void*                 m_stop = nullptr;   // events: Stop(), and focus changes waiting
+    void*                 m_wake = nullptr;
+    std::mutex            m_openMutex;
+    std::vector<std::shared_ptr<Connection>> m_open;
+#else
+    int                   m_listen = -1;
+    int                   m_wake[2] = { -1, -1 };   // pipe: focus changes waiting, or Stop()
+    std::atomic<bool>     m_stop{ false };
+#endif
+};
+
+// Where WWS listens: $XDG_RUNTIME_DIR/wws.sock (else /tmp/wws-<uid>.sock),
+// \\.\pipe\wws-<session> on Windows
+std::string DefaultControlEndpoint();
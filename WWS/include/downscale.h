@@ -0,0 +1,36 @@
+// === include/downscale.h ===
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Buffers DownscaleRgba() works in, kept by the caller so that once they
+// have grown to the widest source seen, downscaling allocates nothing.
+// A few rows' worth, never a whole image.
+struct DownscaleScratch {
+    std::vector<uint16_t> columns;   // k source rows summed, per channel
+    std::vector<uint32_t> rows[2];   // box-filtered rows, bilinear's y0 and y1
+    std::vector<uint32_t> blend;     // the two blended vertically
+    std::vector<uint32_t> xs;        // per output column: x0 << 8 | weight of x0 + 1
+    int                   rowIndex[2] = { -1, -1 };
+
+    size_t Bytes() const;
+};
+
+// Largest size of w x h that fits maxW x maxH keeping the aspect ratio,
+// never larger than w x h and at least 1 x 1
+void FitWithin(int w, int h, int maxW, int maxH, int& outW, int& outH);
+
+// Shrinks an RGBA8 image (strides in pixels) to dstW x dstH, no larger than
+// the source: a box filter first takes it down by a whole factor (up to 16)
+// to at most twice the target, then a bilinear pass samples the rest. Both
+// passes are integer-only and run four channels per lane group with SSE2
+// where available; vectorized = false takes the plain C++ path, which gives
+// bit-identical results.
+void DownscaleRgba(const uint32_t* src, int srcW, int srcH, size_t srcStride,
+                   uint32_t* dst, int dstW, int dstH, size_t dstStride,
+                   DownscaleScratch& scratch, bool vectorized = true);
+
+// Whether this build has the SSE2 path
+bool DownscaleVectorized();
@@ -0,0 +1,78 @@
+// === include/fetch_pool.h ===
+#pragma once
+
+#include "clock.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads for the slow half of a snapshot: calls that can block on
+// another process or a slow disk (process queries, icon extraction), kept
+// off the UI thread so the overlay shows whatever is ready and fills in the
+// rest as it arrives.
+//
+// A job still running after the deadline counts as hung. Its worker is
+// written off until the call returns, and while every worker is hung and
+// jobs are waiting another worker is started, up to maxWorkers, so one stuck
+// application only holds up its own rows. Workers beyond the base count
+// exit once the queue is empty.
+class FetchPool {
+public:
+    static constexpr uint64_t kDeadlineNs = 100000000ull;   // 100 ms
+
+    explicit FetchPool(int workers = 2, int maxWorkers = 6, uint64_t deadlineNs = kDeadlineNs);
+    ~FetchPool() { Stop(); }
+    FetchPool(const FetchPool&) = delete;
+    FetchPool& operator=(const FetchPool&) = delete;
+
+    void Start();
+    // Drops queued jobs and waits for running ones, hung ones included
+    void Stop();
+    bool Running() const;
+
+    // Runs job on a worker; dropped if the pool isn't running
+    void Submit(std::function<void()> job);
+
+    struct Stats {
+        uint64_t jobs = 0;         // finished
+        uint64_t overdue = 0;      // ran past the deadline
+        uint64_t spawned = 0;      // workers started past the base count
+        size_t   queued = 0;
+        int      workers = 0;
+        int      hung = 0;         // workers in a job past its deadline now
+        int      peakWorkers = 0;
+    };
+    Stats GetStats() const;
+
+private:
+    struct Worker {
+        std::thread thread;
+        uint64_t    sinceNs = 0;   // start of the current job
+        bool        busy = false;
+        bool        hung = false;
+    };
+
+    void Spawn();
+    void WorkerMain(Worker* self);
+    void WatchMain();
+
+    const int                          m_baseWorkers;
+    const int                          m_maxWorkers;
+    const uint64_t                     m_deadlineNs;
+    mutable std::mutex                 m_mutex;
+    std::condition_variable            m_work;      // jobs queued, or stopping
+    std::condition_variable            m_watch;     // a worker started, finished or left
+    std::deque<std::function<void()>>  m_queue;
+    std::list<Worker>                  m_workers;   // stable addresses for WorkerMain
+    std::vector<std::thread>           m_exited;    // workers that left, to join
+    std::thread                        m_watchdog;
+    int                                m_idle = 0;
+    bool                               m_running = false;
+    Stats                              m_stats;
+};
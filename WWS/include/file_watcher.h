@@ -0,0 +1,41 @@
+// === include/file_watcher.h ===
+#pragma once
+
+#include <functional>
+#include <string>
+#include <thread>
+
+// Calls onChange, on a thread of its own, when the file at path is
+// written, created or replaced. Watches the directory rather than the file,
+// so saves that rename a temp file over it are caught too. Changes closer
+// together than debounceMs are reported once, after the last of them.
+// inotify on Linux, change notifications on Windows, polling elsewhere.
+class FileWatcher {
+public:
+    using ChangeFn = std::function<void()>;
+
+    FileWatcher() = default;
+    ~FileWatcher() { Stop(); }
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    bool Start(const std::string& path, ChangeFn onChange, int debounceMs = 50);
+    void Stop();
+    bool Running() const { return m_thread.joinable(); }
+
+private:
+    void ThreadMain();
+
+    std::string m_dir;
+    std::string m_name;
+    ChangeFn    m_onChange;
+    int         m_debounceMs = 50;
+    std::thread m_thread;
+#ifdef _WIN32
+    void*       m_change = nullptr;   // FindFirstChangeNotification handle
+    void*       m_stop = nullptr;     // event, for Stop()
+#else
+    int         m_notify = -1;        // inotify fd, -1 when polling
+    int         m_wake[2] = { -1, -1 };   // pipe, for Stop()
+#endif
+};
@@ -0,0 +1,84 @@
+// === include/frame_scheduler.h ===
+#pragma once
+
+#include "clock.h"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+// Why a frame is needed; OR them together
+enum FrameReason : uint32_t {
+    FrameReason_Selection = 1u << 0,
+    FrameReason_Snapshot  = 1u << 1,
+    FrameReason_Settings  = 1u << 2,
+    FrameReason_Input     = 1u << 3,   // mouse/keyboard for the settings panel
+    FrameReason_Resize    = 1u << 4,
+};
+
+// Render-on-demand: a frame is built once per change and never while idle,
+// unless animations are switched on, which renders continuously at a
+// capped rate. The owner either blocks in WaitForFrame() or asks
+// TimeUntilFrameNs() and waits itself (e.g. MsgWaitForMultipleObjects).
+class FrameScheduler {
+public:
+    static constexpr uint64_t kNever = ~0ull;
+
+    struct Counters {
+        uint64_t wakeups = 0;
+        uint64_t framesBuilt = 0;
+        uint64_t framesPresented = 0;
+    };
+
+    explicit FrameScheduler(const Clock& clock = SystemClock());
+
+    // Thread-safe. Requests a frame and wakes whoever is waiting for one.
+    void MarkDirty(uint32_t reasons);
+
+    // Continuous rendering at up to maxFps while on
+    void SetAnimating(bool on, int maxFps = 60);
+
+    // Called whenever a non-blocking owner wakes up (messages, timers, ...)
+    void SetWakeCallback(std::function<void()> fn);
+
+    // How long the owner may sleep before the next frame is due (kNever when idle)
+    uint64_t TimeUntilFrameNs() const;
+
+    // Blocks until a frame is due; false once Stop() was called. Counts a wakeup.
+    bool WaitForFrame();
+    void Stop();
+
+    // Counts a wakeup for owners that do their own waiting
+    void NoteWakeup();
+
+    // True if a frame should be built now; consumes the dirty reasons
+    // (returned through reasons if given)
+    bool BeginFrame(uint32_t* reasons = nullptr);
+    void EndFrame(bool presented);
+
+    Counters Totals() const;
+    // Per-second rates over the last completed one-second window
+    Counters PerSecond() const;
+
+private:
+    bool DueLocked(uint64_t now) const;
+    void RollLocked(uint64_t now) const;
+
+    const Clock&            m_clock;
+    mutable std::mutex      m_mutex;
+    std::condition_variable m_cv;
+    std::function<void()>   m_wake;
+    uint32_t                m_dirty = 0;
+    bool                    m_animating = false;
+    bool                    m_stopped = false;
+    uint64_t                m_frameIntervalNs = 0;
+    uint64_t                m_lastFrameNs = 0;
+
+    Counters                m_totals;
+    mutable Counters        m_windowStart;
+    mutable uint64_t        m_windowStartNs = 0;
+    mutable Counters        m_lastRates;
+};
+
+// The overlay's scheduler
+FrameScheduler& GetFrameScheduler();
@@ -0,0 +1,91 @@
+// === include/frecency_store.h ===
+#pragma once
+
+#include "clock.h"
+#include "mapped_file.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+constexpr const char* kFrecencyFile = "wws_frecency.bin";
+
+// What a window's activations are counted under: its title with the parts
+// that churn taken out (digit runs, "unsaved" markers, case), and the app,
+// which is the part after the title's last " - ". 0 is never a key.
+struct FrecencyKeys {
+    uint64_t pattern = 0;
+    uint64_t app = 0;
+
+    static FrecencyKeys FromTitle(std::wstring_view title);
+};
+
+// How often and how recently windows were activated, in a fixed-layout
+// hash table in a memory-mapped file: opening it is a map and a header
+// check, and recording an activation writes one slot in place, so there is
+// nothing to parse at startup and nothing to save at exit.
+//
+// Each activation is worth 1, halving every kHalfLifeSec. A slot keeps the
+// sum as a level, log2(sum of 2^(t / half-life)) over its activations, so
+// adding one is O(1) and comparing two never needs the current time: the
+// decay scales every score alike. A window ranks by its pattern plus
+// kAppWeight times its app. When a probe run is full the weakest slot in
+// it is replaced.
+//
+// Not synchronized; the registry calls it under its own lock.
+class FrecencyStore {
+public:
+    static constexpr uint32_t kDefaultSlots = 4096;    // ~100 KB
+    static constexpr uint32_t kHalfLifeSec = 7 * 24 * 3600;
+    static constexpr double   kAppWeight = 0.5;
+
+    // wall: seconds for Record(keys); must outlive the store
+    explicit FrecencyStore(const Clock& wall = SystemWallClock());
+    FrecencyStore(const FrecencyStore&) = delete;
+    FrecencyStore& operator=(const FrecencyStore&) = delete;
+
+    // Maps path, starting it over if it isn't a store (or is another
+    // version of one). An existing store keeps its own slot count. When the
+    // file can't be mapped the store works in memory and this returns false.
+    bool Open(const std::string& path, uint32_t slots = kDefaultSlots);
+    // Memory only, nothing kept
+    void OpenInMemory(uint32_t slots = kDefaultSlots);
+    void Close();
+
+    // Counts an activation now, or at unixSec
+    void Record(const FrecencyKeys& keys);
+    void Record(const FrecencyKeys& keys, uint64_t unixSec);
+
+    // Orders windows: higher is used more, or more recently. -infinity for
+    // a window never activated.
+    double Rank(const FrecencyKeys& keys) const;
+    // The decayed activation count behind Rank() at unixSec
+    double Score(const FrecencyKeys& keys, uint64_t unixSec) const;
+
+    bool     IsOpen() const { return m_slots != nullptr; }
+    bool     Mapped() const { return m_file.IsOpen(); }
+    uint32_t Slots() const;
+    uint32_t Used() const;    // slots holding a key
+    void     Clear();
+    // Starts writing changes back to the file
+    void     Flush() { m_file.Flush(); }
+
+private:
+    struct Header;
+    struct Slot;
+
+    static size_t BytesFor(uint32_t slots);
+
+    void   Init(void* data, uint32_t slots);
+    Slot*  Find(uint64_t key) const;
+    Slot&  Claim(uint64_t key);
+    double Level(uint64_t key) const;
+
+    const Clock&                m_wall;
+    MappedFile                  m_file;
+    std::unique_ptr<uint64_t[]> m_memory;   // when there is no file
+    Header*                     m_header = nullptr;
+    Slot*                       m_slots = nullptr;
+    uint32_t                    m_mask = 0;
+};
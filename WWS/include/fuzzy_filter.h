@@ -0,0 +1,69 @@
+// === include/fuzzy_filter.h ===
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class WindowSnapshot;
+
+// Type-to-filter over a window snapshot. Titles and exe names are lowercased
+// into one contiguous UTF-8 arena when the snapshot is built; a query is
+// split on spaces and every term has to match (as a subsequence) the title
+// or the exe name. Each entry also carries a 64-bit "which characters occur"
+// mask, so most non-matches are rejected with a SIMD AND/compare over the
+// mask array before any text is touched.
+class FuzzyFilter {
+public:
+    // Rebuilds the arena from windows; the next Filter() scans everything.
+    // Neither this nor Filter() allocates once the buffers have grown.
+    void Build(const WindowSnapshot& windows);
+
+    // Ranks the windows against query, best first (ties keep MRU order) and
+    // returns their indices into the snapshot. An empty query returns every
+    // window in MRU order. When query extends the previous one only the
+    // previous matches are rescanned.
+    const std::vector<uint32_t>& Filter(const std::wstring& query);
+
+    const std::vector<uint32_t>& Results() const { return m_results; }
+    size_t Size() const { return m_entries.size(); }
+    // Entries whose text was scanned by the last Filter(), for benchmarks
+    size_t Scanned() const { return m_scanned; }
+
+    // Score of one term against lowercased UTF-8 text, -1 if it doesn't match
+    static int Score(const char* text, size_t len, const char* term, size_t termLen);
+
+private:
+    struct Entry {
+        uint32_t title;      // arena offset
+        uint32_t titleLen;
+        uint32_t exe;
+        uint32_t exeLen;
+    };
+
+    struct Term {
+        uint32_t offset;     // into m_q
+        uint32_t len;
+    };
+
+    void Reject(uint64_t queryMask, std::vector<uint32_t>& candidates) const;
+    bool Match(uint32_t index, int& score) const;
+
+    std::string           m_arena;
+    std::vector<Entry>    m_entries;
+    std::vector<uint64_t> m_masks;      // one per entry, for candidate rejection
+    std::string           m_query;      // lowercased query behind m_matches
+    bool                  m_fresh = true;
+    std::vector<uint32_t> m_matches;    // matching indices, ascending
+    std::vector<uint32_t> m_results;    // m_matches by score
+    std::vector<uint64_t> m_keys;       // sort scratch
+    std::string           m_q;          // query being filtered, lowercased
+    std::vector<Term>     m_terms;      // its space-separated terms
+    std::vector<uint32_t> m_candidates;
+    size_t                m_scanned = 0;
+};
+
+// Lowercases s and appends it as UTF-8 (what the arena and queries hold)
+void AppendLowerUtf8(std::string& out, const std::wstring& s);
+void AppendLowerUtf8(std::string& out, const char* s, size_t len);
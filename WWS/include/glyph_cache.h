@@ -0,0 +1,85 @@
+// === include/glyph_cache.h ===
+#pragma once
+
+#include "imgui.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class WindowSnapshot;
+
+// The overlay font, with fallbacks for scripts the main font lacks (CJK,
+// symbols, emoji), and the glyphs window titles need loaded before a frame
+// draws them.
+//
+// ImGui rasterizes glyphs on first use and only uploads the atlas
+// rectangles that changed, so the atlas holds just the glyphs ever drawn.
+// Prepare() moves that work to snapshot time: it walks the snapshot's
+// strings, and each codepoint it has not seen before is rasterized then,
+// not in the middle of a frame. A codepoint the fonts loaded so far don't
+// have pulls in the first fallback file that covers it (its cmap is read
+// to find out; files that don't are left unmerged); one none of them has
+// is counted as missing, drawn as '?' and, being seen, never looked up
+// again.
+// UI thread only.
+class GlyphCache {
+public:
+    // files: main font first, then fallbacks in the order to try them;
+    // ones that don't exist are skipped
+    explicit GlyphCache(std::vector<std::string> files = SystemFonts(), float sizePx = 16.0f);
+    ~GlyphCache();
+
+    // Adds the main font (ImGui's built-in one if it can't be loaded) to
+    // the current context's atlas and makes it the default. Fallbacks are
+    // merged in as they are needed, so it must stay the atlas's last font.
+    void Attach();
+    void Detach();
+
+    // Loads the glyphs for every codepoint in utf8 (or the snapshot's
+    // titles and exe names) not seen before; returns how many were
+    // rasterized. Seen ones cost a bitset lookup. Call after Attach().
+    int Prepare(std::string_view utf8);
+    int Prepare(const WindowSnapshot& windows);
+
+    ImFont* Font() const { return m_font; }
+    float   SizePx() const { return m_sizePx; }
+
+    struct Stats {
+        size_t codepoints = 0;   // distinct ones seen
+        size_t rasterized = 0;   // glyphs Prepare() loaded
+        size_t missing = 0;      // in no font we have
+        size_t fonts = 0;        // font files merged into the atlas
+        size_t fontBytes = 0;    // their size, kept in memory by ImGui
+        size_t fallbacksRead = 0;   // fallback files read for their cmap
+        size_t heldBytes = 0;       // those of them not merged, kept until Detach()
+        size_t atlasBytes = 0;   // the font texture
+        int    atlasWidth = 0;
+        int    atlasHeight = 0;
+    };
+    Stats GetStats() const;
+
+    // This platform's UI font and fallbacks, those that exist here
+    static std::vector<std::string> SystemFonts();
+
+private:
+    static constexpr int kPlanes = 17;   // Unicode planes, 64K codepoints each
+
+    int  Scan(std::string_view utf8, ImFontBaked*& baked);
+    bool Seen(uint32_t c);      // marks c seen; true if it already was
+    int  Load(uint32_t c, ImFontBaked*& baked);
+    bool LoadFallbackFor(uint32_t c);
+    void DropFallbacks();
+
+    struct Fallback;   // a file's data and cmap, until it is merged
+
+    std::vector<std::string>    m_files;
+    float                       m_sizePx;
+    std::vector<std::unique_ptr<Fallback>> m_fallbacks;   // m_files[1..], null until read
+    ImFontAtlas*                m_atlas = nullptr;
+    ImFont*                     m_font = nullptr;
+    std::unique_ptr<uint64_t[]> m_seen[kPlanes];   // bitsets, allocated per plane on first use
+    Stats                       m_stats;
+};
@@ -15,8 +15,38 @@ extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(
 bool InitializeGUI(HINSTANCE hInstance);
 void ShutdownGUI();
 void ShowOverlay();
+// Draws one overlay frame without presenting it, so the first real one
+// finds fonts, glyphs and device objects ready. Call once the registry
+// has its windows; does nothing while the resources are released.
+void WarmUpOverlay();
+// The initiator went down: brings released resources back up (and warms
+// them) ahead of a possible show, if the settings ask for it
+void PrepareOverlay();
+// Releases the device, swap chain and ImGui context once they have been
+// idle for overlayIdleReleaseMs; returns how long the caller may sleep
+// before the next check (~0ull: nothing due)
+uint64_t TickOverlayResources();
 void HideOverlay();
 void AdvanceSelection();
 void SwitchToPreviousWindow();
-void RenderOverlayFrame();
+// Builds and presents one frame; false if nothing was drawn. Only call it
+// when GetFrameScheduler() says a frame is due.
+bool RenderOverlayFrame();
 void CommitSelection();
+// Type-to-filter: appends ch to the overlay query ('\b' deletes one)
+void FilterInput(wchar_t ch);
+
+// Thread-safe: runs the matching call above on the UI thread
+enum class OverlayCommand { Show, Hide, Advance, Commit, Prepare };
+void PostOverlayCommand(OverlayCommand cmd);
+void PostFilterChar(wchar_t ch);
+// The settings file changed; the panel picks up the live config
+void PostSettingsReloaded();
+// Ends the message loop, as closing WWS would
+void PostQuit();
+
+#ifdef WWS_ENABLE_TRACING
+// Writes the trace to %WWS_TRACE% (default wws_trace.json) and the latency
+// report to the debugger output
+void DumpTrace();
+#endif
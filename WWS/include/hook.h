@@ -4,22 +4,32 @@
 #include <windows.h>
 #include <functional>
 #include <chrono>
+#include "switcher.h"       // SwitcherConfig
+#include "key_bindings.h"   // KeyBindingConfig
+#include "published.h"
 
-// State machine for our switcher
-enum class SwitcherState { Idle, TapPending, QuickSelect, Listing };
-// Hotkey configuration
-struct HotkeyConfig {
-    UINT initiator;    // e.g. VK_MENU (Alt)
-    UINT modifier;     // e.g. VK_TAB
-    int tapTimeoutMs;  // e.g. 300
-    int  overlayTimeoutMs;
-};
-
-// Install/uninstall the low-level keyboard hook
-void InstallHook(const HotkeyConfig& cfg,
+// Install/uninstall the low-level keyboard hook. The hook runs on its own
+// high-priority thread and the callbacks run on a worker thread, so they
+// must be thread-safe (marshal UI work with PostOverlayCommand).
+// While the overlay is listing, letter/digit/space/backspace keys are
+// swallowed and passed to onFilterChar instead; that one is called on the
+// hook thread itself, so it must only post.
+// onInitiatorDown fires on the press that may start a gesture, before any
+// of the others, for work worth starting early (the overlay's resources).
+// The hook follows config and bindings: whatever is published there
+// applies from the next key (both switch over between gestures), and
+// both must outlive the hook.
+bool InstallHook(Published<SwitcherConfig>& config,
+    Published<KeyBindingConfig>& bindings,
     std::function<void()> onTap,
     std::function<void()> onHoldStart,
     std::function<void()> onCycle,
     std::function<void()> onCancel,
-    std::function<void()> onCommit);
+    std::function<void()> onCommit,
+    std::function<void(wchar_t)> onFilterChar,
+    std::function<void()> onInitiatorDown);
 void UninstallHook();
+
+// The overlay was hidden from outside a gesture (the control server): stop
+// swallowing typing until the next one lists again.
+void EndKeyCapture();
@@ -0,0 +1,181 @@
+// === include/icon_atlas.h ===
+#pragma once
+
+#include "imgui.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class FetchPool;
+
+// One icon as RGBA8 pixels, row-major, no padding
+struct IconImage {
+    int                   width = 0;
+    int                   height = 0;
+    std::vector<uint32_t> rgba;
+};
+
+// Where icons come from (the exe's resources on Windows, canned in tests)
+class IconProvider {
+public:
+    virtual ~IconProvider() = default;
+    // Extracts the icon of an executable at about size x size pixels;
+    // false if it has none
+    virtual bool Load(const std::wstring& exePath, int size, IconImage& out) = 0;
+};
+
+// Application icons packed into one shared ImGui texture with stb_rect_pack.
+// Each exe's icon is extracted once. New icons only queue their own
+// sub-rectangle for upload; the renderer backend picks those up through
+// ImGui's texture list (ImGuiBackendFlags_RendererHasTextures). When the
+// atlas is full, the least recently drawn icons are evicted and the rest
+// are repacked. Icons drawn in the current frame are never evicted or
+// moved off the atlas: a repack that can't keep them all is not made, and
+// the icon that wanted room waits, with its pixels, for a later frame
+// (backing off as it keeps failing). Exes without an icon, or waiting for
+// room, leave with the icons evicted around them.
+// Extraction runs in Get() within a per-frame budget, or on a FetchPool's
+// workers when one is set, so a slow exe only delays its own icon.
+// UI thread only.
+class IconAtlas {
+public:
+    IconAtlas(int iconSize = 32, int width = 256, int height = 256);
+    ~IconAtlas();
+
+    void SetProvider(IconProvider* provider) { m_provider = provider; }
+    // Icons extracted per frame at most; later ones wait for the next frame
+    void SetLoadBudget(int perFrame) { m_loadBudget = perFrame; }
+    // Extracts icons on pool's workers instead (no budget then); each one
+    // is packed on the first Get() after the NewFrame() that follows it.
+    // The pool must be stopped before the provider goes away.
+    void SetLoader(FetchPool* pool) { m_loader = pool; }
+    // Called on a worker when an icon has been extracted (e.g. to request
+    // a frame)
+    void SetUpdateCallback(std::function<void()> fn);
+
+    // Registers/unregisters the texture with the current ImGui context
+    void Attach();
+    void Detach();
+
+    // Call once per frame before any Get()
+    void NewFrame();
+
+    // Texture coordinates of exePath's icon, extracting and packing it on
+    // first use. False if it has no icon, can't be placed, or is waiting on
+    // the load budget (see Pending()) or a worker.
+    bool Get(const std::wstring& exePath, ImVec2& uv0, ImVec2& uv1);
+
+    // Icons skipped this frame because of the load budget
+    bool         Pending() const { return m_pending; }
+    int          IconSize() const { return m_iconSize; }
+    ImTextureRef TexRef() { return m_tex.GetTexRef(); }
+
+    struct Stats {
+        size_t entries = 0;        // icons in the atlas
+        size_t loads = 0;          // provider calls (finished ones, with a loader)
+        size_t evictions = 0;
+        size_t repacks = 0;
+        size_t uploadRects = 0;    // sub-rectangles queued for upload
+        size_t uploadBytes = 0;    // pixel bytes queued for upload (creates included)
+        float  density = 0.0f;     // icon pixels / atlas pixels
+    };
+    Stats GetStats() const;
+
+private:
+    struct Packer;   // stb_rect_pack state, kept out of this header
+    struct Inbox;    // icons extracted by workers, not picked up yet
+    struct Loaded {
+        IconImage image;
+        bool      ok = false;
+    };
+    struct Entry {
+        int      x = 0, y = 0, w = 0, h = 0;
+        uint64_t lastUsed = 0;     // frame number
+        bool     placed = false;   // false: the exe has no icon, or see waiting
+        std::unique_ptr<IconImage> waiting;   // extracted, found no room yet
+        uint64_t retryFrame = 0;   // when to try placing waiting again
+        int      failures = 0;
+    };
+
+    static constexpr int kMaxBackoff = 6;   // retries at most 2^6 frames apart
+
+    bool Place(Entry& e, const IconImage& img);
+    void Wait(Entry& e, IconImage& img);
+    bool Pack(int w, int h, int& x, int& y);
+    void Repack(int needW, int needH);
+    void ResetPacker(Packer& packer) const;
+    void Blit(const Entry& e, const uint32_t* src);
+    void QueueUpload(const Entry& e);
+    void Submit(const std::wstring& exePath);
+
+    IconProvider*                          m_provider = nullptr;
+    FetchPool*                             m_loader = nullptr;
+    std::shared_ptr<Inbox>                 m_inbox;      // shared with jobs in flight
+    std::unordered_set<std::wstring>       m_loading;    // submitted, not in m_loaded yet
+    std::unordered_map<std::wstring, Loaded> m_loaded;   // extracted, not packed yet
+    int                                    m_iconSize;
+    int                                    m_loadBudget = 8;
+    int                                    m_loadsThisFrame = 0;
+    bool                                   m_pending = false;
+    bool                                   m_attached = false;
+    uint64_t                               m_frame = 1;
+    ImTextureData                          m_tex;
+    std::unique_ptr<Packer>                m_packer;
+    std::unordered_map<std::wstring, Entry> m_entries;
+    IconImage                              m_scratch;
+    Stats                                  m_stats;
+    size_t                                 m_usedPixels = 0;
+};
+
+// Marks a rectangle of tex for upload, with the same bookkeeping as
+// ImFontAtlasTextureBlockQueueUpload. True if it went in as a sub-rectangle
+// update; false while a create is pending, which uploads everything anyway.
+bool QueueTextureUpload(ImTextureData& tex, int x, int y, int w, int h);
+
+// Canned icons: every path gets a solid square (a colour from its hash)
+// unless marked missing; counts loads. Loads of a path can be slowed down,
+// or held until Release(), like FakeProcessInfoProvider's queries.
+class FakeIconProvider : public IconProvider {
+public:
+    void SetMissing(const std::wstring& exePath);
+    void SetDelay(const std::wstring& exePath, int ms);
+    void Hang(const std::wstring& exePath);
+    void Release();   // lets hung loads return, and stops hanging new ones
+    size_t Loads() const;
+
+    bool Load(const std::wstring& exePath, int size, IconImage& out) override;
+
+private:
+    mutable std::mutex                    m_mutex;
+    std::condition_variable               m_released;
+    std::vector<std::wstring>             m_missing;
+    std::unordered_map<std::wstring, int> m_delays;   // ms, -1 to hang
+    size_t                                m_loads = 0;
+};
+
+// Renderer backend that only honours texture requests and counts the
+// bytes it would have uploaded; for driving ImGui headless
+class NullTextureRenderer {
+public:
+    // Sets ImGuiBackendFlags_RendererHasTextures on the current context
+    void Init();
+    // Processes ImGui::GetPlatformIO().Textures, call after ImGui::Render()
+    void Update();
+
+    size_t Creates() const { return m_creates; }
+    size_t UploadRects() const { return m_rects; }
+    size_t UploadBytes() const { return m_bytes; }
+
+private:
+    size_t   m_creates = 0;
+    size_t   m_rects = 0;
+    size_t   m_bytes = 0;
+    intptr_t m_nextId = 1;
+};
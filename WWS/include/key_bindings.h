@@ -0,0 +1,170 @@
+// === include/key_bindings.h ===
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class BindingAction : uint8_t {
+    Select,    // activate the index-th window in list order (1: the previous one)
+    Overlay,   // show the overlay for as long as the chord's modifiers stay down;
+               // the chord again cycles, releasing them commits
+};
+
+const char* BindingActionName(BindingAction action);
+
+// Chord modifiers, matching either side
+namespace keymod {
+constexpr uint8_t Ctrl  = 1;
+constexpr uint8_t Shift = 2;
+constexpr uint8_t Alt   = 4;
+constexpr uint8_t Win   = 8;
+constexpr size_t  kCombinations = 16;
+}
+
+struct KeyChord {
+    uint8_t mods = 0;   // keymod bits, exactly these held
+    uint8_t vk = 0;     // the key that completes it, never a modifier
+};
+
+inline bool operator==(const KeyChord& a, const KeyChord& b) { return a.mods == b.mods && a.vk == b.vk; }
+
+// One binding as written in wws_config.json ("keyBindings")
+struct KeyBinding {
+    std::vector<KeyChord> keys;      // one chord, or a sequence of them
+    BindingAction         action = BindingAction::Select;
+    int                   index = 1; // Select only, 0..255
+};
+
+bool operator==(const KeyBinding& a, const KeyBinding& b);
+inline bool operator!=(const KeyBinding& a, const KeyBinding& b) { return !(a == b); }
+
+// "Win+1", "Ctrl+Shift+F5", "Ctrl+K, Ctrl+W" (a sequence); false for
+// anything unknown or a chord ending in a modifier
+bool        ParseKeys(const std::string& text, std::vector<KeyChord>& out);
+std::string FormatKeys(const std::vector<KeyChord>& keys);
+bool        IsModifierKey(uint8_t vk);
+
+// What a binding asks the switcher for, small enough to travel as a
+// KeyEvent's vk (KeyClass::Binding): the action in the high byte
+inline uint16_t PackBinding(BindingAction action, int index) {
+    return (uint16_t)(((unsigned)action << 8) | (uint8_t)index);
+}
+inline BindingAction BindingActionOf(uint16_t packed) { return (BindingAction)(packed >> 8); }
+inline int           BindingIndexOf(uint16_t packed) { return packed & 0xFF; }
+
+// 256 bits, one per virtual-key code
+class KeyBits {
+public:
+    bool Test(uint8_t vk) const { return (m_words[vk >> 6] >> (vk & 63)) & 1; }
+    void Set(uint8_t vk)        { m_words[vk >> 6] |= 1ull << (vk & 63); }
+    void Clear(uint8_t vk)      { m_words[vk >> 6] &= ~(1ull << (vk & 63)); }
+    // keymod bits of the modifier keys set, either side (or the generic code)
+    uint8_t Mods() const;
+
+private:
+    uint64_t m_words[4] = {};
+};
+
+// The user's bindings, compiled once: a bitset of every key that can
+// complete a chord, and a trie of chords. The root, where every key press
+// starts, is a dense table over (key, modifiers); deeper nodes, only ever
+// reached inside a sequence, keep sorted edges. A binding that is a prefix
+// of an earlier one, or has one as a prefix, can never fire and is dropped.
+// Immutable once built.
+class KeyBindingSet {
+public:
+    static constexpr uint32_t kNone = 0;            // no node; the root is 0 too, never a target
+    static constexpr uint16_t kNoCommand = 0xFFFF;
+
+    explicit KeyBindingSet(std::vector<KeyBinding> bindings);
+
+    const std::vector<KeyBinding>& Bindings() const { return m_bindings; }   // the ones kept
+    bool   Empty() const { return m_bindings.empty(); }
+    size_t Dropped() const { return m_dropped; }
+    size_t Nodes() const { return m_command.size(); }
+
+    bool     IsTrigger(uint8_t vk) const { return m_triggers.Test(vk); }
+    // Where chord (mods, vk) leads from node, kNone if nowhere
+    uint32_t Next(uint32_t node, uint8_t mods, uint8_t vk) const;
+    // The packed command a node completes, kNoCommand inside a sequence
+    uint16_t Command(uint32_t node) const { return m_command[node]; }
+
+private:
+    static uint16_t EdgeKey(uint8_t mods, uint8_t vk) { return (uint16_t)(vk * keymod::kCombinations + mods); }
+
+    std::vector<KeyBinding> m_bindings;
+    size_t                  m_dropped = 0;
+    KeyBits                 m_triggers;
+    std::vector<uint32_t>   m_root;          // EdgeKey -> node
+    std::vector<uint16_t>   m_command;       // per node
+    std::vector<uint32_t>   m_edgeStart;     // per node, into m_edges (Nodes() + 1)
+    std::vector<std::pair<uint16_t, uint32_t>> m_edges;   // (EdgeKey, node), sorted per node
+};
+
+// Same as SameRules(): null holds none
+inline bool SameBindings(const std::shared_ptr<const KeyBindingSet>& a,
+                         const std::shared_ptr<const KeyBindingSet>& b)
+{
+    if (a == b)
+        return true;
+    const bool noneA = !a || a->Empty();
+    const bool noneB = !b || b->Empty();
+    if (noneA || noneB)
+        return noneA && noneB;
+    return a->Bindings() == b->Bindings();
+}
+
+// What the hook matches keys against, published on its own
+struct KeyBindingConfig {
+    std::shared_ptr<const KeyBindingSet> set;   // null: none
+    int sequenceTimeoutMs = 1000;               // between the chords of a sequence
+};
+
+inline bool operator==(const KeyBindingConfig& a, const KeyBindingConfig& b) {
+    return SameBindings(a.set, b.set) && a.sequenceTimeoutMs == b.sequenceTimeoutMs;
+}
+inline bool operator!=(const KeyBindingConfig& a, const KeyBindingConfig& b) { return !(a == b); }
+
+// Runs the bindings against the raw key stream, on the hook thread: every
+// key goes through OnKey(), which says whether to let it through. A key no
+// binding completes costs a bit test; a bound one a table lookup. Never
+// allocates. Keys it swallowed on the way down are swallowed on the way
+// up (and while auto-repeating) too.
+class KeyBindingMatcher {
+public:
+    enum class Result : uint8_t {
+        Pass,      // not ours
+        Swallow,   // ours, nothing to report (a sequence going on, a repeat, a release)
+        Fire,      // a binding completed: command, down
+        Release,   // an overlay binding's modifiers all came up: command, up; the key passes
+    };
+    struct Output {
+        Result   result;
+        uint16_t command;
+    };
+
+    // Starts over with set (null: none); keys already down stay known
+    void SetBindings(std::shared_ptr<const KeyBindingSet> set, int sequenceTimeoutMs);
+    const std::shared_ptr<const KeyBindingSet>& Bindings() const { return m_set; }
+
+    Output OnKey(uint16_t vk, bool down, uint64_t timeNs);
+
+    // No sequence half typed and no overlay binding held
+    bool Idle() const { return m_node == KeyBindingSet::kNone && !m_holding; }
+    const KeyBits& Down() const { return m_down; }
+
+private:
+    std::shared_ptr<const KeyBindingSet> m_set;
+    KeyBits  m_down;
+    KeyBits  m_swallowed;             // down keys whose release is ours
+    uint64_t m_timeoutNs = 0;
+    uint32_t m_node = KeyBindingSet::kNone;   // inside a sequence
+    uint64_t m_nodeNs = 0;
+    bool     m_holding = false;       // an overlay binding is up
+    uint8_t  m_holdMods = 0;
+    uint8_t  m_holdVk = 0;
+    uint16_t m_holdCommand = 0;
+};
@@ -0,0 +1,51 @@
+// === include/key_channel.h ===
+#pragma once
+
+#include "spsc_queue.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// What the hook thread decided about a key before handing it off. Binding
+// is a key binding's chord completing (down) or its modifiers coming up.
+enum class KeyClass : uint8_t { Other, Initiator, Modifier, Binding };
+
+struct KeyEvent {
+    uint64_t timeNs;   // steady clock, taken on hook entry
+    uint16_t vk;       // Binding: the command instead (PackBinding)
+    KeyClass cls;
+    bool     down;
+};
+
+// Hook thread -> worker thread handoff. Push never blocks and never
+// allocates; it only touches the condition variable when the worker is
+// actually asleep.
+class KeyEventChannel {
+public:
+    static constexpr size_t kCapacity = 1024;
+
+    // Producer side. Returns false (and counts a drop) when the queue is full.
+    bool Push(const KeyEvent& ev);
+
+    // Consumer side. Blocks until an event arrives; false once closed and drained.
+    bool Pop(KeyEvent& out);
+
+    // Like Pop, but gives up after timeoutNs (kNoTimeout waits forever)
+    enum class PopResult { Event, Timeout, Closed };
+    static constexpr uint64_t kNoTimeout = ~0ull;
+    PopResult WaitPop(KeyEvent& out, uint64_t timeoutNs);
+
+    void Close();
+    void Reopen();
+
+    uint64_t Dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    SpscQueue<KeyEvent, kCapacity> m_queue;
+    std::atomic<bool>              m_waiting{ false };
+    std::atomic<bool>              m_closed{ false };
+    std::atomic<uint64_t>          m_dropped{ 0 };
+    std::mutex                     m_mutex;
+    std::condition_variable        m_cv;
+};
@@ -0,0 +1,60 @@
+// === include/key_trace.h ===
+#pragma once
+
+#include "key_channel.h"   // KeyEvent
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Binary key trace, little-endian:
+//   KeyTraceHeader, then `count` KeyTraceRecords.
+// Only vk/down/time are stored; the class is re-derived from the config
+// at replay time so one trace can be replayed under different hotkeys.
+struct KeyTraceHeader {
+    char     magic[8];     // "WWSKEYS\0"
+    uint32_t version;      // kKeyTraceVersion
+    uint32_t recordSize;   // sizeof(KeyTraceRecord)
+    uint64_t count;
+};
+
+struct KeyTraceRecord {
+    uint64_t timeNs;
+    uint16_t vk;
+    uint8_t  down;
+    uint8_t  reserved[5];
+};
+
+static_assert(sizeof(KeyTraceHeader) == 24, "trace header layout");
+static_assert(sizeof(KeyTraceRecord) == 16, "trace record layout");
+
+constexpr uint32_t kKeyTraceVersion = 1;
+
+bool WriteKeyTrace(const std::string& path, const std::vector<KeyEvent>& events);
+// Reads all records; cls is left as KeyClass::Other
+bool ReadKeyTrace(const std::string& path, std::vector<KeyEvent>& events);
+
+// Synthetic trace mixing every gesture the switcher knows (cancel, tap,
+// quick-select, tap-then-hold, hold+cycle, unrelated keys) with timings
+// scattered around the default thresholds, so both sides of each decision
+// get exercised. Left Alt / Left Shift; deterministic for a given seed.
+std::vector<KeyEvent> GenerateKeyTrace(size_t count, uint32_t seed = 1);
+
+// Streams events to disk as they happen (used by the hook's worker when
+// WWS_KEY_TRACE is set). Buffered; the header count is patched on Close().
+class KeyTraceWriter {
+public:
+    ~KeyTraceWriter() { Close(); }
+
+    bool Open(const std::string& path);
+    void Append(const KeyEvent& ev);
+    void Close();
+    bool IsOpen() const { return m_file != nullptr; }
+
+private:
+    void Flush();
+
+    FILE*                       m_file = nullptr;
+    uint64_t                    m_count = 0;
+    std::vector<KeyTraceRecord> m_buffer;
+};
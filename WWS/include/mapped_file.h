@@ -0,0 +1,37 @@
+// === include/mapped_file.h ===
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// A file mapped read/write into memory. Stores to Data() reach the file
+// through the page cache with no write() calls, and a crash loses nothing
+// the OS already has. mmap on POSIX, a file mapping on Windows.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Opens (creating it if needed) and maps path, grown with zeros to at
+    // least size bytes; a longer file is mapped whole
+    bool Open(const std::string& path, size_t size);
+    void Close();
+    // Asks the OS to start writing dirty pages back; doesn't wait
+    void Flush();
+
+    bool   IsOpen() const { return m_data != nullptr; }
+    void*  Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+private:
+    void*  m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void*  m_file = nullptr;      // file handle
+    void*  m_mapping = nullptr;   // file mapping handle
+#else
+    int    m_fd = -1;
+#endif
+};
@@ -0,0 +1,80 @@
+// === include/overlay_lifetime.h ===
+#pragma once
+
+#include "clock.h"
+#include <cstddef>
+#include <cstdint>
+
+// When the overlay's heavy resources (graphics device and swap chain, ImGui
+// context, font atlas) should exist, and what that costs. With an idle
+// release set they are created on demand, for a show or ahead of one when
+// the initiator goes down, and released once nothing has used them for that
+// long, so between uses only the hook and the registry stay resident. With
+// 0 they are kept once created, as the app always did.
+//
+// The owner does the creating and releasing and reports it here. UI thread
+// only; all times come from the clock.
+class OverlayLifetime {
+public:
+    static constexpr uint64_t kNever = ~0ull;
+
+    struct Latency {
+        uint64_t count = 0;
+        uint64_t totalNs = 0;
+        uint64_t maxNs = 0;
+        uint64_t lastNs = 0;
+
+        void   Add(uint64_t ns);
+        double MeanMs() const { return count ? totalNs / 1e6 / count : 0.0; }
+    };
+
+    struct Stats {
+        Latency  cold;                 // show to first present, resources created for it
+        Latency  warm;                 // show to first present, resources already up
+        Latency  create;               // creating them, warm-ups included
+        uint64_t creates = 0;
+        uint64_t releases = 0;
+        uint64_t speculative = 0;      // created ahead of a show
+        uint64_t speculativeUsed = 0;  // ... and a show came before the release
+        size_t   workingSetUp = 0;     // bytes, after the last create
+        size_t   workingSetDown = 0;   // bytes, after the last release
+    };
+
+    explicit OverlayLifetime(const Clock& clock = SystemClock());
+
+    // 0 keeps the resources once created
+    void SetIdleRelease(int ms);
+    bool ReleasesWhenIdle() const { return m_idleNs != 0; }
+    bool Alive() const { return m_alive; }
+
+    // The owner created the resources in costNs (speculative: for a show
+    // that may not come); workingSet is the process's afterwards, 0 if unknown
+    void Created(uint64_t costNs, bool speculative, size_t workingSet);
+    void Released(size_t workingSet);
+    // Anything drawn with the resources; restarts the idle period
+    void Used();
+
+    // Call before creating the resources for a show: a show is cold if they
+    // aren't up yet. While shown they are never released.
+    void ShowRequested();
+    // The first present after ShowRequested() ends the show's latency
+    void Presented();
+    void Hidden();
+
+    bool     ShouldRelease() const;
+    // How long the owner may sleep before ShouldRelease() turns true
+    uint64_t TimeUntilReleaseNs() const;
+
+    Stats GetStats() const { return m_stats; }
+
+private:
+    const Clock& m_clock;
+    uint64_t     m_idleNs = 0;
+    uint64_t     m_lastUseNs = 0;
+    uint64_t     m_showNs = 0;          // pending show, 0 once presented
+    bool         m_alive = false;
+    bool         m_shown = false;
+    bool         m_showCold = false;
+    bool         m_speculative = false; // alive from a warm-up no show has used yet
+    Stats        m_stats;
+};
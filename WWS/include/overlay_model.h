@@ -0,0 +1,61 @@
+// === include/overlay_model.h ===
+#pragma once
+
+#include "window_snapshot.h"
+#include "fuzzy_filter.h"
+#include "overlay_view.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ProcessCache;
+
+// What the overlay shows, minus the drawing: the window snapshot, the
+// type-to-filter state and the selection. Snapshots are double-buffered:
+// the next one is filled into Back() while the list on screen stays intact,
+// then Show() or Refresh() swaps it in. Nothing here allocates once the
+// buffers have grown to the size of the desktop.
+class OverlayModel {
+public:
+    OverlayModel();
+
+    // Where the next snapshot goes (registry.Snapshot(model.Back()), ...)
+    WindowSnapshot& Back() { return m_snapshots[m_front ^ 1]; }
+    // Swaps Back() in with an empty query and the previous window selected
+    void Show(ProcessCache& cache);
+    void Show(const WindowRegistry& registry, ProcessCache& cache);
+    // Swaps Back() in keeping the query, and the selected window if it is
+    // still there
+    void Refresh(ProcessCache& cache);
+
+    // Picks up process info that arrived since the last call; exe names are
+    // searchable, so the filter is rebuilt around the selection. Cheap when
+    // the cache has nothing new. True if anything changed.
+    bool ResolveProcesses(ProcessCache& cache);
+
+    // Moves the selection by delta rows, wrapping
+    void Advance(int delta = 1);
+    // Type-to-filter: appends ch to the query ('\b' deletes one); false if
+    // nothing changed
+    bool Input(wchar_t ch);
+
+    // The selected window, 0 if the list is empty
+    WindowId Selected() const;
+
+    const WindowSnapshot&        Windows() const { return m_snapshots[m_front]; }
+    const std::vector<uint32_t>& Rows() const { return m_filter.Results(); }
+    OverlayListState&            List() { return m_list; }
+    const std::wstring&          Query() const { return m_query; }
+    const std::string&           QueryUtf8() const { return m_queryUtf8; }
+
+private:
+    void Rebuild(WindowId keep);
+
+    WindowSnapshot   m_snapshots[2];
+    int              m_front = 0;
+    FuzzyFilter      m_filter;
+    std::wstring     m_query;
+    std::string      m_queryUtf8;   // for drawing
+    OverlayListState m_list;
+    uint64_t         m_processVersion = 0;
+};
@@ -0,0 +1,94 @@
+// === include/overlay_view.h ===
+#pragma once
+
+#include "window_snapshot.h"
+#include "icon_atlas.h"
+#include "thumbnail_cache.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Platform-neutral part of the overlay: just ImGui calls, no backend, so it
+// can be driven headless.
+
+class TitleFitCache;
+
+struct OverlayListLayout {
+    float  width = 500.0f;     // list column width
+    float  exeWidth = 0.0f;    // right-hand exe column, 0 hides it
+    size_t maxTitle = 80;      // characters before "..." (at most kMaxTitle); the width cuts first
+    IconAtlas* icons = nullptr; // exe icons in front of the titles, null for none
+    TitleFitCache* fits = nullptr; // where titles are cut, kept across frames; null measures every frame
+};
+
+struct OverlayListState {
+    int   selIndex = 0;
+    bool  scrollToSelection = false;  // set when the selection moves
+    float scrollY = 0.0f;             // list scroll as of the last frame
+};
+
+// Longest maxTitle a layout can ask for
+constexpr size_t kMaxTitle = 200;
+
+// Where a title is cut: the bytes to draw, then "..." if it was
+struct TitleFit {
+    uint32_t len = 0;
+    bool     cut = false;
+};
+
+// Longest prefix of utf8 that fits width pixels in the current font, with
+// "..." after it unless it is all of it, and at most maxChars characters
+// ("..." counting three). Call inside a frame.
+TitleFit FitTitle(std::string_view utf8, float width, size_t maxChars);
+
+// FitTitle() of each snapshot row's display text, measured the first time
+// the row is drawn and kept until the snapshot is refilled or the font, its
+// size, the width or maxChars change, so a steady frame measures nothing.
+// Never allocates once it has held as many rows as the snapshot has.
+// UI thread only.
+class TitleFitCache {
+public:
+    TitleFit Get(const WindowSnapshot& windows, uint32_t row, float width, size_t maxChars);
+    size_t   Measured() const { return m_measured; }   // FitTitle() calls so far
+
+private:
+    static constexpr uint32_t kUnknown = ~0u;
+    static constexpr uint32_t kCut = 1u << 31;
+
+    uint64_t              m_generation = 0;
+    const ImFont*         m_font = nullptr;
+    float                 m_fontSize = 0.0f;
+    float                 m_width = 0.0f;
+    size_t                m_maxChars = 0;
+    std::vector<uint32_t> m_fits;        // per row: len | kCut, kUnknown until drawn
+    size_t                m_measured = 0;
+};
+
+// Height the list needs for rows, capped at maxHeight (the rest scrolls).
+// Call inside a frame, it depends on the current font.
+float OverlayListHeight(size_t rows, float maxHeight);
+
+// Draws the list as a scrolling child of the current window; row i shows
+// window rows[i] of the snapshot and selIndex counts rows. Only the rows in
+// view (plus the selection) are submitted, straight from the snapshot's
+// arena, so a frame allocates nothing of its own. Titles are cut to the
+// room left of the exe column (FitTitle()). A pending
+// scrollToSelection is applied before the child begins, so the selection
+// is in view on the same frame.
+void DrawWindowList(const char* id, const WindowSnapshot& windows,
+                    const std::vector<uint32_t>& rows, OverlayListState& state,
+                    const OverlayListLayout& layout, float height);
+
+// Height DrawThumbnailStrip() takes
+float ThumbnailStripHeight(const ThumbnailCache& thumbs);
+
+// Thumbnails of the selected row and up to neighbours rows either side of
+// it (more on one side near the ends of the list), as many as fit in
+// width, in a line, the selection framed. These are the only windows asked
+// for (ThumbnailCache::Get()), so nothing off screen is ever captured;
+// a window without one yet keeps its place empty.
+void DrawThumbnailStrip(const char* id, const WindowSnapshot& windows,
+                        const std::vector<uint32_t>& rows, int selIndex,
+                        ThumbnailCache& thumbs, int neighbours, float width);
@@ -0,0 +1,120 @@
+// === include/process_cache.h ===
+#pragma once
+
+#include "fetch_pool.h"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+struct ProcessInfo {
+    uint32_t     pid = 0;
+    uint64_t     startTime = 0;   // disambiguates reused pids
+    std::wstring exeName;         // "notepad.exe"
+    std::wstring exePath;         // full image path
+};
+
+// Where process metadata actually comes from (OpenProcess on Windows,
+// /proc elsewhere, canned data in tests). Called off the render path only.
+class ProcessInfoProvider {
+public:
+    using ExitFn = std::function<void(uint32_t pid, uint64_t startTime)>;
+
+    virtual ~ProcessInfoProvider() = default;
+    // Fills info for pid; false if the process is gone or inaccessible
+    virtual bool Query(uint32_t pid, ProcessInfo& info) = 0;
+    // Calls onExit once the process exits, right away if it already has
+    // (or its pid now belongs to another one). False if exits can't be
+    // watched here; onExit is then never called.
+    virtual bool WatchExit(const ProcessInfo& info, ExitFn onExit) = 0;
+    // Drops every pending exit watch; no onExit calls after this returns
+    virtual void CancelWatches() = 0;
+};
+
+// Process metadata keyed by (pid, start time). Lookups never touch the
+// kernel: a miss queues the pid for a FetchPool and returns null, and the
+// entry shows up (bumping Version()) once it has been fetched. A process
+// that doesn't answer only holds up its own rows; the pool works around it.
+// Entries are evicted when the provider reports the process exited; where
+// it can't watch for that, they are fetched again every kRetryNs, so a
+// reused pid stops showing the dead process's exe.
+class ProcessCache {
+public:
+    explicit ProcessCache(int workers = 2, int maxWorkers = 6,
+                          uint64_t deadlineNs = FetchPool::kDeadlineNs)
+        : m_pool(workers, maxWorkers, deadlineNs) {}
+    ~ProcessCache() { Stop(); }
+
+    void Start(ProcessInfoProvider& provider);
+    void Stop();
+
+    // Cached info for pid, or null (and a fetch is queued) if not known yet
+    std::shared_ptr<const ProcessInfo> Lookup(uint32_t pid);
+
+    void   Evict(uint32_t pid, uint64_t startTime);
+    size_t Size() const;
+    // Bumped whenever an entry is added or evicted
+    uint64_t Version() const;
+
+    // Called on a fetch thread after an entry lands (e.g. to request a frame)
+    void SetUpdateCallback(std::function<void()> fn);
+
+    FetchPool::Stats PoolStats() const { return m_pool.GetStats(); }
+
+    // Failed lookups (access denied, already gone), and entries whose exit
+    // isn't watched, are fetched again after this long
+    static constexpr uint64_t kRetryNs = 5000000000ull;
+
+private:
+    struct Entry {
+        std::shared_ptr<const ProcessInfo> info;   // null for a failed fetch
+        uint64_t                           fetchedAtNs = 0;
+        bool                               watched = false;   // evicted on exit
+    };
+
+    void Fetch(uint32_t pid);   // on a pool worker
+
+    ProcessInfoProvider*                   m_provider = nullptr;
+    mutable std::mutex                     m_mutex;
+    std::unordered_map<uint32_t, Entry>    m_entries;
+    std::unordered_set<uint32_t>           m_queued;     // submitted, not fetched yet
+    std::function<void()>                  m_onUpdate;
+    bool                                   m_running = false;
+    uint64_t                               m_version = 0;
+    FetchPool                              m_pool;
+};
+
+// Canned process table for tests and benchmarks; Exit() fires the watches.
+// Queries for a pid can be slowed down, or held until Release(), to stand
+// in for processes that don't answer.
+class FakeProcessInfoProvider : public ProcessInfoProvider {
+public:
+    void Add(uint32_t pid, uint64_t startTime, std::wstring exePath);
+    void Exit(uint32_t pid);
+    void SetDelay(uint32_t pid, int ms);
+    void Hang(uint32_t pid);
+    void Release();   // lets hung queries return, and stops hanging new ones
+    uint64_t Queries() const;
+
+    bool Query(uint32_t pid, ProcessInfo& info) override;
+    bool WatchExit(const ProcessInfo& info, ExitFn onExit) override;
+    void CancelWatches() override;
+
+private:
+    mutable std::mutex                       m_mutex;
+    std::condition_variable                  m_released;
+    std::unordered_map<uint32_t, ProcessInfo> m_procs;
+    std::unordered_map<uint32_t, ExitFn>      m_watches;
+    std::unordered_map<uint32_t, int>         m_delays;   // ms, -1 to hang
+    uint64_t                                 m_queries = 0;
+};
+
+// Splits the file name off a full path (either slash)
+std::wstring ExeNameFromPath(const std::wstring& path);
+
+// The cache the overlay reads from
+ProcessCache& GetProcessCache();
@@ -0,0 +1,9 @@
+// === include/process_memory.h ===
+#pragma once
+
+#include <cstddef>
+
+// Bytes of this process resident in physical memory (the working set on
+// Windows, RSS elsewhere); 0 if the system won't say. One implementation
+// per platform.
+size_t ProcessWorkingSetBytes();
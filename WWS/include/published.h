@@ -0,0 +1,155 @@
+// === include/published.h ===
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// A value that is replaced now and then and read all the time from other
+// threads (the hook reads the hotkey config on every key). Every published
+// value is an immutable snapshot behind an atomic pointer; readers never
+// lock, wait or retry: Reader::Get() is two atomic loads and a store.
+//
+// Old snapshots are freed by a later Publish() once no reader can still be
+// looking at them: each reader announces the publish epoch it started
+// reading in, and a snapshot retired at epoch E goes once every reader is
+// idle or has announced E or later.
+template <class T>
+class Published {
+public:
+    static constexpr int kMaxReaders = 8;
+
+    class Reader;
+
+    // Keeps the snapshot from Reader::Get() alive while it is in scope
+    class Guard {
+    public:
+        Guard(Guard&& o) noexcept : m_value(o.m_value), m_slot(o.m_slot) { o.m_slot = nullptr; }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+        ~Guard() {
+            if (m_slot)
+                m_slot->store(kIdle, std::memory_order_release);
+        }
+
+        const T& operator*() const { return *m_value; }
+        const T* operator->() const { return m_value; }
+
+    private:
+        friend class Reader;
+        Guard(const T* value, std::atomic<uint64_t>* slot) : m_value(value), m_slot(slot) {}
+
+        const T*               m_value;
+        std::atomic<uint64_t>* m_slot;
+    };
+
+    // One per reading thread, registered for its lifetime (at most
+    // kMaxReaders at once). Only one Guard per Reader may be alive.
+    class Reader {
+    public:
+        explicit Reader(Published& p) : m_p(p), m_slot(p.Register()) {}
+        ~Reader() {
+            if (m_slot)
+                m_slot->store(kFree, std::memory_order_release);
+        }
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        // Wait-free. Null Guard contents only if registration failed.
+        Guard Get() {
+            if (!m_slot)
+                return Guard(nullptr, nullptr);
+            m_slot->store(m_p.m_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+            return Guard(&m_p.m_current.load(std::memory_order_seq_cst)->value, m_slot);
+        }
+
+        bool Registered() const { return m_slot != nullptr; }
+
+    private:
+        Published&             m_p;
+        std::atomic<uint64_t>* m_slot;
+    };
+
+    explicit Published(const T& initial = T()) : m_current(new Node{ initial, 0 }) {
+        for (auto& s : m_slots)
+            s.store(kFree, std::memory_order_relaxed);
+    }
+    ~Published() {
+        // readers must be gone by now
+        delete m_current.load(std::memory_order_relaxed);
+        for (Node* n : m_retired)
+            delete n;
+    }
+    Published(const Published&) = delete;
+    Published& operator=(const Published&) = delete;
+
+    // Swaps value in. Publishers are serialized with each other, never
+    // with readers.
+    void Publish(const T& value) {
+        Node* fresh = new Node{ value, 0 };
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Node* old = m_current.exchange(fresh, std::memory_order_seq_cst);
+        old->retiredAt = m_epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+        m_retired.push_back(old);
+        Reclaim();
+    }
+
+    // A copy of the current value, for threads without a Reader
+    T Load() const {
+        // snapshots are only freed under m_mutex
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_current.load(std::memory_order_acquire)->value;
+    }
+
+    // Bumped by every Publish()
+    uint64_t Version() const { return m_epoch.load(std::memory_order_acquire); }
+
+    // Snapshots still waiting for readers to move on
+    size_t Retired() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_retired.size();
+    }
+
+private:
+    static constexpr uint64_t kFree = ~0ull;        // slot unused
+    static constexpr uint64_t kIdle = ~0ull - 1;    // reader registered, not reading
+
+    struct Node {
+        T        value;
+        uint64_t retiredAt;
+    };
+
+    std::atomic<uint64_t>* Register() {
+        for (auto& s : m_slots) {
+            uint64_t expected = kFree;
+            if (s.compare_exchange_strong(expected, kIdle, std::memory_order_acq_rel))
+                return &s;
+        }
+        return nullptr;
+    }
+
+    void Reclaim() {
+        uint64_t oldest = kIdle;
+        for (auto& s : m_slots) {
+            uint64_t seen = s.load(std::memory_order_seq_cst);
+            if (seen < oldest)
+                oldest = seen;
+        }
+        size_t kept = 0;
+        for (Node* n : m_retired) {
+            if (n->retiredAt <= oldest)
+                delete n;
+            else
+                m_retired[kept++] = n;
+        }
+        m_retired.resize(kept);
+    }
+
+    std::atomic<Node*>    m_current;
+    std::atomic<uint64_t> m_epoch{ 0 };
+    std::atomic<uint64_t> m_slots[kMaxReaders];
+    mutable std::mutex    m_mutex;     // publishers, m_retired
+    std::vector<Node*>    m_retired;
+};
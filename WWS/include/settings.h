@@ -1,21 +1,125 @@
 // === src/settings.h ===
 #pragma once
 
-#include <windows.h>
+#include "switcher.h"      // SwitcherConfig, vk::
+#include "key_bindings.h"  // KeyBindingConfig
+#include "window_rules.h"  // WindowRuleSet
+#include "published.h"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 
-// Your hotkey settings
+// Everything wws_config.json holds. Each part goes to whoever runs on it:
+// SettingsStore publishes the switcher's keys and timings, the key bindings
+// and the window rules on channels of their own; the overlay options are
+// the UI thread's.
 struct HotkeyConfig {
-    UINT initiator;       // e.g. VK_LMENU
-    UINT modifier;        // e.g. VK_LSHIFT
-    int  tapTimeoutMs;    // e.g. 300
-    int  overlayTimeoutMs;// e.g. 500
+    SwitcherConfig   switcher;
+    KeyBindingConfig keyBindings;   // matched on the hook thread (KeyBindingMatcher)
+    // include/exclude/pin rules on top of the built-in window checks,
+    // compiled at load (null: none); shared, so copies stay cheap
+    std::shared_ptr<const WindowRuleSet> windowRules;
+    bool     frecencyOrder = false;            // list windows by frecency, not MRU (WindowRegistry)
+    int      overlayIdleReleaseMs = 0;         // drop the overlay's GPU resources when unused this long, 0: keep (OverlayLifetime)
+    bool     overlayWarmOnInitiator = true;    // recreate them as the initiator goes down
+    bool     thumbnails = false;               // previews of the selection and its neighbours (ThumbnailCache)
+    int      thumbnailCacheMB = 96;            // their texture and captures in flight, read at start
 };
 
-// Accessors
+// Equal when they would save the same file
+bool operator==(const HotkeyConfig& a, const HotkeyConfig& b);
+inline bool operator!=(const HotkeyConfig& a, const HotkeyConfig& b) { return !(a == b); }
+
+constexpr const char* kSettingsFile = "wws_config.json";
+
+// The settings panel's working copy (UI thread only)
 HotkeyConfig& GetSettings();
-HotkeyConfig  LoadSettings();
-void          SaveSettings(const HotkeyConfig& cfg);
+
+// File I/O. LoadSettings gives the defaults for a missing or unreadable
+// file; SaveSettings writes a temp file and renames it over path, so a
+// reader never sees half a file.
+HotkeyConfig  LoadSettings(const std::string& path = kSettingsFile);
+bool          LoadSettings(const std::string& path, HotkeyConfig& out);
+bool          SaveSettings(const HotkeyConfig& cfg, const std::string& path = kSettingsFile);
 
 // Helpers for your UI
-const char* KeyName(UINT vk);
-UINT        KeyFromName(const char* name);
+const char* KeyName(uint32_t vk);
+uint32_t    KeyFromName(const char* name);
+
+class FileWatcher;
+
+// The live settings. Whatever is published here is what the hook runs on:
+// it reads the switcher config and the key bindings through
+// Published<>::Readers, wait-free, on every key. Edits in the settings
+// panel, the file on disk changing and Load() all publish; each channel
+// only when its part changed.
+class SettingsStore {
+public:
+    explicit SettingsStore(std::string path = kSettingsFile);
+    ~SettingsStore();
+    SettingsStore(const SettingsStore&) = delete;
+    SettingsStore& operator=(const SettingsStore&) = delete;
+
+    // Reads the file (defaults if there is none) and publishes it
+    HotkeyConfig Load();
+    // Publishes the parts of cfg that differ from what is live
+    void Publish(const HotkeyConfig& cfg);
+    // Publishes cfg and writes it on a background thread; saves that pile
+    // up while one is being written collapse into the latest
+    void SaveAsync(const HotkeyConfig& cfg);
+    // Waits for every SaveAsync() so far to be on disk
+    void Flush();
+
+    // Reloads whenever the file changes on disk. A changed config is
+    // published, then passed to onReload on the watcher thread.
+    bool Watch(std::function<void(const HotkeyConfig&)> onReload = {});
+    void StopWatching();
+    // What the watcher does on a change, now (the control endpoint's
+    // "reload"); nothing if the file still holds what we last saw
+    void Reload();
+
+    Published<SwitcherConfig>&                       Switcher() { return m_switcher; }
+    Published<KeyBindingConfig>&                     KeyBindings() { return m_keyBindings; }
+    Published<std::shared_ptr<const WindowRuleSet>>& WindowRules() { return m_windowRules; }
+    // Everything last published, for the settings panel
+    HotkeyConfig Current() const;
+    const std::string&       Path() const { return m_path; }
+    // Saves written, reloads published; for tests
+    uint64_t Saves() const;
+    uint64_t Reloads() const;
+
+private:
+    void SaverMain();
+    void PublishLocked(const HotkeyConfig& cfg);   // m_mutex held
+
+    std::string                                     m_path;
+    Published<SwitcherConfig>                       m_switcher;
+    Published<KeyBindingConfig>                     m_keyBindings;
+    Published<std::shared_ptr<const WindowRuleSet>> m_windowRules;
+
+    mutable std::mutex      m_mutex;
+    HotkeyConfig            m_current;      // what the channels hold, and the rest
+    // m_saver state
+    std::condition_variable m_cv;
+    std::thread             m_saver;
+    HotkeyConfig            m_pending;
+    bool                    m_hasPending = false;
+    bool                    m_writing = false;
+    bool                    m_stop = false;
+    uint64_t                m_saves = 0;
+    uint64_t                m_reloads = 0;
+    uint64_t                m_writes = 0;   // saves started, so Reload can tell one began as it read
+    // what we last wrote, so our own saves don't come back as reloads
+    HotkeyConfig            m_written;
+    bool                    m_hasWritten = false;
+
+    std::unique_ptr<FileWatcher>               m_watcher;
+    std::function<void(const HotkeyConfig&)>   m_onReload;
+};
+
+// The app's store, on kSettingsFile
+SettingsStore& GetSettingsStore();
@@ -0,0 +1,123 @@
+// === include/soft_renderer.h ===
+#pragma once
+
+#include "imgui.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A plain 32-bit framebuffer, 0xAARRGGBB per pixel (B, G, R, A in memory,
+// which GDI DIBs and X11 ZPixmaps take as they are), rows top to bottom
+struct SoftFramebuffer {
+    int                   width = 0;
+    int                   height = 0;
+    std::vector<uint32_t> pixels;
+
+    void     Resize(int w, int h);
+    void     Clear(uint32_t argb);
+    uint32_t At(int x, int y) const { return pixels[(size_t)y * width + x]; }
+
+    // Binary PPM (alpha dropped), for golden images and looking at failures
+    bool WritePpm(const std::string& path) const;
+    bool ReadPpm(const std::string& path);
+};
+
+// ImGui renderer backend that draws ImDrawData on the CPU into a
+// SoftFramebuffer: for machines without a usable GPU (VDI sessions, broken
+// drivers) and for pixel tests of the overlay on Linux.
+//
+// Draw commands become primitives first. The axis-aligned quads ImGui
+// emits for text and rectangles, which is nearly all the overlay draws,
+// are filled a span at a time; everything else goes through triangle
+// setup and edge functions evaluated four pixels at once (SSE2 where the
+// target has it). The framebuffer is cut into kTileSize tiles and each
+// tile replays, in order, the primitives that touch it, so tiles fill on
+// several threads and the result doesn't depend on how many.
+//
+// Textures are sampled nearest; blending is ImGui's non-premultiplied
+// "over" (what imgui_impl_dx11 sets up).
+class SoftRenderer {
+public:
+    static constexpr int kTileSize = 64;
+
+    // threads: tile workers including the caller, 0 for one per core
+    explicit SoftRenderer(int threads = 0);
+    ~SoftRenderer();
+    SoftRenderer(const SoftRenderer&) = delete;
+    SoftRenderer& operator=(const SoftRenderer&) = delete;
+
+    // Sets ImGuiBackendFlags_RendererHasTextures (and vertex offsets) on
+    // the current context; Shutdown() gives the textures back
+    void Init();
+    void Shutdown();
+    // Processes ImGui::GetPlatformIO().Textures, call after ImGui::Render()
+    // (Render() does the ones in its draw data itself)
+    void Update();
+
+    // Draws dd over fb, which keeps its size; clear it first if needed
+    void Render(const ImDrawData* dd, SoftFramebuffer& fb);
+
+    // Off sends quads through the triangle path too (to test one against
+    // the other)
+    void SetQuadFastPath(bool on) { m_quadFastPath = on; }
+    int  Threads() const { return (int)m_workers.size() + 1; }
+
+    struct Stats {
+        size_t quads = 0;       // filled as spans
+        size_t triangles = 0;
+        size_t binned = 0;      // primitive-tile pairs
+        size_t textures = 0;
+    };
+    const Stats& LastStats() const { return m_stats; }
+
+private:
+    struct Texture {
+        int                   width = 0;
+        int                   height = 0;
+        std::vector<uint32_t> texels;   // ImU32 layout (R in the low byte), like vertex colours
+    };
+    struct Prim;
+    struct Tri;
+
+    void UpdateTexture(ImTextureData* tex);
+    void AddCommands(const ImDrawData* dd, const SoftFramebuffer& fb);
+    bool AddQuad(const ImDrawVert* v, const ImDrawIdx* idx, const Texture* tex, const int clip[4]);
+    void AddTri(const ImDrawVert& a, const ImDrawVert& b, const ImDrawVert& c, const Texture* tex, const int clip[4]);
+    void Bin(uint32_t prim);
+    void FillTiles();
+    void FillTile(int tile);
+    void FillQuad(const Prim& p, int x0, int y0, int x1, int y1);
+    void FillTri(const Prim& p, int x0, int y0, int x1, int y1);
+    void WorkerMain();
+
+    // per frame, reused
+    std::vector<Prim>                  m_prims;
+    std::vector<Tri>                   m_tris;
+    std::vector<std::vector<uint32_t>> m_bins;   // prims per tile, in draw order
+    int                                m_tilesX = 0;
+    int                                m_tilesY = 0;
+    ImVec2                             m_origin;  // DisplayPos
+    ImVec2                             m_scale;   // FramebufferScale
+    SoftFramebuffer*                   m_fb = nullptr;
+    bool                               m_quadFastPath = true;
+    Stats                              m_stats;
+
+    std::vector<std::unique_ptr<Texture>> m_textures;
+    Texture                               m_white;   // for draws without a texture
+
+    // tile workers
+    std::vector<std::thread> m_workers;
+    std::mutex               m_mutex;
+    std::condition_variable  m_wake;
+    std::condition_variable  m_done;
+    uint64_t                 m_job = 0;     // bumped per frame
+    int                      m_busy = 0;    // workers still filling
+    bool                     m_stop = false;
+    std::atomic<int>         m_nextTile{ 0 };
+};
@@ -0,0 +1,60 @@
+// === include/spsc_queue.h ===
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded single-producer/single-consumer ring buffer. Wait-free on both
+// sides: TryPush/TryPop never block, they fail when full/empty.
+// Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+        "SpscQueue capacity must be a power of two");
+
+public:
+    bool TryPush(const T& v) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tailCache == Capacity) {
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+            if (head - m_tailCache == Capacity)
+                return false;
+        }
+        m_items[head & (Capacity - 1)] = v;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& out) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_headCache) {
+            m_headCache = m_head.load(std::memory_order_acquire);
+            if (tail == m_headCache)
+                return false;
+        }
+        out = m_items[tail & (Capacity - 1)];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called from a third thread
+    bool Empty() const {
+        return m_head.load(std::memory_order_acquire) ==
+               m_tail.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    static constexpr size_t kCacheLine = 64;
+
+    // producer side
+    alignas(kCacheLine) std::atomic<size_t> m_head{ 0 };
+    size_t                                  m_tailCache = 0;
+    // consumer side
+    alignas(kCacheLine) std::atomic<size_t> m_tail{ 0 };
+    size_t                                  m_headCache = 0;
+
+    alignas(kCacheLine) T m_items[Capacity];
+};
@@ -0,0 +1,118 @@
+// === include/switcher.h ===
+#pragma once
+
+#include "key_channel.h"   // KeyEvent, KeyClass
+#include <cstdint>
+
+// Virtual-key codes the switcher cares about (same values as winuser.h,
+// spelled out so this header stays free of windows.h)
+namespace vk {
+constexpr uint16_t Shift  = 0x10;
+constexpr uint16_t Menu   = 0x12;
+constexpr uint16_t LShift = 0xA0;
+constexpr uint16_t RShift = 0xA1;
+constexpr uint16_t LMenu  = 0xA4;
+constexpr uint16_t RMenu  = 0xA5;
+}
+
+// State machine for our switcher
+enum class SwitcherState : uint8_t { Idle, TapPending, QuickSelect, Listing };
+
+// The keys and timings the switcher runs on; the rest of the settings
+// file (settings.h) is none of its business
+struct SwitcherConfig {
+    uint16_t initiator = vk::LMenu;
+    uint16_t modifier = vk::LShift;
+    int      tapTimeoutMs = 300;
+    int      overlayTimeoutMs = 500;
+};
+
+inline bool operator==(const SwitcherConfig& a, const SwitcherConfig& b) {
+    return a.initiator == b.initiator && a.modifier == b.modifier &&
+           a.tapTimeoutMs == b.tapTimeoutMs && a.overlayTimeoutMs == b.overlayTimeoutMs;
+}
+inline bool operator!=(const SwitcherConfig& a, const SwitcherConfig& b) { return !(a == b); }
+
+enum class SwitcherActionType : uint8_t {
+    Tap,          // switch to the previous window
+    HoldStart,    // show the overlay
+    Cycle,        // advance the overlay selection
+    Commit,       // activate the overlay selection
+    Cancel,       // initiator released without doing anything
+    QuickSelect,  // activate the index-th window in list order
+};
+
+struct SwitcherAction {
+    SwitcherActionType type;
+    int                index;   // QuickSelect only
+};
+
+// Pure, table-driven hotkey logic. It never reads a clock: all timing comes
+// from KeyEvent::timeNs and the time passed to OnTimer, so the hook's
+// timestamps and recorded traces replay identically.
+//
+// Holds are detected on a deadline, not on release: pressing the modifier
+// arms tapTimeoutMs, each tap arms overlayTimeoutMs, and HoldStart fires
+// from OnTimer as soon as one expires with the initiator still down.
+//
+// Key bindings arrive already matched (KeyClass::Binding) and act unless
+// a tap or listing gesture owns the keys: a Select quick-selects straight
+// away, an Overlay shows the overlay, cycles on each repeat and commits on
+// its release.
+class SwitcherMachine {
+public:
+    static constexpr int kMaxActions = 2;
+
+    SwitcherMachine() = default;
+    explicit SwitcherMachine(const SwitcherConfig& cfg) : m_cfg(cfg) {}
+
+    // Feeds one key event; writes up to kMaxActions actions to out and
+    // returns how many. A deadline that passed before the event is fired
+    // first. Keys classified as Other are otherwise ignored.
+    int OnKey(const KeyEvent& ev, SwitcherAction* out);
+
+    // Fires the pending deadline if now has reached it
+    int OnTimer(uint64_t nowNs, SwitcherAction* out);
+
+    // When OnTimer must next be called, 0 if nothing is armed
+    uint64_t Deadline() const { return m_deadlineNs; }
+
+    void Reset();
+    void SetConfig(const SwitcherConfig& cfg) { m_cfg = cfg; }
+
+    const SwitcherConfig& Config() const { return m_cfg; }
+    SwitcherState         State() const { return m_state; }
+    int                   TapCount() const { return m_tapCount; }
+
+    // Matches a vk against a configured key (generic Alt/Shift match both sides)
+    static bool     IsKey(uint16_t vk, uint16_t cfg);
+    static KeyClass Classify(uint16_t vk, const SwitcherConfig& cfg);
+
+private:
+    enum Input : uint8_t { InitiatorDown, InitiatorUp, ModifierDown, ModifierUp, Timeout, kInputCount };
+    using Handler = int (SwitcherMachine::*)(uint64_t now, SwitcherAction* out);
+    static const Handler kTable[4][kInputCount];
+
+    int Ignore(uint64_t now, SwitcherAction* out);
+    int Begin(uint64_t now, SwitcherAction* out);
+    int Cancel(uint64_t now, SwitcherAction* out);
+    int PressModifier(uint64_t now, SwitcherAction* out);
+    int FirstTap(uint64_t now, SwitcherAction* out);
+    int CountTap(uint64_t now, SwitcherAction* out);
+    int FinishTaps(uint64_t now, SwitcherAction* out);
+    int StartHold(uint64_t now, SwitcherAction* out);
+    int Cycle(uint64_t now, SwitcherAction* out);
+    int Commit(uint64_t now, SwitcherAction* out);
+    int OnBinding(const KeyEvent& ev, SwitcherAction* out);
+
+    SwitcherConfig m_cfg;
+    SwitcherState  m_state = SwitcherState::Idle;
+    int            m_tapCount = 0;
+    bool           m_modifierDown = false;   // physical state, to skip auto-repeat
+    bool           m_holdPress = false;      // the press that opened the overlay is still down
+    bool           m_bindingHold = false;    // the overlay is up for a binding, which commits it
+    uint64_t       m_modifierDownNs = 0;
+    uint64_t       m_deadlineNs = 0;
+};
+
+const char* SwitcherActionName(SwitcherActionType type);
@@ -0,0 +1,41 @@
+// === include/switcher_scheduler.h ===
+#pragma once
+
+#include "clock.h"
+#include "key_channel.h"
+#include "switcher.h"
+#include <functional>
+
+// Drives a SwitcherMachine from a KeyEventChannel: handles keys as they
+// arrive and fires the machine's deadline on time, sleeping in between.
+// The clock is injected so hold timing can be tested with a ManualClock.
+class SwitcherScheduler {
+public:
+    using ActionFn = std::function<void(const SwitcherAction&)>;
+    using KeyFn = std::function<void(const KeyEvent&)>;
+
+    SwitcherScheduler(SwitcherMachine& machine, KeyEventChannel& keys,
+                      const Clock& clock, ActionFn onAction);
+
+    // Called for every key before the machine sees it (trace recording)
+    void SetKeyObserver(KeyFn fn) { m_onKey = std::move(fn); }
+
+    // Waits for the next key or the machine's deadline, whichever comes
+    // first, and handles it. Returns false once the channel is closed.
+    bool RunOnce();
+    void Run() { while (RunOnce()) {} }
+
+    // Handles every key already queued and a deadline that has passed by
+    // clock.NowNs(); never blocks
+    void Poll();
+
+private:
+    void HandleKey(const KeyEvent& ev);
+    void HandleTimer();
+
+    SwitcherMachine& m_machine;
+    KeyEventChannel& m_keys;
+    const Clock&     m_clock;
+    ActionFn         m_onAction;
+    KeyFn            m_onKey;
+};
@@ -0,0 +1,195 @@
+// === include/thumbnail_cache.h ===
+#pragma once
+
+#include "clock.h"
+#include "downscale.h"
+#include "window_registry.h"   // WindowId
+#include "imgui.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class FetchPool;
+
+// A window's contents as RGBA8 pixels, row-major, no padding
+struct WindowImage {
+    int                   width = 0;
+    int                   height = 0;
+    std::vector<uint32_t> rgba;
+};
+
+// Where thumbnails come from (PrintWindow on Windows, synthetic in tests)
+class ThumbnailSource {
+public:
+    virtual ~ThumbnailSource() = default;
+    // The size Capture() would return, without capturing; false if the
+    // window can't be captured (gone, minimized)
+    virtual bool Size(WindowId id, int& width, int& height) = 0;
+    // Captures the window at its own size; false if it can't be (gone,
+    // minimized, refusing to paint)
+    virtual bool Capture(WindowId id, WindowImage& out) = 0;
+    // Memory a capture of that size holds at its peak
+    virtual size_t CaptureBytes(int width, int height) const { return (size_t)width * height * 4; }
+};
+
+// Window thumbnails in one shared ImGui texture, a grid of fixed-size cells
+// as many as the memory budget allows: the texture's pixels, the captures
+// in flight and the downscaler's rows together stay under it. Captures get
+// a fixed share of the budget; one (which can be a whole 4K window) only
+// lives while it is downscaled (DownscaleRgba) into its cell, and is only
+// started once its size and rows fit in what the others leave of that
+// share. A window too big for all of it gets no thumbnail.
+//
+// Nothing is captured ahead of time: Get() is what asks for a window's
+// thumbnail, so only rows on screen are ever captured, and they are
+// captured again once their thumbnail is older than the refresh interval
+// (the old one stays up meanwhile). Captures run in Get() within a
+// per-frame budget, or on a FetchPool's workers when one is set. The least
+// recently drawn thumbnails give up their cells; ones drawn this frame
+// never do. Uploads only cover the cells that changed, through ImGui's
+// texture list like IconAtlas. UI thread only.
+class ThumbnailCache {
+public:
+    static constexpr int kMaxInFlight = 4;   // captures on workers at once
+
+    // captureBytes of budgetBytes are kept for captures, the texture gets
+    // what is left
+    ThumbnailCache(int cellWidth, int cellHeight, size_t budgetBytes, size_t captureBytes,
+                   const Clock& clock = SystemClock());
+    ~ThumbnailCache();
+
+    void SetSource(ThumbnailSource* source) { m_source = source; }
+    // Captures per frame at most; later ones wait for the next frame
+    void SetCaptureBudget(int perFrame) { m_captureBudget = perFrame; }
+    // Captures and downscales on pool's workers instead; results land in
+    // their cells on the next NewFrame(). The pool must be stopped before
+    // the source goes away.
+    void SetLoader(FetchPool* pool) { m_loader = pool; }
+    // Thumbnails older than this are captured again when drawn; 0 never
+    void SetRefresh(int ms) { m_refreshNs = ms > 0 ? (uint64_t)ms * 1000000 : 0; }
+    // Called on a worker when a capture is done (e.g. to request a frame)
+    void SetUpdateCallback(std::function<void()> fn);
+
+    // Registers/unregisters the texture with the current ImGui context
+    void Attach();
+    void Detach();
+
+    // Call once per frame before any Get()
+    void NewFrame();
+
+    // Texture coordinates and size in pixels of id's thumbnail, capturing
+    // it first if there is none or it is stale. False while there is none
+    // (see Pending()), or the window can't be captured.
+    bool Get(WindowId id, ImVec2& uv0, ImVec2& uv1, ImVec2& size);
+
+    // Forgets every thumbnail; the texture keeps its size
+    void Clear();
+
+    // Captures skipped this frame because of the budget, or still running
+    bool         Pending() const { return m_pending; }
+    int          CellWidth() const { return m_cellW; }
+    int          CellHeight() const { return m_cellH; }
+    size_t       Slots() const { return m_owner.size(); }
+    ImTextureRef TexRef() { return m_tex.GetTexRef(); }
+
+    struct Stats {
+        size_t   entries = 0;          // thumbnails in the texture
+        size_t   slots = 0;
+        size_t   captures = 0;         // source calls (finished ones, with a loader)
+        size_t   failures = 0;         // ... that returned nothing
+        size_t   oversized = 0;        // captures not made, the window too big for the capture share
+        size_t   refreshes = 0;        // captures of a window that already had a thumbnail
+        size_t   evictions = 0;
+        size_t   uploadRects = 0;
+        size_t   uploadBytes = 0;      // creates included
+        uint64_t sourcePixels = 0;     // captured pixels downscaled
+        uint64_t downscaleNs = 0;
+        size_t   largestCapture = 0;   // bytes of the biggest capture, held only while downscaled
+        size_t   retainedBytes = 0;    // texture + captures in flight + scratch
+        size_t   peakBytes = 0;        // most retainedBytes ever was, a capture on the UI thread included
+        size_t   budgetBytes = 0;
+    };
+    Stats GetStats() const;
+
+private:
+    struct Inbox;    // thumbnails downscaled on workers, not placed yet
+    struct Entry {
+        int      slot = -1;          // -1: never captured successfully
+        int      w = 0, h = 0;
+        uint64_t lastUsed = 0;       // frame number
+        uint64_t capturedNs = 0;     // last attempt
+        bool     attempted = false;  // captured (or failed to be) since it last had no cell to go to
+    };
+    struct Done {
+        WindowId    id = 0;
+        WindowImage thumb;           // already cell-sized
+        bool        ok = false;
+        size_t      reserved = 0;    // of m_captureRoom, while it ran
+        size_t      captureBytes = 0;
+        uint64_t    sourcePixels = 0;
+        uint64_t    downscaleNs = 0;
+    };
+
+    int  CellX(int slot) const { return (slot % m_columns) * (m_cellW + 1); }
+    int  CellY(int slot) const { return (slot / m_columns) * (m_cellH + 1); }
+    int  TakeSlot(WindowId id);
+    bool Store(WindowId id, Entry& e, const uint32_t* pixels, int w, int h);
+    size_t Retained() const;
+    void Reserve(size_t bytes);
+    bool CaptureNow(WindowId id, Entry& e, size_t cost);
+    void Submit(WindowId id, size_t cost);
+    void Upload(const Entry& e);
+
+    const Clock&                     m_clock;
+    const int                        m_cellW;
+    const int                        m_cellH;
+    const size_t                     m_budget;
+    const size_t                     m_captureRoom;
+    size_t                           m_captureBytes = 0;   // reserved by captures running
+    int                              m_columns = 1;
+    ThumbnailSource*                 m_source = nullptr;
+    FetchPool*                       m_loader = nullptr;
+    std::shared_ptr<Inbox>           m_inbox;
+    std::unordered_set<WindowId>     m_loading;    // submitted, not placed yet
+    int                              m_captureBudget = 2;
+    int                              m_capturesThisFrame = 0;
+    uint64_t                         m_refreshNs = 1000000000ull;
+    bool                             m_pending = false;
+    bool                             m_attached = false;
+    uint64_t                         m_frame = 1;
+    ImTextureData                    m_tex;
+    std::vector<WindowId>            m_owner;      // per slot, 0 if free
+    std::unordered_map<WindowId, Entry> m_entries;
+    DownscaleScratch                 m_scratch;
+    Stats                            m_stats;
+};
+
+// Synthetic windows: each one a gradient with its id stamped in, changing
+// with every capture, at a size set per window (640 x 400 unless told).
+// Counts captures. Thread-safe.
+class FakeThumbnailSource : public ThumbnailSource {
+public:
+    void SetSize(WindowId id, int width, int height);
+    void SetMissing(WindowId id);
+    size_t Captures() const;
+
+    bool Size(WindowId id, int& width, int& height) override;
+    bool Capture(WindowId id, WindowImage& out) override;
+
+private:
+    struct Window {
+        int  width = 640;
+        int  height = 400;
+        bool missing = false;
+        int  frame = 0;
+    };
+
+    mutable std::mutex                     m_mutex;
+    std::unordered_map<WindowId, Window>   m_windows;
+    size_t                                 m_captures = 0;
+};
@@ -0,0 +1,185 @@
+// === include/trace.h ===
+#pragma once
+
+#include "clock.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Latency tracing, keypress to presented pixels. Every thread writes spans
+// into a ring of its own (no locks, no allocation after the first span);
+// the rings can be exported as Chrome trace-event JSON (chrome://tracing,
+// ui.perfetto.dev) and the end-to-end latencies are kept as histograms.
+//
+// Call sites use the WWS_TRACE_* macros, which are empty unless the build
+// defines WWS_ENABLE_TRACING (cmake -DWWS_TRACING=ON). The classes below
+// are always built, so they can be exercised anywhere.
+
+// One span; begin == end is an instant event
+struct TraceRecord {
+    uint64_t    beginNs = 0;
+    uint64_t    endNs = 0;
+    const char* name = nullptr;   // string literal
+    uint64_t    arg = 0;
+};
+
+// Single-writer ring; the oldest records are overwritten. Read() may run
+// concurrently with the writer: it returns at most kCapacity - 1 records
+// (the oldest slot may be mid-write) and drops whatever the writer lapped
+// while it was copying.
+class TraceRing {
+public:
+    static constexpr size_t kCapacity = 4096;   // power of two
+
+    explicit TraceRing(uint32_t tid) : m_tid(tid) {}
+
+    void Write(const char* name, uint64_t beginNs, uint64_t endNs, uint64_t arg);
+    // Appends the records still in the ring, oldest first
+    void Read(std::vector<TraceRecord>& out) const;
+    // Hides everything written so far from Read(); any thread
+    void Discard() { m_floor.store(m_head.load(std::memory_order_acquire), std::memory_order_release); }
+
+    uint32_t    Tid() const { return m_tid; }
+    const char* Name() const { return m_name.load(std::memory_order_acquire); }
+    void        SetName(const char* name) { m_name.store(name, std::memory_order_release); }
+    uint64_t    Written() const { return m_head.load(std::memory_order_acquire); }
+
+private:
+    TraceRecord               m_records[kCapacity];
+    std::atomic<uint64_t>     m_head{ 0 };
+    std::atomic<uint64_t>     m_floor{ 0 };   // Discard() point
+    std::atomic<const char*>  m_name{ nullptr };
+    uint32_t                  m_tid;
+};
+
+// Log-linear latency histogram (8 buckets per power of two, so about 12%
+// resolution); Record() is a few relaxed atomic adds
+class LatencyHistogram {
+public:
+    static constexpr int kSubBits = 3;
+    static constexpr int kBuckets = 64 << kSubBits;
+
+    void Record(uint64_t ns);
+    void Reset();
+    // Adds other's counts into this one
+    void Merge(const LatencyHistogram& other);
+
+    uint64_t Count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t MaxNs() const { return m_max.load(std::memory_order_relaxed); }
+    double   MeanNs() const;
+    // Upper bound of the bucket holding the q-th quantile (0..1), 0 if empty
+    uint64_t PercentileNs(double q) const;
+
+    static int      BucketOf(uint64_t ns);
+    static uint64_t BucketMax(int bucket);
+
+private:
+    std::atomic<uint64_t> m_buckets[kBuckets] = {};
+    std::atomic<uint64_t> m_count{ 0 };
+    std::atomic<uint64_t> m_sum{ 0 };
+    std::atomic<uint64_t> m_max{ 0 };
+};
+
+// The end-to-end latencies we track
+enum TraceLatency {
+    TraceLatency_KeyToPresent,      // key down to the overlay frame it caused
+    TraceLatency_KeyToForeground,   // key down to the window manager confirming the switch
+    TraceLatency_Count
+};
+
+class Tracer {
+public:
+    // Histograms cover the last one to two of these windows
+    static constexpr uint64_t kLatencyWindowNs = 60ull * 1000000000ull;
+
+    // The calling thread's ring (created on first use)
+    TraceRing& ThisThread();
+    // Names the calling thread in exports; name must outlive the tracer
+    void SetThreadName(const char* name) { ThisThread().SetName(name); }
+
+    void Span(const char* name, uint64_t beginNs, uint64_t endNs, uint64_t arg = 0) {
+        ThisThread().Write(name, beginNs, endNs, arg);
+    }
+    void Instant(const char* name, uint64_t ns, uint64_t arg = 0) {
+        ThisThread().Write(name, ns, ns, arg);
+    }
+
+    // Starts a latency measurement at startNs unless one is already open
+    // (so the earliest input wins when several land before the frame)
+    void LatencyBegin(TraceLatency which, uint64_t startNs);
+    // Closes the open measurement, if any, at endNs
+    void LatencyEnd(TraceLatency which, uint64_t endNs);
+    // Drops the open measurement: what it waited for won't happen
+    void LatencyCancel(TraceLatency which);
+    // Records one latency directly
+    void RecordLatency(TraceLatency which, uint64_t ns, uint64_t nowNs);
+    // Both generations of the rolling histogram, merged
+    void Latency(TraceLatency which, LatencyHistogram& out) const;
+
+    // Every thread's records as Chrome trace-event JSON
+    bool WriteChromeJson(const std::string& path) const;
+    void WriteChromeJson(std::FILE* f) const;
+    // count / mean / p50 / p90 / p99 / max per latency, one line each
+    std::string LatencyReport() const;
+
+    // Drops all records and latencies
+    void Clear();
+
+    static const char* LatencyName(TraceLatency which);
+
+private:
+    struct Rolling {
+        LatencyHistogram      gens[2];
+        std::atomic<int>      current{ 0 };
+        std::atomic<uint64_t> windowStartNs{ 0 };
+        std::atomic<uint64_t> pendingNs{ 0 };   // open LatencyBegin, 0 if none
+    };
+
+    mutable std::mutex                      m_mutex;   // m_rings, rotation
+    std::vector<std::unique_ptr<TraceRing>> m_rings;
+    std::vector<std::thread::id>            m_owners;  // writer of each ring
+    Rolling                                 m_latency[TraceLatency_Count];
+};
+
+// The process-wide tracer the macros write to
+Tracer& GetTracer();
+
+// Times the enclosing scope
+class TraceScope {
+public:
+    explicit TraceScope(const char* name, uint64_t arg = 0);
+    ~TraceScope();
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* m_name;
+    uint64_t    m_arg;
+    uint64_t    m_beginNs;
+};
+
+#ifdef WWS_ENABLE_TRACING
+#define WWS_TRACE_CONCAT2(a, b) a##b
+#define WWS_TRACE_CONCAT(a, b) WWS_TRACE_CONCAT2(a, b)
+#define WWS_TRACE_SCOPE(name)                  TraceScope WWS_TRACE_CONCAT(wwsTrace_, __LINE__)(name)
+#define WWS_TRACE_SPAN(name, beginNs, endNs, arg) GetTracer().Span(name, beginNs, endNs, arg)
+#define WWS_TRACE_INSTANT(name, arg)           GetTracer().Instant(name, SystemClock().NowNs(), arg)
+#define WWS_TRACE_THREAD(name)                 GetTracer().SetThreadName(name)
+#define WWS_TRACE_LATENCY_BEGIN(which, startNs) GetTracer().LatencyBegin(which, startNs)
+#define WWS_TRACE_LATENCY_END(which)           GetTracer().LatencyEnd(which, SystemClock().NowNs())
+#define WWS_TRACE_LATENCY_CANCEL(which)        GetTracer().LatencyCancel(which)
+#else
+#define WWS_TRACE_SCOPE(name)                  ((void)0)
+#define WWS_TRACE_SPAN(name, beginNs, endNs, arg) ((void)0)
+#define WWS_TRACE_INSTANT(name, arg)           ((void)0)
+#define WWS_TRACE_THREAD(name)                 ((void)0)
+#define WWS_TRACE_LATENCY_BEGIN(which, startNs) ((void)0)
+#define WWS_TRACE_LATENCY_END(which)           ((void)0)
+#define WWS_TRACE_LATENCY_CANCEL(which)        ((void)0)
+#endif
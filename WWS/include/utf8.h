@@ -0,0 +1,37 @@
+// === include/utf8.h ===
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Window titles arrive as wide strings (UTF-16 on Windows, UTF-32 on
+// Linux); ImGui, the filter arena and X11 properties all want UTF-8.
+
+// Appends one code point
+void AppendUtf8(std::string& out, uint32_t cp);
+// Appends s; surrogate pairs are combined, lone ones are passed through
+void AppendUtf8(std::string& out, const wchar_t* s, size_t len);
+
+// Most UTF-8 bytes one wide unit can turn into
+constexpr size_t kUtf8PerWide = sizeof(wchar_t) == 2 ? 3 : 4;
+
+// What AppendUtf8() does, into out (room for len * kUtf8PerWide bytes);
+// returns the bytes written. Runs of units that all encode to the same
+// length are done eight at a time with SSE2 where available; vectorized =
+// false takes the plain C++ path, which gives identical bytes.
+size_t Utf8FromWide(const wchar_t* s, size_t len, char* out, bool vectorized = true);
+
+// Whether this build has the SSE2 path
+bool Utf8Vectorized();
+inline void AppendUtf8(std::string& out, const std::wstring& s) { AppendUtf8(out, s.data(), s.size()); }
+
+// Decodes the code point at p and advances past it; malformed input gives
+// U+FFFD and skips one byte. p must be before end.
+uint32_t DecodeUtf8(const char*& p, const char* end);
+
+// UTF-8 to a wide string (surrogate pairs where wchar_t is 16 bits)
+std::wstring WideFromUtf8(const char* s, size_t len);
+
+// Bytes taken by the first maxChars code points of s (all of it if shorter)
+size_t Utf8Prefix(const char* s, size_t len, size_t maxChars);
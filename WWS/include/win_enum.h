@@ -2,9 +2,70 @@
 #include <windows.h>
 #include <string>
 #include <vector>
+#include "window_registry.h"
+#include "window_system.h"
+#include "activator.h"
+#include "process_cache.h"
+#include "icon_atlas.h"
+#include "thumbnail_cache.h"
 
 struct WindowInfo { HWND handle; std::wstring title; };
 std::vector<WindowInfo> GetOpenWindows();
 
 // The focus hack:
 void ForceSetForegroundWindow(HWND hWnd);
+
+// Feeds the registry from SetWinEventHook; must be started on a thread
+// that pumps messages (the hooks are out-of-context).
+class Win32WindowEventSource : public WindowEventSource {
+public:
+    bool Start(WindowEventSink& sink) override;
+    void Stop() override;
+};
+
+// EnumWindows snapshots, the AttachThreadInput focus hack and
+// SetWinEventHook events; GetWindowSystem() returns this
+class Win32WindowSystem : public WindowSystem {
+public:
+    bool Snapshot(std::vector<WindowRecord>& out) override;
+    bool Activate(WindowId id) override;
+    WindowEventSource& Events() override { return m_events; }
+
+private:
+    Win32WindowEventSource m_events;
+};
+
+// For the Activator, politest first: SetForegroundWindow alone (enough
+// while we own the foreground, e.g. from the overlay), then with input
+// attached to the foreground thread (the old focus hack), then
+// SwitchToThisWindow, which the foreground lock doesn't apply to
+class Win32ActivationBackend : public ActivationBackend {
+public:
+    int         Strategies() const override { return 3; }
+    const char* StrategyName(int strategy) const override;
+    bool        Attempt(WindowId id, int strategy, const ActivationToken& token) override;
+};
+
+// OpenProcess-based metadata; exit watches use the thread pool
+class Win32ProcessInfoProvider : public ProcessInfoProvider {
+public:
+    bool Query(uint32_t pid, ProcessInfo& info) override;
+    bool WatchExit(const ProcessInfo& info, ExitFn onExit) override;
+    void CancelWatches() override;
+};
+
+// Icons from the exe's resources (PrivateExtractIcons), converted to RGBA
+class Win32IconProvider : public IconProvider {
+public:
+    bool Load(const std::wstring& exePath, int size, IconImage& out) override;
+};
+
+// Window contents through PrintWindow (PW_RENDERFULLCONTENT, so DirectX and
+// browser windows draw too), converted to RGBA; minimized windows fail
+class Win32ThumbnailSource : public ThumbnailSource {
+public:
+    bool Size(WindowId id, int& width, int& height) override;
+    bool Capture(WindowId id, WindowImage& out) override;
+    // the DIB PrintWindow draws into and its RGBA copy
+    size_t CaptureBytes(int width, int height) const override { return (size_t)width * height * 4 * 2; }
+};
@@ -0,0 +1,51 @@
+// === include/window_filter.h ===
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cwctype>
+#include <string>
+
+// Window style bits the filter and the rules look at (same values as winuser.h)
+namespace ws {
+constexpr uint32_t ExToolWindow = 0x00000080;   // WS_EX_TOOLWINDOW
+constexpr uint32_t Caption      = 0x00C00000;   // WS_CAPTION
+constexpr uint32_t Popup        = 0x80000000;   // WS_POPUP
+constexpr uint32_t ExTopmost    = 0x00000008;   // WS_EX_TOPMOST
+constexpr uint32_t ExAppWindow  = 0x00040000;   // WS_EX_APPWINDOW
+constexpr uint32_t ExNoActivate = 0x08000000;   // WS_EX_NOACTIVATE
+}
+
+// Which top-level windows belong in the switcher. W is whatever can answer
+// the questions (live Win32 calls in win_enum.cpp, plain fields in the
+// benchmark):
+//   bool     Visible() const;
+//   uint32_t ExStyle() const;
+//   uint32_t Style() const;
+//   bool     IsRootOwner() const;    // not owned by another window
+//   void     Title(std::wstring&) const;
+// The checks run cheapest first and stop at the first failure, so the
+// title is only fetched for windows that pass everything else.
+template <class W>
+bool IsSwitchableWindow(const W& w, std::wstring& title) {
+    // must be visible
+    if (!w.Visible())
+        return false;
+
+    // skip tool windows
+    if (w.ExStyle() & ws::ExToolWindow)
+        return false;
+
+    // skip owned windows; only top-level
+    if (!w.IsRootOwner())
+        return false;
+
+    // must have a caption style (real window)
+    if ((w.Style() & ws::Caption) == 0)
+        return false;
+
+    // require a non-empty title, and skip all-whitespace ones
+    w.Title(title);
+    return std::any_of(title.begin(), title.end(),
+        [](wchar_t c) { return std::iswspace((wint_t)c) == 0; });
+}
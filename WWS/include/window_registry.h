@@ -0,0 +1,164 @@
+// === include/window_registry.h ===
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Opaque window id (an HWND on Windows)
+using WindowId = std::uint64_t;
+
+enum class WindowEventType : std::uint8_t {
+    Created,      // window became switchable (also used to refresh a known one)
+    Destroyed,    // window closed or is no longer switchable
+    Foreground,   // window was activated
+    NameChanged,  // title changed
+    Minimized,
+    Restored,
+};
+
+struct WindowEvent {
+    WindowEventType type;
+    WindowId        id;
+    std::wstring    title;   // only used by Created / NameChanged
+    uint32_t        pid = 0; // owning process, Created only (0 = unknown)
+    bool            pinned = false;   // a pin rule matched; Created / NameChanged
+};
+
+struct ProcessInfo;
+class WindowSnapshot;
+class FrecencyStore;
+
+// Anything that wants window events (the registry, tests, ...)
+class WindowEventSink {
+public:
+    virtual ~WindowEventSink() = default;
+    virtual void OnWindowEvent(const WindowEvent& ev) = 0;
+};
+
+// Platform-neutral event source; Start() may seed the sink with the
+// current windows before streaming changes.
+class WindowEventSource {
+public:
+    virtual ~WindowEventSource() = default;
+    virtual bool Start(WindowEventSink& sink) = 0;
+    virtual void Stop() = 0;
+};
+
+struct WindowRecord {
+    WindowId     id = 0;
+    std::wstring title;
+    bool         minimized = false;
+    bool         pinned = false;    // listed right after the active window
+    uint32_t     pid = 0;
+    // Filled from the ProcessCache by whoever consumes the snapshot; null
+    // until the background fetch for pid has finished
+    std::shared_ptr<const ProcessInfo> process;
+};
+
+// MRU-ordered set of switchable windows, kept current by window events.
+// Every event is O(1); snapshots are a walk of the list, no syscalls.
+//
+// With a FrecencyStore attached, activations are recorded into it, and with
+// frecency order on, snapshots and At() list the active window first and
+// the rest by frecency (MRU order among equals), so a window stays where it
+// was in the list however often the user flips between two others. Pinned
+// windows come right after the active one either way, in list order.
+class WindowRegistry : public WindowEventSink {
+public:
+    void OnWindowEvent(const WindowEvent& ev) override;
+
+    // Copies the non-minimized windows in list order into out, reusing its storage
+    void Snapshot(std::vector<WindowRecord>& out) const;
+    std::vector<WindowRecord> Snapshot() const;
+    // The same into the overlay's layout; allocation-free once out has grown
+    void Snapshot(WindowSnapshot& out) const;
+
+    // Id of the n-th non-minimized window in list order, 0 if there is none
+    WindowId At(size_t index) const;
+    // The same in MRU order whatever the list order is (At(1) there is the
+    // previous window)
+    WindowId MruAt(size_t mruIndex) const;
+
+    // store must outlive the registry or be detached (null) first
+    void SetFrecency(FrecencyStore* store);
+    void SetFrecencyOrder(bool on);
+    bool FrecencyOrder() const;
+
+    // Makes the tracked set exactly current (a fresh WindowSystem snapshot,
+    // after the filter rules changed): windows not in it are dropped, new
+    // ones added behind the rest, known ones refreshed in place
+    void Reconcile(const std::vector<WindowRecord>& current);
+
+    size_t   Size() const;      // all tracked windows, minimized included
+    uint64_t Version() const;   // bumped on every change
+    void     Clear();
+
+private:
+    static constexpr uint32_t kNil = 0xFFFFFFFFu;
+
+    struct Node {
+        WindowRecord rec;
+        uint32_t     prev = kNil;
+        uint32_t     next = kNil;
+        uint64_t     pattern = 0;   // FrecencyKeys of the title, with a store
+        uint64_t     app = 0;
+    };
+
+    uint32_t Insert(WindowId id);   // appends at the MRU tail
+    void     Remove(uint32_t n);
+    void     Unlink(uint32_t n);
+    void     PushFront(uint32_t n);
+    void     SetKeys(Node& node);
+    void     SetPinned(Node& node, bool pinned);
+    // The non-minimized nodes in list order, into m_order
+    void     Order() const;
+
+    mutable std::mutex                     m_mutex;
+    std::vector<Node>                      m_nodes;
+    std::vector<uint32_t>                  m_free;
+    std::unordered_map<WindowId, uint32_t> m_index;
+    uint32_t                               m_head = kNil;
+    uint32_t                               m_tail = kNil;
+    uint64_t                               m_version = 0;
+    FrecencyStore*                         m_frecency = nullptr;
+    bool                                   m_frecencyOrder = false;
+    size_t                                 m_pinned = 0;   // tracked windows with rec.pinned
+    // Order() scratch
+    struct Ranked {
+        double   rank;
+        uint32_t mru;    // position in MRU order, for ties
+        uint32_t node;
+        bool     pinned;
+    };
+    mutable std::vector<uint32_t>          m_order;
+    mutable std::vector<Ranked>            m_ranked;
+};
+
+// Event source driven by hand, for tests and benchmarks
+class FakeWindowEventSource : public WindowEventSource {
+public:
+    bool Start(WindowEventSink& sink) override { m_sink = &sink; return true; }
+    void Stop() override { m_sink = nullptr; }
+
+    void Create(WindowId id, std::wstring title, uint32_t pid = 0, bool pinned = false);
+    void Destroy(WindowId id);
+    void Focus(WindowId id);
+    // Keeps the pinned state the window was created with
+    void Rename(WindowId id, std::wstring title);
+    void Minimize(WindowId id);
+    void Restore(WindowId id);
+
+private:
+    void Emit(WindowEvent ev);
+
+    WindowEventSink* m_sink = nullptr;
+    std::unordered_map<WindowId, bool> m_pinned;   // as created, for renames
+};
+
+// The process-wide registry the hook and overlay read from
+WindowRegistry& GetWindowRegistry();
@@ -0,0 +1,171 @@
+// === include/window_rules.h ===
+#pragma once
+
+#include "window_filter.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class WindowRuleAction : uint8_t {
+    Include,   // list it even if the built-in checks would not
+    Exclude,   // never list it
+    Pin,       // list it, right after the active window
+};
+
+const char* WindowRuleActionName(WindowRuleAction action);
+
+// One rule as written in wws_config.json ("windowRules"). Every condition
+// given must hold: strings are substrings, case-insensitive for ASCII, and
+// the style tests are (style & mask) == value. A rule without any
+// condition is dropped when compiled.
+struct WindowRule {
+    WindowRuleAction action = WindowRuleAction::Exclude;
+    std::string      title;          // UTF-8
+    std::string      windowClass;
+    std::string      exe;            // executable file name, "notepad.exe"
+    uint32_t         styleMask = 0;
+    uint32_t         style = 0;
+    uint32_t         exStyleMask = 0;
+    uint32_t         exStyle = 0;
+};
+
+bool operator==(const WindowRule& a, const WindowRule& b);
+inline bool operator!=(const WindowRule& a, const WindowRule& b) { return !(a == b); }
+
+enum class WindowVerdict : uint8_t { Reject, Keep, Pin };
+
+// The user's rules, compiled once so that deciding on a window is a single
+// pass over each string it needs. Every string condition goes into one
+// Aho-Corasick automaton (a dense DFA over the few character classes the
+// patterns use), each style test into a table of distinct (mask, value)
+// pairs, and the rules into bitsets.
+//
+// Evaluate() runs the built-in checks of IsSwitchableWindow() and the
+// style tests first, from bits it reads anyway; a string is only fetched
+// while a rule still alive needs it and could change the outcome: the
+// title, then the class, then the executable (a process query). The first
+// rule, in file order, whose conditions all hold decides; a window no rule
+// matches gets the built-in verdict. Untitled windows are never listed.
+//
+// Immutable once built, so one can be shared between threads. W is what
+// IsSwitchableWindow() takes, plus
+//   void ClassName(std::wstring&) const;
+//   void Exe(std::wstring&) const;      // file name only
+class WindowRuleSet {
+public:
+    // Per-caller buffers, so evaluating doesn't allocate once they have grown
+    struct Scratch {
+        std::vector<uint64_t> alive;     // rules still possible
+        std::vector<uint64_t> hit;       // rules whose pattern matched this field
+        std::wstring          text;      // class or exe
+        uint64_t              fetches = 0;   // class and exe strings asked for, for tests
+    };
+
+    explicit WindowRuleSet(std::vector<WindowRule> rules);
+
+    template <class W>
+    WindowVerdict Evaluate(const W& w, std::wstring& title, Scratch& s) const;
+
+    const std::vector<WindowRule>& Rules() const { return m_rules; }
+    bool   Empty() const { return m_rules.empty(); }
+    size_t Patterns() const { return m_patternField.size(); }
+    size_t States() const { return m_states; }
+    size_t Classes() const { return m_classes; }
+
+private:
+    enum Field : uint8_t { FieldTitle, FieldClass, FieldExe, kFieldCount };
+
+    // Fills s.alive with the rules whose style tests pass; false if none
+    // of them could change builtIn's verdict
+    bool Begin(uint32_t style, uint32_t exStyle, bool builtIn, Scratch& s) const;
+    bool Needs(Field f, const Scratch& s) const;
+    // Drops the rules whose pattern for f isn't in text; same result as Begin()
+    bool Match(Field f, const std::wstring& text, bool builtIn, Scratch& s) const;
+    WindowVerdict Decide(bool builtIn, const Scratch& s) const;
+    bool     Open(bool builtIn, const Scratch& s) const;
+    uint32_t ClassOf(wchar_t c) const;
+
+    struct StyleTest {
+        uint32_t styleMask, style, exStyleMask, exStyle;
+        size_t   rules;        // offset of its bitset in m_bits
+    };
+
+    std::vector<WindowRule> m_rules;
+    size_t                  m_words = 0;         // uint64_t per rule bitset
+    std::vector<uint64_t>   m_bits;              // every rule bitset, m_words each
+    size_t                  m_untested = 0;      // rules without a style test
+    size_t                  m_needs[kFieldCount] = {};
+    size_t                  m_changesKept = 0;   // rules that aren't Include
+    size_t                  m_changesRejected = 0;   // rules that aren't Exclude
+    std::vector<StyleTest>  m_styleTests;
+
+    // the automaton: m_next[state * m_classes + class], state 0 the root
+    uint16_t                m_ascii[128] = {};   // ASCII (either case) to class, 0: in no pattern
+    std::vector<std::pair<wchar_t, uint32_t>> m_wide;   // other characters, sorted
+    size_t                  m_classes = 1;
+    size_t                  m_states = 1;
+    std::vector<uint32_t>   m_next;
+    std::vector<uint32_t>   m_outStart;          // per state, into m_out (m_states + 1)
+    std::vector<uint32_t>   m_out;               // patterns ending here, suffixes included
+    std::vector<uint8_t>    m_patternField;
+    std::vector<uint32_t>   m_patternRuleStart;  // per pattern, into m_patternRules
+    std::vector<uint32_t>   m_patternRules;
+};
+
+// Whether a and b hold the same rules (null holds none); pointer-equal
+// ones, the usual case, without looking inside
+inline bool SameRules(const std::shared_ptr<const WindowRuleSet>& a,
+                      const std::shared_ptr<const WindowRuleSet>& b)
+{
+    if (a == b)
+        return true;
+    const bool noneA = !a || a->Empty();
+    const bool noneB = !b || b->Empty();
+    if (noneA || noneB)
+        return noneA && noneB;
+    return a->Rules() == b->Rules();
+}
+
+// IsSwitchableWindow() with the user's rules on top (none if rules is null)
+template <class W>
+WindowVerdict ClassifyWindow(const W& w, const WindowRuleSet* rules, std::wstring& title,
+                             WindowRuleSet::Scratch& s)
+{
+    if (!rules || rules->Empty())
+        return IsSwitchableWindow(w, title) ? WindowVerdict::Keep : WindowVerdict::Reject;
+    return rules->Evaluate(w, title, s);
+}
+
+template <class W>
+WindowVerdict WindowRuleSet::Evaluate(const W& w, std::wstring& title, Scratch& s) const {
+    if (!w.Visible())
+        return WindowVerdict::Reject;
+    const uint32_t exStyle = w.ExStyle();
+    const uint32_t style = w.Style();
+    const bool builtIn = (exStyle & ws::ExToolWindow) == 0 && (style & ws::Caption) != 0 &&
+                         w.IsRootOwner();
+    bool open = Begin(style, exStyle, builtIn, s);
+    if (!builtIn && !open)
+        return WindowVerdict::Reject;
+
+    w.Title(title);
+    if (std::none_of(title.begin(), title.end(), [](wchar_t c) { return std::iswspace((wint_t)c) == 0; }))
+        return WindowVerdict::Reject;
+    if (open && Needs(FieldTitle, s))
+        open = Match(FieldTitle, title, builtIn, s);
+    if (open && Needs(FieldClass, s)) {
+        w.ClassName(s.text);
+        ++s.fetches;
+        open = Match(FieldClass, s.text, builtIn, s);
+    }
+    if (open && Needs(FieldExe, s)) {
+        w.Exe(s.text);
+        ++s.fetches;
+        open = Match(FieldExe, s.text, builtIn, s);
+    }
+    if (!open)
+        return builtIn ? WindowVerdict::Keep : WindowVerdict::Reject;
+    return Decide(builtIn, s);
+}
@@ -0,0 +1,70 @@
+// === include/window_snapshot.h ===
+#pragma once
+
+#include "window_registry.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class ProcessCache;
+
+// The switchable windows as the overlay reads them. The rows a frame walks
+// are small and contiguous; every string (titles, their "app - page" form,
+// exe names) is UTF-8 in one arena, and the process info sits in a separate
+// array. Clear() keeps all the capacity, so once a snapshot has held as many
+// windows as the desktop has, refilling it allocates nothing.
+class WindowSnapshot {
+public:
+    struct Text {
+        uint32_t offset = 0;   // into the arena
+        uint32_t len = 0;      // bytes
+    };
+
+    struct Row {
+        WindowId id = 0;
+        uint32_t pid = 0;
+        Text     title;
+        Text     display;      // "page - app" turned into "app - page"
+        Text     exe;          // empty until the process is resolved
+    };
+
+    void Clear();
+    void Add(WindowId id, const std::wstring& title, uint32_t pid);
+
+    size_t Size() const { return m_rows.size(); }
+    bool   Empty() const { return m_rows.empty(); }
+    const Row& At(size_t i) const { return m_rows[i]; }
+
+    std::string_view Title(size_t i) const { return View(m_rows[i].title); }
+    std::string_view Display(size_t i) const { return View(m_rows[i].display); }
+    std::string_view Exe(size_t i) const { return View(m_rows[i].exe); }
+    const std::shared_ptr<const ProcessInfo>& Process(size_t i) const { return m_process[i]; }
+
+    // Attaches process info to row i (and its exe name to the arena)
+    void SetProcess(size_t i, std::shared_ptr<const ProcessInfo> info);
+    // Attaches whatever the cache already has to rows without it; misses are
+    // fetched in the background. True if any row changed.
+    bool Resolve(ProcessCache& cache);
+
+    // Index of the row for id, or Size() if there is none
+    size_t Find(WindowId id) const;
+
+    // Arena bytes in use, for benchmarks
+    size_t ArenaSize() const { return m_arena.size(); }
+
+    // Different for every fill (each Clear()) of every snapshot, so what is
+    // cached per row can be keyed on it
+    uint64_t Generation() const { return m_generation; }
+
+private:
+    static uint64_t NextGeneration();
+    std::string_view View(Text t) const { return std::string_view(m_arena.data() + t.offset, t.len); }
+
+    std::string                                     m_arena;
+    std::vector<Row>                                m_rows;      // hot: every frame
+    std::vector<std::shared_ptr<const ProcessInfo>> m_process;   // cold: icons, resolving
+    uint64_t                                        m_generation = NextGeneration();
+};
@@ -0,0 +1,47 @@
+// === include/window_system.h ===
+#pragma once
+
+#include "window_registry.h"
+#include "window_rules.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Everything the switcher needs from the desktop's window system: the
+// switchable top-level windows, a way to bring one to the front, and events
+// to keep a WindowRegistry current. One implementation per platform
+// (Win32WindowSystem in win_enum.h, X11WindowSystem in x11_window_system.h).
+class WindowSystem {
+public:
+    virtual ~WindowSystem() = default;
+
+    // Switchable top-level windows, topmost first, minimized ones included
+    // (and flagged); reuses out's storage. False if the window system can't
+    // be reached.
+    virtual bool Snapshot(std::vector<WindowRecord>& out) = 0;
+
+    // Brings id to the front (restoring it if minimized) and focuses it
+    virtual bool Activate(WindowId id) = 0;
+
+    // Streams window changes, seeded with the current windows on Start()
+    virtual WindowEventSource& Events() = 0;
+
+    // The user's rules on top of the built-in checks, for snapshots and
+    // events alike (null: none). Thread-safe; windows already reported
+    // stay as they are, see WindowRegistry::Reconcile().
+    void SetRules(std::shared_ptr<const WindowRuleSet> rules) {
+        std::lock_guard<std::mutex> lock(m_rulesMutex);
+        m_rules = std::move(rules);
+    }
+    std::shared_ptr<const WindowRuleSet> Rules() const {
+        std::lock_guard<std::mutex> lock(m_rulesMutex);
+        return m_rules;
+    }
+
+private:
+    mutable std::mutex                   m_rulesMutex;
+    std::shared_ptr<const WindowRuleSet> m_rules;
+};
+
+// The platform's window system (defined by the platform backend)
+WindowSystem& GetWindowSystem();
@@ -0,0 +1,101 @@
+// === include/x11_window_system.h ===
+#pragma once
+
+#include "window_system.h"
+#include "process_cache.h"
+#include <xcb/xcb.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class X11WindowSystem;
+
+// Watches the root window's client list and active window, plus the names
+// and state of every client, and re-diffs a snapshot when any of them
+// changes. Events arrive on a thread of its own.
+class X11WindowEventSource : public WindowEventSource {
+public:
+    explicit X11WindowEventSource(X11WindowSystem& ws) : m_ws(ws) {}
+    ~X11WindowEventSource() override { Stop(); }
+
+    bool Start(WindowEventSink& sink) override;
+    void Stop() override;
+
+private:
+    struct Known {
+        std::wstring title;
+        bool         minimized;
+        bool         pinned;
+    };
+
+    void ThreadMain();
+    void Refresh();   // snapshot, then emit the differences
+
+    X11WindowSystem&                      m_ws;
+    WindowEventSink*                      m_sink = nullptr;
+    std::thread                           m_thread;
+    int                                   m_wake[2] = { -1, -1 };   // pipe, for Stop()
+    std::unordered_map<WindowId, Known>   m_known;
+    std::vector<WindowRecord>             m_snapshot;
+    WindowId                              m_active = 0;
+};
+
+// EWMH window system over XCB. A snapshot costs two round-trips however
+// many windows there are: the root's _NET_CLIENT_LIST_STACKING and
+// _NET_ACTIVE_WINDOW in one, then every client's properties requested
+// back to back and only then collected. Thread-safe (so is XCB).
+class X11WindowSystem : public WindowSystem {
+public:
+    X11WindowSystem() : m_events(*this) {}
+    ~X11WindowSystem() override { Disconnect(); }
+
+    // Connects to display (null: $DISPLAY) and interns the atoms
+    bool Connect(const char* display = nullptr);
+    void Disconnect();
+
+    bool Snapshot(std::vector<WindowRecord>& out) override;
+    // _NET_ACTIVE_WINDOW request to the window manager
+    bool Activate(WindowId id) override;
+    WindowEventSource& Events() override { return m_events; }
+
+    // The window the window manager reports as active, 0 if none
+    WindowId Active() const { return m_active.load(std::memory_order_relaxed); }
+
+    // Replies waited for so far (each is one round-trip)
+    uint64_t RoundTrips() const { return m_roundTrips.load(std::memory_order_relaxed); }
+
+    xcb_connection_t* Connection() const { return m_conn; }
+    xcb_window_t      Root() const { return m_root; }
+
+    // Atoms we use; filled by Connect()
+    enum Atom {
+        NetClientListStacking, NetActiveWindow, NetWmName, NetWmPid, NetWmState,
+        NetWmStateHidden, NetWmStateSkipTaskbar, NetWmWindowType,
+        NetWmWindowTypeNormal, NetWmWindowTypeDialog, Utf8String,
+        kAtomCount
+    };
+    xcb_atom_t AtomOf(Atom a) const { return m_atoms[a]; }
+
+private:
+    void CountRoundTrip() { m_roundTrips.fetch_add(1, std::memory_order_relaxed); }
+
+    xcb_connection_t*     m_conn = nullptr;
+    xcb_window_t          m_root = 0;
+    xcb_atom_t            m_atoms[kAtomCount] = {};
+    std::atomic<WindowId> m_active{ 0 };
+    std::atomic<uint64_t> m_roundTrips{ 0 };
+    X11WindowEventSource  m_events;
+};
+
+// /proc/<pid>/exe and the start time from /proc/<pid>/stat. Exit watches
+// are a no-op, so entries live as long as the cache; fine for the X11
+// overlay, which only runs for one switch.
+class ProcfsProcessInfoProvider : public ProcessInfoProvider {
+public:
+    bool Query(uint32_t pid, ProcessInfo& info) override;
+    bool WatchExit(const ProcessInfo&, ExitFn) override { return false; }   // /proc has no exit notification
+    void CancelWatches() override {}
+};
@@ -0,0 +1,296 @@
+﻿// === src/activator.cpp ===
+#include "activator.h"
+#include "clock.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+const char* ActivationOutcomeName(ActivationOutcome outcome) {
+    switch (outcome) {
+    case ActivationOutcome::Confirmed:  return "confirmed";
+    case ActivationOutcome::TimedOut:   return "timed_out";
+    case ActivationOutcome::Gone:       return "gone";
+    case ActivationOutcome::Superseded: return "superseded";
+    case ActivationOutcome::Coalesced:  return "coalesced";
+    }
+    return "?";
+}
+
+// One call into the backend, shared with the pool job running it
+struct Activator::Attempt {
+    ActivationToken token;
+    bool            returned = false;   // under m_mutex
+    bool            ok = true;
+};
+
+// A hung attempt is written off at half the attempt timeout, so the next
+// strategy never waits behind it for a worker; one request hung in every
+// attempt still leaves workers for the next
+Activator::Activator(uint64_t attemptTimeoutNs, int maxAttempts)
+    : m_attemptTimeoutNs(attemptTimeoutNs),
+      m_maxAttempts(std::min(std::max(maxAttempts, 1), ActivationResult::kMaxAttempts)),
+      m_pool(1, 2 * ActivationResult::kMaxAttempts, attemptTimeoutNs / 2) {}
+
+void Activator::Start(ActivationBackend& backend) {
+    Stop();
+    m_backend = &backend;
+    m_pool.Start();
+    m_thread = std::thread(&Activator::ThreadMain, this);
+}
+
+void Activator::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_thread.joinable())
+            return;
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    m_thread.join();
+    m_pool.Stop();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = false;
+    m_pending = 0;
+    m_coalesced.clear();
+    m_backend = nullptr;
+}
+
+void Activator::Request(WindowId id) {
+    if (!id)
+        return;
+    const uint64_t now = SystemClock().NowNs();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.requests;
+        if (m_pending) {
+            ActivationResult r;
+            r.id = m_pending;
+            r.outcome = ActivationOutcome::Coalesced;
+            r.requestNs = m_pendingNs;
+            r.doneNs = now;
+            m_coalesced.push_back(r);
+        }
+        m_pending = id;
+        m_pendingNs = now;
+    }
+    m_cv.notify_all();
+}
+
+void Activator::OnWindowEvent(const WindowEvent& ev) {
+    if (ev.type != WindowEventType::Foreground)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_foreground = ev.id;
+    }
+    m_cv.notify_all();
+}
+
+void Activator::SetResultCallback(std::function<void(const ActivationResult&)> fn) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_onResult = std::move(fn);
+}
+
+bool Activator::WaitIdle(uint64_t timeoutNs) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_idle.wait_for(lock, std::chrono::nanoseconds(timeoutNs), [&] {
+        return !m_pending && !m_busy && m_coalesced.empty();
+    });
+}
+
+Activator::Stats Activator::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void Activator::ThreadMain() {
+    WWS_TRACE_THREAD("activate");
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_cv.wait(lock, [&] { return m_stop || m_pending || !m_coalesced.empty(); });
+        if (m_stop)
+            break;
+        m_busy = true;
+        // the requests this one replaced come first, as they came in first
+        while (!m_coalesced.empty()) {
+            ActivationResult r = m_coalesced.front();
+            m_coalesced.pop_front();
+            Finish(r, lock);
+        }
+        if (m_pending) {
+            const WindowId id = m_pending;
+            const uint64_t requestNs = m_pendingNs;
+            m_pending = 0;
+            Run(id, requestNs, lock);
+        }
+        m_busy = false;
+        if (!m_pending && m_coalesced.empty())
+            m_idle.notify_all();
+    }
+    m_busy = false;
+    m_idle.notify_all();
+}
+
+void Activator::Run(WindowId id, uint64_t requestNs, std::unique_lock<std::mutex>& lock) {
+    ActivationResult r;
+    r.id = id;
+    r.requestNs = requestNs;
+    if (m_foreground == id) {
+        // nothing to do; Tap back to where the overlay came from, say
+        r.outcome = ActivationOutcome::Confirmed;
+        Finish(r, lock);
+        return;
+    }
+    for (int a = 0; a < m_maxAttempts; ++a) {
+        const int strategy = std::min(a, m_backend->Strategies() - 1);
+        auto attempt = std::make_shared<Attempt>();
+        ActivationBackend* backend = m_backend;
+        const uint64_t issuedNs = SystemClock().NowNs();
+        const uint64_t deadlineNs = issuedNs + m_attemptTimeoutNs;
+        ++m_stats.attempts;
+        r.attempts = a + 1;
+        m_pool.Submit([this, backend, attempt, id, strategy] {
+            const bool ok = backend->Attempt(id, strategy, attempt->token);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                attempt->returned = true;
+                attempt->ok = ok;
+            }
+            m_cv.notify_all();
+        });
+
+        bool timedOut = false;
+        for (;;) {
+            if (m_foreground == id) {
+                r.outcome = ActivationOutcome::Confirmed;
+                r.strategy = strategy;
+                break;
+            }
+            if (attempt->returned && !attempt->ok) {
+                r.outcome = ActivationOutcome::Gone;
+                break;
+            }
+            if (m_pending || m_stop) {
+                r.outcome = ActivationOutcome::Superseded;
+                break;
+            }
+            const uint64_t now = SystemClock().NowNs();
+            if (now >= deadlineNs) {
+                timedOut = true;
+                break;
+            }
+            m_cv.wait_for(lock, std::chrono::nanoseconds(deadlineNs - now));
+        }
+        const uint64_t endNs = SystemClock().NowNs();
+        r.attemptNs[a] = endNs - issuedNs;
+        WWS_TRACE_SPAN("activate attempt", issuedNs, endNs, (uint64_t)strategy);
+        if (r.outcome != ActivationOutcome::Confirmed)
+            attempt->token.Cancel();   // a late return mustn't activate it now
+        if (!timedOut) {
+            Finish(r, lock);
+            return;
+        }
+    }
+    r.outcome = ActivationOutcome::TimedOut;
+    Finish(r, lock);
+}
+
+void Activator::Finish(ActivationResult& r, std::unique_lock<std::mutex>& lock) {
+    if (!r.doneNs)
+        r.doneNs = SystemClock().NowNs();
+    switch (r.outcome) {
+    case ActivationOutcome::Confirmed:
+        ++m_stats.confirmed;
+        if (r.strategy >= 0 && r.strategy < ActivationResult::kMaxAttempts)
+            ++m_stats.confirmedBy[r.strategy];
+        break;
+    case ActivationOutcome::TimedOut:   ++m_stats.timedOut;   break;
+    case ActivationOutcome::Gone:       ++m_stats.gone;       break;
+    case ActivationOutcome::Superseded: ++m_stats.superseded; break;
+    case ActivationOutcome::Coalesced:  ++m_stats.coalesced;  break;
+    }
+    WWS_TRACE_SPAN("activate", r.requestNs, r.doneNs, (uint64_t)r.outcome);
+    if (!m_onResult)
+        return;
+    // outside the lock, so the callback may Request() again
+    std::function<void(const ActivationResult&)> fn = m_onResult;
+    lock.unlock();
+    fn(r);
+    lock.lock();
+}
+
+Activator& GetActivator() {
+    static Activator g_activator;
+    return g_activator;
+}
+
+// --- fake backend ---
+
+const char* FakeActivationBackend::StrategyName(int strategy) const {
+    static const char* const kNames[kStrategies] = { "polite", "forceful", "desperate" };
+    return strategy >= 0 && strategy < kStrategies ? kNames[strategy] : "?";
+}
+
+bool FakeActivationBackend::Attempt(WindowId id, int strategy, const ActivationToken& token) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_windows.count(id))
+        return false;
+    m_released.wait(lock, [&] { return !m_hung.count(id); });
+    if (m_delayMs > 0) {
+        const int ms = m_delayMs;
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+        lock.lock();
+    }
+    auto w = m_windows.find(id);
+    if (w == m_windows.end())
+        return false;
+    const bool applied = !token.Cancelled() && strategy >= w->second;
+    m_calls.push_back({ id, strategy, applied });
+    if (applied && m_foreground != id) {
+        // under the lock, so the events go out in the order focus moved
+        m_foreground = id;
+        m_sink.OnWindowEvent({ WindowEventType::Foreground, id, {} });
+    }
+    return true;
+}
+
+void FakeActivationBackend::Add(WindowId id, int needsStrategy) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_windows[id] = needsStrategy;
+}
+
+void FakeActivationBackend::Remove(WindowId id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_windows.erase(id);
+}
+
+void FakeActivationBackend::SetDelay(int ms) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_delayMs = ms;
+}
+
+void FakeActivationBackend::Hang(WindowId id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_hung.insert(id);
+}
+
+void FakeActivationBackend::Release() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_hung.clear();
+    }
+    m_released.notify_all();
+}
+
+std::vector<FakeActivationBackend::Call> FakeActivationBackend::Calls() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_calls;
+}
+
+WindowId FakeActivationBackend::Foreground() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_foreground;
+}
@@ -0,0 +1,12 @@
+﻿// === src/clock.cpp ===
+#include "clock.h"
+
+const Clock& SystemClock() {
+    static SteadyClock g_clock;
+    return g_clock;
+}
+
+const Clock& SystemWallClock() {
+    static WallClock g_clock;
+    return g_clock;
+}
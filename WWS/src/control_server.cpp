@@ -0,0 +1,203 @@
+﻿// === src/control_server.cpp ===
+#include "control_server.h"
+
+#include <charconv>
+
+// Platform halves: control_server_posix.cpp, control_server_win32.cpp
+
+ControlServer::ControlServer(WindowRegistry& registry, ControlActions& actions)
+    : m_registry(registry), m_actions(actions) {}
+
+ControlServer::~ControlServer() {
+    Stop();
+}
+
+static void AppendNumber(std::string& out, uint64_t n) {
+    char buf[24];
+    const auto r = std::to_chars(buf, buf + sizeof(buf), n);
+    out.append(buf, r.ptr);
+}
+
+// A title on a line of its own: no line breaks inside it
+static void AppendTitle(std::string& out, std::string_view title) {
+    const size_t at = out.size();
+    out += title;
+    for (size_t i = at; i < out.size(); ++i)
+        if (out[i] == '\n' || out[i] == '\r')
+            out[i] = ' ';
+}
+
+static bool ParseNumber(std::string_view s, uint64_t& n) {
+    const auto r = std::from_chars(s.data(), s.data() + s.size(), n);
+    return !s.empty() && r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+
+// The first word of line; arg gets the rest, without the space
+static std::string_view Verb(std::string_view line, std::string_view& arg) {
+    const size_t space = line.find(' ');
+    if (space == std::string_view::npos) {
+        arg = std::string_view();
+        return line;
+    }
+    arg = line.substr(space + 1);
+    return line.substr(0, space);
+}
+
+size_t ControlServer::Serve(std::string_view in, std::string& out, bool& subscribe) {
+    size_t used = 0;
+    uint64_t requests = 0;
+    for (size_t eol; (eol = in.find('\n', used)) != std::string_view::npos; used = eol + 1) {
+        std::string_view line = in.substr(used, eol - used);
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        if (line.empty())
+            continue;
+        Handle(line, out, subscribe);
+        ++requests;
+    }
+    if (requests) {
+        m_requests.fetch_add(requests, std::memory_order_relaxed);
+        m_batches.fetch_add(1, std::memory_order_relaxed);
+    }
+    return used;
+}
+
+void ControlServer::Handle(std::string_view line, std::string& out, bool& subscribe) {
+    std::string_view arg;
+    const std::string_view verb = Verb(line, arg);
+    if (verb == "ping" && arg.empty()) {
+        out += "ok\n";
+    }
+    else if (verb == "list" && arg.empty()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Refresh();
+        out += m_listText;
+    }
+    else if (verb == "switch") {
+        Switch(arg, out);
+    }
+    else if (verb == "overlay" && (arg == "show" || arg == "hide")) {
+        m_actions.Overlay(arg == "show");
+        out += "ok\n";
+    }
+    else if (verb == "reload" && arg.empty()) {
+        m_actions.ReloadSettings();
+        out += "ok\n";
+    }
+    else if (verb == "quit" && arg.empty()) {
+        m_actions.Quit();
+        out += "ok\n";
+    }
+    else if (verb == "subscribe" && arg.empty()) {
+        subscribe = true;
+        out += "ok\n";
+    }
+    else {
+        Error(out, "unknown request");
+    }
+}
+
+void ControlServer::Switch(std::string_view arg, std::string& out) {
+    const bool byId = arg.substr(0, 3) == "id ";
+    uint64_t n = 0;
+    if (!ParseNumber(byId ? arg.substr(3) : arg, n)) {
+        Error(out, byId ? "bad id" : "bad index");
+        return;
+    }
+    // the same snapshot list answers from, so an index means what the
+    // client was last shown (unless the windows changed since)
+    WindowId id = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Refresh();
+        if (byId && m_snapshot.Find(n) < m_snapshot.Size())
+            id = n;
+        else if (!byId && n < m_snapshot.Size())
+            id = m_snapshot.At((size_t)n).id;
+    }
+    if (!id) {
+        Error(out, "no such window");
+        return;
+    }
+    m_actions.Activate(id);
+    out += "ok\n";
+}
+
+void ControlServer::Error(std::string& out, const char* why) {
+    out += "err ";
+    out += why;
+    out += '\n';
+    m_errors.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ControlServer::Refresh() {
+    // read before the snapshot: a change in between only costs a refill
+    // on the next request
+    const uint64_t version = m_registry.Version();
+    if (m_filled && version == m_version)
+        return;
+    m_registry.Snapshot(m_snapshot);
+    m_version = version;
+    m_filled = true;
+    m_refills.fetch_add(1, std::memory_order_relaxed);
+    m_listText.clear();
+    m_listText += "ok ";
+    AppendNumber(m_listText, m_snapshot.Size());
+    m_listText += '\n';
+    for (size_t i = 0; i < m_snapshot.Size(); ++i) {
+        AppendNumber(m_listText, i);
+        m_listText += ' ';
+        AppendNumber(m_listText, m_snapshot.At(i).id);
+        m_listText += ' ';
+        AppendTitle(m_listText, m_snapshot.Title(i));
+        m_listText += '\n';
+    }
+}
+
+void ControlServer::OnWindowEvent(const WindowEvent& ev) {
+    if (ev.type != WindowEventType::Foreground || !Running())
+        return;
+    // under the lock, so Stop() can't close what Wake() uses under us
+    std::lock_guard<std::mutex> lock(m_focusMutex);
+    if (!Running())
+        return;
+    m_focus.push_back(ev.id);
+    Wake();
+}
+
+void ControlServer::FocusLines(std::string& out) {
+    std::vector<WindowId> focus;
+    {
+        std::lock_guard<std::mutex> lock(m_focusMutex);
+        focus.swap(m_focus);
+    }
+    if (focus.empty())
+        return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Refresh();
+    WindowId last = 0;
+    for (WindowId id : focus) {
+        if (id == last)
+            continue;   // the same window again, before anyone could see the first
+        last = id;
+        out += "focus ";
+        AppendNumber(out, id);
+        const size_t row = m_snapshot.Find(id);
+        if (row < m_snapshot.Size()) {
+            out += ' ';
+            AppendTitle(out, m_snapshot.Title(row));
+        }
+        out += '\n';
+    }
+}
+
+ControlServer::Stats ControlServer::GetStats() const {
+    Stats s;
+    s.connections = m_connections.load(std::memory_order_relaxed);
+    s.requests = m_requests.load(std::memory_order_relaxed);
+    s.batches = m_batches.load(std::memory_order_relaxed);
+    s.errors = m_errors.load(std::memory_order_relaxed);
+    s.pushes = m_pushes.load(std::memory_order_relaxed);
+    s.refills = m_refills.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,241 @@
+﻿// === src/control_server_posix.cpp ===
+#include "control_server.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+struct ControlServer::Connection {
+    int         fd = -1;
+    std::string in;
+    std::string out;
+    size_t      sent = 0;          // of out
+    bool        subscribed = false;
+    bool        eof = false;       // the client is done writing; close once answered
+    bool        closed = false;
+};
+
+static bool MakeAddress(const std::string& path, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path))
+        return false;
+    std::memcpy(addr.sun_path, path.data(), path.size());
+    return true;
+}
+
+// Whether a server is listening at addr; anything but a refusal counts
+static bool Answers(const sockaddr_un& addr) {
+    const int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0)
+        return true;
+    const bool answers = connect(probe, (const sockaddr*)&addr, sizeof(addr)) == 0 || errno != ECONNREFUSED;
+    close(probe);
+    return answers;
+}
+
+static void SetNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+
+bool ControlServer::Start(const std::string& endpoint) {
+    Stop();
+    sockaddr_un addr;
+    if (!MakeAddress(endpoint, addr))
+        return false;
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return false;
+    SetNonBlocking(fd);
+    // only our user, from the moment it exists (XDG_RUNTIME_DIR is private
+    // anyway; /tmp isn't)
+    const mode_t mask = umask(077);
+    bool bound = bind(fd, (const sockaddr*)&addr, sizeof(addr)) == 0;
+    if (!bound) {
+        // taken: by a WWS that is still running, or by one that died
+        // without removing it, in which case nobody answers
+        const bool stale = errno == EADDRINUSE && !Answers(addr);
+        bound = stale && unlink(endpoint.c_str()) == 0 && bind(fd, (const sockaddr*)&addr, sizeof(addr)) == 0;
+    }
+    umask(mask);
+    if (!bound) {
+        close(fd);
+        return false;
+    }
+    if (listen(fd, SOMAXCONN) != 0 || pipe(m_wake) != 0) {
+        close(fd);
+        unlink(endpoint.c_str());
+        return false;
+    }
+    SetNonBlocking(m_wake[0]);
+    SetNonBlocking(m_wake[1]);
+    m_listen = fd;
+    m_endpoint = endpoint;
+    m_stop = false;
+    m_running = true;
+    m_thread = std::thread(&ControlServer::ThreadMain, this);
+    return true;
+}
+
+void ControlServer::Stop() {
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_focusMutex);
+            m_running = false;   // OnWindowEvent wakes no more
+            m_focus.clear();
+        }
+        m_stop = true;
+        Wake();
+        m_thread.join();
+    }
+    if (m_listen >= 0) {
+        close(m_listen);
+        unlink(m_endpoint.c_str());
+    }
+    m_listen = -1;
+    for (int& fd : m_wake) {
+        if (fd >= 0)
+            close(fd);
+        fd = -1;
+    }
+}
+
+void ControlServer::Wake() {
+    char c = 0;
+    (void)!write(m_wake[1], &c, 1);   // a full pipe wakes the thread just as well
+}
+
+// Reads what is there and answers it, a buffer at a time; stops at a line
+// too long, or once the client has more replies waiting than it may, and
+// leaves the rest in the socket. False once the connection is over.
+bool ControlServer::Receive(Connection& c) {
+    char buf[4096];
+    for (;;) {
+        const ssize_t n = read(c.fd, buf, sizeof(buf));
+        if (n > 0) {
+            c.in.append(buf, (size_t)n);
+            c.in.erase(0, Serve(c.in, c.out, c.subscribed));
+            if (c.in.size() > kMaxLine) {
+                c.out += "err line too long\n";
+                c.eof = true;
+                break;
+            }
+            if (c.out.size() - c.sent > kMaxBacklog)
+                break;
+            continue;
+        }
+        if (n == 0)
+            c.eof = true;
+        else if (errno == EINTR)
+            continue;
+        else if (errno != EAGAIN && errno != EWOULDBLOCK)
+            return false;
+        break;
+    }
+    return true;
+}
+
+// Writes as much of the replies as the socket takes; false on error
+bool ControlServer::Send(Connection& c) {
+    while (c.sent < c.out.size()) {
+        const ssize_t n = send(c.fd, c.out.data() + c.sent, c.out.size() - c.sent, MSG_NOSIGNAL);
+        if (n >= 0) {
+            c.sent += (size_t)n;
+            continue;
+        }
+        if (errno == EINTR)
+            continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+            return false;
+        break;
+    }
+    if (c.sent == c.out.size()) {
+        c.out.clear();
+        c.sent = 0;
+    }
+    return c.out.size() - c.sent <= kMaxBacklog;
+}
+
+void ControlServer::ThreadMain() {
+    // one thread polls the listener and every client; a request is a few
+    // hundred nanoseconds of work, less than a thread switch would cost
+    std::vector<Connection> conns;
+    std::vector<pollfd> fds;
+    std::string focus;
+    for (;;) {
+        fds.clear();
+        fds.push_back({ m_listen, POLLIN, 0 });
+        fds.push_back({ m_wake[0], POLLIN, 0 });
+        for (const Connection& c : conns)
+            fds.push_back({ c.fd, (short)((c.eof ? 0 : POLLIN) | (c.out.empty() ? 0 : POLLOUT)), 0 });
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            char buf[64];
+            while (read(m_wake[0], buf, sizeof(buf)) > 0) {}
+            if (m_stop)
+                break;
+            focus.clear();
+            FocusLines(focus);
+            if (!focus.empty()) {
+                for (Connection& c : conns) {
+                    if (c.subscribed) {
+                        c.out += focus;
+                        m_pushes.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            }
+        }
+        for (size_t i = 0; i < conns.size(); ++i) {
+            Connection& c = conns[i];
+            const short ev = fds[i + 2].revents;
+            if ((ev & (POLLIN | POLLHUP | POLLERR)) && !c.eof && !Receive(c))
+                c.closed = true;
+            if (!c.closed && !c.out.empty() && !Send(c))
+                c.closed = true;
+            if (c.eof && c.out.empty())
+                c.closed = true;
+        }
+        for (size_t i = conns.size(); i-- > 0;) {
+            if (conns[i].closed) {
+                close(conns[i].fd);
+                conns[i] = std::move(conns.back());
+                conns.pop_back();
+            }
+        }
+        if (fds[0].revents & POLLIN) {
+            for (;;) {
+                const int fd = accept(m_listen, nullptr, nullptr);
+                if (fd < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    break;   // EAGAIN, or out of descriptors until some close
+                }
+                SetNonBlocking(fd);
+                Connection c;
+                c.fd = fd;
+                conns.push_back(std::move(c));
+                m_connections.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    for (Connection& c : conns)
+        close(c.fd);
+}
+
+std::string DefaultControlEndpoint() {
+    if (const char* dir = std::getenv("XDG_RUNTIME_DIR"))
+        if (*dir)
+            return std::string(dir) + "/wws.sock";
+    return "/tmp/wws-" + std::to_string(getuid()) + ".sock";
+}
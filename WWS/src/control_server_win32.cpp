@@ -0,0 +1,211 @@
+﻿// === src/control_server_win32.cpp ===
+#include "control_server.h"
+
+#include <windows.h>
+#include <functional>
+
+static const DWORD kPipeBuffer = 16 * 1024;
+// A client that stops reading is dropped after this, not waited for
+static const DWORD kWriteTimeoutMs = 100;
+
+struct ControlServer::Connection {
+    HANDLE            pipe = INVALID_HANDLE_VALUE;
+    HANDLE            readDone = nullptr;    // overlapped I/O events
+    HANDLE            writeDone = nullptr;
+    std::mutex        writeMutex;            // replies from its thread, pushes from the server's
+    std::atomic<bool> subscribed{ false };
+    std::atomic<bool> finished{ false };
+    std::thread       thread;
+};
+
+// Instances share the name; the first one fails if another WWS owns it
+static HANDLE CreateInstance(const std::string& name, bool first) {
+    return CreateNamedPipeA(name.c_str(),
+        PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | (first ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0),
+        PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+        PIPE_UNLIMITED_INSTANCES, kPipeBuffer, kPipeBuffer, 0, nullptr);
+}
+
+bool ControlServer::Start(const std::string& endpoint) {
+    Stop();
+    // a WWS that died took its instances with it, so there is nothing
+    // stale to take over here
+    HANDLE pipe = CreateInstance(endpoint, true);
+    if (pipe == INVALID_HANDLE_VALUE)
+        return false;
+    m_pipe = pipe;
+    m_stop = CreateEventW(nullptr, TRUE, FALSE, nullptr);    // manual: every thread sees it
+    m_wake = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (!m_stop || !m_wake) {
+        Stop();
+        return false;
+    }
+    m_endpoint = endpoint;
+    m_running = true;
+    m_thread = std::thread(&ControlServer::ThreadMain, this);
+    return true;
+}
+
+void ControlServer::Stop() {
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_focusMutex);
+            m_running = false;   // OnWindowEvent wakes no more
+            m_focus.clear();
+        }
+        SetEvent((HANDLE)m_stop);
+        m_thread.join();
+        std::lock_guard<std::mutex> lock(m_openMutex);
+        Reap(true);
+    }
+    for (void** h : { &m_pipe, &m_stop, &m_wake }) {
+        if (*h)
+            CloseHandle((HANDLE)*h);
+        *h = nullptr;
+    }
+}
+
+void ControlServer::Wake() {
+    SetEvent((HANDLE)m_wake);
+}
+
+void ControlServer::ThreadMain() {
+    // accepts clients, each served on a thread of its own, and pushes
+    // focus changes to the subscribed ones
+    HANDLE pipe = (HANDLE)m_pipe;
+    m_pipe = nullptr;
+    HANDLE connected = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    const HANDLE waits[3] = { connected, (HANDLE)m_stop, (HANDLE)m_wake };
+    std::string focus;
+    bool stop = !connected;
+    while (!stop) {
+        ResetEvent(connected);
+        OVERLAPPED ov{};
+        ov.hEvent = connected;
+        bool ok = ConnectNamedPipe(pipe, &ov) != FALSE;
+        const DWORD err = ok ? ERROR_SUCCESS : GetLastError();
+        ok = ok || err == ERROR_PIPE_CONNECTED;   // came in before we asked
+        while (err == ERROR_IO_PENDING) {
+            const DWORD w = WaitForMultipleObjects(3, waits, FALSE, INFINITE);
+            if (w == WAIT_OBJECT_0 + 2) {
+                focus.clear();
+                FocusLines(focus);
+                if (focus.empty())
+                    continue;
+                std::lock_guard<std::mutex> lock(m_openMutex);
+                for (const auto& c : m_open)
+                    if (c->subscribed && !c->finished && Write(*c, focus))
+                        m_pushes.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            DWORD n = 0;
+            if (w == WAIT_OBJECT_0) {
+                ok = GetOverlappedResult(pipe, &ov, &n, FALSE) != FALSE;
+            }
+            else {
+                CancelIo(pipe);
+                GetOverlappedResult(pipe, &ov, &n, TRUE);
+                stop = true;
+            }
+            break;
+        }
+        if (ok && !stop) {
+            auto c = std::make_shared<Connection>();
+            c->pipe = pipe;
+            c->readDone = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+            c->writeDone = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+            m_connections.fetch_add(1, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(m_openMutex);
+            Reap(false);
+            if (c->readDone && c->writeDone)
+                c->thread = std::thread(&ControlServer::ConnectionMain, this, std::ref(*c));
+            else
+                c->finished = true;
+            m_open.push_back(std::move(c));
+        }
+        else {
+            CloseHandle(pipe);
+        }
+        if (stop)
+            break;
+        pipe = CreateInstance(m_endpoint, false);
+        if (pipe == INVALID_HANDLE_VALUE)
+            break;   // out of handles; clients already connected stay served
+    }
+    if (connected)
+        CloseHandle(connected);
+}
+
+void ControlServer::ConnectionMain(Connection& c) {
+    std::string in, out;
+    char buf[4096];
+    bool subscribe = false;
+    const HANDLE waits[2] = { c.readDone, (HANDLE)m_stop };
+    for (;;) {
+        OVERLAPPED ov{};
+        ov.hEvent = c.readDone;
+        DWORD n = 0;
+        if (!ReadFile(c.pipe, buf, sizeof(buf), nullptr, &ov) && GetLastError() != ERROR_IO_PENDING)
+            break;
+        if (WaitForMultipleObjects(2, waits, FALSE, INFINITE) != WAIT_OBJECT_0) {
+            CancelIo(c.pipe);
+            GetOverlappedResult(c.pipe, &ov, &n, TRUE);
+            break;
+        }
+        // fails once the client is gone, or a push to it timed out
+        if (!GetOverlappedResult(c.pipe, &ov, &n, FALSE) || n == 0)
+            break;
+        in.append(buf, n);
+        in.erase(0, Serve(in, out, subscribe));
+        if (subscribe)
+            c.subscribed = true;
+        const bool tooLong = in.size() > kMaxLine;
+        if (tooLong)
+            out += "err line too long\n";
+        if (!out.empty() && !Write(c, out))
+            break;
+        out.clear();
+        if (tooLong)
+            break;
+    }
+    c.finished = true;
+}
+
+bool ControlServer::Write(Connection& c, const std::string& data) {
+    std::lock_guard<std::mutex> lock(c.writeMutex);
+    OVERLAPPED ov{};
+    ov.hEvent = c.writeDone;
+    DWORD n = 0;
+    if (!WriteFile(c.pipe, data.data(), (DWORD)data.size(), nullptr, &ov) && GetLastError() != ERROR_IO_PENDING)
+        return false;
+    if (WaitForSingleObject(c.writeDone, kWriteTimeoutMs) != WAIT_OBJECT_0) {
+        // everything on the pipe, so its read ends too and the thread goes
+        CancelIoEx(c.pipe, nullptr);
+        GetOverlappedResult(c.pipe, &ov, &n, TRUE);
+        return false;
+    }
+    return GetOverlappedResult(c.pipe, &ov, &n, FALSE) && n == data.size();
+}
+
+void ControlServer::Reap(bool all) {
+    for (size_t i = m_open.size(); i-- > 0;) {
+        Connection& c = *m_open[i];
+        if (!all && !c.finished)
+            continue;
+        if (c.thread.joinable())
+            c.thread.join();   // all: m_stop is set, so it is on its way out
+        DisconnectNamedPipe(c.pipe);
+        CloseHandle(c.pipe);
+        for (HANDLE h : { c.readDone, c.writeDone })
+            if (h)
+                CloseHandle(h);
+        m_open[i] = std::move(m_open.back());
+        m_open.pop_back();
+    }
+}
+
+std::string DefaultControlEndpoint() {
+    DWORD session = 0;
+    ProcessIdToSessionId(GetCurrentProcessId(), &session);
+    return "\\\\.\\pipe\\wws-" + std::to_string(session);
+}
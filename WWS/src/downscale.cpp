@@ -0,0 +1,231 @@
+﻿// === src/downscale.cpp ===
+#include "downscale.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WWS_DOWNSCALE_SSE2 1
+#endif
+
+static constexpr int kMaxBox = 16;   // 16 * 16 * 255 still fits a uint16_t sum
+
+size_t DownscaleScratch::Bytes() const {
+    return columns.capacity() * sizeof(uint16_t) +
+           (rows[0].capacity() + rows[1].capacity() + blend.capacity() + xs.capacity()) * sizeof(uint32_t);
+}
+
+bool DownscaleVectorized() {
+#ifdef WWS_DOWNSCALE_SSE2
+    return true;
+#else
+    return false;
+#endif
+}
+
+void FitWithin(int w, int h, int maxW, int maxH, int& outW, int& outH) {
+    w = std::max(w, 1);
+    h = std::max(h, 1);
+    if (w <= maxW && h <= maxH) {
+        outW = w;
+        outH = h;
+    }
+    else if ((int64_t)w * maxH <= (int64_t)h * maxW) {
+        outH = maxH;
+        outW = (int)std::max<int64_t>(1, (int64_t)w * maxH / h);
+    }
+    else {
+        outW = maxW;
+        outH = (int)std::max<int64_t>(1, (int64_t)h * maxW / w);
+    }
+}
+
+// --- box pass ---
+
+// columns += one source row, per byte
+static void AddRow(uint16_t* columns, const uint32_t* row, int pixels, bool vectorized) {
+    const uint8_t* bytes = (const uint8_t*)row;
+    int i = 0;
+#ifdef WWS_DOWNSCALE_SSE2
+    if (vectorized) {
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 4 <= pixels; i += 4) {
+            const __m128i b = _mm_loadu_si128((const __m128i*)(bytes + i * 4));
+            __m128i* c = (__m128i*)(columns + i * 4);
+            _mm_storeu_si128(c, _mm_add_epi16(_mm_loadu_si128(c), _mm_unpacklo_epi8(b, zero)));
+            _mm_storeu_si128(c + 1, _mm_add_epi16(_mm_loadu_si128(c + 1), _mm_unpackhi_epi8(b, zero)));
+        }
+    }
+#else
+    (void)vectorized;
+#endif
+    for (int j = i * 4; j < pixels * 4; ++j)
+        columns[j] = (uint16_t)(columns[j] + bytes[j]);
+}
+
+// Every k adjacent column sums into one pixel: (sum + n/2) * ceil(2^16/n) >> 16
+static void SumColumns(const uint16_t* columns, int k, uint32_t* out, int pixels, bool vectorized) {
+    const unsigned n = (unsigned)(k * k);
+    const unsigned recip = (65536 + n - 1) / n;
+#ifdef WWS_DOWNSCALE_SSE2
+    if (vectorized) {
+        const __m128i half = _mm_set1_epi16((short)(n / 2));
+        const __m128i mul = _mm_set1_epi16((short)recip);
+        for (int x = 0; x < pixels; ++x) {
+            const uint16_t* c = columns + (size_t)x * k * 4;
+            __m128i sum = _mm_loadl_epi64((const __m128i*)c);
+            for (int j = 1; j < k; ++j)
+                sum = _mm_add_epi16(sum, _mm_loadl_epi64((const __m128i*)(c + j * 4)));
+            sum = _mm_mulhi_epu16(_mm_add_epi16(sum, half), mul);
+            out[x] = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(sum, sum));
+        }
+        return;
+    }
+#else
+    (void)vectorized;
+#endif
+    for (int x = 0; x < pixels; ++x) {
+        const uint16_t* c = columns + (size_t)x * k * 4;
+        uint32_t px = 0;
+        for (int ch = 0; ch < 4; ++ch) {
+            unsigned sum = 0;
+            for (int j = 0; j < k; ++j)
+                sum += c[j * 4 + ch];
+            px |= (((sum + n / 2) * recip) >> 16) << (ch * 8);
+        }
+        out[x] = px;
+    }
+}
+
+// --- bilinear pass ---
+
+// out = (a * (256 - f) + b * f) >> 8, per byte
+static void BlendRows(const uint32_t* a, const uint32_t* b, unsigned f, uint32_t* out, int pixels, bool vectorized) {
+    int i = 0;
+#ifdef WWS_DOWNSCALE_SSE2
+    if (vectorized) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i wa = _mm_set1_epi16((short)(256 - f));
+        const __m128i wb = _mm_set1_epi16((short)f);
+        for (; i + 4 <= pixels; i += 4) {
+            const __m128i pa = _mm_loadu_si128((const __m128i*)(a + i));
+            const __m128i pb = _mm_loadu_si128((const __m128i*)(b + i));
+            __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pa, zero), wa),
+                                       _mm_mullo_epi16(_mm_unpacklo_epi8(pb, zero), wb));
+            __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(pa, zero), wa),
+                                       _mm_mullo_epi16(_mm_unpackhi_epi8(pb, zero), wb));
+            lo = _mm_srli_epi16(lo, 8);
+            hi = _mm_srli_epi16(hi, 8);
+            _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(lo, hi));
+        }
+    }
+#else
+    (void)vectorized;
+#endif
+    for (; i < pixels; ++i) {
+        uint32_t px = 0;
+        for (int ch = 0; ch < 32; ch += 8) {
+            const unsigned va = (a[i] >> ch) & 0xFF, vb = (b[i] >> ch) & 0xFF;
+            px |= ((va * (256 - f) + vb * f) >> 8) << ch;
+        }
+        out[i] = px;
+    }
+}
+
+// One output row from the blended row (which has a spare pixel at the end)
+static void SampleRow(const uint32_t* blend, const uint32_t* xs, uint32_t* out, int pixels, bool vectorized) {
+#ifdef WWS_DOWNSCALE_SSE2
+    if (vectorized) {
+        const __m128i zero = _mm_setzero_si128();
+        for (int x = 0; x < pixels; ++x) {
+            const uint32_t x0 = xs[x] >> 8;
+            const short f = (short)(xs[x] & 0xFF);
+            const short g = (short)(256 - f);
+            // both neighbours in one register: x0 in the low half, x0 + 1 in the high
+            const __m128i p = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(blend + x0)), zero);
+            const __m128i w = _mm_mullo_epi16(p, _mm_set_epi16(f, f, f, f, g, g, g, g));
+            const __m128i v = _mm_srli_epi16(_mm_add_epi16(w, _mm_srli_si128(w, 8)), 8);
+            out[x] = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(v, v));
+        }
+        return;
+    }
+#else
+    (void)vectorized;
+#endif
+    for (int x = 0; x < pixels; ++x) {
+        const uint32_t x0 = xs[x] >> 8;
+        const unsigned f = xs[x] & 0xFF;
+        uint32_t px = 0;
+        for (int ch = 0; ch < 32; ch += 8) {
+            const unsigned va = (blend[x0] >> ch) & 0xFF, vb = (blend[x0 + 1] >> ch) & 0xFF;
+            px |= ((va * (256 - f) + vb * f) >> 8) << ch;
+        }
+        out[x] = px;
+    }
+}
+
+// Pixel centre of output i in box coordinates, 8.8 fixed point, clamped
+// so that i0 + 1 is still inside (the weight is 0 at the last pixel)
+static uint32_t SamplePoint(int i, int boxLen, int outLen) {
+    int64_t s = ((int64_t)(2 * i + 1) * boxLen * 128) / outLen - 128;
+    if (s < 0)
+        s = 0;
+    if ((s >> 8) >= boxLen - 1)
+        s = (int64_t)(boxLen - 1) << 8;
+    return (uint32_t)s;
+}
+
+void DownscaleRgba(const uint32_t* src, int srcW, int srcH, size_t srcStride,
+                   uint32_t* dst, int dstW, int dstH, size_t dstStride,
+                   DownscaleScratch& s, bool vectorized)
+{
+    if (srcW <= 0 || srcH <= 0 || dstW <= 0 || dstH <= 0)
+        return;
+    dstW = std::min(dstW, srcW);
+    dstH = std::min(dstH, srcH);
+    const int k = std::max(1, std::min({ kMaxBox, srcW / dstW, srcH / dstH }));
+    const int boxW = srcW / k, boxH = srcH / k;
+    // the box pass leaves out fewer than k pixels at the edges; split them
+    // between both sides so the image doesn't shift
+    src += (size_t)((srcH - boxH * k) / 2) * srcStride + (size_t)((srcW - boxW * k) / 2);
+
+    if (k > 1)
+        s.columns.resize((size_t)boxW * k * 4);
+    for (auto& r : s.rows)
+        r.resize((size_t)boxW);
+    s.blend.resize((size_t)boxW + 1);
+    s.xs.resize((size_t)dstW);
+    s.rowIndex[0] = s.rowIndex[1] = -1;
+    for (int x = 0; x < dstW; ++x)
+        s.xs[x] = SamplePoint(x, boxW, dstW);
+
+    // box row r, computed once into the slot of its parity; without a box
+    // factor it is the source row itself
+    auto boxRow = [&](int r) -> const uint32_t* {
+        if (k == 1)
+            return src + (size_t)r * srcStride;
+        std::vector<uint32_t>& out = s.rows[r & 1];
+        if (s.rowIndex[r & 1] != r) {
+            std::fill(s.columns.begin(), s.columns.end(), (uint16_t)0);
+            for (int j = 0; j < k; ++j)
+                AddRow(s.columns.data(), src + (size_t)(r * k + j) * srcStride, boxW * k, vectorized);
+            SumColumns(s.columns.data(), k, out.data(), boxW, vectorized);
+            s.rowIndex[r & 1] = r;
+        }
+        return out.data();
+    };
+
+    for (int y = 0; y < dstH; ++y) {
+        const uint32_t sy = SamplePoint(y, boxH, dstH);
+        const int y0 = (int)(sy >> 8);
+        const unsigned fy = sy & 0xFF;
+        const uint32_t* r0 = boxRow(y0);
+        if (fy == 0)
+            std::memcpy(s.blend.data(), r0, (size_t)boxW * sizeof(uint32_t));
+        else
+            BlendRows(r0, boxRow(y0 + 1), fy, s.blend.data(), boxW, vectorized);
+        s.blend[boxW] = s.blend[boxW - 1];
+        SampleRow(s.blend.data(), s.xs.data(), dst + (size_t)y * dstStride, dstW, vectorized);
+    }
+}
@@ -0,0 +1,157 @@
+﻿// === src/fetch_pool.cpp ===
+#include "fetch_pool.h"
+
+#include <algorithm>
+
+FetchPool::FetchPool(int workers, int maxWorkers, uint64_t deadlineNs)
+    : m_baseWorkers(std::max(workers, 1)),
+      m_maxWorkers(std::max(maxWorkers, std::max(workers, 1))),
+      m_deadlineNs(deadlineNs)
+{
+}
+
+void FetchPool::Start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running)
+        return;
+    m_running = true;
+    for (int i = 0; i < m_baseWorkers; ++i)
+        Spawn();
+    m_watchdog = std::thread(&FetchPool::WatchMain, this);
+}
+
+void FetchPool::Stop() {
+    std::vector<std::thread> threads;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_running)
+            return;
+        m_running = false;
+        m_queue.clear();
+        m_work.notify_all();
+        m_watch.notify_all();
+        // a hung job keeps its worker here for as long as it takes
+        m_watch.wait(lock, [this] { return m_workers.empty(); });
+        threads.swap(m_exited);
+    }
+    for (std::thread& t : threads)
+        t.join();
+    m_watchdog.join();
+}
+
+bool FetchPool::Running() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_running;
+}
+
+void FetchPool::Submit(std::function<void()> job) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_running)
+        return;
+    m_queue.push_back(std::move(job));
+    m_stats.queued = std::max(m_stats.queued, m_queue.size());
+    if (m_idle > 0)
+        m_work.notify_one();
+    else
+        m_watch.notify_one();
+}
+
+FetchPool::Stats FetchPool::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats s = m_stats;
+    s.queued = m_queue.size();
+    s.workers = (int)m_workers.size();
+    s.hung = 0;
+    for (const Worker& w : m_workers)
+        s.hung += w.hung;
+    return s;
+}
+
+// Under m_mutex
+void FetchPool::Spawn() {
+    // threads that left since the last spawn have finished or are about to
+    for (std::thread& t : m_exited)
+        t.join();
+    m_exited.clear();
+    m_workers.emplace_back();
+    Worker* w = &m_workers.back();
+    w->thread = std::thread(&FetchPool::WorkerMain, this, w);
+    m_stats.peakWorkers = std::max(m_stats.peakWorkers, (int)m_workers.size());
+}
+
+void FetchPool::WorkerMain(Worker* self) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        ++m_idle;
+        m_work.wait(lock, [this] { return !m_running || !m_queue.empty(); });
+        --m_idle;
+        if (!m_running)
+            break;
+        std::function<void()> job = std::move(m_queue.front());
+        m_queue.pop_front();
+        self->busy = true;
+        self->sinceNs = SystemClock().NowNs();
+        m_watch.notify_one();
+
+        lock.unlock();
+        job();
+        job = nullptr;   // captures may free things; not under the lock
+        lock.lock();
+
+        // past the deadline between two watchdog looks still counts
+        if (!self->hung && SystemClock().NowNs() - self->sinceNs >= m_deadlineNs)
+            ++m_stats.overdue;
+        self->busy = false;
+        self->hung = false;
+        ++m_stats.jobs;
+        if (m_queue.empty() && (int)m_workers.size() > m_baseWorkers)
+            break;   // a stand-in for a hung worker; not needed any more
+    }
+    // leave; the thread is joined by the next Spawn() or by Stop()
+    for (auto it = m_workers.begin(); it != m_workers.end(); ++it) {
+        if (&*it == self) {
+            m_exited.push_back(std::move(it->thread));
+            m_workers.erase(it);
+            break;
+        }
+    }
+    m_watch.notify_all();
+}
+
+// Marks running jobs hung as they pass the deadline, whatever the queue
+// holds, and wakes at the next one; adds a worker when jobs are waiting,
+// none is idle and every busy one is hung. Sleeps while nothing runs.
+void FetchPool::WatchMain() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_running) {
+        const uint64_t now = SystemClock().NowNs();
+        uint64_t next = ~0ull;
+        bool allHung = true;
+        for (Worker& w : m_workers) {
+            if (!w.busy) {
+                allHung = false;   // just started; about to take a job
+                continue;
+            }
+            if (now - w.sinceNs >= m_deadlineNs) {
+                if (!w.hung) {
+                    w.hung = true;
+                    ++m_stats.overdue;
+                }
+            }
+            else {
+                allHung = false;
+                next = std::min(next, w.sinceNs + m_deadlineNs);
+            }
+        }
+        const bool waiting = !m_queue.empty() && m_idle == 0;
+        if (waiting && allHung && (int)m_workers.size() < m_maxWorkers) {
+            Spawn();
+            ++m_stats.spawned;
+            continue;
+        }
+        if (next == ~0ull)
+            m_watch.wait(lock);   // nothing due: wait for a job to start or return
+        else
+            m_watch.wait_for(lock, std::chrono::nanoseconds(next - now));
+    }
+}
@@ -0,0 +1,127 @@
+﻿// === src/file_watcher_posix.cpp ===
+#include "file_watcher.h"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+// How often the fallback looks at the file where there is no inotify
+static const int kPollMs = 250;
+
+namespace {
+struct Signature {
+    bool   exists = false;
+    time_t mtime = 0;
+    long   mtimeNs = 0;
+    off_t  size = 0;
+
+    bool operator!=(const Signature& o) const {
+        return exists != o.exists || mtime != o.mtime || mtimeNs != o.mtimeNs || size != o.size;
+    }
+};
+}
+
+static Signature Stat(const std::string& path) {
+    Signature sig;
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0) {
+        sig.exists = true;
+        sig.mtime = st.st_mtime;
+#ifdef __linux__
+        sig.mtimeNs = st.st_mtim.tv_nsec;
+#endif
+        sig.size = st.st_size;
+    }
+    return sig;
+}
+
+bool FileWatcher::Start(const std::string& path, ChangeFn onChange, int debounceMs) {
+    Stop();
+    std::filesystem::path p(path);
+    m_dir = p.has_parent_path() ? p.parent_path().string() : std::string(".");
+    m_name = p.filename().string();
+    m_onChange = std::move(onChange);
+    m_debounceMs = debounceMs;
+    if (pipe(m_wake) != 0)
+        return false;
+#ifdef __linux__
+    m_notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    // whole writes and renames onto the name; partial writes would only
+    // get us a half-written file
+    if (m_notify >= 0 && inotify_add_watch(m_notify, m_dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(m_notify);
+        m_notify = -1;
+    }
+#endif
+    m_thread = std::thread(&FileWatcher::ThreadMain, this);
+    return true;
+}
+
+void FileWatcher::Stop() {
+    if (m_thread.joinable()) {
+        char c = 0;
+        (void)!write(m_wake[1], &c, 1);
+        m_thread.join();
+    }
+    for (int& fd : m_wake) {
+        if (fd >= 0)
+            close(fd);
+        fd = -1;
+    }
+    if (m_notify >= 0)
+        close(m_notify);
+    m_notify = -1;
+}
+
+void FileWatcher::ThreadMain() {
+    const std::string path = m_dir + "/" + m_name;
+    Signature last = Stat(path);
+    pollfd fds[2] = { { m_notify, POLLIN, 0 }, { m_wake[0], POLLIN, 0 } };   // fd -1 is skipped
+    bool pending = false;
+    for (;;) {
+        int timeout = pending ? m_debounceMs : m_notify >= 0 ? -1 : kPollMs;
+        int n = poll(fds, 2, timeout);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        if (fds[1].revents & POLLIN)
+            return;
+        if (n == 0) {
+            // quiet for a debounce period (or a polling tick)
+            if (m_notify < 0) {
+                Signature now = Stat(path);
+                if (!(now != last))
+                    continue;
+                last = now;
+            }
+            else if (!pending) {
+                continue;
+            }
+            pending = false;
+            m_onChange();
+            continue;
+        }
+#ifdef __linux__
+        if (fds[0].revents & POLLIN) {
+            alignas(inotify_event) char buf[4096];
+            ssize_t len;
+            while ((len = read(m_notify, buf, sizeof(buf))) > 0) {
+                for (char* at = buf; at < buf + len;) {
+                    const inotify_event* ev = (const inotify_event*)at;
+                    if (ev->len && m_name == ev->name)
+                        pending = true;
+                    at += sizeof(inotify_event) + ev->len;
+                }
+            }
+        }
+#endif
+    }
+}
@@ -0,0 +1,88 @@
+﻿// === src/file_watcher_win32.cpp ===
+#include "file_watcher.h"
+#include "utf8.h"
+
+#include <windows.h>
+#include <filesystem>
+
+namespace {
+struct Signature {
+    bool     exists = false;
+    FILETIME written{};
+    DWORD    size = 0;
+
+    bool operator!=(const Signature& o) const {
+        return exists != o.exists || CompareFileTime(&written, &o.written) != 0 || size != o.size;
+    }
+};
+}
+
+static Signature Stat(const std::wstring& path) {
+    Signature sig;
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data)) {
+        sig.exists = true;
+        sig.written = data.ftLastWriteTime;
+        sig.size = data.nFileSizeLow;
+    }
+    return sig;
+}
+
+bool FileWatcher::Start(const std::string& path, ChangeFn onChange, int debounceMs) {
+    Stop();
+    std::filesystem::path p(path);
+    m_dir = p.has_parent_path() ? p.parent_path().string() : std::string(".");
+    m_name = p.filename().string();
+    m_onChange = std::move(onChange);
+    m_debounceMs = debounceMs;
+    // the notification doesn't say which file changed, so ThreadMain
+    // compares ours against what it was
+    std::wstring dir = WideFromUtf8(m_dir.data(), m_dir.size());
+    m_change = FindFirstChangeNotificationW(dir.c_str(), FALSE,
+        FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE);
+    if (m_change == INVALID_HANDLE_VALUE) {
+        m_change = nullptr;
+        return false;
+    }
+    m_stop = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    m_thread = std::thread(&FileWatcher::ThreadMain, this);
+    return true;
+}
+
+void FileWatcher::Stop() {
+    if (m_thread.joinable()) {
+        SetEvent((HANDLE)m_stop);
+        m_thread.join();
+    }
+    if (m_change)
+        FindCloseChangeNotification((HANDLE)m_change);
+    if (m_stop)
+        CloseHandle((HANDLE)m_stop);
+    m_change = nullptr;
+    m_stop = nullptr;
+}
+
+void FileWatcher::ThreadMain() {
+    const std::string utf8 = m_dir + "\\" + m_name;
+    const std::wstring path = WideFromUtf8(utf8.data(), utf8.size());
+    Signature last = Stat(path);
+    HANDLE handles[2] = { (HANDLE)m_stop, (HANDLE)m_change };
+    bool pending = false;
+    for (;;) {
+        DWORD r = WaitForMultipleObjects(2, handles, FALSE, pending ? (DWORD)m_debounceMs : INFINITE);
+        if (r == WAIT_OBJECT_0 || r == WAIT_FAILED)
+            return;
+        if (r == WAIT_TIMEOUT) {
+            // quiet for a debounce period
+            pending = false;
+            m_onChange();
+            continue;
+        }
+        FindNextChangeNotification((HANDLE)m_change);
+        Signature now = Stat(path);
+        if (now.exists && now != last) {
+            last = now;
+            pending = true;
+        }
+    }
+}
@@ -0,0 +1,136 @@
+﻿// === src/frame_scheduler.cpp ===
+#include "frame_scheduler.h"
+
+#include <chrono>
+
+static constexpr uint64_t kNsPerSec = 1000000000ull;
+
+FrameScheduler::FrameScheduler(const Clock& clock) : m_clock(clock) {
+    m_windowStartNs = m_clock.NowNs();
+}
+
+void FrameScheduler::MarkDirty(uint32_t reasons) {
+    std::function<void()> wake;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        bool wasIdle = (m_dirty == 0);
+        m_dirty |= reasons;
+        if (wasIdle) wake = m_wake;
+    }
+    m_cv.notify_one();
+    if (wake) wake();
+}
+
+void FrameScheduler::SetAnimating(bool on, int maxFps) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_animating = on && maxFps > 0;
+        m_frameIntervalNs = m_animating ? kNsPerSec / (uint64_t)maxFps : 0;
+    }
+    m_cv.notify_one();
+}
+
+void FrameScheduler::SetWakeCallback(std::function<void()> fn) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_wake = std::move(fn);
+}
+
+uint64_t FrameScheduler::TimeUntilFrameNs() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_dirty)
+        return 0;
+    if (!m_animating)
+        return kNever;
+    uint64_t now = m_clock.NowNs();
+    uint64_t next = m_lastFrameNs + m_frameIntervalNs;
+    return next > now ? next - now : 0;
+}
+
+bool FrameScheduler::WaitForFrame() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        if (m_stopped)
+            return false;
+        uint64_t now = m_clock.NowNs();
+        if (DueLocked(now)) {
+            ++m_totals.wakeups;
+            RollLocked(now);
+            return true;
+        }
+        if (m_animating)
+            m_cv.wait_for(lock, std::chrono::nanoseconds(m_lastFrameNs + m_frameIntervalNs - now));
+        else
+            m_cv.wait(lock);
+    }
+}
+
+void FrameScheduler::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+    }
+    m_cv.notify_all();
+}
+
+void FrameScheduler::NoteWakeup() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_totals.wakeups;
+    RollLocked(m_clock.NowNs());
+}
+
+bool FrameScheduler::BeginFrame(uint32_t* reasons) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint64_t now = m_clock.NowNs();
+    if (!DueLocked(now))
+        return false;
+    if (reasons) *reasons = m_dirty;
+    m_dirty = 0;
+    m_lastFrameNs = now;
+    ++m_totals.framesBuilt;
+    return true;
+}
+
+void FrameScheduler::EndFrame(bool presented) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (presented)
+        ++m_totals.framesPresented;
+    RollLocked(m_clock.NowNs());
+}
+
+FrameScheduler::Counters FrameScheduler::Totals() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_totals;
+}
+
+FrameScheduler::Counters FrameScheduler::PerSecond() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    RollLocked(m_clock.NowNs());
+    return m_lastRates;
+}
+
+bool FrameScheduler::DueLocked(uint64_t now) const {
+    if (m_dirty)
+        return true;
+    return m_animating && now >= m_lastFrameNs + m_frameIntervalNs;
+}
+
+// Closes the current one-second window if it is over. A window with no
+// activity at all reports zeros once it has elapsed.
+void FrameScheduler::RollLocked(uint64_t now) const {
+    uint64_t elapsed = now - m_windowStartNs;
+    if (elapsed < kNsPerSec)
+        return;
+    auto rate = [&](uint64_t cur, uint64_t start) {
+        return (cur - start) * kNsPerSec / elapsed;
+    };
+    m_lastRates.wakeups = rate(m_totals.wakeups, m_windowStart.wakeups);
+    m_lastRates.framesBuilt = rate(m_totals.framesBuilt, m_windowStart.framesBuilt);
+    m_lastRates.framesPresented = rate(m_totals.framesPresented, m_windowStart.framesPresented);
+    m_windowStart = m_totals;
+    m_windowStartNs = now;
+}
+
+FrameScheduler& GetFrameScheduler() {
+    static FrameScheduler g_scheduler;
+    return g_scheduler;
+}
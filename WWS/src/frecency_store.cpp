@@ -0,0 +1,226 @@
+﻿// === src/frecency_store.cpp ===
+#include "frecency_store.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+// File layout, all little-endian, native alignment: a header, then a
+// power-of-two run of slots. Bump kVersion whenever either changes.
+struct FrecencyStore::Header {
+    char     magic[8];
+    uint32_t version;
+    uint32_t slots;
+    uint32_t halfLifeSec;   // levels are in these units
+    uint32_t used;
+    uint64_t reserved;
+};
+
+struct FrecencyStore::Slot {
+    uint64_t key;           // 0: empty
+    double   level;         // log2(sum of 2^(t / half-life))
+    uint32_t count;         // activations, undecayed
+    uint32_t lastSec;       // last activation, Unix seconds
+};
+
+static const char     kMagic[8] = { 'W', 'W', 'S', 'F', 'R', 'E', 'C', '\0' };
+static const uint32_t kVersion = 1;
+// A key lives within this many slots of its home; a full run evicts
+static const uint32_t kMaxProbe = 16;
+
+static const double kNever = -std::numeric_limits<double>::infinity();
+
+// log2(2^a + 2^b) without leaving double range (levels are ~3000)
+static double LogAdd(double a, double b) {
+    if (a < b) std::swap(a, b);
+    if (b == kNever) return a;
+    return a + std::log2(1.0 + std::exp2(b - a));
+}
+
+size_t FrecencyStore::BytesFor(uint32_t slots) {
+    static_assert(sizeof(Header) == 32 && sizeof(Slot) == 24, "file layout");
+    return sizeof(Header) + (size_t)slots * sizeof(Slot);
+}
+
+static uint32_t RoundSlots(uint32_t slots) {
+    uint32_t n = kMaxProbe;
+    while (n < slots && n < (1u << 24))
+        n <<= 1;
+    return n;
+}
+
+// --- keys ---
+
+static const uint64_t kFnvBasis = 1469598103934665603ull;
+static const uint64_t kFnvPrime = 1099511628211ull;
+
+static bool IsMarker(wchar_t c) {
+    // what editors put in front of a title for unsaved changes
+    return c == L' ' || c == L'*' || c == 0x2022 || c == 0x25CF;
+}
+
+static uint64_t HashPattern(std::wstring_view s, uint64_t h) {
+    size_t i = 0;
+    while (i < s.size() && IsMarker(s[i]))
+        ++i;
+    bool inDigits = false;
+    for (; i < s.size(); ++i) {
+        uint32_t c = (uint32_t)s[i];
+        const bool digit = (c >= '0' && c <= '9');
+        if (digit && inDigits)
+            continue;
+        inDigits = digit;
+        if (digit)                       c = '#';
+        else if (c >= 'A' && c <= 'Z')   c += 'a' - 'A';
+        for (int b = 0; b < 4; ++b) {
+            h ^= (c >> (b * 8)) & 0xFF;
+            h *= kFnvPrime;
+        }
+    }
+    return h ? h : 1;
+}
+
+FrecencyKeys FrecencyKeys::FromTitle(std::wstring_view title) {
+    FrecencyKeys k;
+    if (title.empty())
+        return k;
+    // "page - site - App", or Firefox's em dash
+    size_t cut = 0;
+    for (size_t i = title.size(); i-- > 2;) {
+        if (title[i] == L' ' && title[i - 2] == L' ' && (title[i - 1] == L'-' || title[i - 1] == 0x2014)) {
+            cut = i + 1;
+            break;
+        }
+    }
+    k.pattern = HashPattern(title, kFnvBasis);
+    // seeded apart, so "App" alone doesn't share a slot with the app of "x - App"
+    k.app = HashPattern(title.substr(cut), kFnvBasis ^ 0x9E3779B97F4A7C15ull);
+    return k;
+}
+
+// --- store ---
+
+FrecencyStore::FrecencyStore(const Clock& wall) : m_wall(wall) {}
+
+bool FrecencyStore::Open(const std::string& path, uint32_t slots) {
+    Close();
+    slots = RoundSlots(slots);
+    if (!m_file.Open(path, BytesFor(slots))) {
+        OpenInMemory(slots);
+        return false;
+    }
+    const Header* h = (const Header*)m_file.Data();
+    const bool valid = std::memcmp(h->magic, kMagic, sizeof(kMagic)) == 0 &&
+                       h->version == kVersion && h->halfLifeSec == kHalfLifeSec &&
+                       h->slots >= kMaxProbe && (h->slots & (h->slots - 1)) == 0 &&
+                       BytesFor(h->slots) <= m_file.Size();
+    if (valid)
+        slots = h->slots;
+    else
+        Init(m_file.Data(), slots);
+    m_header = (Header*)m_file.Data();
+    m_slots = (Slot*)(m_header + 1);
+    m_mask = slots - 1;
+    return true;
+}
+
+void FrecencyStore::OpenInMemory(uint32_t slots) {
+    Close();
+    slots = RoundSlots(slots);
+    m_memory.reset(new uint64_t[BytesFor(slots) / sizeof(uint64_t)]);
+    Init(m_memory.get(), slots);
+    m_header = (Header*)m_memory.get();
+    m_slots = (Slot*)(m_header + 1);
+    m_mask = slots - 1;
+}
+
+void FrecencyStore::Close() {
+    m_file.Close();
+    m_memory.reset();
+    m_header = nullptr;
+    m_slots = nullptr;
+    m_mask = 0;
+}
+
+void FrecencyStore::Init(void* data, uint32_t slots) {
+    std::memset(data, 0, BytesFor(slots));
+    Header* h = (Header*)data;
+    h->version = kVersion;
+    h->slots = slots;
+    h->halfLifeSec = kHalfLifeSec;
+    // the magic last: a store torn mid-Init doesn't pass for a valid one
+    std::memcpy(h->magic, kMagic, sizeof(kMagic));
+}
+
+void FrecencyStore::Clear() {
+    if (m_slots)
+        Init(m_header, m_header->slots);
+}
+
+uint32_t FrecencyStore::Slots() const { return m_header ? m_header->slots : 0; }
+uint32_t FrecencyStore::Used() const { return m_header ? m_header->used : 0; }
+
+FrecencyStore::Slot* FrecencyStore::Find(uint64_t key) const {
+    for (uint32_t i = 0; i < kMaxProbe; ++i) {
+        Slot& s = m_slots[(key + i) & m_mask];
+        if (s.key == key) return &s;
+        if (s.key == 0)   return nullptr;
+    }
+    return nullptr;
+}
+
+FrecencyStore::Slot& FrecencyStore::Claim(uint64_t key) {
+    Slot* weakest = nullptr;
+    for (uint32_t i = 0; i < kMaxProbe; ++i) {
+        Slot& s = m_slots[(key + i) & m_mask];
+        if (s.key == key)
+            return s;
+        if (s.key == 0) {
+            ++m_header->used;
+            weakest = &s;
+            break;
+        }
+        if (!weakest || s.level < weakest->level)
+            weakest = &s;
+    }
+    // an evicted slot stays occupied, so other keys' probe runs stay intact
+    weakest->key = key;
+    weakest->level = kNever;
+    weakest->count = 0;
+    weakest->lastSec = 0;
+    return *weakest;
+}
+
+double FrecencyStore::Level(uint64_t key) const {
+    const Slot* s = key ? Find(key) : nullptr;
+    return s ? s->level : kNever;
+}
+
+void FrecencyStore::Record(const FrecencyKeys& keys) {
+    Record(keys, m_wall.NowNs() / 1000000000ull);
+}
+
+void FrecencyStore::Record(const FrecencyKeys& keys, uint64_t unixSec) {
+    if (!m_slots || !keys.pattern)
+        return;
+    const double t = (double)unixSec / kHalfLifeSec;
+    for (uint64_t key : { keys.pattern, keys.app }) {
+        Slot& s = Claim(key);
+        s.level = LogAdd(s.level, t);
+        ++s.count;
+        s.lastSec = (uint32_t)unixSec;
+    }
+}
+
+double FrecencyStore::Rank(const FrecencyKeys& keys) const {
+    if (!m_slots)
+        return kNever;
+    static const double kAppShift = std::log2(kAppWeight);
+    return LogAdd(Level(keys.pattern), Level(keys.app) + kAppShift);
+}
+
+double FrecencyStore::Score(const FrecencyKeys& keys, uint64_t unixSec) const {
+    const double rank = Rank(keys);
+    return rank == kNever ? 0.0 : std::exp2(rank - (double)unixSec / kHalfLifeSec);
+}
@@ -0,0 +1,264 @@
+﻿// === src/fuzzy_filter.cpp ===
+#include "fuzzy_filter.h"
+#include "window_snapshot.h"
+#include "utf8.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cwctype>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WWS_FILTER_SSE2 1
+#endif
+
+// Bit for one arena byte: letters and digits get their own, other ASCII
+// shares the rest, and every non-ASCII byte lands on bit 63. Sharing only
+// makes rejection weaker, never wrong.
+static inline uint64_t CharBit(unsigned char c) {
+    if (c >= 'a' && c <= 'z') return 1ull << (c - 'a');
+    if (c >= '0' && c <= '9') return 1ull << (26 + c - '0');
+    if (c >= 0x80)            return 1ull << 63;
+    return 1ull << (36 + c % 27);
+}
+
+struct CharBits {
+    uint64_t bit[256];
+    CharBits() { for (int c = 0; c < 256; ++c) bit[c] = CharBit((unsigned char)c); }
+};
+static const CharBits kCharBits;
+
+static uint64_t MaskOf(const char* s, size_t len) {
+    uint64_t m = 0;
+    for (size_t i = 0; i < len; ++i)
+        m |= kCharBits.bit[(unsigned char)s[i]];
+    return m;
+}
+
+static inline bool IsBoundary(char c) {
+    return c == ' ' || c == '-' || c == '_' || c == '.' || c == '/' ||
+           c == '\\' || c == ':' || c == '|' || c == '(' || c == '[';
+}
+
+void AppendLowerUtf8(std::string& out, const std::wstring& s) {
+    for (size_t i = 0; i < s.size(); ++i) {
+        // runs of ASCII go straight in
+        size_t j = i;
+        while (j < s.size() && (uint32_t)s[j] < 0x80)
+            ++j;
+        if (j > i) {
+            size_t at = out.size();
+            out.resize(at + (j - i));
+            for (char* d = &out[at]; i < j; ++i)
+                *d++ = (char)((s[i] >= L'A' && s[i] <= L'Z') ? s[i] + 32 : s[i]);
+            if (i == s.size())
+                break;
+        }
+        uint32_t c = (uint32_t)s[i];
+        // wchar_t is UTF-16 on Windows
+        if (sizeof(wchar_t) == 2 && c >= 0xD800 && c < 0xDC00 && i + 1 < s.size()) {
+            uint32_t lo = (uint32_t)s[i + 1];
+            if (lo >= 0xDC00 && lo < 0xE000) {
+                AppendUtf8(out, 0x10000 + ((c - 0xD800) << 10) + (lo - 0xDC00));
+                ++i;
+                continue;
+            }
+        }
+        AppendUtf8(out, (uint32_t)std::towlower((wint_t)c));
+    }
+}
+
+void AppendLowerUtf8(std::string& out, const char* s, size_t len) {
+    const char* end = s + len;
+    while (s < end) {
+        const char* run = s;
+        while (s < end && (unsigned char)*s < 0x80)
+            ++s;
+        if (s > run) {
+            size_t at = out.size();
+            out.resize(at + (size_t)(s - run));
+            for (char* d = &out[at]; run < s; ++run)
+                *d++ = (*run >= 'A' && *run <= 'Z') ? (char)(*run + 32) : *run;
+            if (s == end)
+                break;
+        }
+        AppendUtf8(out, (uint32_t)std::towlower((wint_t)DecodeUtf8(s, end)));
+    }
+}
+
+void FuzzyFilter::Build(const WindowSnapshot& windows) {
+    const size_t n = windows.Size();
+    m_arena.clear();
+    m_arena.reserve(windows.ArenaSize());
+    m_entries.resize(n);
+    m_masks.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        Entry& e = m_entries[i];
+        const std::string_view title = windows.Title(i);
+        const std::string_view exe = windows.Exe(i);
+        e.title = (uint32_t)m_arena.size();
+        AppendLowerUtf8(m_arena, title.data(), title.size());
+        e.titleLen = (uint32_t)m_arena.size() - e.title;
+        e.exe = (uint32_t)m_arena.size();
+        AppendLowerUtf8(m_arena, exe.data(), exe.size());
+        e.exeLen = (uint32_t)m_arena.size() - e.exe;
+        m_masks[i] = MaskOf(m_arena.data() + e.title, e.titleLen + e.exeLen);
+    }
+    m_fresh = true;
+    m_query.clear();
+    m_matches.clear();
+    m_results.resize(n);
+    for (uint32_t i = 0; i < (uint32_t)n; ++i)
+        m_results[i] = i;
+}
+
+// fzf-style: the leftmost end of a subsequence match, then back from there
+// to the latest start, and score that (tightest) span. Matches on word
+// boundaries and runs of consecutive characters score higher, gaps and late
+// starts lower.
+int FuzzyFilter::Score(const char* text, size_t len, const char* term, size_t termLen) {
+    if (termLen == 0)
+        return 0;
+    if (termLen > len)
+        return -1;
+
+    const char* p = text;
+    const char* end = text + len;
+    for (size_t k = 0; k < termLen; ++k) {
+        p = (const char*)memchr(p, term[k], (size_t)(end - p));
+        if (!p)
+            return -1;
+        ++p;
+    }
+    size_t stop = (size_t)(p - text);
+    size_t start = stop;
+    for (size_t k = termLen; k > 0; ) {
+        --start;
+        if (text[start] == term[k - 1])
+            --k;
+    }
+
+    int score = 0;
+    int run = 0;
+    size_t k = 0;
+    for (size_t i = start; i < stop && k < termLen; ++i) {
+        if (text[i] == term[k]) {
+            int s = 16;
+            if (i == 0)                       s += 10;
+            else if (IsBoundary(text[i - 1])) s += 8;
+            s += 4 * std::min(run, 3);
+            score += s;
+            ++run;
+            ++k;
+        }
+        else {
+            score -= run ? 3 : 1;
+            run = 0;
+        }
+    }
+    score -= (int)std::min<size_t>(start, 15);
+    return std::max(score, 0);
+}
+
+bool FuzzyFilter::Match(uint32_t index, int& score) const {
+    const Entry& e = m_entries[index];
+    const char* title = m_arena.data() + e.title;
+    const char* exe = m_arena.data() + e.exe;
+    score = 0;
+    for (const Term& t : m_terms) {
+        const char* term = m_q.data() + t.offset;
+        int s = std::max(Score(title, e.titleLen, term, t.len),
+                         Score(exe, e.exeLen, term, t.len));
+        if (s < 0)
+            return false;
+        score += s;
+    }
+    return true;
+}
+
+// Full scan: keeps the entries whose mask has every query bit
+void FuzzyFilter::Reject(uint64_t queryMask, std::vector<uint32_t>& candidates) const {
+    candidates.clear();
+    const uint32_t n = (uint32_t)m_masks.size();
+    uint32_t i = 0;
+#ifdef WWS_FILTER_SSE2
+    const __m128i q = _mm_set1_epi64x((long long)queryMask);
+    for (; i + 4 <= n; i += 4) {
+        __m128i a = _mm_loadu_si128((const __m128i*)&m_masks[i]);
+        __m128i b = _mm_loadu_si128((const __m128i*)&m_masks[i + 2]);
+        int ma = _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(a, q), q));
+        int mb = _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(b, q), q));
+        if ((ma | mb) == 0)
+            continue;
+        if ((ma & 0x00FF) == 0x00FF) candidates.push_back(i);
+        if ((ma & 0xFF00) == 0xFF00) candidates.push_back(i + 1);
+        if ((mb & 0x00FF) == 0x00FF) candidates.push_back(i + 2);
+        if ((mb & 0xFF00) == 0xFF00) candidates.push_back(i + 3);
+    }
+#endif
+    for (; i < n; ++i)
+        if ((m_masks[i] & queryMask) == queryMask)
+            candidates.push_back(i);
+}
+
+const std::vector<uint32_t>& FuzzyFilter::Filter(const std::wstring& query) {
+    m_q.clear();
+    AppendLowerUtf8(m_q, query);
+
+    m_terms.clear();
+    for (size_t pos = 0; pos < m_q.size(); ) {
+        size_t sp = m_q.find(' ', pos);
+        if (sp == std::string::npos) sp = m_q.size();
+        if (sp > pos) m_terms.push_back({ (uint32_t)pos, (uint32_t)(sp - pos) });
+        pos = sp + 1;
+    }
+
+    const uint32_t n = (uint32_t)m_entries.size();
+    m_scanned = 0;
+    if (m_terms.empty()) {
+        m_matches.resize(n);
+        for (uint32_t i = 0; i < n; ++i)
+            m_matches[i] = i;
+        m_results = m_matches;
+        m_query.swap(m_q);
+        m_fresh = false;
+        return m_results;
+    }
+
+    uint64_t queryMask = 0;
+    for (const Term& t : m_terms)
+        queryMask |= MaskOf(m_q.data() + t.offset, t.len);
+
+    // a longer query can only drop matches, so only the last ones need a look
+    bool extends = !m_fresh && m_q.size() >= m_query.size() &&
+                   m_q.compare(0, m_query.size(), m_query) == 0 && m_matches.size() < n;
+    if (extends) {
+        m_candidates.clear();
+        for (uint32_t i : m_matches)
+            if ((m_masks[i] & queryMask) == queryMask)
+                m_candidates.push_back(i);
+    }
+    else {
+        Reject(queryMask, m_candidates);
+    }
+
+    m_matches.clear();
+    m_keys.clear();
+    for (uint32_t i : m_candidates) {
+        int score;
+        ++m_scanned;
+        if (!Match(i, score))
+            continue;
+        m_matches.push_back(i);
+        // best score first, then MRU order
+        m_keys.push_back(((uint64_t)(0x7FFFFFFF - score) << 32) | i);
+    }
+    std::sort(m_keys.begin(), m_keys.end());
+    m_results.resize(m_keys.size());
+    for (size_t i = 0; i < m_keys.size(); ++i)
+        m_results[i] = (uint32_t)m_keys[i];
+
+    m_query.swap(m_q);
+    m_fresh = false;
+    return m_results;
+}
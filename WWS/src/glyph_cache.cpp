@@ -0,0 +1,264 @@
+﻿// === src/glyph_cache.cpp ===
+#include "glyph_cache.h"
+#include "utf8.h"
+#include "window_snapshot.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
+// our own copy for reading fallbacks' cmaps, in a namespace: imgui_draw.cpp
+// has one too, and not all of its helpers are static
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"   // the parts we don't call
+#elif defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4505)
+#endif
+namespace stbtt {
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "imstb_truetype.h"
+}
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#elif defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+using stbtt::stbtt_fontinfo;
+
+static bool FileExists(const std::string& path, size_t* size = nullptr) {
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(path, ec))
+        return false;
+    if (size)
+        *size = (size_t)std::filesystem::file_size(path, ec);
+    return true;
+}
+
+// The whole file in ImGui's allocator, which the atlas frees; null if it
+// can't be read
+static void* ReadFont(const std::string& path, size_t& size) {
+    if (!FileExists(path, &size) || size == 0)
+        return nullptr;
+    std::ifstream in(path, std::ios::binary);
+    void* data = IM_ALLOC(size);
+    if (!in.read((char*)data, (std::streamsize)size)) {
+        IM_FREE(data);
+        return nullptr;
+    }
+    return data;
+}
+
+struct GlyphCache::Fallback {
+    void*          data = nullptr;   // ImGui's allocator; the atlas takes it on merging
+    size_t         size = 0;
+    stbtt_fontinfo info = {};
+    bool           usable = false;   // read, and stb_truetype can parse it
+    bool           merged = false;
+
+    ~Fallback() {
+        if (!merged)
+            IM_FREE(data);
+    }
+};
+
+GlyphCache::GlyphCache(std::vector<std::string> files, float sizePx)
+    : m_files(std::move(files)), m_sizePx(sizePx) {}
+
+GlyphCache::~GlyphCache() = default;
+
+void GlyphCache::Attach() {
+    m_atlas = ImGui::GetIO().Fonts;
+    m_font = nullptr;
+    DropFallbacks();
+    m_fallbacks.resize(m_files.empty() ? 0 : m_files.size() - 1);
+    m_stats = Stats();
+    for (auto& plane : m_seen)
+        plane.reset();
+    m_seen[0].reset(new uint64_t[1024]());   // the BMP; Scan() reads it directly
+
+    size_t bytes = 0;
+    if (!m_files.empty() && FileExists(m_files[0], &bytes)) {
+        m_font = m_atlas->AddFontFromFileTTF(m_files[0].c_str(), m_sizePx);
+        if (m_font) {
+            ++m_stats.fonts;
+            m_stats.fontBytes += bytes;
+        }
+    }
+    if (!m_font) {
+        // ProggyClean: ASCII and not much else, the fallbacks do the rest
+        ImFontConfig cfg;
+        cfg.SizePixels = m_sizePx;
+        m_font = m_atlas->AddFontDefault(&cfg);
+    }
+    ImGui::GetIO().FontDefault = m_font;
+}
+
+void GlyphCache::Detach() {
+    // the atlas owns the fonts, and the files merged into them
+    m_font = nullptr;
+    m_atlas = nullptr;
+    DropFallbacks();
+}
+
+void GlyphCache::DropFallbacks() {
+    m_fallbacks.clear();
+    m_stats.heldBytes = 0;
+}
+
+int GlyphCache::Prepare(const WindowSnapshot& windows) {
+    if (!m_font)
+        return 0;
+    // display strings are the titles rearranged, nothing new in them
+    ImFontBaked* baked = nullptr;
+    int loaded = 0;
+    for (size_t i = 0; i < windows.Size(); ++i) {
+        loaded += Scan(windows.Title(i), baked);
+        loaded += Scan(windows.Exe(i), baked);
+    }
+    return loaded;
+}
+
+int GlyphCache::Prepare(std::string_view utf8) {
+    if (!m_font)
+        return 0;
+    ImFontBaked* baked = nullptr;
+    return Scan(utf8, baked);
+}
+
+int GlyphCache::Scan(std::string_view utf8, ImFontBaked*& baked) {
+    int loaded = 0;
+    const uint64_t* bmp = m_seen[0].get();
+    const char* p = utf8.data();
+    const char* end = p + utf8.size();
+    while (p < end) {
+        uint32_t c = (unsigned char)*p < 0x80 ? (uint32_t)*p++ : DecodeUtf8(p, end);
+        // nearly every character has been seen before
+        if (c < 0x10000 && (bmp[c >> 6] >> (c & 63)) & 1)
+            continue;
+        if (!Seen(c))
+            loaded += Load(c, baked);   // baked is looked up on the first one
+    }
+    return loaded;
+}
+
+bool GlyphCache::Seen(uint32_t c) {
+    if (c > IM_UNICODE_CODEPOINT_MAX)
+        return true;
+    auto& plane = m_seen[c >> 16];
+    if (!plane)
+        plane.reset(new uint64_t[1024]());
+    uint64_t& word = plane[(c & 0xFFFF) >> 6];
+    const uint64_t bit = 1ull << (c & 63);
+    if (word & bit)
+        return true;
+    word |= bit;
+    ++m_stats.codepoints;
+    return false;
+}
+
+int GlyphCache::Load(uint32_t c, ImFontBaked*& baked) {
+    if (c < 0x20)
+        return 0;
+    if (!baked)
+        baked = m_font->GetFontBaked(m_sizePx);
+    const ImWchar ch = (ImWchar)c;
+    if (baked->IsGlyphLoaded(ch))
+        return 0;   // drawn before we got to it
+    // only ask for the glyph once some font has it: a miss is remembered
+    if (!m_font->IsGlyphInFont(ch) && !LoadFallbackFor(c)) {
+        ++m_stats.missing;
+        return 0;
+    }
+    if (!baked->FindGlyphNoFallback(ch)) {
+        ++m_stats.missing;
+        return 0;
+    }
+    ++m_stats.rasterized;
+    return 1;
+}
+
+// Merges the first fallback whose cmap has c. Files are read on first use
+// and kept until merged, so each is read once however many misses there
+// are; merged ones are in m_font already and not asked again.
+bool GlyphCache::LoadFallbackFor(uint32_t c) {
+    for (size_t i = 0; i < m_fallbacks.size(); ++i) {
+        std::unique_ptr<Fallback>& f = m_fallbacks[i];
+        if (!f) {
+            f.reset(new Fallback);
+            f->data = ReadFont(m_files[i + 1], f->size);
+            if (f->data) {
+                const unsigned char* ttf = (const unsigned char*)f->data;
+                const int offset = stbtt::stbtt_GetFontOffsetForIndex(ttf, 0);
+                f->usable = offset >= 0 && stbtt::stbtt_InitFont(&f->info, ttf, offset);
+                ++m_stats.fallbacksRead;
+                m_stats.heldBytes += f->size;
+            }
+        }
+        if (f->merged || !f->usable || !stbtt::stbtt_FindGlyphIndex(&f->info, (int)c))
+            continue;
+        // merges into the last font added, which is ours; stb_truetype keeps
+        // no per-size state, so sizes already baked pick it up as they are
+        ImFontConfig cfg;
+        cfg.MergeMode = true;
+        const bool added = m_atlas->AddFontFromMemoryTTF(f->data, (int)f->size, m_sizePx, &cfg) != nullptr;
+        // the atlas has the data either way (it frees it on failure)
+        f->merged = true;
+        m_stats.heldBytes -= f->size;
+        if (!added)
+            continue;
+        ++m_stats.fonts;
+        m_stats.fontBytes += f->size;
+        return true;
+    }
+    return false;
+}
+
+GlyphCache::Stats GlyphCache::GetStats() const {
+    Stats s = m_stats;
+    if (m_atlas && m_atlas->TexData) {
+        s.atlasWidth = m_atlas->TexData->Width;
+        s.atlasHeight = m_atlas->TexData->Height;
+        s.atlasBytes = (size_t)m_atlas->TexData->GetSizeInBytes();
+    }
+    return s;
+}
+
+std::vector<std::string> GlyphCache::SystemFonts() {
+#ifdef _WIN32
+    const char* windir = std::getenv("WINDIR");
+    const std::string dir = std::string(windir ? windir : "C:\\Windows") + "\\Fonts\\";
+    const char* names[] = {
+        "segoeui.ttf",    // UI: Latin, Greek, Cyrillic, ...
+        "msyh.ttc",       // Chinese
+        "YuGothM.ttc",    // Japanese
+        "malgun.ttf",     // Korean
+        "Nirmala.ttf",    // Indic
+        "seguisym.ttf",   // symbols
+        "seguiemj.ttf",   // emoji (outlines only; stb_truetype has no colour)
+    };
+#else
+    const std::string dir = "/usr/share/fonts/";
+    const char* names[] = {
+        "truetype/dejavu/DejaVuSans.ttf",
+        "dejavu-sans-fonts/DejaVuSans.ttf",
+        "truetype/noto/NotoSans-Regular.ttf",
+        "opentype/noto/NotoSansCJK-Regular.ttc",
+        "google-noto-cjk/NotoSansCJK-Regular.ttc",
+        "truetype/wqy/wqy-microhei.ttc",
+        "truetype/noto/NotoSansSymbols2-Regular.ttf",
+        "truetype/ancient-scripts/Symbola_hint.ttf",
+    };
+#endif
+    std::vector<std::string> files;
+    for (const char* name : names)
+        if (FileExists(dir + name))
+            files.push_back(dir + name);
+    return files;
+}
@@ -1,14 +1,28 @@
 ﻿// === src/gui.cpp ===
 #include "gui.h"
 #include "win_enum.h"
+#include "window_registry.h"
+#include "activator.h"
+#include "frame_scheduler.h"
+#include "overlay_lifetime.h"
+#include "process_memory.h"
 #include <windows.h>
 #include "settings.h"
-#include <psapi.h>  // for GetModuleBaseNameW
+#include "process_cache.h"
+#include "fetch_pool.h"
+#include "overlay_model.h"
+#include "icon_atlas.h"
+#include "thumbnail_cache.h"
+#include "glyph_cache.h"
+#include "soft_renderer.h"
+#include "trace.h"
 
 #include "imgui_impl_win32.h"
 #include "imgui_impl_dx11.h"
 #include <d3d11.h>
 #include <dxgi.h>
+#include <algorithm>
+#include <memory>
 
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(
     HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam
@@ -26,11 +40,37 @@ static IDXGISwapChain* g_pSwapChain = nullptr;
 static ID3D11RenderTargetView* g_mainRTView = nullptr;
 static bool                    g_showOverlay = false;
 static bool                    showSettingsPanel = false;
-static std::vector<WindowInfo> g_windows;
-static int                     g_selIndex = 0;
+static OverlayModel            g_model;        // windows, filter and selection
+static uint64_t                g_registryVersion = 0;   // WindowRegistry version g_model was snapshotted at
+static Win32IconProvider       g_iconProvider;
+static IconAtlas               g_icons(16, 512, 512);   // 16px icons, ~900 of them
+static FetchPool               g_iconLoads;    // icon extraction, off the UI thread
+static Win32ThumbnailSource    g_thumbSource;
+static std::unique_ptr<ThumbnailCache> g_thumbs;   // sized from the config at start
+static FetchPool               g_thumbLoads;   // PrintWindow and downscaling
+static GlyphCache              g_glyphs;       // Segoe UI plus fallbacks for other scripts
+static TitleFitCache           g_titleFits;    // where each title is cut, per snapshot
+static bool                    g_warmingUp = false;     // drawing the frame nobody sees
+// CPU rendering, when there is no D3D11 device (VDI sessions, broken
+// drivers) or WWS_SOFTWARE_RENDERER is set; presented with GDI
+static std::unique_ptr<SoftRenderer> g_soft;
+static SoftFramebuffer         g_softFrame;
+static bool                    g_forceSoft = false;     // WWS_SOFTWARE_RENDERER
+// Device, swap chain, ImGui context and font atlas come and go with use;
+// the hidden window stays, it receives the posted commands
+static OverlayLifetime         g_lifetime;
+
+// Posted by PostOverlayCommand; wParam is the OverlayCommand
+static const UINT WM_WWS_OVERLAY = WM_APP + 1;
+// Posted by PostFilterChar; wParam is the character
+static const UINT WM_WWS_FILTER = WM_APP + 2;
+// Posted by PostSettingsReloaded
+static const UINT WM_WWS_SETTINGS = WM_APP + 3;
+// Posted by PostQuit
+static const UINT WM_WWS_QUIT = WM_APP + 4;
 
 // Hotkey options
-static const UINT hotkeyOptions[] = { VK_LMENU, VK_RMENU, VK_LSHIFT, VK_RSHIFT };
+static const uint16_t hotkeyOptions[] = { vk::LMenu, vk::RMenu, vk::LShift, vk::RShift };
 
 bool CreateDeviceD3D(HWND hWnd) {
     DXGI_SWAP_CHAIN_DESC sd{};
@@ -64,12 +104,68 @@ void CleanupDeviceD3D() {
     if (g_pd3dDevice) { g_pd3dDevice->Release();  g_pd3dDevice = nullptr; }
 }
 
+// g_softFrame to the window, as a top-down 32-bit DIB (its pixel layout)
+static void PresentSoftFrame() {
+    BITMAPINFO bmi{};
+    bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+    bmi.bmiHeader.biWidth = g_softFrame.width;
+    bmi.bmiHeader.biHeight = -g_softFrame.height;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    HDC dc = GetDC(g_hWnd);
+    SetDIBitsToDevice(dc, 0, 0, g_softFrame.width, g_softFrame.height, 0, 0, 0, g_softFrame.height,
+                      g_softFrame.pixels.data(), &bmi, DIB_RGB_COLORS);
+    ReleaseDC(g_hWnd, dc);
+}
+
 LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wp, LPARAM lp) {
-    if (ImGui_ImplWin32_WndProcHandler(hWnd, msg, wp, lp))
+    if (msg == WM_WWS_OVERLAY) {
+        switch ((OverlayCommand)wp) {
+        case OverlayCommand::Show:    ShowOverlay();      break;
+        case OverlayCommand::Hide:    HideOverlay();      break;
+        case OverlayCommand::Advance: AdvanceSelection(); break;
+        case OverlayCommand::Commit:  CommitSelection();  break;
+        case OverlayCommand::Prepare: PrepareOverlay();   break;
+        }
+        return 0;
+    }
+    if (msg == WM_WWS_FILTER) {
+        FilterInput((wchar_t)wp);
+        return 0;
+    }
+    if (msg == WM_WWS_SETTINGS) {
+        // the file changed on disk; show what the hook now runs on
+        GetSettings() = GetSettingsStore().Current();
+        GetWindowRegistry().SetFrecencyOrder(GetSettings().frecencyOrder);
+        g_lifetime.SetIdleRelease(GetSettings().overlayIdleReleaseMs);
+        // new window rules decide again on every window, not just new ones
+        const auto rules = GetSettingsStore().WindowRules().Load();
+        if (!SameRules(GetWindowSystem().Rules(), rules)) {
+            GetWindowSystem().SetRules(rules);
+            std::vector<WindowRecord> current;
+            if (GetWindowSystem().Snapshot(current))
+                GetWindowRegistry().Reconcile(current);
+        }
+        GetFrameScheduler().MarkDirty(FrameReason_Settings);
+        return 0;
+    }
+    if (msg == WM_WWS_QUIT) {
+        PostQuitMessage(0);
+        return 0;
+    }
+    // only input that reaches a visible overlay can change what we draw
+    if ((g_showOverlay || showSettingsPanel) &&
+        ((msg >= WM_MOUSEFIRST && msg <= WM_MOUSELAST) || msg == WM_MOUSELEAVE ||
+         (msg >= WM_KEYFIRST && msg <= WM_KEYLAST)))
+        GetFrameScheduler().MarkDirty(FrameReason_Input);
+    // no context while the resources are released
+    if (ImGui::GetCurrentContext() && ImGui_ImplWin32_WndProcHandler(hWnd, msg, wp, lp))
         return TRUE;
     if (msg == WM_SIZE && g_pd3dDevice && wp != SIZE_MINIMIZED) {
         CleanupDeviceD3D();
         CreateDeviceD3D(hWnd);
+        GetFrameScheduler().MarkDirty(FrameReason_Resize);
     }
     else if (msg == WM_DESTROY) {
         PostQuitMessage(0);
@@ -77,8 +173,53 @@ LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wp, LPARAM lp) {
     return DefWindowProcW(hWnd, msg, wp, lp);
 }
 
+// Device (or CPU renderer), ImGui context, fonts; a no-op while they exist
+static void EnsureOverlayResources(bool speculative) {
+    if (g_lifetime.Alive())
+        return;
+    WWS_TRACE_SCOPE("overlay_create");
+    const uint64_t start = SystemClock().NowNs();
+    if (g_forceSoft || !CreateDeviceD3D(g_hWnd)) {
+        CleanupDeviceD3D();
+        g_soft = std::make_unique<SoftRenderer>();
+    }
+
+    IMGUI_CHECKVERSION(); ImGui::CreateContext();
+    ImGui_ImplWin32_Init(g_hWnd);
+    if (g_soft)
+        g_soft->Init();
+    else
+        ImGui_ImplDX11_Init(g_pd3dDevice, g_pd3dContext);
+    g_glyphs.Attach();
+    g_icons.Attach();
+    g_thumbs->Attach();
+    g_lifetime.Created(SystemClock().NowNs() - start, speculative, ProcessWorkingSetBytes());
+}
+
+// Everything EnsureOverlayResources() made, back to the system; the icons
+// already extracted and the window stay
+static void ReleaseOverlayResources() {
+    if (!g_lifetime.Alive())
+        return;
+    WWS_TRACE_SCOPE("overlay_release");
+    if (g_soft)
+        g_soft->Shutdown();
+    else
+        ImGui_ImplDX11_Shutdown();
+    ImGui_ImplWin32_Shutdown();
+    g_thumbs->Detach();
+    g_icons.Detach();
+    g_glyphs.Detach();
+    ImGui::DestroyContext();
+    g_soft.reset();
+    g_softFrame = SoftFramebuffer();
+    CleanupDeviceD3D();
+    g_lifetime.Released(ProcessWorkingSetBytes());
+}
+
 bool InitializeGUI(HINSTANCE hInst) {
-    LoadSettings();
+    WWS_TRACE_THREAD("ui");
+    GetSettings() = GetSettingsStore().Load();
     HMONITOR mon = MonitorFromWindow(nullptr, MONITOR_DEFAULTTOPRIMARY);
     MONITORINFO mi{ sizeof(mi) };
     GetMonitorInfoW(mon, &mi);
@@ -98,62 +239,161 @@ bool InitializeGUI(HINSTANCE hInst) {
         g_ScreenW, g_ScreenH,
         nullptr, nullptr, hInst, nullptr
     );
-    if (!g_hWnd || !CreateDeviceD3D(g_hWnd)) return false;
-
-    IMGUI_CHECKVERSION(); ImGui::CreateContext();
-    ImGui_ImplWin32_Init(g_hWnd);
-    ImGui_ImplDX11_Init(g_pd3dDevice, g_pd3dContext);
+    if (!g_hWnd) return false;
+    g_forceSoft = GetEnvironmentVariableW(L"WWS_SOFTWARE_RENDERER", nullptr, 0) > 0;
+
+    // icons extracted so far outlive the resources, so a cold show only
+    // uploads them again
+    g_icons.SetProvider(&g_iconProvider);
+    g_iconLoads.Start();
+    g_icons.SetLoader(&g_iconLoads);
+    // 120 x 75 cells, five across the list; like the icons, thumbnails
+    // survive a release. Captures get three quarters of the budget, as one
+    // of a maximized window is bigger than a whole texture of cells.
+    const size_t thumbBudget = (size_t)std::max(1, GetSettings().thumbnailCacheMB) << 20;
+    g_thumbs = std::make_unique<ThumbnailCache>(120, 75, thumbBudget, thumbBudget / 4 * 3);
+    g_thumbs->SetSource(&g_thumbSource);
+    g_thumbLoads.Start();
+    g_thumbs->SetLoader(&g_thumbLoads);
+    g_lifetime.SetIdleRelease(GetSettings().overlayIdleReleaseMs);
+    if (!g_lifetime.ReleasesWhenIdle())
+        EnsureOverlayResources(false);
 
     SetLayeredWindowAttributes(g_hWnd, RGB(0, 0, 0), 0, LWA_COLORKEY);
     ShowWindow(g_hWnd, SW_HIDE);
+
+    // frames requested from other threads must break the message wait
+    GetFrameScheduler().SetWakeCallback([]() { PostMessageW(g_hWnd, WM_NULL, 0, 0); });
+    // late process info and icons need a redraw (a no-op frame if hidden)
+    GetProcessCache().SetUpdateCallback([]() {
+        GetFrameScheduler().MarkDirty(FrameReason_Snapshot);
+    });
+    g_icons.SetUpdateCallback([]() {
+        GetFrameScheduler().MarkDirty(FrameReason_Snapshot);
+    });
+    g_thumbs->SetUpdateCallback([]() {
+        GetFrameScheduler().MarkDirty(FrameReason_Snapshot);
+    });
     return true;
 }
 
 void ShutdownGUI() {
-    ImGui_ImplDX11_Shutdown();
-    ImGui_ImplWin32_Shutdown();
-    ImGui::DestroyContext();
-    CleanupDeviceD3D();
+    ReleaseOverlayResources();
+    g_iconLoads.Stop();
+    g_thumbLoads.Stop();
+    g_thumbs.reset();
     DestroyWindow(g_hWnd);
     UnregisterClassW(L"AltTabOverlayClass", GetModuleHandleW(nullptr));
 }
 
 void ShowOverlay() {
-    g_windows = GetOpenWindows();
-    g_selIndex = (g_windows.size() > 1 ? 1 : 0);
+    g_lifetime.ShowRequested();
+    EnsureOverlayResources(false);
+    g_registryVersion = GetWindowRegistry().Version();
+    g_model.Show(GetWindowRegistry(), GetProcessCache());
+    g_glyphs.Prepare(g_model.Windows());
     g_showOverlay = true;
     ShowWindow(g_hWnd, SW_SHOW);
+    GetFrameScheduler().MarkDirty(FrameReason_Snapshot);
+}
+
+void WarmUpOverlay() {
+    if (!g_lifetime.Alive())
+        return;
+    WWS_TRACE_SCOPE("warm_up");
+    g_registryVersion = GetWindowRegistry().Version();
+    g_model.Show(GetWindowRegistry(), GetProcessCache());
+    g_glyphs.Prepare(g_model.Windows());
+    g_warmingUp = true;
+    RenderOverlayFrame();
+    g_warmingUp = false;
 }
 
 void HideOverlay() {
     g_showOverlay = false;
     ShowWindow(g_hWnd, SW_HIDE);
+    g_lifetime.Hidden();
+}
+
+void PrepareOverlay() {
+    if (g_lifetime.Alive() || !GetSettings().overlayWarmOnInitiator)
+        return;
+    EnsureOverlayResources(true);
+    WarmUpOverlay();
+}
+
+uint64_t TickOverlayResources() {
+    if (g_lifetime.ShouldRelease())
+        ReleaseOverlayResources();
+    return g_lifetime.TimeUntilReleaseNs();
 }
 
 void AdvanceSelection() {
-    if (!g_windows.empty())
-        g_selIndex = (g_selIndex + 1) % g_windows.size();
+    g_model.Advance();
+    GetFrameScheduler().MarkDirty(FrameReason_Selection);
+}
+
+void FilterInput(wchar_t ch) {
+    if (!g_showOverlay)
+        return;
+    if (g_model.Input(ch))
+        GetFrameScheduler().MarkDirty(FrameReason_Selection);
+}
+
+void PostOverlayCommand(OverlayCommand cmd) {
+    PostMessageW(g_hWnd, WM_WWS_OVERLAY, (WPARAM)cmd, 0);
+}
+
+void PostFilterChar(wchar_t ch) {
+    PostMessageW(g_hWnd, WM_WWS_FILTER, (WPARAM)ch, 0);
+}
+
+void PostSettingsReloaded() {
+    PostMessageW(g_hWnd, WM_WWS_SETTINGS, 0, 0);
+}
+
+void PostQuit() {
+    PostMessageW(g_hWnd, WM_WWS_QUIT, 0, 0);
 }
 
 void SwitchToPreviousWindow() {
-    auto v = GetOpenWindows();
-    if (v.size() > 1)
-        ForceSetForegroundWindow(v[1].handle);
+    if (WindowId prev = GetWindowRegistry().MruAt(1))
+        GetActivator().Request(prev);
 }
 
-void RenderOverlayFrame() {
-    if (!g_showOverlay && !showSettingsPanel) return;
+bool RenderOverlayFrame() {
+    if (!g_showOverlay && !showSettingsPanel && !g_warmingUp) return false;
+    if (!g_lifetime.Alive()) return false;
+    WWS_TRACE_SCOPE("frame");
+    g_lifetime.Used();
 
     ImGui_ImplWin32_NewFrame();
-    ImGui_ImplDX11_NewFrame();
+    if (!g_soft)
+        ImGui_ImplDX11_NewFrame();
     ImGui::NewFrame();
+    g_icons.NewFrame();
+    g_thumbs->NewFrame();
 
     const float pad = 10.0f;
-    const float list_w = 500.0f;
+    const float exe_w = 120.0f;
+    const float list_w = 500.0f + exe_w;
     const float gear_w = 24.0f;
     const float settings_w = showSettingsPanel ? 200.0f : 0.0f;
-    const float line_h = ImGui::GetFontSize() * 1.3f;
-    const float panel_h = line_h * g_windows.size() + pad * 2;
+    // windows opened or closed while we are up replace the snapshot; the
+    // one on screen stays valid until the new one is swapped in
+    if (g_showOverlay && GetWindowRegistry().Version() != g_registryVersion) {
+        g_registryVersion = GetWindowRegistry().Version();
+        GetWindowRegistry().Snapshot(g_model.Back());
+        g_model.Refresh(GetProcessCache());
+        g_glyphs.Prepare(g_model.Windows());
+    }
+    const auto& rows = g_model.Rows();
+    // long lists scroll instead of running off the screen
+    const float list_h = OverlayListHeight(rows.size(), g_ScreenH * 0.6f);
+    const float query_h = g_model.Query().empty() ? 0.0f : ImGui::GetTextLineHeightWithSpacing();
+    const bool  thumbs = GetSettings().thumbnails && !rows.empty();
+    const float thumbs_h = thumbs ? ThumbnailStripHeight(*g_thumbs) : 0.0f;
+    const float panel_h = list_h + query_h + thumbs_h + pad * 2;
     const float extra_w = showSettingsPanel ? (settings_w + pad) : (gear_w + pad);
     const float panel_w = list_w + extra_w + pad * 2;
     ImVec2 panel_sz(panel_w, panel_h);
@@ -181,54 +421,49 @@ void RenderOverlayFrame() {
         ImGuiWindowFlags_NoBackground |
         ImGuiWindowFlags_NoScrollbar);
 
-    ImGui::BeginChild("##List", ImVec2(list_w, panel_h - pad * 2), false);
-    const size_t maxTitle = 80;
-    for (int i = 0; i < (int)g_windows.size(); ++i) {
-        auto& w = g_windows[i];
-        DWORD pid = 0;
-        GetWindowThreadProcessId(w.handle, &pid);
-        HANDLE hProc = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION | PROCESS_VM_READ, FALSE, pid);
-        wchar_t exeW[MAX_PATH] = L"";
-        if (hProc) {
-            GetModuleBaseNameW(hProc, NULL, exeW, MAX_PATH);
-            CloseHandle(hProc);
-        }
-        std::wstring full = w.title;
-        std::wstring disp;
-        size_t pos = full.find(L" - ");
-        if (pos != std::wstring::npos) {
-            std::wstring page = full.substr(0, pos);
-            std::wstring app = full.substr(pos + 3);
-            disp = app + L" - " + page;
-        }
-        else {
-            disp = full;
-        }
-        if (disp.length() > maxTitle)
-            disp = disp.substr(0, maxTitle - 3) + L"...";
-        if (i == g_selIndex)
-            ImGui::TextColored(ImVec4(0.0f, 250.0f / 255.0f, 255.0f / 255.0f, 1.0f), "> %ls", disp.c_str());
-        else
-            ImGui::Text("  %ls", disp.c_str());
+    // late process info: exe names and icons
+    if (g_model.ResolveProcesses(GetProcessCache()))
+        g_glyphs.Prepare(g_model.Windows());
+
+    OverlayListLayout layout;
+    layout.width = list_w;
+    layout.exeWidth = exe_w;
+    layout.maxTitle = kMaxTitle;   // the width cuts them
+    layout.icons = &g_icons;
+    layout.fits = &g_titleFits;
+    if (!g_model.Query().empty())
+        ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.6f, 1.0f), "Filter: %s  (%d/%d)",
+            g_model.QueryUtf8().c_str(), (int)rows.size(), (int)g_model.Windows().Size());
+    DrawWindowList("##List", g_model.Windows(), rows, g_model.List(), layout, list_h);
+    // icons over this frame's extraction budget come in on the next one
+    if (g_icons.Pending())
+        GetFrameScheduler().MarkDirty(FrameReason_Snapshot);
+    if (thumbs) {
+        DrawThumbnailStrip("##Thumbs", g_model.Windows(), rows, g_model.List().selIndex, *g_thumbs, 2, list_w);
+        if (g_thumbs->Pending())
+            GetFrameScheduler().MarkDirty(FrameReason_Snapshot);
     }
-    ImGui::EndChild();
 
     ImGui::SetCursorScreenPos(ImVec2(
         panel_pos.x + list_w + pad,
         panel_pos.y + pad
     ));
-    if (ImGui::Button("⚙", ImVec2(gear_w, gear_w)))
+    if (ImGui::Button("⚙", ImVec2(gear_w, gear_w))) {
         showSettingsPanel = !showSettingsPanel;
+        GetFrameScheduler().MarkDirty(FrameReason_Settings);
+    }
 
     if (showSettingsPanel) {
         ImGui::SameLine();
         ImGui::BeginChild("##Settings", ImVec2(settings_w, panel_h - pad * 2), false);
+        // every edit goes live at once; Save only writes it to disk
+        const HotkeyConfig before = GetSettings();
         ImGui::Text("Initiator");
         ImGui::SetNextItemWidth(settings_w);
-        if (ImGui::BeginCombo("##Initiator", KeyName(GetSettings().initiator))) {
+        if (ImGui::BeginCombo("##Initiator", KeyName(GetSettings().switcher.initiator))) {
             for (auto k : hotkeyOptions) {
-                bool sel = (GetSettings().initiator == k);
-                if (ImGui::Selectable(KeyName(k), sel)) GetSettings().initiator = k;
+                bool sel = (GetSettings().switcher.initiator == k);
+                if (ImGui::Selectable(KeyName(k), sel)) GetSettings().switcher.initiator = k;
                 if (sel) ImGui::SetItemDefaultFocus();
             }
             ImGui::EndCombo();
@@ -236,10 +471,10 @@ void RenderOverlayFrame() {
 
         ImGui::Text("Modifier");
         ImGui::SetNextItemWidth(settings_w);
-        if (ImGui::BeginCombo("##Modifier", KeyName(GetSettings().modifier))) {
+        if (ImGui::BeginCombo("##Modifier", KeyName(GetSettings().switcher.modifier))) {
             for (auto k : hotkeyOptions) {
-                bool sel = (GetSettings().modifier == k);
-                if (ImGui::Selectable(KeyName(k), sel)) GetSettings().modifier = k;
+                bool sel = (GetSettings().switcher.modifier == k);
+                if (ImGui::Selectable(KeyName(k), sel)) GetSettings().switcher.modifier = k;
                 if (sel) ImGui::SetItemDefaultFocus();
             }
             ImGui::EndCombo();
@@ -247,31 +482,93 @@ void RenderOverlayFrame() {
 
         ImGui::Text("Tap Timeout (ms)");
         ImGui::SetNextItemWidth(settings_w);
-        ImGui::SliderInt("##TapTimeout", &GetSettings().tapTimeoutMs, 50, 1000);
+        ImGui::SliderInt("##TapTimeout", &GetSettings().switcher.tapTimeoutMs, 50, 1000);
 
         ImGui::Text("Overlay Timeout (ms)");
         ImGui::SetNextItemWidth(settings_w);
-        ImGui::SliderInt("##OverlayTimeout", &GetSettings().overlayTimeoutMs, 100, 2000);
+        ImGui::SliderInt("##OverlayTimeout", &GetSettings().switcher.overlayTimeoutMs, 100, 2000);
+
+        // most used first instead of most recent; Tap still goes back one
+        ImGui::Checkbox("Order by frecency", &GetSettings().frecencyOrder);
+        ImGui::Checkbox("Thumbnails", &GetSettings().thumbnails);
+
+        // resident mode: only the hook and the registry stay up between uses
+        ImGui::Text("Release GPU after idle");
+        ImGui::SetNextItemWidth(settings_w);
+        int idleSec = GetSettings().overlayIdleReleaseMs / 1000;
+        if (ImGui::SliderInt("##IdleRelease", &idleSec, 0, 600, idleSec ? "%d s" : "never"))
+            GetSettings().overlayIdleReleaseMs = idleSec * 1000;
+        ImGui::Checkbox("Warm on initiator", &GetSettings().overlayWarmOnInitiator);
+        if (GetSettings() != before) {
+            GetSettingsStore().Publish(GetSettings());
+            GetWindowRegistry().SetFrecencyOrder(GetSettings().frecencyOrder);
+            g_lifetime.SetIdleRelease(GetSettings().overlayIdleReleaseMs);
+        }
+        const OverlayLifetime::Stats life = g_lifetime.GetStats();
+        ImGui::TextDisabled("Show: cold %.1f ms, warm %.1f ms", life.cold.MeanMs(), life.warm.MeanMs());
+        ImGui::TextDisabled("Memory: %.0f MB up, %.0f MB released",
+            life.workingSetUp / 1048576.0, life.workingSetDown / 1048576.0);
 
         ImGui::Spacing();
         if (ImGui::Button("Save Settings", ImVec2(settings_w, 0))) {
-            SaveSettings(GetSettings());
+            GetSettingsStore().SaveAsync(GetSettings());
             showSettingsPanel = false;
+            GetFrameScheduler().MarkDirty(FrameReason_Settings);
         }
+#ifdef WWS_ENABLE_TRACING
+        if (ImGui::Button("Dump Trace", ImVec2(settings_w, 0)))
+            DumpTrace();
+#endif
         ImGui::EndChild();
     }
 
     ImGui::End();
+
+    // hover and active states settle a frame after the input that caused
+    // them; ask for one follow-up while ImGui is still busy with it
+    const ImGuiIO& io = ImGui::GetIO();
+    if (ImGui::IsAnyItemActive() || io.MouseDelta.x != 0.0f || io.MouseDelta.y != 0.0f)
+        GetFrameScheduler().MarkDirty(FrameReason_Input);
+
     ImGui::Render();
-    g_pd3dContext->OMSetRenderTargets(1, &g_mainRTView, nullptr);
-    float clear_col[4] = { 0,0,0,0 };
-    g_pd3dContext->ClearRenderTargetView(g_mainRTView, clear_col);
-    ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
-    g_pSwapChain->Present(1, 0);
+    if (g_soft) {
+        g_softFrame.Resize(g_ScreenW, g_ScreenH);
+        g_softFrame.Clear(0xFF000000u);   // the colour key
+        g_soft->Render(ImGui::GetDrawData(), g_softFrame);
+    }
+    else {
+        g_pd3dContext->OMSetRenderTargets(1, &g_mainRTView, nullptr);
+        float clear_col[4] = { 0,0,0,0 };
+        g_pd3dContext->ClearRenderTargetView(g_mainRTView, clear_col);
+        ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
+    }
+    if (g_warmingUp)
+        return true;   // drawn, never shown
+    {
+        WWS_TRACE_SCOPE("present");
+        if (g_soft)
+            PresentSoftFrame();
+        else
+            g_pSwapChain->Present(1, 0);
+    }
+    g_lifetime.Presented();
+    WWS_TRACE_LATENCY_END(TraceLatency_KeyToPresent);
+    return true;
 }
 
 void CommitSelection() {
-    if (!g_windows.empty())
-        ForceSetForegroundWindow(g_windows[g_selIndex].handle);
+    if (WindowId id = g_model.Selected())
+        GetActivator().Request(id);
     HideOverlay();
 }
+
+#ifdef WWS_ENABLE_TRACING
+void DumpTrace() {
+    char path[MAX_PATH];
+    if (!GetEnvironmentVariableA("WWS_TRACE", path, MAX_PATH))
+        strcpy_s(path, "wws_trace.json");
+    if (!GetTracer().WriteChromeJson(path))
+        OutputDebugStringA("WWS: cannot write the trace\n");
+    OutputDebugStringA(GetTracer().LatencyReport().c_str());
+}
+#endif
@@ -1,11 +1,22 @@
 ﻿// === src/hook.cpp ===
 #include "hook.h"
-#include "win_enum.h"          // for GetOpenWindows()
+#include "window_system.h"
+#include "window_registry.h"
+#include "activator.h"
 #include <windows.h>
 #include <functional>
 #include <chrono>
 #include <atomic>
 #include <cstdio>
+#include <future>
+#include <thread>
+#include "key_bindings.h"
+#include "key_channel.h"
+#include "key_trace.h"
+#include "switcher.h"
+#include "switcher_scheduler.h"
+#include "clock.h"
+#include "trace.h"
 
 static void DebugLog(const char* fmt, ...) {
     char buf[256];
@@ -17,160 +28,284 @@ static void DebugLog(const char* fmt, ...) {
     OutputDebugStringA("\n");
 }
 
-static bool IsKey(UINT vk, UINT cfg) {
-    switch (cfg) {
-    case VK_MENU:    return vk == VK_LMENU || vk == VK_RMENU;
-    case VK_SHIFT:   return vk == VK_LSHIFT || vk == VK_RSHIFT;
-    default:         return vk == cfg;
-    }
-}
-
 static HHOOK                   g_hHook = nullptr;
-static HotkeyConfig           g_cfg;
+static Published<SwitcherConfig>*   g_config = nullptr;     // live settings, from InstallHook
+static Published<KeyBindingConfig>* g_bindingConfig = nullptr;
+static KeyEventChannel        g_keys;
+static std::thread            g_hookThread;
+static std::thread            g_workerThread;
+static DWORD                  g_hookThreadId = 0;
 static std::function<void()>  g_onTap;
 static std::function<void()>  g_onHoldStart;
 static std::function<void()>  g_onCycle;
 static std::function<void()>  g_onCancel;
 static std::function<void()>  g_onCommit;
+static std::function<void(wchar_t)> g_onFilterChar;
+static std::function<void()>  g_onInitiatorDown;
+// set while the overlay is listing; the hook then keeps typing for itself
+static std::atomic<bool>      g_capture{ false };
 
-// state
-static bool                    g_initiatorDown = false;
-static bool                    g_holdTriggered = false;
-static int                     g_tapCount = 0;
-static std::chrono::steady_clock::time_point g_lastShiftUpTime;
+// hook-thread state
+static Published<SwitcherConfig>::Reader*   g_hookReader = nullptr;
+static Published<KeyBindingConfig>::Reader* g_hookBindingReader = nullptr;
+static SwitcherConfig         g_hookCfg;                 // what keys are classified by
+static uint64_t               g_hookVersion = 0;         // of g_config, when g_hookCfg was taken
+static uint64_t               g_hookBindingVersion = 0;  // of g_bindingConfig, when g_bindings got it
+static bool                   g_initiatorHeld = false;
+static bool                   g_winMasked = false;       // for the Win press still held
+static KeyBindingMatcher      g_bindings;
 
-LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam) {
-    if (nCode != HC_ACTION)
-        return CallNextHookEx(g_hHook, nCode, wParam, lParam);
-    auto* kbd = reinterpret_cast<KBDLLHOOKSTRUCT*>(lParam);
-    UINT vk = kbd->vkCode;
-    bool down = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
-    bool up = (wParam == WM_KEYUP || wParam == WM_SYSKEYUP);
-
-    //DebugLog("Event %s vk=0x%02X", down ? "DOWN" : up ? "UP" : "??", vk);
-
-    // --- ALT down: start fresh ---
-    if (down && !g_initiatorDown && IsKey(vk, g_cfg.initiator)) {
-        //DebugLog("→ ALT down");
-        g_initiatorDown = true;
-        g_holdTriggered = false;
-        g_tapCount = 0;
+// worker-thread state
+static SwitcherMachine         g_machine;
+static KeyTraceWriter          g_trace;
+static uint64_t                g_lastKeyNs = 0;   // hook timestamp of the key being handled
+
+// Runs on the worker thread, never inside the hook
+static void RunAction(const SwitcherAction& a) {
+    //DebugLog("→ %s #%d", SwitcherActionName(a.type), a.index);
+    WWS_TRACE_SPAN("decision", g_lastKeyNs, SystemClock().NowNs(), (uint64_t)a.type);
+    switch (a.type) {
+    case SwitcherActionType::HoldStart:
+    case SwitcherActionType::Cycle:
+        WWS_TRACE_LATENCY_BEGIN(TraceLatency_KeyToPresent, g_lastKeyNs);
+        break;
+    case SwitcherActionType::Cancel:
+        // the overlay goes away; a frame for an earlier key may never show
+        WWS_TRACE_LATENCY_CANCEL(TraceLatency_KeyToPresent);
+        break;
+    case SwitcherActionType::Commit:
+        WWS_TRACE_LATENCY_CANCEL(TraceLatency_KeyToPresent);
+        WWS_TRACE_LATENCY_BEGIN(TraceLatency_KeyToForeground, g_lastKeyNs);
+        break;
+    case SwitcherActionType::Tap:
+    case SwitcherActionType::QuickSelect:
+        WWS_TRACE_LATENCY_BEGIN(TraceLatency_KeyToForeground, g_lastKeyNs);
+        break;
+    default:
+        break;
     }
-    // --- SHIFT down: cycle if overlay is already up ---
-    else if (down && g_initiatorDown && IsKey(vk, g_cfg.modifier)) {
-        if (g_holdTriggered) {
-            //DebugLog("→ SHIFT down (cycle)");
-            g_onCycle();
-        }
+    switch (a.type) {
+    case SwitcherActionType::Tap:       g_onTap();       break;
+    case SwitcherActionType::Cycle:     g_onCycle();     break;
+    case SwitcherActionType::Cancel:    g_onCancel();    break;
+    case SwitcherActionType::HoldStart:
+        g_capture = true;
+        g_onHoldStart();
+        break;
+    case SwitcherActionType::Commit:
+        g_capture = false;
+        g_onCommit();
+        break;
+    case SwitcherActionType::QuickSelect:
+        if (WindowId id = GetWindowRegistry().At(a.index))
+            GetActivator().Request(id);
+        break;
     }
-    // --- SHIFT up: either count a tap or show overlay if first long hold ---
-    else if (up && g_initiatorDown && IsKey(vk, g_cfg.modifier)) {
-        auto now = std::chrono::steady_clock::now();
-        auto delta = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now - g_lastShiftUpTime).count();
-        g_lastShiftUpTime = now;
-
-        // first time: decide hold vs. initial tap
-        if (!g_holdTriggered && g_tapCount == 0) {
-            // measure how long the SHIFT was held (approximate)
-            static auto lastShiftDownTime = now;
-            // if you need accurate hold time, capture shift-down time too
-            if (delta > g_cfg.tapTimeoutMs) {
-                //DebugLog("→ initial long hold → onHoldStart");
-                g_holdTriggered = true;
-                g_onHoldStart();
-            }
-            else {
-                g_tapCount = 1;
-                //DebugLog("→ quick-select tap #%d", g_tapCount);
-            }
-        }
-        // after first decision, any further SHIFT-ups always increment taps
-        else if (!g_holdTriggered) {
-            g_tapCount++;
-            //DebugLog("→ quick-select tap #%d", g_tapCount);
-        }
-        // if holdTriggered, ignore shift-ups here (we cycle on shift-down)
+    // whichever way the gesture ended, typing belongs to the app again
+    if (g_machine.State() != SwitcherState::Listing)
+        g_capture = false;
+}
+
+// Keys that type into the overlay filter (lowercase, '\b' for backspace)
+static wchar_t FilterChar(UINT vk) {
+    if (vk >= 'A' && vk <= 'Z')                 return (wchar_t)(L'a' + (vk - 'A'));
+    if (vk >= '0' && vk <= '9')                 return (wchar_t)vk;
+    if (vk >= VK_NUMPAD0 && vk <= VK_NUMPAD9)   return (wchar_t)(L'0' + (vk - VK_NUMPAD0));
+    switch (vk) {
+    case VK_SPACE:      return L' ';
+    case VK_BACK:       return L'\b';
+    case VK_OEM_MINUS:  return L'-';
+    case VK_OEM_PERIOD: return L'.';
     }
-    // --- ALT up: finalize action ---
-    else if (up && g_initiatorDown && IsKey(vk, g_cfg.initiator)) {
-        auto now = std::chrono::steady_clock::now();
-        auto sinceLastShift = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now - g_lastShiftUpTime).count();
-
-        //DebugLog("→ ALT up; holdTriggered=%d tapCount=%d sinceLastShift=%lldms",            (int)g_holdTriggered, g_tapCount, (long long)sinceLastShift);
-
-        // if you tapped but then held ALT beyond overlayTimeout, force overlay
-        if (!g_holdTriggered && g_tapCount > 0 &&
-            sinceLastShift > g_cfg.overlayTimeoutMs)
-        {
-            //DebugLog("→ delayed overlay → onHoldStart");
-            g_holdTriggered = true;
-            g_onHoldStart();
-        }
+    return 0;
+}
+
+// Win held through a chord we swallowed: on its release the shell would
+// open the Start menu as if Win had been tapped alone. An unassigned key
+// in between tells it otherwise. Once per Win press is enough, and keeps
+// SendInput out of the hook for every auto-repeat.
+static void MaskWinKey() {
+    if (g_winMasked)
+        return;
+    g_winMasked = true;
+    INPUT in[2] = {};
+    in[0].type = in[1].type = INPUT_KEYBOARD;
+    in[0].ki.wVk = in[1].ki.wVk = 0xE8;
+    in[1].ki.dwFlags = KEYEVENTF_KEYUP;
+    SendInput(2, in, sizeof(INPUT));
+}
 
-        if (g_holdTriggered) {
-            //DebugLog("→ commit overlay");
-            g_onCommit();
+// The hook only timestamps, classifies and matches bindings; everything
+// else happens on the worker so we stay far away from LowLevelHooksTimeout
+LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam) {
+    WWS_TRACE_SCOPE("hook");
+    if (nCode == HC_ACTION) {
+        auto* kbd = reinterpret_cast<KBDLLHOOKSTRUCT*>(lParam);
+        UINT vk = kbd->vkCode;
+        bool down = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
+        bool up = (wParam == WM_KEYUP || wParam == WM_SYSKEYUP);
+        // pick up new settings between gestures only, or the initiator's
+        // release could be classified by a config that never saw it pressed
+        if (!g_initiatorHeld && g_bindings.Idle()) {
+            if (g_config->Version() != g_hookVersion) {
+                g_hookVersion = g_config->Version();
+                g_hookCfg = *g_hookReader->Get();
+            }
+            if (g_bindingConfig->Version() != g_hookBindingVersion) {
+                g_hookBindingVersion = g_bindingConfig->Version();
+                auto b = g_hookBindingReader->Get();
+                g_bindings.SetBindings(b->set, b->sequenceTimeoutMs);
+            }
         }
-        else if (g_tapCount > 0) {
-            if (g_tapCount == 1) {
-                //DebugLog("→ single tap → onTap");
-                g_onTap();
+        KeyClass cls = SwitcherMachine::Classify((uint16_t)vk, g_hookCfg);
+        if (cls == KeyClass::Initiator && (down || up))
+            g_initiatorHeld = down;
+        if (up && (vk == VK_LWIN || vk == VK_RWIN))
+            g_winMasked = false;
+        const uint64_t now = (down || up) ? SystemClock().NowNs() : 0;
+        if (cls != KeyClass::Other && (down || up))
+            g_keys.Push({ now, (uint16_t)vk, cls, down });
+        if (down || up) {
+            const KeyBindingMatcher::Output m = g_bindings.OnKey((uint16_t)vk, down, now);
+            if (m.result == KeyBindingMatcher::Result::Fire || m.result == KeyBindingMatcher::Result::Release)
+                g_keys.Push({ now, m.command, KeyClass::Binding, m.result == KeyBindingMatcher::Result::Fire });
+            if (m.result == KeyBindingMatcher::Result::Fire || m.result == KeyBindingMatcher::Result::Swallow) {
+                if (down && (g_bindings.Down().Mods() & keymod::Win))
+                    MaskWinKey();
+                return 1;
             }
-            else {
-                //DebugLog("→ multi tap → select #%d", g_tapCount);
-                auto wins = GetOpenWindows();
-                int idx = g_tapCount; // *** +1 from prior logic ***
-                if (idx >= 0 && idx < (int)wins.size()) {
-                    ForceSetForegroundWindow(wins[idx].handle);
-                }
-                else {
-                    //DebugLog("→ index out-of-range");
-                }
+        }
+        // typing while the overlay is up filters it and never reaches the
+        // foreground app (which would otherwise see Alt+letter accelerators)
+        if (cls == KeyClass::Other && g_capture.load(std::memory_order_relaxed)) {
+            if (wchar_t ch = FilterChar(vk)) {
+                if (down) g_onFilterChar(ch);
+                return 1;
             }
         }
-        else {
-            // DebugLog("→ no action → onCancel");
-            g_onCancel();
+    }
+    return CallNextHookEx(g_hHook, nCode, wParam, lParam);
+}
+
+static void WorkerThreadMain() {
+    WWS_TRACE_THREAD("worker");
+    // set WWS_KEY_TRACE=<file> to record a trace for wws_replay
+    char path[MAX_PATH];
+    if (GetEnvironmentVariableA("WWS_KEY_TRACE", path, MAX_PATH))
+        g_trace.Open(path);
+
+    // keys and hold deadlines are both handled here, so the overlay shows
+    // up as soon as the hold threshold passes
+    Published<SwitcherConfig>::Reader config(*g_config);
+    SwitcherScheduler scheduler(g_machine, g_keys, SystemClock(), RunAction);
+    scheduler.SetKeyObserver([&config](const KeyEvent& ev) {
+        g_lastKeyNs = ev.timeNs;
+        // new timeouts apply from the next gesture
+        if (g_machine.State() == SwitcherState::Idle) {
+            auto live = config.Get();
+            if (*live != g_machine.Config())
+                g_machine.SetConfig(*live);
+            // auto-repeat arrives mid-gesture, so this is once per press
+            if (ev.cls == KeyClass::Initiator && ev.down)
+                g_onInitiatorDown();
         }
+        // traces hold keys, not what bindings made of them
+        if (g_trace.IsOpen() && ev.cls != KeyClass::Binding)
+            g_trace.Append(ev);
+    });
+    scheduler.Run();
+    g_trace.Close();
+}
 
-        // reset
-        g_initiatorDown = false;
-        g_holdTriggered = false;
-        g_tapCount = 0;
+// LL hooks are called on the installing thread, which must pump messages
+static void HookThreadMain(std::promise<bool> installed) {
+    WWS_TRACE_THREAD("hook");
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+    Published<SwitcherConfig>::Reader config(*g_config);
+    Published<KeyBindingConfig>::Reader bindings(*g_bindingConfig);
+    g_hookReader = &config;
+    g_hookBindingReader = &bindings;
+    g_hookVersion = g_config->Version();
+    g_hookCfg = *config.Get();
+    g_hookBindingVersion = g_bindingConfig->Version();
+    {
+        auto b = bindings.Get();
+        g_bindings.SetBindings(b->set, b->sequenceTimeoutMs);
     }
-
-    return CallNextHookEx(g_hHook, nCode, wParam, lParam);
+    g_initiatorHeld = false;
+    g_winMasked = false;
+    MSG msg;
+    PeekMessageW(&msg, nullptr, 0, 0, PM_NOREMOVE);   // create the queue
+    g_hHook = SetWindowsHookExW(
+        WH_KEYBOARD_LL, LowLevelKeyboardProc,
+        GetModuleHandle(nullptr), 0
+    );
+    installed.set_value(g_hHook != nullptr);
+    if (!g_hHook) {
+        g_hookReader = nullptr;
+        g_hookBindingReader = nullptr;
+        return;
+    }
+    while (GetMessageW(&msg, nullptr, 0, 0) > 0) {
+        TranslateMessage(&msg);
+        DispatchMessageW(&msg);
+    }
+    UnhookWindowsHookEx(g_hHook);
+    g_hHook = nullptr;
+    g_hookReader = nullptr;
+    g_hookBindingReader = nullptr;
 }
 
-void InstallHook(const HotkeyConfig& cfg,
+bool InstallHook(Published<SwitcherConfig>& config,
+    Published<KeyBindingConfig>& bindings,
     std::function<void()> onTap,
     std::function<void()> onHoldStart,
     std::function<void()> onCycle,
     std::function<void()> onCancel,
-    std::function<void()> onCommit)
+    std::function<void()> onCommit,
+    std::function<void(wchar_t)> onFilterChar,
+    std::function<void()> onInitiatorDown)
 {
-    g_cfg = cfg;
+    g_config = &config;
+    g_bindingConfig = &bindings;
+    g_machine = SwitcherMachine(config.Load());
     g_onTap = std::move(onTap);
     g_onHoldStart = std::move(onHoldStart);
     g_onCycle = std::move(onCycle);
     g_onCancel = std::move(onCancel);
     g_onCommit = std::move(onCommit);
+    g_onFilterChar = std::move(onFilterChar);
+    g_onInitiatorDown = std::move(onInitiatorDown);
+    g_capture = false;
 
-    //DebugLog("Installing hook (Alt=0x%02X, Shift=0x%02X, tapTimeout=%dms, overlayTimeout=%dms)",        cfg.initiator, cfg.modifier, cfg.tapTimeoutMs, cfg.overlayTimeoutMs);
-    g_hHook = SetWindowsHookExW(
-        WH_KEYBOARD_LL, LowLevelKeyboardProc,
-        GetModuleHandle(nullptr), 0
-    );
-    //DebugLog(g_hHook ? "Hook installed" : "Hook FAILED");
+    g_keys.Reopen();
+    g_workerThread = std::thread(WorkerThreadMain);
+
+    std::promise<bool> installed;
+    std::future<bool> ok = installed.get_future();
+    g_hookThread = std::thread(HookThreadMain, std::move(installed));
+    g_hookThreadId = GetThreadId(g_hookThread.native_handle());
+    bool hooked = ok.get();
+    //DebugLog(hooked ? "Hook installed" : "Hook FAILED");
+    if (!hooked)
+        UninstallHook();
+    return hooked;
+}
+
+void EndKeyCapture() {
+    g_capture = false;
 }
 
 void UninstallHook() {
     //DebugLog("Uninstalling hook");
-    if (g_hHook) {
-        UnhookWindowsHookEx(g_hHook);
-        g_hHook = nullptr;
+    if (g_hookThread.joinable()) {
+        PostThreadMessageW(g_hookThreadId, WM_QUIT, 0, 0);
+        g_hookThread.join();
+        g_hookThreadId = 0;
         //DebugLog("Hook removed");
     }
+    g_keys.Close();
+    if (g_workerThread.joinable())
+        g_workerThread.join();
+    g_capture = false;
 }
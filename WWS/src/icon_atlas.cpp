@@ -0,0 +1,442 @@
+﻿// === src/icon_atlas.cpp ===
+#include "icon_atlas.h"
+#include "fetch_pool.h"
+#include "imgui_internal.h"    // RegisterUserTexture
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+// Our own (static) copy; imgui_draw.cpp keeps its copy static as well
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imstb_rectpack.h"
+
+// Gutter right/below every icon so linear filtering never bleeds neighbours
+static constexpr int kPad = 1;
+
+struct IconAtlas::Packer {
+    stbrp_context           ctx;
+    std::vector<stbrp_node> nodes;
+};
+
+struct IconAtlas::Inbox {
+    std::mutex                                   mutex;
+    std::vector<std::pair<std::wstring, Loaded>> done;
+    std::function<void()>                        onLoad;
+};
+
+IconAtlas::IconAtlas(int iconSize, int width, int height)
+    : m_inbox(std::make_shared<Inbox>()), m_iconSize(iconSize), m_packer(new Packer)
+{
+    m_tex.Create(ImTextureFormat_RGBA32, width, height);
+    m_stats.uploadBytes += (size_t)m_tex.GetSizeInBytes();
+    ResetPacker(*m_packer);
+}
+
+IconAtlas::~IconAtlas() {
+    if (ImGui::GetCurrentContext())
+        Detach();
+}
+
+void IconAtlas::Attach() {
+    if (m_attached)
+        return;
+    ImGui::RegisterUserTexture(&m_tex);
+    m_attached = true;
+}
+
+void IconAtlas::Detach() {
+    if (!m_attached)
+        return;
+    ImGui::UnregisterUserTexture(&m_tex);
+    m_attached = false;
+}
+
+void IconAtlas::SetUpdateCallback(std::function<void()> fn) {
+    std::lock_guard<std::mutex> lock(m_inbox->mutex);
+    m_inbox->onLoad = std::move(fn);
+}
+
+void IconAtlas::NewFrame() {
+    ++m_frame;
+    m_loadsThisFrame = 0;
+    m_pending = false;
+    {
+        // what the workers extracted since last frame; packed as rows ask for it
+        std::lock_guard<std::mutex> lock(m_inbox->mutex);
+        for (auto& d : m_inbox->done) {
+            m_loading.erase(d.first);
+            m_loaded[std::move(d.first)] = std::move(d.second);
+            ++m_stats.loads;
+        }
+        m_inbox->done.clear();
+    }
+    if (m_tex.Status == ImTextureStatus_OK) {
+        // the backend has consumed last frame's uploads
+        m_tex.Updates.resize(0);
+        m_tex.UpdateRect.x = m_tex.UpdateRect.y = (unsigned short)~0;
+        m_tex.UpdateRect.w = m_tex.UpdateRect.h = 0;
+    }
+    else if (m_tex.Status == ImTextureStatus_Destroyed) {
+        // backend was torn down (device lost, shutdown); we still have the pixels
+        m_tex.Updates.resize(0);
+        m_tex.SetStatus(ImTextureStatus_WantCreate);
+        m_stats.uploadBytes += (size_t)m_tex.GetSizeInBytes();
+    }
+}
+
+bool IconAtlas::Get(const std::wstring& exePath, ImVec2& uv0, ImVec2& uv1) {
+    auto it = m_entries.find(exePath);
+    if (it == m_entries.end()) {
+        if (!m_provider)
+            return false;
+        bool ok;
+        if (m_loader) {
+            auto done = m_loaded.find(exePath);
+            if (done == m_loaded.end()) {
+                if (m_loading.insert(exePath).second)
+                    Submit(exePath);
+                return false;
+            }
+            ok = done->second.ok;
+            std::swap(m_scratch, done->second.image);
+            m_loaded.erase(done);
+        }
+        else {
+            if (m_loadsThisFrame >= m_loadBudget) {
+                m_pending = true;
+                return false;
+            }
+            ++m_loadsThisFrame;
+            ++m_stats.loads;
+            m_scratch.rgba.clear();
+            ok = m_provider->Load(exePath, m_iconSize, m_scratch);
+        }
+
+        ok = ok && m_scratch.width > 0 && m_scratch.height > 0 &&
+                  m_scratch.width + kPad <= m_tex.Width && m_scratch.height + kPad <= m_tex.Height &&
+                  m_scratch.rgba.size() >= (size_t)m_scratch.width * m_scratch.height;
+        it = m_entries.emplace(exePath, Entry()).first;
+        Entry& e = it->second;
+        e.lastUsed = m_frame;   // in use: a repack for its room keeps it
+        // no room even after evicting: keep the pixels and try again later
+        if (ok && !Place(e, m_scratch))
+            Wait(e, m_scratch);
+    }
+
+    Entry& e = it->second;
+    e.lastUsed = m_frame;
+    if (!e.placed && e.waiting && m_frame >= e.retryFrame) {
+        if (Place(e, *e.waiting))
+            e.waiting.reset();
+        else
+            Wait(e, *e.waiting);
+    }
+    if (!e.placed)
+        return false;
+    const float iw = 1.0f / (float)m_tex.Width;
+    const float ih = 1.0f / (float)m_tex.Height;
+    uv0 = ImVec2((float)e.x * iw, (float)e.y * ih);
+    uv1 = ImVec2((float)(e.x + e.w) * iw, (float)(e.y + e.h) * ih);
+    return true;
+}
+
+IconAtlas::Stats IconAtlas::GetStats() const {
+    Stats s = m_stats;
+    s.entries = 0;
+    for (const auto& kv : m_entries)
+        s.entries += kv.second.placed;
+    s.density = (float)m_usedPixels / (float)(m_tex.Width * m_tex.Height);
+    return s;
+}
+
+bool IconAtlas::Place(Entry& e, const IconImage& img) {
+    int x, y;
+    if (!Pack(img.width, img.height, x, y)) {
+        Repack(img.width, img.height);
+        if (!Pack(img.width, img.height, x, y))
+            return false;
+    }
+    e.x = x;
+    e.y = y;
+    e.w = img.width;
+    e.h = img.height;
+    e.placed = true;
+    Blit(e, img.rgba.data());
+    QueueUpload(e);
+    m_usedPixels += (size_t)e.w * e.h;
+    return true;
+}
+
+void IconAtlas::Wait(Entry& e, IconImage& img) {
+    if (!e.waiting)
+        e.waiting.reset(new IconImage(std::move(img)));
+    e.failures = std::min(e.failures + 1, kMaxBackoff);
+    e.retryFrame = m_frame + (1ull << e.failures);
+}
+
+bool IconAtlas::Pack(int w, int h, int& x, int& y) {
+    stbrp_rect r{};
+    r.w = w + kPad;
+    r.h = h + kPad;
+    stbrp_pack_rects(&m_packer->ctx, &r, 1);
+    if (!r.was_packed)
+        return false;
+    x = r.x;
+    y = r.y;
+    return true;
+}
+
+void IconAtlas::ResetPacker(Packer& packer) const {
+    packer.nodes.resize((size_t)m_tex.Width);
+    stbrp_init_target(&packer.ctx, m_tex.Width, m_tex.Height,
+                      packer.nodes.data(), (int)packer.nodes.size());
+}
+
+// The skyline packer can't free single rects: drop the least recently drawn
+// icons until there's comfortable room, then pack the survivors again. The
+// new layout is built on a packer of its own, the icons drawn this frame
+// first, and only used if it holds all of them; otherwise nothing changes.
+void IconAtlas::Repack(int needW, int needH) {
+    std::vector<std::pair<const std::wstring*, Entry*>> placed;
+    for (auto& kv : m_entries)
+        if (kv.second.placed)
+            placed.emplace_back(&kv.first, &kv.second);
+    std::sort(placed.begin(), placed.end(), [](const auto& a, const auto& b) {
+        return a.second->lastUsed < b.second->lastUsed;
+    });
+
+    auto padded = [](const Entry& e) { return (size_t)(e.w + kPad) * (e.h + kPad); };
+    size_t keptArea = (size_t)(needW + kPad) * (needH + kPad);
+    for (const auto& p : placed)
+        keptArea += padded(*p.second);
+    // skyline packing wastes some space; aim for a quarter of the atlas free
+    const size_t target = (size_t)m_tex.Width * m_tex.Height * 3 / 4;
+    std::vector<const std::wstring*> evict;
+    size_t first = 0;
+    for (; first < placed.size() && keptArea > target; ++first) {
+        if (placed[first].second->lastUsed == m_frame)
+            break;   // everything from here on is on screen
+        keptArea -= padded(*placed[first].second);
+        evict.push_back(placed[first].first);
+    }
+
+    // on screen first, so the rest only get what they leave
+    std::vector<stbrp_rect> rects;
+    rects.reserve(placed.size() - first);
+    size_t pinned = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t i = first; i < placed.size(); ++i) {
+            const Entry& e = *placed[i].second;
+            if ((e.lastUsed == m_frame) != (pass == 0))
+                continue;
+            stbrp_rect r{};
+            r.id = (int)i;
+            r.w = e.w + kPad;
+            r.h = e.h + kPad;
+            rects.push_back(r);
+        }
+        if (pass == 0)
+            pinned = rects.size();
+    }
+    std::unique_ptr<Packer> next(new Packer);
+    ResetPacker(*next);
+    if (pinned)
+        stbrp_pack_rects(&next->ctx, rects.data(), (int)pinned);
+    for (size_t i = 0; i < pinned; ++i)
+        if (!rects[i].was_packed)
+            return;   // they fit where they are; leave them there
+    if (rects.size() > pinned)
+        stbrp_pack_rects(&next->ctx, rects.data() + pinned, (int)(rects.size() - pinned));
+
+    // survivors' pixels, before anything moves
+    std::vector<uint32_t> pixels;
+    for (const stbrp_rect& r : rects) {
+        const Entry& e = *placed[(size_t)r.id].second;
+        for (int row = 0; row < e.h; ++row) {
+            const uint32_t* src = (const uint32_t*)m_tex.GetPixelsAt(e.x, e.y + row);
+            pixels.insert(pixels.end(), src, src + e.w);
+        }
+    }
+
+    m_packer = std::move(next);
+    const uint32_t* src = pixels.data();
+    for (const stbrp_rect& r : rects) {
+        Entry& e = *placed[(size_t)r.id].second;
+        const uint32_t* mine = src;
+        src += (size_t)e.w * e.h;
+        if (!r.was_packed) {
+            evict.push_back(placed[(size_t)r.id].first);
+            continue;
+        }
+        if (r.x == e.x && r.y == e.y)
+            continue;   // same spot, pixels and GPU copy are still right
+        e.x = r.x;
+        e.y = r.y;
+        Blit(e, mine);
+        QueueUpload(e);
+    }
+
+    // exes with nothing in the atlas go with the icons last drawn when they were
+    if (first > 0) {
+        const uint64_t cutoff = placed[first - 1].second->lastUsed;
+        for (auto& kv : m_entries)
+            if (!kv.second.placed && kv.second.lastUsed <= cutoff)
+                evict.push_back(&kv.first);
+    }
+    for (const std::wstring* key : evict) {
+        auto it = m_entries.find(*key);
+        if (it->second.placed)
+            m_usedPixels -= (size_t)it->second.w * it->second.h;
+        m_entries.erase(it);
+    }
+    m_stats.evictions += evict.size();
+    ++m_stats.repacks;
+}
+
+void IconAtlas::Blit(const Entry& e, const uint32_t* src) {
+    for (int row = 0; row < e.h; ++row)
+        memcpy(m_tex.GetPixelsAt(e.x, e.y + row), src + (size_t)row * e.w, (size_t)e.w * 4);
+}
+
+void IconAtlas::QueueUpload(const Entry& e) {
+    if (QueueTextureUpload(m_tex, e.x, e.y, e.w, e.h)) {
+        ++m_stats.uploadRects;
+        m_stats.uploadBytes += (size_t)e.w * e.h * 4;
+    }
+}
+
+bool QueueTextureUpload(ImTextureData& tex, int x, int y, int w, int h) {
+    ImTextureRect req = { (unsigned short)x, (unsigned short)y, (unsigned short)w, (unsigned short)h };
+    ImTextureRect& u = tex.UpdateRect;
+    int x1 = std::max(u.w == 0 ? 0 : u.x + u.w, req.x + req.w);
+    int y1 = std::max(u.h == 0 ? 0 : u.y + u.h, req.y + req.h);
+    u.x = std::min(u.x, req.x);
+    u.y = std::min(u.y, req.y);
+    u.w = (unsigned short)(x1 - u.x);
+    u.h = (unsigned short)(y1 - u.y);
+    ImTextureRect& used = tex.UsedRect;
+    int ux1 = std::max(used.x + used.w, req.x + req.w);
+    int uy1 = std::max(used.y + used.h, req.y + req.h);
+    used.x = std::min(used.x, req.x);
+    used.y = std::min(used.y, req.y);
+    used.w = (unsigned short)(ux1 - used.x);
+    used.h = (unsigned short)(uy1 - used.y);
+
+    // a pending create uploads everything anyway
+    if (tex.Status != ImTextureStatus_OK && tex.Status != ImTextureStatus_WantUpdates)
+        return false;
+    tex.SetStatus(ImTextureStatus_WantUpdates);
+    tex.Updates.push_back(req);
+    return true;
+}
+
+void IconAtlas::Submit(const std::wstring& exePath) {
+    m_loader->Submit([inbox = m_inbox, provider = m_provider, exePath, size = m_iconSize] {
+        Loaded l;
+        l.ok = provider->Load(exePath, size, l.image);
+        std::function<void()> fn;
+        {
+            std::lock_guard<std::mutex> lock(inbox->mutex);
+            inbox->done.emplace_back(exePath, std::move(l));
+            fn = inbox->onLoad;
+        }
+        if (fn)
+            fn();
+    });
+}
+
+// --- fake provider ---
+
+void FakeIconProvider::SetMissing(const std::wstring& exePath) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_missing.push_back(exePath);
+}
+
+void FakeIconProvider::SetDelay(const std::wstring& exePath, int ms) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_delays[exePath] = ms;
+}
+
+void FakeIconProvider::Hang(const std::wstring& exePath) {
+    SetDelay(exePath, -1);
+}
+
+void FakeIconProvider::Release() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_delays.begin(); it != m_delays.end();)
+            it = it->second < 0 ? m_delays.erase(it) : std::next(it);
+    }
+    m_released.notify_all();
+}
+
+size_t FakeIconProvider::Loads() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_loads;
+}
+
+bool FakeIconProvider::Load(const std::wstring& exePath, int size, IconImage& out) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    ++m_loads;
+    auto d = m_delays.find(exePath);
+    const int ms = d == m_delays.end() ? 0 : d->second;
+    if (ms < 0) {
+        m_released.wait(lock, [&] {
+            auto it = m_delays.find(exePath);
+            return it == m_delays.end() || it->second >= 0;
+        });
+    }
+    else if (ms > 0) {
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+        lock.lock();
+    }
+    if (std::find(m_missing.begin(), m_missing.end(), exePath) != m_missing.end())
+        return false;
+    uint32_t colour = (uint32_t)std::hash<std::wstring>()(exePath) | 0xFF000000u;
+    out.width = size;
+    out.height = size;
+    out.rgba.assign((size_t)size * size, colour);
+    return true;
+}
+
+// --- null renderer ---
+
+void NullTextureRenderer::Init() {
+    ImGuiIO& io = ImGui::GetIO();
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasTextures;
+    if (!io.BackendRendererName)
+        io.BackendRendererName = "null";
+}
+
+void NullTextureRenderer::Update() {
+    for (ImTextureData* tex : ImGui::GetPlatformIO().Textures) {
+        switch (tex->Status) {
+        case ImTextureStatus_WantCreate:
+            ++m_creates;
+            m_bytes += (size_t)tex->GetSizeInBytes();
+            tex->SetTexID((ImTextureID)m_nextId++);
+            tex->SetStatus(ImTextureStatus_OK);
+            break;
+        case ImTextureStatus_WantUpdates:
+            for (const ImTextureRect& r : tex->Updates) {
+                ++m_rects;
+                m_bytes += (size_t)r.w * r.h * tex->BytesPerPixel;
+            }
+            tex->SetStatus(ImTextureStatus_OK);
+            break;
+        case ImTextureStatus_WantDestroy:
+            if (tex->UnusedFrames > 0) {
+                tex->SetTexID(ImTextureID_Invalid);
+                tex->SetStatus(ImTextureStatus_Destroyed);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
@@ -0,0 +1,316 @@
+﻿// === src/key_bindings.cpp ===
+#include "key_bindings.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <map>
+
+const char* BindingActionName(BindingAction action) {
+    switch (action) {
+    case BindingAction::Select:  return "select";
+    case BindingAction::Overlay: return "overlay";
+    }
+    return "?";
+}
+
+bool operator==(const KeyBinding& a, const KeyBinding& b) {
+    return a.keys == b.keys && a.action == b.action && a.index == b.index;
+}
+
+// --- key names ---
+
+// Virtual-key codes by the name used in "keys"; the first name of a code
+// is the one written back
+struct KeyName {
+    const char* name;
+    uint8_t     vk;
+};
+static const KeyName keyNames[] = {
+    { "Tab", 0x09 }, { "Enter", 0x0D }, { "Esc", 0x1B }, { "Escape", 0x1B }, { "Space", 0x20 },
+    { "Backspace", 0x08 }, { "Pause", 0x13 }, { "PageUp", 0x21 }, { "PageDown", 0x22 },
+    { "End", 0x23 }, { "Home", 0x24 }, { "Left", 0x25 }, { "Up", 0x26 }, { "Right", 0x27 },
+    { "Down", 0x28 }, { "PrintScreen", 0x2C }, { "Insert", 0x2D }, { "Delete", 0x2E },
+    { ";", 0xBA }, { "=", 0xBB }, { ",", 0xBC }, { "-", 0xBD }, { ".", 0xBE }, { "/", 0xBF },
+    { "`", 0xC0 }, { "[", 0xDB }, { "\\", 0xDC }, { "]", 0xDD }, { "'", 0xDE },
+};
+
+// Modifier names; the vk is what IsModifierKey() knows them by
+struct ModName {
+    const char* name;
+    uint8_t     mod;
+};
+static const ModName modNames[] = {
+    { "Ctrl", keymod::Ctrl }, { "Control", keymod::Ctrl }, { "Shift", keymod::Shift },
+    { "Alt", keymod::Alt }, { "Win", keymod::Win },
+};
+
+static bool SameName(const std::string& a, const char* b) {
+    size_t i = 0;
+    for (; i < a.size() && b[i]; ++i)
+        if (std::tolower((unsigned char)a[i]) != std::tolower((unsigned char)b[i]))
+            return false;
+    return i == a.size() && !b[i];
+}
+
+static bool KeyFromText(const std::string& name, uint8_t& vk) {
+    if (name.size() == 1 && std::isalnum((unsigned char)name[0])) {
+        vk = (uint8_t)std::toupper((unsigned char)name[0]);   // 'A'..'Z', '0'..'9'
+        return true;
+    }
+    int n = 0;
+    if ((name[0] == 'F' || name[0] == 'f') && std::sscanf(name.c_str() + 1, "%d", &n) == 1 &&
+        n >= 1 && n <= 24 && name == name.substr(0, 1) + std::to_string(n)) {
+        vk = (uint8_t)(0x6F + n);
+        return true;
+    }
+    if (name.size() == 4 && SameName(name.substr(0, 3), "Num") && std::isdigit((unsigned char)name[3])) {
+        vk = (uint8_t)(0x60 + (name[3] - '0'));
+        return true;
+    }
+    for (const KeyName& k : keyNames)
+        if (SameName(name, k.name)) {
+            vk = k.vk;
+            return true;
+        }
+    return false;
+}
+
+static std::string TextFromKey(uint8_t vk) {
+    if ((vk >= 'A' && vk <= 'Z') || (vk >= '0' && vk <= '9'))
+        return std::string(1, (char)vk);
+    if (vk >= 0x70 && vk <= 0x87)
+        return "F" + std::to_string(vk - 0x6F);
+    if (vk >= 0x60 && vk <= 0x69)
+        return "Num" + std::to_string(vk - 0x60);
+    for (const KeyName& k : keyNames)
+        if (k.vk == vk)
+            return k.name;
+    return "?";
+}
+
+static std::string Trim(const std::string& s) {
+    size_t b = 0, e = s.size();
+    while (b < e && std::isspace((unsigned char)s[b])) ++b;
+    while (e > b && std::isspace((unsigned char)s[e - 1])) --e;
+    return s.substr(b, e - b);
+}
+
+bool ParseKeys(const std::string& text, std::vector<KeyChord>& out) {
+    out.clear();
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find(',', start);
+        if (end == std::string::npos) end = text.size();
+        const std::string step = text.substr(start, end - start);
+        start = end + 1;
+
+        KeyChord chord;
+        size_t from = 0;
+        for (;;) {
+            const size_t plus = step.find('+', from);
+            const std::string name = Trim(step.substr(from, plus == std::string::npos ? std::string::npos : plus - from));
+            if (name.empty())
+                return false;
+            if (plus == std::string::npos) {
+                if (!KeyFromText(name, chord.vk))
+                    return false;
+                break;
+            }
+            const ModName* mod = nullptr;
+            for (const ModName& m : modNames)
+                if (SameName(name, m.name))
+                    mod = &m;
+            if (!mod)
+                return false;
+            chord.mods |= mod->mod;
+            from = plus + 1;
+        }
+        out.push_back(chord);
+    }
+    return !out.empty();
+}
+
+std::string FormatKeys(const std::vector<KeyChord>& keys) {
+    std::string s;
+    for (const KeyChord& c : keys) {
+        if (!s.empty())
+            s += ", ";
+        if (c.mods & keymod::Ctrl)  s += "Ctrl+";
+        if (c.mods & keymod::Shift) s += "Shift+";
+        if (c.mods & keymod::Alt)   s += "Alt+";
+        if (c.mods & keymod::Win)   s += "Win+";
+        s += TextFromKey(c.vk);
+    }
+    return s;
+}
+
+bool IsModifierKey(uint8_t vk) {
+    switch (vk) {
+    case 0x10: case 0x11: case 0x12:              // Shift, Control, Menu
+    case 0x5B: case 0x5C:                         // LWin, RWin
+    case 0xA0: case 0xA1: case 0xA2: case 0xA3: case 0xA4: case 0xA5:
+        return true;
+    }
+    return false;
+}
+
+uint8_t KeyBits::Mods() const {
+    // generic codes live in word 0, the windows keys in word 1, the sided ones in word 2
+    const uint64_t w0 = m_words[0] >> 0x10, w1 = m_words[1] >> (0x5B - 64), w2 = m_words[2] >> (0xA0 - 128);
+    uint8_t mods = 0;
+    if ((w0 & 0x2) || (w2 & 0xC))  mods |= keymod::Ctrl;
+    if ((w0 & 0x1) || (w2 & 0x3))  mods |= keymod::Shift;
+    if ((w0 & 0x4) || (w2 & 0x30)) mods |= keymod::Alt;
+    if (w1 & 0x3)                  mods |= keymod::Win;
+    return mods;
+}
+
+// --- compiled set ---
+
+static bool Usable(const KeyBinding& b) {
+    if (b.keys.empty() || b.index < 0 || b.index > 0xFF)
+        return false;
+    for (const KeyChord& c : b.keys)
+        if (c.vk == 0 || IsModifierKey(c.vk) || c.mods >= keymod::kCombinations)
+            return false;
+    // an overlay binding ends when its modifiers come up, so it needs some
+    return b.action != BindingAction::Overlay || b.keys.back().mods != 0;
+}
+
+KeyBindingSet::KeyBindingSet(std::vector<KeyBinding> bindings) {
+    // the trie while building: children per node, by EdgeKey
+    std::vector<std::map<uint16_t, uint32_t>> children(1);
+    m_command.assign(1, kNoCommand);
+    for (KeyBinding& b : bindings) {
+        if (!Usable(b)) {
+            ++m_dropped;
+            continue;
+        }
+        // follow the chords as far as the trie has them: passing another
+        // binding's end, or ending where others continue, is a conflict
+        uint32_t node = 0;
+        size_t step = 0;
+        bool conflict = false;
+        for (; step < b.keys.size(); ++step) {
+            const auto it = children[node].find(EdgeKey(b.keys[step].mods, b.keys[step].vk));
+            if (it == children[node].end())
+                break;
+            node = it->second;
+            if (m_command[node] != kNoCommand) {
+                conflict = true;
+                break;
+            }
+        }
+        if (conflict || step == b.keys.size()) {
+            ++m_dropped;
+            continue;
+        }
+        for (; step < b.keys.size(); ++step) {
+            const uint32_t next = (uint32_t)children.size();
+            children.emplace_back();
+            m_command.push_back(kNoCommand);
+            children[node][EdgeKey(b.keys[step].mods, b.keys[step].vk)] = next;
+            node = next;
+        }
+        m_command[node] = PackBinding(b.action, b.index);
+        for (const KeyChord& c : b.keys)
+            m_triggers.Set(c.vk);
+        m_bindings.push_back(std::move(b));
+    }
+
+    m_root.assign(256 * keymod::kCombinations, kNone);
+    for (const auto& e : children[0])
+        m_root[e.first] = e.second;
+    m_edgeStart.assign(children.size() + 1, 0);
+    for (size_t n = 1; n < children.size(); ++n) {
+        m_edgeStart[n] = (uint32_t)m_edges.size();
+        m_edges.insert(m_edges.end(), children[n].begin(), children[n].end());
+    }
+    m_edgeStart[children.size()] = (uint32_t)m_edges.size();
+}
+
+uint32_t KeyBindingSet::Next(uint32_t node, uint8_t mods, uint8_t vk) const {
+    const uint16_t key = EdgeKey(mods, vk);
+    if (node == 0)
+        return m_root[key];
+    const auto first = m_edges.begin() + m_edgeStart[node];
+    const auto last = m_edges.begin() + m_edgeStart[node + 1];
+    const auto it = std::lower_bound(first, last, key,
+                                     [](const std::pair<uint16_t, uint32_t>& e, uint16_t k) { return e.first < k; });
+    return (it != last && it->first == key) ? it->second : kNone;
+}
+
+// --- matcher ---
+
+void KeyBindingMatcher::SetBindings(std::shared_ptr<const KeyBindingSet> set, int sequenceTimeoutMs) {
+    m_set = (set && !set->Empty()) ? std::move(set) : nullptr;
+    m_timeoutNs = (uint64_t)std::max(sequenceTimeoutMs, 0) * 1000000;
+    m_node = KeyBindingSet::kNone;
+    m_holding = false;
+}
+
+KeyBindingMatcher::Output KeyBindingMatcher::OnKey(uint16_t vk16, bool down, uint64_t timeNs) {
+    if (vk16 > 0xFF)
+        return { Result::Pass, 0 };
+    const uint8_t vk = (uint8_t)vk16;
+
+    if (!down) {
+        m_down.Clear(vk);
+        if (m_swallowed.Test(vk)) {
+            m_swallowed.Clear(vk);
+            return { Result::Swallow, 0 };
+        }
+        if (m_holding && (m_down.Mods() & m_holdMods) == 0) {
+            m_holding = false;
+            return { Result::Release, m_holdCommand };
+        }
+        return { Result::Pass, 0 };
+    }
+
+    m_down.Set(vk);
+    if (m_swallowed.Test(vk)) {
+        // auto-repeat: holding the overlay chord's key keeps cycling
+        if (m_holding && vk == m_holdVk)
+            return { Result::Fire, m_holdCommand };
+        return { Result::Swallow, 0 };
+    }
+    // the common case: a key no binding ends with
+    if (!m_set || !m_set->IsTrigger(vk)) {
+        if (m_node != KeyBindingSet::kNone && !IsModifierKey(vk))
+            m_node = KeyBindingSet::kNone;
+        return { Result::Pass, 0 };
+    }
+
+    const uint8_t mods = m_down.Mods();
+    if (m_holding && vk == m_holdVk && (mods & m_holdMods) == m_holdMods) {
+        m_swallowed.Set(vk);
+        return { Result::Fire, m_holdCommand };
+    }
+    if (m_node != KeyBindingSet::kNone && timeNs > m_nodeNs + m_timeoutNs)
+        m_node = KeyBindingSet::kNone;
+    uint32_t next = m_set->Next(m_node, mods, vk);
+    if (next == KeyBindingSet::kNone && m_node != KeyBindingSet::kNone) {
+        // a sequence broken off; the key may still start something
+        m_node = KeyBindingSet::kNone;
+        next = m_set->Next(m_node, mods, vk);
+    }
+    if (next == KeyBindingSet::kNone)
+        return { Result::Pass, 0 };
+
+    m_swallowed.Set(vk);
+    const uint16_t command = m_set->Command(next);
+    if (command == KeyBindingSet::kNoCommand) {
+        m_node = next;
+        m_nodeNs = timeNs;
+        return { Result::Swallow, 0 };
+    }
+    m_node = KeyBindingSet::kNone;
+    if (BindingActionOf(command) == BindingAction::Overlay) {
+        m_holding = true;
+        m_holdMods = mods;
+        m_holdVk = vk;
+        m_holdCommand = command;
+    }
+    return { Result::Fire, command };
+}
@@ -0,0 +1,64 @@
+﻿// === src/key_channel.cpp ===
+#include "key_channel.h"
+
+#include <chrono>
+
+bool KeyEventChannel::Push(const KeyEvent& ev) {
+    if (!m_queue.TryPush(ev)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    // pairs with the fence in Pop(): either we see the worker waiting, or
+    // it sees our item before going to sleep
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waiting.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cv.notify_one();
+    }
+    return true;
+}
+
+bool KeyEventChannel::Pop(KeyEvent& out) {
+    return WaitPop(out, kNoTimeout) == PopResult::Event;
+}
+
+KeyEventChannel::PopResult KeyEventChannel::WaitPop(KeyEvent& out, uint64_t timeoutNs) {
+    if (m_queue.TryPop(out))
+        return PopResult::Event;
+    if (timeoutNs == 0)
+        return m_closed.load(std::memory_order_acquire) ? PopResult::Closed : PopResult::Timeout;
+
+    auto until = std::chrono::steady_clock::now() +
+        std::chrono::nanoseconds(timeoutNs == kNoTimeout ? 0 : timeoutNs);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_waiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    PopResult r = PopResult::Event;
+    while (!m_queue.TryPop(out)) {
+        if (m_closed.load(std::memory_order_acquire)) {
+            r = PopResult::Closed;
+            break;
+        }
+        if (timeoutNs == kNoTimeout) {
+            m_cv.wait(lock);
+        }
+        else if (m_cv.wait_until(lock, until) == std::cv_status::timeout) {
+            if (!m_queue.TryPop(out))
+                r = PopResult::Timeout;
+            break;
+        }
+    }
+    m_waiting.store(false, std::memory_order_relaxed);
+    return r;
+}
+
+void KeyEventChannel::Close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_closed.store(true, std::memory_order_release);
+    m_cv.notify_all();
+}
+
+void KeyEventChannel::Reopen() {
+    m_closed.store(false, std::memory_order_release);
+}
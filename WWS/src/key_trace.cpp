@@ -0,0 +1,160 @@
+﻿// === src/key_trace.cpp ===
+#include "key_trace.h"
+#include "switcher.h"   // vk::
+
+#include <cstring>
+#include <random>
+
+static const char kMagic[8] = { 'W', 'W', 'S', 'K', 'E', 'Y', 'S', '\0' };
+
+static KeyTraceHeader MakeHeader(uint64_t count) {
+    KeyTraceHeader h{};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kKeyTraceVersion;
+    h.recordSize = sizeof(KeyTraceRecord);
+    h.count = count;
+    return h;
+}
+
+static KeyTraceRecord MakeRecord(const KeyEvent& ev) {
+    KeyTraceRecord r{};
+    r.timeNs = ev.timeNs;
+    r.vk = ev.vk;
+    r.down = ev.down ? 1 : 0;
+    return r;
+}
+
+bool WriteKeyTrace(const std::string& path, const std::vector<KeyEvent>& events) {
+    KeyTraceWriter w;
+    if (!w.Open(path))
+        return false;
+    for (const auto& ev : events)
+        w.Append(ev);
+    w.Close();
+    return true;
+}
+
+bool ReadKeyTrace(const std::string& path, std::vector<KeyEvent>& events) {
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f)
+        return false;
+
+    KeyTraceHeader h{};
+    bool ok = std::fread(&h, sizeof(h), 1, f) == 1 &&
+              std::memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 &&
+              h.version == kKeyTraceVersion &&
+              h.recordSize == sizeof(KeyTraceRecord);
+    if (ok) {
+        std::vector<KeyTraceRecord> records((size_t)h.count);
+        ok = records.empty() ||
+             std::fread(records.data(), sizeof(KeyTraceRecord), records.size(), f) == records.size();
+        if (ok) {
+            events.clear();
+            events.reserve(records.size());
+            for (const auto& r : records)
+                events.push_back({ r.timeNs, r.vk, KeyClass::Other, r.down != 0 });
+        }
+    }
+    std::fclose(f);
+    return ok;
+}
+
+bool KeyTraceWriter::Open(const std::string& path) {
+    Close();
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file)
+        return false;
+    m_count = 0;
+    KeyTraceHeader h = MakeHeader(0);
+    std::fwrite(&h, sizeof(h), 1, m_file);
+    m_buffer.reserve(4096);
+    return true;
+}
+
+void KeyTraceWriter::Append(const KeyEvent& ev) {
+    if (!m_file)
+        return;
+    m_buffer.push_back(MakeRecord(ev));
+    if (m_buffer.size() == m_buffer.capacity())
+        Flush();
+}
+
+void KeyTraceWriter::Close() {
+    if (!m_file)
+        return;
+    Flush();
+    KeyTraceHeader h = MakeHeader(m_count);
+    std::fseek(m_file, 0, SEEK_SET);
+    std::fwrite(&h, sizeof(h), 1, m_file);
+    std::fclose(m_file);
+    m_file = nullptr;
+}
+
+void KeyTraceWriter::Flush() {
+    if (!m_buffer.empty())
+        std::fwrite(m_buffer.data(), sizeof(KeyTraceRecord), m_buffer.size(), m_file);
+    m_count += m_buffer.size();
+    m_buffer.clear();
+}
+
+// --- synthetic traces ---
+
+static constexpr uint64_t kMs = 1000000;
+
+namespace {
+struct TraceBuilder {
+    std::vector<KeyEvent> events;
+    uint64_t              now = kMs;
+
+    void Key(uint16_t key, bool down, uint64_t afterMs) {
+        now += afterMs * kMs;
+        events.push_back({ now, key, KeyClass::Other, down });
+    }
+};
+}
+
+std::vector<KeyEvent> GenerateKeyTrace(size_t count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    auto ms = [&](int lo, int hi) { return (uint64_t)std::uniform_int_distribution<int>(lo, hi)(rng); };
+    TraceBuilder b;
+    while (b.events.size() < count) {
+        b.Key(vk::LMenu, true, ms(200, 3000));
+        switch (ms(0, 5)) {
+        case 0:   // cancel
+            break;
+        case 1:   // single tap
+        case 2:   // quick-select
+        {
+            uint64_t taps = (ms(0, 5) == 2) ? ms(2, 6) : 1;
+            for (uint64_t i = 0; i < taps; ++i) {
+                b.Key(vk::LShift, true, ms(20, 120));
+                b.Key(vk::LShift, false, ms(30, 150));
+            }
+            break;
+        }
+        case 3:   // tap, then keep holding the initiator
+            b.Key(vk::LShift, true, ms(20, 120));
+            b.Key(vk::LShift, false, ms(30, 150));
+            b.now += ms(300, 900) * kMs;
+            break;
+        case 4:   // hold and cycle
+        {
+            b.Key(vk::LShift, true, ms(20, 120));
+            b.Key(vk::LShift, false, ms(250, 800));
+            uint64_t cycles = ms(0, 8);
+            for (uint64_t i = 0; i < cycles; ++i) {
+                b.Key(vk::LShift, true, ms(60, 250));
+                b.Key(vk::LShift, false, ms(40, 120));
+            }
+            break;
+        }
+        default:  // unrelated typing with the initiator down
+            b.Key('A', true, ms(20, 120));
+            b.Key('A', false, ms(30, 80));
+            break;
+        }
+        b.Key(vk::LMenu, false, ms(20, 200));
+    }
+    b.events.resize(count);
+    return b.events;
+}
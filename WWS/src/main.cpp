@@ -2,7 +2,15 @@
 #include "hook.h"
 #include "gui.h"
 #include "win_enum.h"
+#include "window_registry.h"
+#include "activator.h"
+#include "frame_scheduler.h"
+#include "process_cache.h"
+#include "frecency_store.h"
+#include "settings.h"
+#include "control_server.h"
 #include <windows.h>
+#include <cstdio>
 #include <exception>
 
 inline void DebugLog(const char* msg) {
@@ -11,6 +19,20 @@ inline void DebugLog(const char* msg) {
     OutputDebugStringA("\n");
 }
 
+// Control requests arrive on the endpoint's threads; each is handed on
+// like the hook's
+class Win32ControlActions : public ControlActions {
+public:
+    void Activate(WindowId id) override { GetActivator().Request(id); }
+    void Overlay(bool show) override {
+        if (!show)
+            EndKeyCapture();
+        PostOverlayCommand(show ? OverlayCommand::Show : OverlayCommand::Hide);
+    }
+    void ReloadSettings() override { GetSettingsStore().Reload(); }
+    void Quit() override { PostQuit(); }
+};
+
 int WINAPI WinMain(HINSTANCE hInst, HINSTANCE, LPSTR, int) {
     try {
         //DebugLog("Initializing GUI");
@@ -20,20 +42,92 @@ int WINAPI WinMain(HINSTANCE hInst, HINSTANCE, LPSTR, int) {
         }
         // DebugLog("GUI initialized");
 
-        HotkeyConfig cfg{ VK_LMENU, VK_LSHIFT, 230, 200 };
+        // Activation history for frecency order, mapped straight from disk
+        static FrecencyStore frecency;
+        if (!frecency.Open(kFrecencyFile))
+            DebugLog("Frecency store not mapped; history is kept in memory only");
+        GetWindowRegistry().SetFrecency(&frecency);
+        GetWindowRegistry().SetFrecencyOrder(GetSettings().frecencyOrder);
+
+        // Switches run on the activator's thread, confirmed by the same
+        // foreground events that keep the registry current
+        Win32ActivationBackend activation;
+        Activator& activator = GetActivator();
+        activator.SetResultCallback([&activation](const ActivationResult& r) {
+            if (r.outcome != ActivationOutcome::TimedOut && r.attempts <= 1)
+                return;
+            char buf[160];
+            sprintf_s(buf, "activation %s after %d attempts (%s), %.1f ms",
+                      ActivationOutcomeName(r.outcome), r.attempts,
+                      r.strategy >= 0 ? activation.StrategyName(r.strategy) : "-",
+                      (r.doneNs - r.requestNs) / 1e6);
+            DebugLog(buf);
+        });
+        activator.Start(activation);
+
+        // Keep the MRU registry current from window events (needs this
+        // thread's message loop), filtered by the rules in the settings
+        GetWindowSystem().SetRules(GetSettingsStore().WindowRules().Load());
+        // and the control endpoint's focus subscribers (after the
+        // registry, so it knows the titles)
+        Win32ControlActions controlActions;
+        ControlServer control(GetWindowRegistry(), controlActions);
+        WindowEventSource& windowEvents = GetWindowSystem().Events();
+        WindowEventTee controlSinks(activator, control);
+        WindowEventTee windowSinks(GetWindowRegistry(), controlSinks);
+        if (!windowEvents.Start(windowSinks)) {
+            DebugLog("SetWinEventHook failed");
+            return 1;
+        }
+
+        // Process names for the overlay, fetched off the render path
+        Win32ProcessInfoProvider processInfo;
+        GetProcessCache().Start(processInfo);
+        WarmUpOverlay();
+
+        // InitializeGUI loaded the settings; edits to the file apply live
+        SettingsStore& settings = GetSettingsStore();
+        if (!settings.Watch([](const HotkeyConfig&) { PostSettingsReloaded(); }))
+            DebugLog("Settings watcher failed; edits to the file need a restart");
+
         //DebugLog("Installing hook");
-        InstallHook(cfg,
+        // Callbacks run on the hook's worker thread: switching only needs
+        // the registry, overlay changes go through the UI thread
+        if (!InstallHook(settings.Switcher(), settings.KeyBindings(),
             []() { SwitchToPreviousWindow(); },
-            []() { ShowOverlay(); },
-            []() { AdvanceSelection(); },
-            []() { HideOverlay(); },
-            []() { CommitSelection(); }   
-        );
+            []() { PostOverlayCommand(OverlayCommand::Show); },
+            []() { PostOverlayCommand(OverlayCommand::Advance); },
+            []() { PostOverlayCommand(OverlayCommand::Hide); },
+            []() { PostOverlayCommand(OverlayCommand::Commit); },
+            [](wchar_t ch) { PostFilterChar(ch); },
+            []() { PostOverlayCommand(OverlayCommand::Prepare); }
+        )) {
+            DebugLog("InstallHook failed");
+            return 1;
+        }
+
+        // Scripts and launchers drive WWS through the control endpoint
+        if (!control.Start(DefaultControlEndpoint()))
+            DebugLog("Control endpoint not started (another WWS running?)");
 
         //DebugLog("Entering loop");
+        FrameScheduler& frames = GetFrameScheduler();
         MSG msg;
         bool running = true;
         while (running) {
+            // Sleep until a message arrives, a frame is due or the
+            // overlay's resources have been idle long enough to release;
+            // once they are gone there is no timeout at all
+            uint64_t waitNs = frames.TimeUntilFrameNs();
+            const uint64_t releaseNs = TickOverlayResources();
+            if (releaseNs < waitNs)
+                waitNs = releaseNs;
+            DWORD waitMs = (waitNs == FrameScheduler::kNever) ? INFINITE
+                         : (DWORD)((waitNs + 999999) / 1000000);
+            if (waitMs)
+                MsgWaitForMultipleObjectsEx(0, nullptr, waitMs, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+            frames.NoteWakeup();
+
             // Process all pending messages
             while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) {
                 if (msg.message == WM_QUIT) {
@@ -43,13 +137,24 @@ int WINAPI WinMain(HINSTANCE hInst, HINSTANCE, LPSTR, int) {
                 TranslateMessage(&msg);
                 DispatchMessageW(&msg);
             }
-            // Render (if needed) then sleep so we don't spin at 100%
-            RenderOverlayFrame();
-            Sleep(10);
+            // Render once per change
+            if (running && frames.BeginFrame())
+                frames.EndFrame(RenderOverlayFrame());
         }
 
         //DebugLog("Cleaning up");
+        control.Stop();
         UninstallHook();
+        activator.Stop();
+        settings.StopWatching();
+        settings.Flush();
+#ifdef WWS_ENABLE_TRACING
+        DumpTrace();
+#endif
+        GetProcessCache().Stop();
+        windowEvents.Stop();
+        GetWindowRegistry().SetFrecency(nullptr);
+        frecency.Close();
         ShutdownGUI();
         return 0;
     }
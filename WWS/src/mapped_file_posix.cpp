@@ -0,0 +1,51 @@
+﻿// === src/mapped_file_posix.cpp ===
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool MappedFile::Open(const std::string& path, size_t size) {
+    Close();
+    m_fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (m_fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(m_fd, &st) != 0) {
+        Close();
+        return false;
+    }
+    if ((size_t)st.st_size < size) {
+        if (ftruncate(m_fd, (off_t)size) != 0) {
+            Close();
+            return false;
+        }
+    }
+    else {
+        size = (size_t)st.st_size;
+    }
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (p == MAP_FAILED) {
+        Close();
+        return false;
+    }
+    m_data = p;
+    m_size = size;
+    return true;
+}
+
+void MappedFile::Close() {
+    if (m_data)
+        munmap(m_data, m_size);
+    m_data = nullptr;
+    m_size = 0;
+    if (m_fd >= 0)
+        close(m_fd);
+    m_fd = -1;
+}
+
+void MappedFile::Flush() {
+    if (m_data)
+        msync(m_data, m_size, MS_ASYNC);
+}
@@ -0,0 +1,58 @@
+﻿// === src/mapped_file_win32.cpp ===
+#include "mapped_file.h"
+#include "utf8.h"
+
+#include <windows.h>
+
+bool MappedFile::Open(const std::string& path, size_t size) {
+    Close();
+    std::wstring wide = WideFromUtf8(path.data(), path.size());
+    HANDLE file = CreateFileW(wide.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+                              nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    m_file = file;
+    LARGE_INTEGER length;
+    if (!GetFileSizeEx(file, &length)) {
+        Close();
+        return false;
+    }
+    // the mapping grows the file for us (with zeros) when it is shorter
+    if ((size_t)length.QuadPart > size)
+        size = (size_t)length.QuadPart;
+    const unsigned long long size64 = size;
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE,
+                                        (DWORD)(size64 >> 32), (DWORD)size64, nullptr);
+    if (!mapping) {
+        Close();
+        return false;
+    }
+    m_mapping = mapping;
+    void* p = MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, size);
+    if (!p) {
+        Close();
+        return false;
+    }
+    m_data = p;
+    m_size = size;
+    return true;
+}
+
+void MappedFile::Close() {
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    m_data = nullptr;
+    m_size = 0;
+    if (m_mapping)
+        CloseHandle((HANDLE)m_mapping);
+    m_mapping = nullptr;
+    if (m_file)
+        CloseHandle((HANDLE)m_file);
+    m_file = nullptr;
+}
+
+void MappedFile::Flush() {
+    // FlushViewOfFile only starts the writes; FlushFileBuffers would wait
+    if (m_data)
+        FlushViewOfFile(m_data, 0);
+}
@@ -0,0 +1,80 @@
+﻿// === src/overlay_lifetime.cpp ===
+#include "overlay_lifetime.h"
+
+void OverlayLifetime::Latency::Add(uint64_t ns) {
+    ++count;
+    totalNs += ns;
+    lastNs = ns;
+    if (ns > maxNs)
+        maxNs = ns;
+}
+
+OverlayLifetime::OverlayLifetime(const Clock& clock) : m_clock(clock) {}
+
+void OverlayLifetime::SetIdleRelease(int ms) {
+    m_idleNs = ms > 0 ? (uint64_t)ms * 1000000 : 0;
+}
+
+void OverlayLifetime::Created(uint64_t costNs, bool speculative, size_t workingSet) {
+    m_alive = true;
+    m_speculative = speculative;
+    m_lastUseNs = m_clock.NowNs();
+    ++m_stats.creates;
+    if (speculative)
+        ++m_stats.speculative;
+    m_stats.create.Add(costNs);
+    m_stats.workingSetUp = workingSet;
+}
+
+void OverlayLifetime::Released(size_t workingSet) {
+    m_alive = false;
+    m_speculative = false;
+    ++m_stats.releases;
+    m_stats.workingSetDown = workingSet;
+}
+
+void OverlayLifetime::Used() {
+    m_lastUseNs = m_clock.NowNs();
+}
+
+void OverlayLifetime::ShowRequested() {
+    const uint64_t now = m_clock.NowNs();
+    // a show while one is still unpresented keeps the first one's start
+    if (!m_showNs) {
+        m_showNs = now;
+        m_showCold = !m_alive;
+    }
+    if (m_speculative) {
+        ++m_stats.speculativeUsed;
+        m_speculative = false;
+    }
+    m_shown = true;
+    m_lastUseNs = now;
+}
+
+void OverlayLifetime::Presented() {
+    const uint64_t now = m_clock.NowNs();
+    m_lastUseNs = now;
+    if (!m_showNs)
+        return;
+    (m_showCold ? m_stats.cold : m_stats.warm).Add(now - m_showNs);
+    m_showNs = 0;
+}
+
+void OverlayLifetime::Hidden() {
+    m_shown = false;
+    m_showNs = 0;   // hidden before anything was presented: not a show
+    m_lastUseNs = m_clock.NowNs();
+}
+
+bool OverlayLifetime::ShouldRelease() const {
+    return TimeUntilReleaseNs() == 0;
+}
+
+uint64_t OverlayLifetime::TimeUntilReleaseNs() const {
+    if (!m_alive || m_shown || !m_idleNs)
+        return kNever;
+    const uint64_t now = m_clock.NowNs();
+    const uint64_t due = m_lastUseNs + m_idleNs;
+    return now >= due ? 0 : due - now;
+}
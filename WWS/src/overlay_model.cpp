@@ -0,0 +1,100 @@
+﻿// === src/overlay_model.cpp ===
+#include "overlay_model.h"
+#include "process_cache.h"
+#include "utf8.h"
+#include "trace.h"
+
+#include <algorithm>
+
+OverlayModel::OverlayModel() {
+    // queries are typed by hand; this is plenty
+    m_query.reserve(64);
+    m_queryUtf8.reserve(256);
+}
+
+void OverlayModel::Show(ProcessCache& cache) {
+    WWS_TRACE_SCOPE("show");
+    m_front ^= 1;
+    m_query.clear();
+    m_queryUtf8.clear();
+    m_processVersion = cache.Version();
+    m_snapshots[m_front].Resolve(cache);
+    m_filter.Build(Windows());
+    m_list.selIndex = (Windows().Size() > 1 ? 1 : 0);
+    m_list.scrollY = 0.0f;
+    m_list.scrollToSelection = true;
+}
+
+void OverlayModel::Show(const WindowRegistry& registry, ProcessCache& cache) {
+    {
+        WWS_TRACE_SCOPE("snapshot");
+        registry.Snapshot(Back());
+    }
+    Show(cache);
+}
+
+void OverlayModel::Refresh(ProcessCache& cache) {
+    // the old snapshot is still there to read the selection from
+    const WindowId keep = Selected();
+    m_front ^= 1;
+    m_processVersion = cache.Version();
+    m_snapshots[m_front].Resolve(cache);
+    Rebuild(keep);
+}
+
+bool OverlayModel::ResolveProcesses(ProcessCache& cache) {
+    const uint64_t version = cache.Version();
+    if (version == m_processVersion)
+        return false;
+    m_processVersion = version;
+    if (!m_snapshots[m_front].Resolve(cache))
+        return false;
+    Rebuild(Selected());
+    return true;
+}
+
+void OverlayModel::Rebuild(WindowId keep) {
+    const int oldIndex = m_list.selIndex;
+    m_filter.Build(Windows());
+    const auto& rows = m_filter.Filter(m_query);
+    const size_t at = Windows().Find(keep);
+    auto it = std::find(rows.begin(), rows.end(), (uint32_t)at);
+    if (it != rows.end())
+        m_list.selIndex = (int)(it - rows.begin());
+    else
+        m_list.selIndex = rows.empty() ? 0 : std::min(oldIndex, (int)rows.size() - 1);
+    m_list.scrollToSelection = true;
+}
+
+void OverlayModel::Advance(int delta) {
+    const int count = (int)Rows().size();
+    if (count == 0)
+        return;
+    m_list.selIndex = ((m_list.selIndex + delta) % count + count) % count;
+    m_list.scrollToSelection = true;
+}
+
+bool OverlayModel::Input(wchar_t ch) {
+    if (ch == L'\b') {
+        if (m_query.empty())
+            return false;
+        m_query.pop_back();
+    }
+    else {
+        m_query += ch;
+    }
+    m_queryUtf8.clear();
+    AppendUtf8(m_queryUtf8, m_query);
+    // best match first; with the filter cleared go back to "previous window"
+    const auto& rows = m_filter.Filter(m_query);
+    m_list.selIndex = (m_query.empty() && rows.size() > 1) ? 1 : 0;
+    m_list.scrollToSelection = true;
+    return true;
+}
+
+WindowId OverlayModel::Selected() const {
+    const auto& rows = Rows();
+    if (m_list.selIndex < 0 || m_list.selIndex >= (int)rows.size())
+        return 0;
+    return Windows().At(rows[m_list.selIndex]).id;
+}
@@ -0,0 +1,192 @@
+﻿// === src/overlay_view.cpp ===
+#include "overlay_view.h"
+#include "process_cache.h"
+#include "utf8.h"
+#include "imgui.h"
+
+#include <algorithm>
+#include <cstring>
+
+// "> " or "  ", then text as fit cuts it; returns the length
+static size_t FormatRow(char* buf, bool selected, std::string_view text, TitleFit fit) {
+    size_t n = 0;
+    buf[n++] = selected ? '>' : ' ';
+    buf[n++] = ' ';
+    std::memcpy(buf + n, text.data(), fit.len);
+    n += fit.len;
+    if (fit.cut) {
+        std::memcpy(buf + n, "...", 3);
+        n += 3;
+    }
+    return n;
+}
+
+TitleFit FitTitle(std::string_view utf8, float width, size_t maxChars) {
+    ImFontBaked* baked = ImGui::GetFontBaked();
+    const float ellipsis = baked->GetCharAdvance((ImWchar)'.') * 3.0f;
+    const char* p = utf8.data();
+    const char* end = p + utf8.size();
+    TitleFit fit;           // the longest prefix that still has room for "..."
+    float x = 0.0f;
+    size_t chars = 0;
+    while (p < end) {
+        if (x + ellipsis <= width && chars + 3 <= maxChars)
+            fit.len = (uint32_t)(p - utf8.data());
+        x += baked->GetCharAdvance((ImWchar)DecodeUtf8(p, end));
+        if (x > width || ++chars > maxChars) {
+            fit.cut = true;
+            return fit;
+        }
+    }
+    fit.len = (uint32_t)utf8.size();
+    return fit;
+}
+
+TitleFit TitleFitCache::Get(const WindowSnapshot& windows, uint32_t row, float width, size_t maxChars) {
+    const ImFont* font = ImGui::GetFont();
+    const float fontSize = ImGui::GetFontSize();
+    if (windows.Generation() != m_generation || font != m_font || fontSize != m_fontSize ||
+        width != m_width || maxChars != m_maxChars)
+    {
+        m_generation = windows.Generation();
+        m_font = font;
+        m_fontSize = fontSize;
+        m_width = width;
+        m_maxChars = maxChars;
+        m_fits.assign(windows.Size(), kUnknown);
+    }
+    if (row >= m_fits.size())
+        m_fits.resize(windows.Size(), kUnknown);   // rows added since
+    uint32_t& packed = m_fits[row];
+    if (packed == kUnknown) {
+        const TitleFit fit = FitTitle(windows.Display(row), width, maxChars);
+        packed = fit.len | (fit.cut ? kCut : 0);
+        ++m_measured;
+    }
+    TitleFit fit;
+    fit.len = packed & ~kCut;
+    fit.cut = (packed & kCut) != 0;
+    return fit;
+}
+
+float OverlayListHeight(size_t rows, float maxHeight) {
+    return std::min(ImGui::GetTextLineHeightWithSpacing() * (float)rows, maxHeight);
+}
+
+void DrawWindowList(const char* id, const WindowSnapshot& windows,
+    const std::vector<uint32_t>& rows, OverlayListState& state,
+    const OverlayListLayout& layout, float height)
+{
+    const int   count = (int)rows.size();
+    const float row_h = ImGui::GetTextLineHeightWithSpacing();
+    const bool  hasSel = state.selIndex >= 0 && state.selIndex < count;
+
+    // scroll just enough to bring the selection into view
+    if (state.scrollToSelection && hasSel) {
+        float top = row_h * (float)state.selIndex;
+        float scroll = state.scrollY;
+        if (top < scroll)
+            scroll = top;
+        else if (top + row_h > scroll + height)
+            scroll = top + row_h - height;
+        ImGui::SetNextWindowScroll(ImVec2(-1.0f, scroll));
+    }
+    state.scrollToSelection = false;
+
+    ImGui::BeginChild(id, ImVec2(layout.width, height), ImGuiChildFlags_None);
+
+    const size_t maxTitle = std::min(layout.maxTitle, kMaxTitle);
+    char line[2 + kMaxTitle * 4];   // UTF-8 is at most 4 bytes a character
+    // titles end where the exe column (or the list) starts
+    const ImGuiStyle& style = ImGui::GetStyle();
+    const float left = ImGui::GetCursorPosX() + ImGui::CalcTextSize("> ").x +
+                       (layout.icons ? ImGui::GetTextLineHeight() + style.ItemSpacing.x : 0.0f);
+    const float right = layout.exeWidth > 0.0f ? layout.width - layout.exeWidth - style.ItemSpacing.x
+                                               : ImGui::GetCursorPosX() + ImGui::GetContentRegionAvail().x;
+    const float titleWidth = std::max(0.0f, right - left);
+    const ImVec4 selColor(0.0f, 250.0f / 255.0f, 255.0f / 255.0f, 1.0f);
+    const ImVec4 exeColor = style.Colors[ImGuiCol_TextDisabled];
+
+    ImGuiListClipper clipper;
+    clipper.Begin(count, row_h);
+    if (hasSel)
+        clipper.IncludeItemByIndex(state.selIndex);
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+            const uint32_t w = rows[i];
+            const auto& process = windows.Process(w);
+            if (layout.icons) {
+                // drawn at text height so rows keep the clipper's row_h;
+                // keep titles aligned whether or not the icon is there (yet)
+                const float sz = ImGui::GetTextLineHeight();
+                ImVec2 uv0, uv1;
+                if (process && layout.icons->Get(process->exePath, uv0, uv1))
+                    ImGui::Image(layout.icons->TexRef(), ImVec2(sz, sz), uv0, uv1);
+                else
+                    ImGui::Dummy(ImVec2(sz, sz));
+                ImGui::SameLine();
+            }
+            const bool selected = (i == state.selIndex);
+            const TitleFit fit = layout.fits ? layout.fits->Get(windows, w, titleWidth, maxTitle)
+                                             : FitTitle(windows.Display(w), titleWidth, maxTitle);
+            const size_t len = FormatRow(line, selected, windows.Display(w), fit);
+            if (selected)
+                ImGui::PushStyleColor(ImGuiCol_Text, selColor);
+            ImGui::TextUnformatted(line, line + len);
+            if (selected)
+                ImGui::PopStyleColor();
+            const std::string_view exe = windows.Exe(w);
+            if (layout.exeWidth > 0.0f && !exe.empty()) {
+                ImGui::SameLine(layout.width - layout.exeWidth);
+                ImGui::PushStyleColor(ImGuiCol_Text, exeColor);
+                ImGui::TextUnformatted(exe.data(), exe.data() + exe.size());
+                ImGui::PopStyleColor();
+            }
+        }
+    }
+
+    state.scrollY = ImGui::GetScrollY();
+    ImGui::EndChild();
+}
+
+float ThumbnailStripHeight(const ThumbnailCache& thumbs) {
+    return (float)thumbs.CellHeight() + ImGui::GetStyle().ItemSpacing.y + 4.0f;
+}
+
+void DrawThumbnailStrip(const char* id, const WindowSnapshot& windows,
+    const std::vector<uint32_t>& rows, int selIndex,
+    ThumbnailCache& thumbs, int neighbours, float width)
+{
+    const int count = (int)rows.size();
+    if (selIndex < 0 || selIndex >= count)
+        return;
+    const ImVec2 cell((float)thumbs.CellWidth(), (float)thumbs.CellHeight());
+    const float gap = ImGui::GetStyle().ItemSpacing.x;
+    // as many as fit, the selection in the middle unless near either end
+    const int fit = std::max(1, (int)((width + gap) / (cell.x + gap)));
+    const int shown = std::min({ count, fit, 2 * neighbours + 1 });
+    const int first = std::clamp(selIndex - shown / 2, 0, count - shown);
+    const int last = first + shown - 1;
+    const float used = (float)(last - first + 1) * (cell.x + gap) - gap;
+
+    ImGui::BeginChild(id, ImVec2(width, ThumbnailStripHeight(thumbs)), ImGuiChildFlags_None,
+                      ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoBackground);
+    ImGui::SetCursorPos(ImVec2(std::max(2.0f, (width - used) * 0.5f), 2.0f));   // room for the frames
+    ImDrawList* dl = ImGui::GetWindowDrawList();
+    for (int i = first; i <= last; ++i) {
+        if (i != first)
+            ImGui::SameLine(0.0f, gap);
+        const ImVec2 pos = ImGui::GetCursorScreenPos();
+        ImVec2 uv0, uv1, size;
+        if (thumbs.Get(windows.At(rows[i]).id, uv0, uv1, size)) {
+            // letterboxed: the cell keeps its size whatever the aspect ratio
+            const ImVec2 at(pos.x + (cell.x - size.x) * 0.5f, pos.y + (cell.y - size.y) * 0.5f);
+            dl->AddImage(thumbs.TexRef(), at, ImVec2(at.x + size.x, at.y + size.y), uv0, uv1);
+        }
+        ImGui::Dummy(cell);
+        const ImU32 frame = i == selIndex ? IM_COL32(0, 250, 255, 255) : IM_COL32(80, 80, 80, 255);
+        dl->AddRect(ImVec2(pos.x - 1.0f, pos.y - 1.0f), ImVec2(pos.x + cell.x + 1.0f, pos.y + cell.y + 1.0f),
+                    frame, 0.0f, 0, i == selIndex ? 2.0f : 1.0f);
+    }
+    ImGui::EndChild();
+}
@@ -0,0 +1,218 @@
+﻿// === src/process_cache.cpp ===
+#include "process_cache.h"
+#include "clock.h"
+
+#include <chrono>
+#include <thread>
+
+void ProcessCache::Start(ProcessInfoProvider& provider) {
+    Stop();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_provider = &provider;
+        m_running = true;
+    }
+    m_pool.Start();
+}
+
+void ProcessCache::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running)
+            return;
+        m_running = false;
+    }
+    // queued fetches are dropped; running ones finish (a hung one blocks here)
+    m_pool.Stop();
+    m_provider->CancelWatches();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_provider = nullptr;
+    m_queued.clear();
+    m_entries.clear();
+    ++m_version;
+}
+
+std::shared_ptr<const ProcessInfo> ProcessCache::Lookup(uint32_t pid) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::shared_ptr<const ProcessInfo> cached;
+    auto it = m_entries.find(pid);
+    if (it != m_entries.end()) {
+        const Entry& e = it->second;
+        if (e.watched || SystemClock().NowNs() - e.fetchedAtNs < kRetryNs)
+            return e.info;
+        cached = e.info;   // until the fetch says whether the pid was reused
+    }
+    if (m_running && m_queued.insert(pid).second)
+        m_pool.Submit([this, pid] { Fetch(pid); });
+    return cached;
+}
+
+void ProcessCache::Evict(uint32_t pid, uint64_t startTime) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(pid);
+    // a reused pid belongs to a newer process; leave it alone
+    if (it == m_entries.end() || !it->second.info || it->second.info->startTime != startTime)
+        return;
+    m_entries.erase(it);
+    ++m_version;
+}
+
+size_t ProcessCache::Size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+uint64_t ProcessCache::Version() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_version;
+}
+
+void ProcessCache::SetUpdateCallback(std::function<void()> fn) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_onUpdate = std::move(fn);
+}
+
+void ProcessCache::Fetch(uint32_t pid) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_running)
+        return;
+    ProcessInfoProvider* provider = m_provider;
+
+    // the provider may block (hung or protected processes); not under the lock
+    lock.unlock();
+    auto query = std::make_shared<ProcessInfo>();
+    const bool ok = provider->Query(pid, *query);
+    std::shared_ptr<const ProcessInfo> info;
+    if (ok)
+        info = std::move(query);
+    lock.lock();
+
+    m_queued.erase(pid);
+    Entry& e = m_entries[pid];
+    e.fetchedAtNs = SystemClock().NowNs();
+    // an unwatched entry checked again and still the same process
+    if (info && e.info && e.info->startTime == info->startTime)
+        return;
+    e.info = info;
+    e.watched = false;
+    ++m_version;
+    auto fn = m_onUpdate;
+    lock.unlock();
+
+    // the entry is in before the watch, so an exit in between still finds
+    // it (the provider reports one that already happened right away)
+    if (info && provider->WatchExit(*info, [this](uint32_t p, uint64_t start) { Evict(p, start); })) {
+        lock.lock();
+        auto it = m_entries.find(pid);
+        if (it != m_entries.end() && it->second.info == info)
+            it->second.watched = true;
+        lock.unlock();
+    }
+    if (fn)
+        fn();
+}
+
+// --- fake provider ---
+
+void FakeProcessInfoProvider::Add(uint32_t pid, uint64_t startTime, std::wstring exePath) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ProcessInfo& p = m_procs[pid];
+    p.pid = pid;
+    p.startTime = startTime;
+    p.exeName = ExeNameFromPath(exePath);
+    p.exePath = std::move(exePath);
+}
+
+void FakeProcessInfoProvider::Exit(uint32_t pid) {
+    ExitFn fn;
+    uint64_t start = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto p = m_procs.find(pid);
+        if (p == m_procs.end())
+            return;
+        start = p->second.startTime;
+        m_procs.erase(p);
+        auto w = m_watches.find(pid);
+        if (w != m_watches.end()) {
+            fn = std::move(w->second);
+            m_watches.erase(w);
+        }
+    }
+    if (fn) fn(pid, start);
+}
+
+uint64_t FakeProcessInfoProvider::Queries() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_queries;
+}
+
+void FakeProcessInfoProvider::SetDelay(uint32_t pid, int ms) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_delays[pid] = ms;
+}
+
+void FakeProcessInfoProvider::Hang(uint32_t pid) {
+    SetDelay(pid, -1);
+}
+
+void FakeProcessInfoProvider::Release() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_delays.begin(); it != m_delays.end();)
+            it = it->second < 0 ? m_delays.erase(it) : std::next(it);
+    }
+    m_released.notify_all();
+}
+
+bool FakeProcessInfoProvider::Query(uint32_t pid, ProcessInfo& info) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    ++m_queries;
+    auto d = m_delays.find(pid);
+    const int ms = d == m_delays.end() ? 0 : d->second;
+    if (ms < 0) {
+        m_released.wait(lock, [&] {
+            auto it = m_delays.find(pid);
+            return it == m_delays.end() || it->second >= 0;
+        });
+    }
+    else if (ms > 0) {
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+        lock.lock();
+    }
+    auto p = m_procs.find(pid);
+    if (p == m_procs.end())
+        return false;
+    info = p->second;
+    return true;
+}
+
+bool FakeProcessInfoProvider::WatchExit(const ProcessInfo& info, ExitFn onExit) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto p = m_procs.find(info.pid);
+        if (p != m_procs.end() && p->second.startTime == info.startTime) {
+            m_watches[info.pid] = std::move(onExit);
+            return true;
+        }
+    }
+    onExit(info.pid, info.startTime);   // exited since the query
+    return true;
+}
+
+void FakeProcessInfoProvider::CancelWatches() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_watches.clear();
+}
+
+std::wstring ExeNameFromPath(const std::wstring& path) {
+    size_t slash = path.find_last_of(L"\\/");
+    return slash == std::wstring::npos ? path : path.substr(slash + 1);
+}
+
+ProcessCache& GetProcessCache() {
+    static ProcessCache g_cache;
+    return g_cache;
+}
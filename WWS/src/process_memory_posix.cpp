@@ -0,0 +1,19 @@
+﻿// === src/process_memory_posix.cpp ===
+#include "process_memory.h"
+
+#include <cstdio>
+#include <unistd.h>
+
+size_t ProcessWorkingSetBytes() {
+    // /proc/self/statm: total and resident size, in pages
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (!f)
+        return 0;
+    unsigned long total = 0, resident = 0;
+    const int n = std::fscanf(f, "%lu %lu", &total, &resident);
+    std::fclose(f);
+    if (n != 2)
+        return 0;
+    const long page = sysconf(_SC_PAGESIZE);
+    return page > 0 ? (size_t)resident * (size_t)page : 0;
+}
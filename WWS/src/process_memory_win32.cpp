@@ -0,0 +1,14 @@
+﻿// === src/process_memory_win32.cpp ===
+#include "process_memory.h"
+
+#include <windows.h>
+#include <psapi.h>
+
+size_t ProcessWorkingSetBytes() {
+    // K32GetProcessMemoryInfo lives in kernel32, no psapi.lib needed
+    PROCESS_MEMORY_COUNTERS pmc{};
+    pmc.cb = sizeof(pmc);
+    if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return 0;
+    return (size_t)pmc.WorkingSetSize;
+}
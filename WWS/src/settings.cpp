@@ -1,7 +1,9 @@
 ﻿// === src/settings.cpp ===
 #include "settings.h"
+#include "file_watcher.h"
 
 #include <fstream>
+#include <filesystem>
 #include <vector>
 #include <cstring>           // for strcmp()
 #include "json.hpp"        // single-header nlohmann/json
@@ -9,51 +11,374 @@
 using json = nlohmann::json;
 
 static HotkeyConfig g_cfg;
-static const char* SETTINGS_FILE = "wws_config.json";
 
 // Dropdown options
-static const std::vector<UINT> keys = { VK_LMENU, VK_RMENU, VK_LSHIFT, VK_RSHIFT };
+static const std::vector<uint32_t> keys = { vk::LMenu, vk::RMenu, vk::LShift, vk::RShift };
 static const std::vector<const char*> keyNames = { "Left Alt", "Right Alt", "Left Shift", "Right Shift" };
 
-const char* KeyName(UINT vk) {
+const char* KeyName(uint32_t vk) {
     for (size_t i = 0; i < keys.size(); ++i)
         if (keys[i] == vk)
             return keyNames[i];
     return "Unknown";
 }
 
-UINT KeyFromName(const char* name) {
+uint32_t KeyFromName(const char* name) {
     for (size_t i = 0; i < keyNames.size(); ++i)
         if (std::strcmp(name, keyNames[i]) == 0)
             return keys[i];
-    return VK_LMENU;
+    return vk::LMenu;
 }
 
 HotkeyConfig& GetSettings() {
     return g_cfg;
 }
 
-HotkeyConfig LoadSettings() {
-    std::ifstream ifs(SETTINGS_FILE);
-    if (ifs) {
-        json j; ifs >> j;
-        g_cfg.initiator = j.value("initiator", VK_LMENU);
-        g_cfg.modifier = j.value("modifier", VK_LSHIFT);
-        g_cfg.tapTimeoutMs = j.value("tapTimeoutMs", 300);
-        g_cfg.overlayTimeoutMs = j.value("overlayTimeoutMs", 500);
+// --- window rules ---
+
+// Style bits a rule can test, by the name used in "has" / "lacks"
+struct StyleName {
+    const char* name;
+    bool        ex;     // extended style
+    uint32_t    bit;
+};
+static const StyleName styleNames[] = {
+    { "caption",    false, ws::Caption },
+    { "popup",      false, ws::Popup },
+    { "toolwindow", true,  ws::ExToolWindow },
+    { "topmost",    true,  ws::ExTopmost },
+    { "appwindow",  true,  ws::ExAppWindow },
+    { "noactivate", true,  ws::ExNoActivate },
+};
+
+// False for anything this version can't honour; a rule is skipped rather
+// than applied with a condition missing
+static bool RuleFromJson(const json& j, WindowRule& r) {
+    if (!j.is_object())
+        return false;
+    const std::string action = j.value("action", std::string());
+    if (action == "include")      r.action = WindowRuleAction::Include;
+    else if (action == "exclude") r.action = WindowRuleAction::Exclude;
+    else if (action == "pin")     r.action = WindowRuleAction::Pin;
+    else                          return false;
+    r.title = j.value("title", std::string());
+    r.windowClass = j.value("class", std::string());
+    r.exe = j.value("exe", std::string());
+    for (const char* list : { "has", "lacks" }) {
+        const auto it = j.find(list);
+        if (it == j.end())
+            continue;
+        if (!it->is_array())
+            return false;
+        for (const json& name : *it) {
+            const StyleName* found = nullptr;
+            for (const StyleName& sn : styleNames)
+                if (name.is_string() && name.get<std::string>() == sn.name)
+                    found = &sn;
+            if (!found)
+                return false;
+            uint32_t& mask = found->ex ? r.exStyleMask : r.styleMask;
+            uint32_t& value = found->ex ? r.exStyle : r.style;
+            mask |= found->bit;
+            if (list[0] == 'h')
+                value |= found->bit;
+        }
     }
-    else {
-        g_cfg = { VK_LMENU, VK_LSHIFT, 300, 500 };
+    return true;
+}
+
+static json RuleToJson(const WindowRule& r) {
+    json j;
+    j["action"] = WindowRuleActionName(r.action);
+    if (!r.title.empty())       j["title"] = r.title;
+    if (!r.windowClass.empty()) j["class"] = r.windowClass;
+    if (!r.exe.empty())         j["exe"] = r.exe;
+    json has = json::array(), lacks = json::array();
+    for (const StyleName& sn : styleNames) {
+        const uint32_t mask = sn.ex ? r.exStyleMask : r.styleMask;
+        const uint32_t value = sn.ex ? r.exStyle : r.style;
+        if (mask & sn.bit)
+            ((value & sn.bit) ? has : lacks).push_back(sn.name);
     }
-    return g_cfg;
+    if (!has.empty())   j["has"] = has;
+    if (!lacks.empty()) j["lacks"] = lacks;
+    return j;
+}
+
+// --- key bindings ---
+
+static bool BindingFromJson(const json& j, KeyBinding& b) {
+    if (!j.is_object())
+        return false;
+    const auto keys = j.find("keys");
+    if (keys == j.end() || !keys->is_string() || !ParseKeys(keys->get<std::string>(), b.keys))
+        return false;
+    const std::string action = j.value("action", std::string());
+    if (action == "select")       b.action = BindingAction::Select;
+    else if (action == "overlay") b.action = BindingAction::Overlay;
+    else                          return false;
+    b.index = j.value("index", 1);
+    return true;
+}
+
+static json BindingToJson(const KeyBinding& b) {
+    json j;
+    j["keys"] = FormatKeys(b.keys);
+    j["action"] = BindingActionName(b.action);
+    if (b.action == BindingAction::Select)
+        j["index"] = b.index;
+    return j;
+}
+
+bool LoadSettings(const std::string& path, HotkeyConfig& out) {
+    std::ifstream ifs(path);
+    if (!ifs)
+        return false;
+    // an editor halfway through saving can leave anything in there
+    json j = json::parse(ifs, nullptr, false);
+    if (j.is_discarded() || !j.is_object())
+        return false;
+    const HotkeyConfig defaults;
+    out.switcher.initiator = (uint16_t)j.value("initiator", (uint32_t)defaults.switcher.initiator);
+    out.switcher.modifier = (uint16_t)j.value("modifier", (uint32_t)defaults.switcher.modifier);
+    out.switcher.tapTimeoutMs = j.value("tapTimeoutMs", defaults.switcher.tapTimeoutMs);
+    out.switcher.overlayTimeoutMs = j.value("overlayTimeoutMs", defaults.switcher.overlayTimeoutMs);
+    out.frecencyOrder = j.value("frecencyOrder", defaults.frecencyOrder);
+    out.overlayIdleReleaseMs = j.value("overlayIdleReleaseMs", defaults.overlayIdleReleaseMs);
+    out.overlayWarmOnInitiator = j.value("overlayWarmOnInitiator", defaults.overlayWarmOnInitiator);
+    out.thumbnails = j.value("thumbnails", defaults.thumbnails);
+    out.thumbnailCacheMB = j.value("thumbnailCacheMB", defaults.thumbnailCacheMB);
+    // compiled here, once per load, never per window
+    out.windowRules = defaults.windowRules;
+    const auto rules = j.find("windowRules");
+    if (rules != j.end() && rules->is_array()) {
+        std::vector<WindowRule> parsed;
+        for (const json& r : *rules) {
+            WindowRule rule;
+            if (RuleFromJson(r, rule))
+                parsed.push_back(std::move(rule));
+        }
+        if (!parsed.empty())
+            out.windowRules = std::make_shared<const WindowRuleSet>(std::move(parsed));
+    }
+    out.keyBindings.set = defaults.keyBindings.set;
+    const auto bindings = j.find("keyBindings");
+    if (bindings != j.end() && bindings->is_array()) {
+        std::vector<KeyBinding> parsed;
+        for (const json& b : *bindings) {
+            KeyBinding binding;
+            if (BindingFromJson(b, binding))
+                parsed.push_back(std::move(binding));
+        }
+        if (!parsed.empty())
+            out.keyBindings.set = std::make_shared<const KeyBindingSet>(std::move(parsed));
+    }
+    out.keyBindings.sequenceTimeoutMs = j.value("keySequenceTimeoutMs", defaults.keyBindings.sequenceTimeoutMs);
+    return true;
 }
 
-void SaveSettings(const HotkeyConfig& cfg) {
+HotkeyConfig LoadSettings(const std::string& path) {
+    HotkeyConfig cfg;
+    if (!LoadSettings(path, cfg))
+        cfg = HotkeyConfig();
+    return cfg;
+}
+
+static json SettingsJson(const HotkeyConfig& cfg) {
     json j;
-    j["initiator"] = cfg.initiator;
-    j["modifier"] = cfg.modifier;
-    j["tapTimeoutMs"] = cfg.tapTimeoutMs;
-    j["overlayTimeoutMs"] = cfg.overlayTimeoutMs;
-    std::ofstream ofs(SETTINGS_FILE);
-    ofs << j.dump(4);
+    j["initiator"] = cfg.switcher.initiator;
+    j["modifier"] = cfg.switcher.modifier;
+    j["tapTimeoutMs"] = cfg.switcher.tapTimeoutMs;
+    j["overlayTimeoutMs"] = cfg.switcher.overlayTimeoutMs;
+    j["frecencyOrder"] = cfg.frecencyOrder;
+    j["overlayIdleReleaseMs"] = cfg.overlayIdleReleaseMs;
+    j["overlayWarmOnInitiator"] = cfg.overlayWarmOnInitiator;
+    j["thumbnails"] = cfg.thumbnails;
+    j["thumbnailCacheMB"] = cfg.thumbnailCacheMB;
+    if (cfg.windowRules && !cfg.windowRules->Empty()) {
+        json rules = json::array();
+        for (const WindowRule& r : cfg.windowRules->Rules())
+            rules.push_back(RuleToJson(r));
+        j["windowRules"] = rules;
+    }
+    if (cfg.keyBindings.set && !cfg.keyBindings.set->Empty()) {
+        json bindings = json::array();
+        for (const KeyBinding& b : cfg.keyBindings.set->Bindings())
+            bindings.push_back(BindingToJson(b));
+        j["keyBindings"] = bindings;
+    }
+    j["keySequenceTimeoutMs"] = cfg.keyBindings.sequenceTimeoutMs;
+    return j;
+}
+
+// the file is the definition: no field can be left out of the comparison
+bool operator==(const HotkeyConfig& a, const HotkeyConfig& b) {
+    return SettingsJson(a) == SettingsJson(b);
+}
+
+bool SaveSettings(const HotkeyConfig& cfg, const std::string& path) {
+    const json j = SettingsJson(cfg);
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream ofs(tmp, std::ios::trunc);
+        ofs << j.dump(4);
+        if (!ofs.flush())
+            return false;
+    }
+    // rename replaces the old file in one step (MoveFileEx with
+    // MOVEFILE_REPLACE_EXISTING on Windows)
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+// --- SettingsStore ---
+
+SettingsStore::SettingsStore(std::string path) : m_path(std::move(path)) {}
+
+SettingsStore::~SettingsStore() {
+    StopWatching();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;   // the saver finishes what is pending first
+    }
+    m_cv.notify_all();
+    if (m_saver.joinable())
+        m_saver.join();
+}
+
+HotkeyConfig SettingsStore::Load() {
+    HotkeyConfig cfg = LoadSettings(m_path);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_written = cfg;
+    m_hasWritten = true;
+    PublishLocked(cfg);
+    return cfg;
+}
+
+void SettingsStore::Publish(const HotkeyConfig& cfg) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    PublishLocked(cfg);
+}
+
+void SettingsStore::PublishLocked(const HotkeyConfig& cfg) {
+    if (cfg.switcher != m_current.switcher)
+        m_switcher.Publish(cfg.switcher);
+    if (cfg.keyBindings != m_current.keyBindings)
+        m_keyBindings.Publish(cfg.keyBindings);
+    if (!SameRules(cfg.windowRules, m_current.windowRules))
+        m_windowRules.Publish(cfg.windowRules);
+    m_current = cfg;
+}
+
+HotkeyConfig SettingsStore::Current() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_current;
+}
+
+void SettingsStore::SaveAsync(const HotkeyConfig& cfg) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        PublishLocked(cfg);
+        m_pending = cfg;
+        m_hasPending = true;
+        if (!m_saver.joinable())
+            m_saver = std::thread(&SettingsStore::SaverMain, this);
+    }
+    m_cv.notify_all();
+}
+
+void SettingsStore::Flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this] { return !m_hasPending && !m_writing; });
+}
+
+void SettingsStore::SaverMain() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_cv.wait(lock, [this] { return m_hasPending || m_stop; });
+        if (!m_hasPending)
+            return;
+        HotkeyConfig cfg = m_pending;
+        m_hasPending = false;
+        m_writing = true;
+        ++m_writes;
+        // before the rename, so the watcher already knows it is ours
+        m_written = cfg;
+        m_hasWritten = true;
+        lock.unlock();
+        SaveSettings(cfg, m_path);
+        lock.lock();
+        m_writing = false;
+        ++m_saves;
+        m_cv.notify_all();
+    }
+}
+
+bool SettingsStore::Watch(std::function<void(const HotkeyConfig&)> onReload) {
+    StopWatching();
+    m_onReload = std::move(onReload);
+    m_watcher = std::make_unique<FileWatcher>();
+    if (!m_watcher->Start(m_path, [this] { Reload(); })) {
+        m_watcher.reset();
+        return false;
+    }
+    return true;
+}
+
+void SettingsStore::StopWatching() {
+    if (m_watcher) {
+        m_watcher->Stop();
+        m_watcher.reset();
+    }
+}
+
+void SettingsStore::Reload() {
+    // while a save of ours is queued or being written the file is on its
+    // way to being ours; its rename brings another change after it
+    uint64_t writes;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_hasPending || m_writing)
+            return;
+        writes = m_writes;
+    }
+    HotkeyConfig cfg;
+    if (!LoadSettings(m_path, cfg))
+        return;   // gone or mid-write; the next change brings it back
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // a save started as we read: what we read may be an older one of ours
+        if (m_hasPending || m_writing || m_writes != writes)
+            return;
+        // our own save coming back; the live config may have moved on since
+        if (m_hasWritten && cfg == m_written)
+            return;
+        m_written = cfg;
+        m_hasWritten = true;
+        ++m_reloads;
+        // in the same step as the checks, so a SaveAsync can't slip between
+        PublishLocked(cfg);
+    }
+    if (m_onReload)
+        m_onReload(cfg);
+}
+
+uint64_t SettingsStore::Saves() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_saves;
+}
+
+uint64_t SettingsStore::Reloads() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_reloads;
+}
+
+SettingsStore& GetSettingsStore() {
+    static SettingsStore store;
+    return store;
 }
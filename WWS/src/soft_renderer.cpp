@@ -0,0 +1,572 @@
+﻿// === src/soft_renderer.cpp ===
+#include "soft_renderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WWS_SOFT_SSE2 1
+#endif
+
+// Quads: axis-aligned rectangles, pixel bounds already clipped
+// Triangles: setup in m_tris
+struct SoftRenderer::Prim {
+    int            x0, y0, x1, y1;   // pixels covered: [x0, x1) x [y0, y1)
+    const Texture* tex;
+    uint32_t       color;            // quads: vertex colour, times the texel when solid
+    bool           quad;
+    bool           solid;            // quad with one uv: the same colour everywhere
+    uint32_t       tri;              // triangles: index into m_tris
+    float          u0, du, v0, dv;   // quads: texel coordinate at pixel centre x is u0 + x * du
+};
+
+// Edge i is the one opposite vertex i; w = ea * x + eb * y + ec at the
+// centre of pixel (x, y), scaled by the area so it is vertex i's
+// barycentric weight
+struct SoftRenderer::Tri {
+    float ea[3], eb[3], ec[3];
+    float min[3];        // inside if w >= min: 0 on top and left edges, just above it on the others
+    float u[3], v[3];    // texels
+    float c[4][3];       // r, g, b, a of each vertex, 0..255
+};
+
+// --- pixels ---
+
+static inline uint32_t Div255(uint32_t x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+// ImU32 (R in the low byte) times ImU32, per channel
+static inline uint32_t Modulate(uint32_t a, uint32_t b) {
+    if (b == 0xFFFFFFFFu) return a;
+    if (a == 0xFFFFFFFFu) return b;
+    uint32_t r = Div255((a & 0xFF) * (b & 0xFF));
+    uint32_t g = Div255(((a >> 8) & 0xFF) * ((b >> 8) & 0xFF));
+    uint32_t bl = Div255(((a >> 16) & 0xFF) * ((b >> 16) & 0xFF));
+    uint32_t al = Div255((a >> 24) * (b >> 24));
+    return r | g << 8 | bl << 16 | al << 24;
+}
+
+// Non-premultiplied src (ImU32) over dst (0xAARRGGBB); alpha accumulates
+// as src.a + dst.a * (1 - src.a), like imgui_impl_dx11's blend state.
+// Every channel is Div255(s * a + d * (255 - a)) with s.a taken as 255, the
+// same sum BlendSpan() does four pixels at a time.
+static inline uint32_t Over(uint32_t dst, uint32_t src) {
+    uint32_t a = src >> 24;
+    if (a == 0)
+        return dst;
+    uint32_t r = src & 0xFF, g = (src >> 8) & 0xFF, b = (src >> 16) & 0xFF;
+    if (a == 255)
+        return 0xFF000000u | r << 16 | g << 8 | b;
+    uint32_t ia = 255 - a;
+    uint32_t outA = Div255(255 * a + (dst >> 24) * ia);
+    uint32_t outR = Div255(r * a + ((dst >> 16) & 0xFF) * ia);
+    uint32_t outG = Div255(g * a + ((dst >> 8) & 0xFF) * ia);
+    uint32_t outB = Div255(b * a + (dst & 0xFF) * ia);
+    return outA << 24 | outR << 16 | outG << 8 | outB;
+}
+
+// n pixels of one colour (ImU32) over dst
+static void BlendSpan(uint32_t* dst, int n, uint32_t src) {
+    uint32_t a = src >> 24;
+    if (a == 0)
+        return;
+    if (a == 255) {
+        std::fill(dst, dst + n, Over(0, src));
+        return;
+    }
+    int i = 0;
+#ifdef WWS_SOFT_SSE2
+    // two pixels per register as 16-bit channels
+    uint32_t s = 0xFF000000u | (src & 0xFF) << 16 | (src & 0xFF00) | ((src >> 16) & 0xFF);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i sa = _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_set1_epi32((int)s), zero),
+                                       _mm_set1_epi16((short)a));
+    const __m128i ia = _mm_set1_epi16((short)(255 - a));
+    const __m128i half = _mm_set1_epi16(128);
+    for (; i + 4 <= n; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i lo = _mm_add_epi16(_mm_add_epi16(sa, _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), ia)), half);
+        __m128i hi = _mm_add_epi16(_mm_add_epi16(sa, _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), ia)), half);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; i < n; ++i)
+        dst[i] = Over(dst[i], src);
+}
+
+static inline int TexelIndex(float t, int size) {
+    int i = (int)t;
+    return t < 0.0f ? 0 : (i >= size ? size - 1 : i);
+}
+
+// --- framebuffer ---
+
+void SoftFramebuffer::Resize(int w, int h) {
+    width = std::max(w, 0);
+    height = std::max(h, 0);
+    pixels.resize((size_t)width * height);
+}
+
+void SoftFramebuffer::Clear(uint32_t argb) {
+    std::fill(pixels.begin(), pixels.end(), argb);
+}
+
+bool SoftFramebuffer::WritePpm(const std::string& path) const {
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f)
+        return false;
+    std::fprintf(f, "P6\n%d %d\n255\n", width, height);
+    std::vector<unsigned char> row((size_t)width * 3);
+    bool ok = true;
+    for (int y = 0; y < height && ok; ++y) {
+        const uint32_t* p = &pixels[(size_t)y * width];
+        for (int x = 0; x < width; ++x) {
+            row[x * 3 + 0] = (unsigned char)(p[x] >> 16);
+            row[x * 3 + 1] = (unsigned char)(p[x] >> 8);
+            row[x * 3 + 2] = (unsigned char)p[x];
+        }
+        ok = std::fwrite(row.data(), 1, row.size(), f) == row.size();
+    }
+    return std::fclose(f) == 0 && ok;
+}
+
+bool SoftFramebuffer::ReadPpm(const std::string& path) {
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f)
+        return false;
+    int w = 0, h = 0, maxval = 0;
+    bool ok = std::fscanf(f, "P6 %d %d %d", &w, &h, &maxval) == 3 && maxval == 255 &&
+              w > 0 && h > 0 && std::fgetc(f) != EOF;
+    if (ok) {
+        Resize(w, h);
+        std::vector<unsigned char> row((size_t)w * 3);
+        for (int y = 0; y < h && ok; ++y) {
+            ok = std::fread(row.data(), 1, row.size(), f) == row.size();
+            uint32_t* p = &pixels[(size_t)y * w];
+            for (int x = 0; x < w && ok; ++x)
+                p[x] = 0xFF000000u | (uint32_t)row[x * 3] << 16 | (uint32_t)row[x * 3 + 1] << 8 | row[x * 3 + 2];
+        }
+    }
+    std::fclose(f);
+    return ok;
+}
+
+// --- renderer ---
+
+SoftRenderer::SoftRenderer(int threads) {
+    if (threads <= 0)
+        threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    m_white.width = m_white.height = 1;
+    m_white.texels.assign(1, 0xFFFFFFFFu);
+    for (int i = 1; i < threads; ++i)
+        m_workers.emplace_back([this] { WorkerMain(); });
+}
+
+SoftRenderer::~SoftRenderer() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& t : m_workers)
+        t.join();
+}
+
+void SoftRenderer::Init() {
+    ImGuiIO& io = ImGui::GetIO();
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasTextures | ImGuiBackendFlags_RendererHasVtxOffset;
+    io.BackendRendererName = "wws_soft";
+}
+
+void SoftRenderer::Shutdown() {
+    for (ImTextureData* tex : ImGui::GetPlatformIO().Textures) {
+        if (tex->RefCount == 1 && tex->TexID != ImTextureID_Invalid) {
+            tex->SetTexID(ImTextureID_Invalid);
+            tex->SetStatus(ImTextureStatus_Destroyed);
+        }
+    }
+    m_textures.clear();
+    ImGuiIO& io = ImGui::GetIO();
+    io.BackendFlags &= ~(ImGuiBackendFlags_RendererHasTextures | ImGuiBackendFlags_RendererHasVtxOffset);
+    io.BackendRendererName = nullptr;
+}
+
+void SoftRenderer::Update() {
+    for (ImTextureData* tex : ImGui::GetPlatformIO().Textures)
+        if (tex->Status != ImTextureStatus_OK)
+            UpdateTexture(tex);
+}
+
+void SoftRenderer::UpdateTexture(ImTextureData* tex) {
+    auto copy = [tex](Texture& t, int x, int y, int w, int h) {
+        for (int row = y; row < y + h; ++row) {
+            const unsigned char* src = (const unsigned char*)tex->GetPixelsAt(x, row);
+            uint32_t* dst = &t.texels[(size_t)row * t.width + x];
+            if (tex->Format == ImTextureFormat_RGBA32)
+                std::memcpy(dst, src, (size_t)w * 4);
+            else
+                for (int i = 0; i < w; ++i)
+                    dst[i] = 0x00FFFFFFu | (uint32_t)src[i] << 24;
+        }
+    };
+
+    switch (tex->Status) {
+    case ImTextureStatus_WantCreate: {
+        auto t = std::make_unique<Texture>();
+        t->width = tex->Width;
+        t->height = tex->Height;
+        t->texels.resize((size_t)t->width * t->height);
+        copy(*t, 0, 0, t->width, t->height);
+        tex->SetTexID((ImTextureID)(intptr_t)t.get());
+        tex->SetStatus(ImTextureStatus_OK);
+        m_textures.push_back(std::move(t));
+        break;
+    }
+    case ImTextureStatus_WantUpdates: {
+        Texture* t = (Texture*)(intptr_t)tex->TexID;
+        for (const ImTextureRect& r : tex->Updates)
+            copy(*t, r.x, r.y, r.w, r.h);
+        tex->SetStatus(ImTextureStatus_OK);
+        break;
+    }
+    case ImTextureStatus_WantDestroy:
+        if (tex->UnusedFrames > 0) {
+            Texture* t = (Texture*)(intptr_t)tex->TexID;
+            m_textures.erase(std::remove_if(m_textures.begin(), m_textures.end(),
+                                            [t](const std::unique_ptr<Texture>& p) { return p.get() == t; }),
+                             m_textures.end());
+            tex->SetTexID(ImTextureID_Invalid);
+            tex->SetStatus(ImTextureStatus_Destroyed);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void SoftRenderer::Render(const ImDrawData* dd, SoftFramebuffer& fb) {
+    m_stats = Stats();
+    if (dd->Textures)
+        for (ImTextureData* tex : *dd->Textures)
+            if (tex->Status != ImTextureStatus_OK)
+                UpdateTexture(tex);
+    m_stats.textures = m_textures.size();
+    if (fb.width == 0 || fb.height == 0 || dd->CmdListsCount == 0)
+        return;
+
+    m_tilesX = (fb.width + kTileSize - 1) / kTileSize;
+    m_tilesY = (fb.height + kTileSize - 1) / kTileSize;
+    m_bins.resize((size_t)m_tilesX * m_tilesY);
+    for (std::vector<uint32_t>& bin : m_bins)
+        bin.clear();
+    m_prims.clear();
+    m_tris.clear();
+    AddCommands(dd, fb);
+    if (m_prims.empty())
+        return;
+
+    m_fb = &fb;
+    m_nextTile.store(0, std::memory_order_relaxed);
+    if (!m_workers.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_job;
+            m_busy = (int)m_workers.size();
+        }
+        m_wake.notify_all();
+    }
+    FillTiles();
+    if (!m_workers.empty()) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this] { return m_busy == 0; });
+    }
+    m_fb = nullptr;
+}
+
+// --- setup ---
+
+void SoftRenderer::AddCommands(const ImDrawData* dd, const SoftFramebuffer& fb) {
+    m_origin = dd->DisplayPos;
+    m_scale = dd->FramebufferScale;
+    for (const ImDrawList* list : dd->CmdLists) {
+        for (const ImDrawCmd& cmd : list->CmdBuffer) {
+            if (cmd.UserCallback) {
+                if (cmd.UserCallback != ImDrawCallback_ResetRenderState)
+                    cmd.UserCallback(list, &cmd);
+                continue;
+            }
+            // same rounding as a scissor rect
+            int clip[4] = {
+                std::max(0, (int)((cmd.ClipRect.x - m_origin.x) * m_scale.x)),
+                std::max(0, (int)((cmd.ClipRect.y - m_origin.y) * m_scale.y)),
+                std::min(fb.width, (int)((cmd.ClipRect.z - m_origin.x) * m_scale.x)),
+                std::min(fb.height, (int)((cmd.ClipRect.w - m_origin.y) * m_scale.y)),
+            };
+            if (clip[0] >= clip[2] || clip[1] >= clip[3])
+                continue;
+
+            ImTextureID id = cmd.GetTexID();
+            const Texture* tex = id == ImTextureID_Invalid ? &m_white : (const Texture*)(intptr_t)id;
+            const ImDrawVert* vtx = list->VtxBuffer.Data + cmd.VtxOffset;
+            const ImDrawIdx* idx = list->IdxBuffer.Data + cmd.IdxOffset;
+            for (unsigned int k = 0; k + 3 <= cmd.ElemCount;) {
+                if (m_quadFastPath && k + 6 <= cmd.ElemCount && AddQuad(vtx, idx + k, tex, clip)) {
+                    k += 6;
+                    continue;
+                }
+                AddTri(vtx[idx[k]], vtx[idx[k + 1]], vtx[idx[k + 2]], tex, clip);
+                k += 3;
+            }
+        }
+    }
+}
+
+// Two triangles (a, b, c) (a, c, d) making an axis-aligned rectangle with
+// one colour and axis-aligned uvs, the way ImDrawList::PrimRectUV() and
+// text lay them out
+bool SoftRenderer::AddQuad(const ImDrawVert* v, const ImDrawIdx* idx, const Texture* tex, const int clip[4]) {
+    if (idx[3] != idx[0] || idx[4] != idx[2])
+        return false;
+    const ImDrawVert& a = v[idx[0]];
+    const ImDrawVert& b = v[idx[1]];
+    const ImDrawVert& c = v[idx[2]];
+    const ImDrawVert& d = v[idx[5]];
+    if (a.col != b.col || a.col != c.col || a.col != d.col)
+        return false;
+    if (a.pos.y != b.pos.y || b.pos.x != c.pos.x || c.pos.y != d.pos.y || d.pos.x != a.pos.x)
+        return false;
+    if (a.uv.y != b.uv.y || b.uv.x != c.uv.x || c.uv.y != d.uv.y || d.uv.x != a.uv.x)
+        return false;
+    if ((a.col >> 24) == 0)
+        return true;
+
+    float ax = (a.pos.x - m_origin.x) * m_scale.x, ay = (a.pos.y - m_origin.y) * m_scale.y;
+    float cx = (c.pos.x - m_origin.x) * m_scale.x, cy = (c.pos.y - m_origin.y) * m_scale.y;
+    if (ax == cx || ay == cy)
+        return true;
+    // pixels whose centre is inside, same as the triangle path's fill rule
+    Prim p;
+    p.x0 = std::max(clip[0], (int)std::ceil(std::min(ax, cx) - 0.5f));
+    p.x1 = std::min(clip[2], (int)std::ceil(std::max(ax, cx) - 0.5f));
+    p.y0 = std::max(clip[1], (int)std::ceil(std::min(ay, cy) - 0.5f));
+    p.y1 = std::min(clip[3], (int)std::ceil(std::max(ay, cy) - 0.5f));
+    if (p.x0 >= p.x1 || p.y0 >= p.y1)
+        return true;
+
+    p.tex = tex;
+    p.quad = true;
+    p.tri = 0;
+    p.du = (c.uv.x - a.uv.x) / (cx - ax) * tex->width;
+    p.dv = (c.uv.y - a.uv.y) / (cy - ay) * tex->height;
+    p.u0 = a.uv.x * tex->width + (0.5f - ax) * p.du;
+    p.v0 = a.uv.y * tex->height + (0.5f - ay) * p.dv;
+    p.solid = a.uv.x == c.uv.x && a.uv.y == c.uv.y;
+    if (p.solid) {
+        uint32_t texel = tex->texels[(size_t)TexelIndex(a.uv.y * tex->height, tex->height) * tex->width +
+                                     TexelIndex(a.uv.x * tex->width, tex->width)];
+        p.color = Modulate(a.col, texel);
+        if ((p.color >> 24) == 0)
+            return true;
+    }
+    else {
+        p.color = a.col;
+    }
+    m_prims.push_back(p);
+    ++m_stats.quads;
+    Bin((uint32_t)m_prims.size() - 1);
+    return true;
+}
+
+void SoftRenderer::AddTri(const ImDrawVert& a, const ImDrawVert& b, const ImDrawVert& c,
+                          const Texture* tex, const int clip[4]) {
+    if ((a.col >> 24) == 0 && (b.col >> 24) == 0 && (c.col >> 24) == 0)
+        return;   // AA fringes fade to nothing on their outer side; these are all fringe
+    const ImDrawVert* vs[3] = { &a, &b, &c };
+    float x[3], y[3];
+    for (int i = 0; i < 3; ++i) {
+        x[i] = (vs[i]->pos.x - m_origin.x) * m_scale.x;
+        y[i] = (vs[i]->pos.y - m_origin.y) * m_scale.y;
+    }
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+    if (area == 0.0f)
+        return;
+
+    Prim p;
+    p.x0 = std::max(clip[0], (int)std::ceil(std::min({ x[0], x[1], x[2] }) - 0.5f));
+    p.x1 = std::min(clip[2], (int)std::ceil(std::max({ x[0], x[1], x[2] }) - 0.5f));
+    p.y0 = std::max(clip[1], (int)std::ceil(std::min({ y[0], y[1], y[2] }) - 0.5f));
+    p.y1 = std::min(clip[3], (int)std::ceil(std::max({ y[0], y[1], y[2] }) - 0.5f));
+    if (p.x0 >= p.x1 || p.y0 >= p.y1)
+        return;
+
+    Tri t;
+    float inv = 1.0f / area;
+    for (int i = 0; i < 3; ++i) {
+        int j = (i + 1) % 3, k = (i + 2) % 3;
+        float dx = x[k] - x[j], dy = y[k] - y[j];
+        t.ea[i] = -dy * inv;
+        t.eb[i] = dx * inv;
+        t.ec[i] = (dy * x[j] - dx * y[j]) * inv + 0.5f * (t.ea[i] + t.eb[i]);
+        // top-left rule, so a pixel on an edge two triangles share is drawn once
+        bool inclusive = t.ea[i] > 0.0f || (t.ea[i] == 0.0f && t.eb[i] > 0.0f);
+        t.min[i] = inclusive ? 0.0f : std::numeric_limits<float>::min();
+        t.u[i] = vs[i]->uv.x * tex->width;
+        t.v[i] = vs[i]->uv.y * tex->height;
+        for (int ch = 0; ch < 4; ++ch)
+            t.c[ch][i] = (float)((vs[i]->col >> (ch * 8)) & 0xFF);
+    }
+    m_tris.push_back(t);
+
+    p.tex = tex;
+    p.color = 0;
+    p.quad = false;
+    p.solid = false;
+    p.tri = (uint32_t)m_tris.size() - 1;
+    p.u0 = p.du = p.v0 = p.dv = 0.0f;
+    m_prims.push_back(p);
+    ++m_stats.triangles;
+    Bin((uint32_t)m_prims.size() - 1);
+}
+
+void SoftRenderer::Bin(uint32_t prim) {
+    const Prim& p = m_prims[prim];
+    int tx0 = p.x0 / kTileSize, tx1 = (p.x1 - 1) / kTileSize;
+    int ty0 = p.y0 / kTileSize, ty1 = (p.y1 - 1) / kTileSize;
+    for (int ty = ty0; ty <= ty1; ++ty)
+        for (int tx = tx0; tx <= tx1; ++tx)
+            m_bins[(size_t)ty * m_tilesX + tx].push_back(prim);
+    m_stats.binned += (size_t)(tx1 - tx0 + 1) * (ty1 - ty0 + 1);
+}
+
+// --- fill ---
+
+void SoftRenderer::WorkerMain() {
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_job != seen; });
+            if (m_stop)
+                return;
+            seen = m_job;
+        }
+        FillTiles();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_busy == 0)
+                m_done.notify_one();
+        }
+    }
+}
+
+void SoftRenderer::FillTiles() {
+    const int count = m_tilesX * m_tilesY;
+    for (;;) {
+        int tile = m_nextTile.fetch_add(1, std::memory_order_relaxed);
+        if (tile >= count)
+            return;
+        FillTile(tile);
+    }
+}
+
+void SoftRenderer::FillTile(int tile) {
+    const int tx0 = (tile % m_tilesX) * kTileSize;
+    const int ty0 = (tile / m_tilesX) * kTileSize;
+    const int tx1 = std::min(tx0 + kTileSize, m_fb->width);
+    const int ty1 = std::min(ty0 + kTileSize, m_fb->height);
+    for (uint32_t i : m_bins[tile]) {
+        const Prim& p = m_prims[i];
+        int x0 = std::max(p.x0, tx0), x1 = std::min(p.x1, tx1);
+        int y0 = std::max(p.y0, ty0), y1 = std::min(p.y1, ty1);
+        if (p.quad)
+            FillQuad(p, x0, y0, x1, y1);
+        else
+            FillTri(p, x0, y0, x1, y1);
+    }
+}
+
+void SoftRenderer::FillQuad(const Prim& p, int x0, int y0, int x1, int y1) {
+    SoftFramebuffer& fb = *m_fb;
+    if (p.solid) {
+        for (int y = y0; y < y1; ++y)
+            BlendSpan(&fb.pixels[(size_t)y * fb.width + x0], x1 - x0, p.color);
+        return;
+    }
+    const Texture& tex = *p.tex;
+    for (int y = y0; y < y1; ++y) {
+        const uint32_t* texels = &tex.texels[(size_t)TexelIndex(p.v0 + y * p.dv, tex.height) * tex.width];
+        uint32_t* dst = &fb.pixels[(size_t)y * fb.width];
+        for (int x = x0; x < x1; ++x) {
+            uint32_t texel = texels[TexelIndex(p.u0 + x * p.du, tex.width)];
+            if (texel >> 24)
+                dst[x] = Over(dst[x], Modulate(p.color, texel));
+        }
+    }
+}
+
+void SoftRenderer::FillTri(const Prim& p, int x0, int y0, int x1, int y1) {
+    SoftFramebuffer& fb = *m_fb;
+    const Tri& t = m_tris[p.tri];
+    const Texture& tex = *p.tex;
+
+    // shades the pixel at dst with weights w (of vertices 0, 1, 2)
+    auto shade = [&](uint32_t& dst, float w0, float w1, float w2) {
+        float u = w0 * t.u[0] + w1 * t.u[1] + w2 * t.u[2];
+        float v = w0 * t.v[0] + w1 * t.v[1] + w2 * t.v[2];
+        uint32_t col = 0;
+        for (int ch = 0; ch < 4; ++ch) {
+            float c = w0 * t.c[ch][0] + w1 * t.c[ch][1] + w2 * t.c[ch][2];
+            col |= (uint32_t)std::min(255.0f, std::max(0.0f, c + 0.5f)) << (ch * 8);
+        }
+        uint32_t texel = tex.texels[(size_t)TexelIndex(v, tex.height) * tex.width + TexelIndex(u, tex.width)];
+        dst = Over(dst, Modulate(col, texel));
+    };
+
+    for (int y = y0; y < y1; ++y) {
+        uint32_t* row = &fb.pixels[(size_t)y * fb.width];
+        float r0 = t.eb[0] * y + t.ec[0];
+        float r1 = t.eb[1] * y + t.ec[1];
+        float r2 = t.eb[2] * y + t.ec[2];
+        int x = x0;
+#ifdef WWS_SOFT_SSE2
+        // four pixels per step: edge functions, then the covered ones shaded
+        const __m128i lanes = _mm_set_epi32(3, 2, 1, 0);
+        const __m128 a0 = _mm_set1_ps(t.ea[0]), a1 = _mm_set1_ps(t.ea[1]), a2 = _mm_set1_ps(t.ea[2]);
+        const __m128 m0 = _mm_set1_ps(t.min[0]), m1 = _mm_set1_ps(t.min[1]), m2 = _mm_set1_ps(t.min[2]);
+        const __m128 b0 = _mm_set1_ps(r0), b1 = _mm_set1_ps(r1), b2 = _mm_set1_ps(r2);
+        for (; x < x1; x += 4) {
+            __m128 xs = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(x), lanes));
+            __m128 w0 = _mm_add_ps(_mm_mul_ps(a0, xs), b0);
+            __m128 w1 = _mm_add_ps(_mm_mul_ps(a1, xs), b1);
+            __m128 w2 = _mm_add_ps(_mm_mul_ps(a2, xs), b2);
+            __m128 in = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(w0, m0), _mm_cmpge_ps(w1, m1)), _mm_cmpge_ps(w2, m2));
+            int mask = _mm_movemask_ps(in);
+            if (x1 - x < 4)
+                mask &= (1 << (x1 - x)) - 1;
+            if (!mask)
+                continue;
+            alignas(16) float f0[4], f1[4], f2[4];
+            _mm_store_ps(f0, w0);
+            _mm_store_ps(f1, w1);
+            _mm_store_ps(f2, w2);
+            for (int l = 0; l < 4; ++l)
+                if (mask & (1 << l))
+                    shade(row[x + l], f0[l], f1[l], f2[l]);
+        }
+#else
+        for (; x < x1; ++x) {
+            float w0 = t.ea[0] * x + r0, w1 = t.ea[1] * x + r1, w2 = t.ea[2] * x + r2;
+            if (w0 >= t.min[0] && w1 >= t.min[1] && w2 >= t.min[2])
+                shade(row[x], w0, w1, w2);
+        }
+#endif
+    }
+}
@@ -0,0 +1,188 @@
+﻿// === src/switcher.cpp ===
+#include "switcher.h"
+#include "key_bindings.h"   // BindingActionOf, BindingIndexOf
+
+static constexpr uint64_t kNsPerMs = 1000000;
+
+// Rows are SwitcherState, columns are Input
+const SwitcherMachine::Handler SwitcherMachine::kTable[4][kInputCount] = {
+    //                InitiatorDown             InitiatorUp                  ModifierDown                     ModifierUp                  Timeout
+    /* Idle        */ { &SwitcherMachine::Begin,  &SwitcherMachine::Ignore,     &SwitcherMachine::Ignore,        &SwitcherMachine::Ignore,   &SwitcherMachine::Ignore },
+    /* TapPending  */ { &SwitcherMachine::Ignore, &SwitcherMachine::Cancel,     &SwitcherMachine::PressModifier, &SwitcherMachine::FirstTap, &SwitcherMachine::StartHold },
+    /* QuickSelect */ { &SwitcherMachine::Ignore, &SwitcherMachine::FinishTaps, &SwitcherMachine::PressModifier, &SwitcherMachine::CountTap, &SwitcherMachine::StartHold },
+    /* Listing     */ { &SwitcherMachine::Ignore, &SwitcherMachine::Commit,     &SwitcherMachine::Cycle,         &SwitcherMachine::Ignore,   &SwitcherMachine::Ignore },
+};
+
+bool SwitcherMachine::IsKey(uint16_t key, uint16_t cfg) {
+    switch (cfg) {
+    case vk::Menu:   return key == vk::LMenu || key == vk::RMenu;
+    case vk::Shift:  return key == vk::LShift || key == vk::RShift;
+    default:         return key == cfg;
+    }
+}
+
+KeyClass SwitcherMachine::Classify(uint16_t key, const SwitcherConfig& cfg) {
+    if (IsKey(key, cfg.initiator)) return KeyClass::Initiator;
+    if (IsKey(key, cfg.modifier))  return KeyClass::Modifier;
+    return KeyClass::Other;
+}
+
+int SwitcherMachine::OnKey(const KeyEvent& ev, SwitcherAction* out) {
+    // a deadline that expired before this key was pressed wins
+    int n = OnTimer(ev.timeNs, out);
+
+    if (ev.cls == KeyClass::Binding)
+        return n + OnBinding(ev, out + n);
+
+    Input in;
+    switch (ev.cls) {
+    case KeyClass::Initiator: in = ev.down ? InitiatorDown : InitiatorUp; break;
+    case KeyClass::Modifier:  in = ev.down ? ModifierDown : ModifierUp;   break;
+    default:                  return n;
+    }
+    n += (this->*kTable[(int)m_state][in])(ev.timeNs, out + n);
+    if (ev.cls == KeyClass::Modifier) {
+        m_modifierDown = ev.down;
+        if (!ev.down) m_holdPress = false;
+    }
+    return n;
+}
+
+int SwitcherMachine::OnTimer(uint64_t nowNs, SwitcherAction* out) {
+    if (m_deadlineNs == 0 || nowNs < m_deadlineNs)
+        return 0;
+    // handlers see the deadline itself, not the (later) time we noticed it
+    uint64_t due = m_deadlineNs;
+    m_deadlineNs = 0;
+    return (this->*kTable[(int)m_state][Timeout])(due, out);
+}
+
+void SwitcherMachine::Reset() {
+    m_state = SwitcherState::Idle;
+    m_tapCount = 0;
+    m_modifierDown = false;
+    m_holdPress = false;
+    m_bindingHold = false;
+    m_modifierDownNs = 0;
+    m_deadlineNs = 0;
+}
+
+int SwitcherMachine::Ignore(uint64_t, SwitcherAction*) {
+    return 0;
+}
+
+// --- initiator down: start fresh ---
+int SwitcherMachine::Begin(uint64_t, SwitcherAction*) {
+    m_state = SwitcherState::TapPending;
+    m_tapCount = 0;
+    m_deadlineNs = 0;
+    return 0;
+}
+
+// --- initiator up without any modifier activity ---
+int SwitcherMachine::Cancel(uint64_t, SwitcherAction* out) {
+    out[0] = { SwitcherActionType::Cancel, 0 };
+    m_state = SwitcherState::Idle;
+    m_tapCount = 0;
+    m_deadlineNs = 0;
+    return 1;
+}
+
+// --- modifier down before the overlay is up: arm the hold deadline ---
+int SwitcherMachine::PressModifier(uint64_t now, SwitcherAction*) {
+    if (m_modifierDown)   // auto-repeat
+        return 0;
+    m_modifierDownNs = now;
+    m_deadlineNs = now + (uint64_t)m_cfg.tapTimeoutMs * kNsPerMs;
+    return 0;
+}
+
+// --- first modifier up before the hold deadline: it was a tap ---
+int SwitcherMachine::FirstTap(uint64_t now, SwitcherAction* out) {
+    m_state = SwitcherState::QuickSelect;
+    return CountTap(now, out);
+}
+
+// --- every further tap; holding the initiator after it opens the overlay ---
+int SwitcherMachine::CountTap(uint64_t now, SwitcherAction*) {
+    ++m_tapCount;
+    m_deadlineNs = now + (uint64_t)m_cfg.overlayTimeoutMs * kNsPerMs;
+    return 0;
+}
+
+// --- initiator up after taps: single tap or quick-select ---
+int SwitcherMachine::FinishTaps(uint64_t, SwitcherAction* out) {
+    if (m_tapCount == 1)
+        out[0] = { SwitcherActionType::Tap, 0 };
+    else
+        out[0] = { SwitcherActionType::QuickSelect, m_tapCount };
+    m_state = SwitcherState::Idle;
+    m_tapCount = 0;
+    m_deadlineNs = 0;
+    return 1;
+}
+
+// --- a deadline expired with the keys still held: show the overlay now ---
+int SwitcherMachine::StartHold(uint64_t, SwitcherAction* out) {
+    out[0] = { SwitcherActionType::HoldStart, 0 };
+    m_state = SwitcherState::Listing;
+    m_holdPress = m_modifierDown;
+    return 1;
+}
+
+// --- modifier down while listing: cycle (auto-repeat keeps cycling, except
+//     for the press that opened the overlay) ---
+int SwitcherMachine::Cycle(uint64_t, SwitcherAction* out) {
+    if (m_holdPress)
+        return 0;
+    out[0] = { SwitcherActionType::Cycle, 0 };
+    return 1;
+}
+
+// --- initiator (or an overlay binding) up while listing ---
+int SwitcherMachine::Commit(uint64_t, SwitcherAction* out) {
+    out[0] = { SwitcherActionType::Commit, 0 };
+    m_state = SwitcherState::Idle;
+    m_tapCount = 0;
+    m_deadlineNs = 0;
+    m_bindingHold = false;
+    return 1;
+}
+
+// --- a key binding; taps and a listing the initiator opened keep the keys ---
+int SwitcherMachine::OnBinding(const KeyEvent& ev, SwitcherAction* out) {
+    const bool free = m_state == SwitcherState::Idle || m_state == SwitcherState::TapPending;
+    if (BindingActionOf(ev.vk) == BindingAction::Select) {
+        if (!free || !ev.down)
+            return 0;
+        out[0] = { SwitcherActionType::QuickSelect, BindingIndexOf(ev.vk) };
+        return 1;
+    }
+    if (m_state == SwitcherState::Listing && m_bindingHold) {
+        if (ev.down) {
+            out[0] = { SwitcherActionType::Cycle, 0 };
+            return 1;
+        }
+        return Commit(ev.timeNs, out);
+    }
+    if (!free || !ev.down)
+        return 0;
+    out[0] = { SwitcherActionType::HoldStart, 0 };
+    m_state = SwitcherState::Listing;
+    m_deadlineNs = 0;
+    m_holdPress = false;
+    m_bindingHold = true;
+    return 1;
+}
+
+const char* SwitcherActionName(SwitcherActionType type) {
+    switch (type) {
+    case SwitcherActionType::Tap:         return "tap";
+    case SwitcherActionType::HoldStart:   return "hold-start";
+    case SwitcherActionType::Cycle:       return "cycle";
+    case SwitcherActionType::Commit:      return "commit";
+    case SwitcherActionType::Cancel:      return "cancel";
+    case SwitcherActionType::QuickSelect: return "quick-select";
+    }
+    return "?";
+}
@@ -0,0 +1,46 @@
+﻿// === src/switcher_scheduler.cpp ===
+#include "switcher_scheduler.h"
+
+SwitcherScheduler::SwitcherScheduler(SwitcherMachine& machine, KeyEventChannel& keys,
+    const Clock& clock, ActionFn onAction)
+    : m_machine(machine), m_keys(keys), m_clock(clock), m_onAction(std::move(onAction)) {}
+
+bool SwitcherScheduler::RunOnce() {
+    uint64_t timeout = KeyEventChannel::kNoTimeout;
+    if (uint64_t deadline = m_machine.Deadline()) {
+        uint64_t now = m_clock.NowNs();
+        timeout = deadline > now ? deadline - now : 0;
+    }
+
+    KeyEvent ev;
+    switch (m_keys.WaitPop(ev, timeout)) {
+    case KeyEventChannel::PopResult::Event:   HandleKey(ev); return true;
+    case KeyEventChannel::PopResult::Timeout: Poll();        return true;
+    case KeyEventChannel::PopResult::Closed:  return false;
+    }
+    return false;
+}
+
+// Keys still in the queue may predate the deadline, so they go first
+void SwitcherScheduler::Poll() {
+    KeyEvent ev;
+    while (m_keys.WaitPop(ev, 0) == KeyEventChannel::PopResult::Event)
+        HandleKey(ev);
+    HandleTimer();
+}
+
+void SwitcherScheduler::HandleKey(const KeyEvent& ev) {
+    if (m_onKey)
+        m_onKey(ev);
+    SwitcherAction actions[SwitcherMachine::kMaxActions];
+    int n = m_machine.OnKey(ev, actions);
+    for (int i = 0; i < n; ++i)
+        m_onAction(actions[i]);
+}
+
+void SwitcherScheduler::HandleTimer() {
+    SwitcherAction actions[SwitcherMachine::kMaxActions];
+    int n = m_machine.OnTimer(m_clock.NowNs(), actions);
+    for (int i = 0; i < n; ++i)
+        m_onAction(actions[i]);
+}
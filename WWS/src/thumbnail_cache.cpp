@@ -0,0 +1,374 @@
+﻿// === src/thumbnail_cache.cpp ===
+#include "thumbnail_cache.h"
+#include "icon_atlas.h"       // QueueTextureUpload
+#include "fetch_pool.h"
+#include "imgui_internal.h"   // RegisterUserTexture
+
+#include <algorithm>
+#include <cmath>
+
+// Scratch rows kept between captures; a very wide window's are dropped
+static constexpr size_t kScratchKeep = 64 * 1024;
+
+// The most DownscaleRgba()'s scratch grows to for a source this wide: k
+// rows of columns, then two rows and a blend of the box-filtered width
+static size_t ScratchBytes(int srcW, int dstW) {
+    return (size_t)srcW * 4 * sizeof(uint16_t) + ((size_t)srcW + 1) * 3 * sizeof(uint32_t) +
+           (size_t)dstW * sizeof(uint32_t);
+}
+
+static bool Usable(const WindowImage& img) {
+    return img.width > 0 && img.height > 0 && img.rgba.size() >= (size_t)img.width * img.height;
+}
+
+struct ThumbnailCache::Inbox {
+    std::mutex            mutex;
+    std::vector<Done>     done;
+    std::function<void()> onDone;
+};
+
+ThumbnailCache::ThumbnailCache(int cellWidth, int cellHeight, size_t budgetBytes, size_t captureBytes,
+                               const Clock& clock)
+    : m_clock(clock), m_cellW(cellWidth), m_cellH(cellHeight), m_budget(budgetBytes),
+      m_captureRoom(captureBytes), m_inbox(std::make_shared<Inbox>())
+{
+    // what isn't the texture: the captures, a cell-sized result per capture
+    // in flight, and the downscaler's rows; each cell has a gutter right
+    // and below
+    const size_t cell = (size_t)m_cellW * m_cellH * 4;
+    const size_t reserve = captureBytes + kMaxInFlight * cell + kScratchKeep;
+    const size_t paddedCell = (size_t)(m_cellW + 1) * (m_cellH + 1) * 4;
+    const size_t maxSlots = std::max<size_t>(1, budgetBytes > reserve ? (budgetBytes - reserve) / paddedCell : 0);
+    m_columns = std::max(1, (int)std::sqrt((double)maxSlots));
+    const int rows = std::max(1, (int)(maxSlots / (size_t)m_columns));
+    m_owner.assign((size_t)m_columns * rows, 0);
+    m_tex.Create(ImTextureFormat_RGBA32, m_columns * (m_cellW + 1), rows * (m_cellH + 1));
+    m_stats.uploadBytes += (size_t)m_tex.GetSizeInBytes();
+}
+
+ThumbnailCache::~ThumbnailCache() {
+    if (ImGui::GetCurrentContext())
+        Detach();
+}
+
+void ThumbnailCache::SetUpdateCallback(std::function<void()> fn) {
+    std::lock_guard<std::mutex> lock(m_inbox->mutex);
+    m_inbox->onDone = std::move(fn);
+}
+
+void ThumbnailCache::Attach() {
+    if (m_attached)
+        return;
+    ImGui::RegisterUserTexture(&m_tex);
+    m_attached = true;
+}
+
+void ThumbnailCache::Detach() {
+    if (!m_attached)
+        return;
+    ImGui::UnregisterUserTexture(&m_tex);
+    m_attached = false;
+}
+
+void ThumbnailCache::NewFrame() {
+    ++m_frame;
+    m_capturesThisFrame = 0;
+    m_pending = false;
+    if (m_tex.Status == ImTextureStatus_OK) {
+        // the backend has consumed last frame's uploads
+        m_tex.Updates.resize(0);
+        m_tex.UpdateRect.x = m_tex.UpdateRect.y = (unsigned short)~0;
+        m_tex.UpdateRect.w = m_tex.UpdateRect.h = 0;
+    }
+    else if (m_tex.Status == ImTextureStatus_Destroyed) {
+        // backend was torn down (device lost, shutdown); we still have the pixels
+        m_tex.Updates.resize(0);
+        m_tex.SetStatus(ImTextureStatus_WantCreate);
+        m_stats.uploadBytes += (size_t)m_tex.GetSizeInBytes();
+    }
+
+    // what the workers downscaled since last frame, into its cells now
+    std::vector<Done> done;
+    {
+        std::lock_guard<std::mutex> lock(m_inbox->mutex);
+        done.swap(m_inbox->done);
+    }
+    for (Done& d : done) {
+        m_loading.erase(d.id);
+        m_captureBytes -= d.reserved;
+        ++m_stats.captures;
+        m_stats.largestCapture = std::max(m_stats.largestCapture, d.captureBytes);
+        auto it = m_entries.find(d.id);
+        if (it == m_entries.end())
+            continue;   // cleared meanwhile
+        if (it->second.slot >= 0)
+            ++m_stats.refreshes;
+        if (!d.ok) {
+            ++m_stats.failures;
+            continue;
+        }
+        m_stats.sourcePixels += d.sourcePixels;
+        m_stats.downscaleNs += d.downscaleNs;
+        if (!Store(d.id, it->second, d.thumb.rgba.data(), d.thumb.width, d.thumb.height))
+            it->second.attempted = false;   // every cell was on screen; try again when drawn
+    }
+
+    // windows looked at once and never captured don't pile up
+    if (m_entries.size() > 2 * m_owner.size()) {
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            if (it->second.slot < 0 && it->second.lastUsed + 1 < m_frame && !m_loading.count(it->first))
+                it = m_entries.erase(it);
+            else
+                ++it;
+        }
+    }
+}
+
+bool ThumbnailCache::Get(WindowId id, ImVec2& uv0, ImVec2& uv1, ImVec2& size) {
+    Entry& e = m_entries[id];
+    e.lastUsed = m_frame;
+
+    const uint64_t now = m_clock.NowNs();
+    const bool due = !e.attempted || (m_refreshNs && now - e.capturedNs >= m_refreshNs);
+    // (one still on a worker asks for the frame itself)
+    if (due && m_source && !m_loading.count(id)) {
+        int w = 0, h = 0;
+        const bool sized = m_source->Size(id, w, h) && w > 0 && h > 0;
+        const size_t cost = sized ? m_source->CaptureBytes(w, h) + ScratchBytes(w, m_cellW) : 0;
+        if (!sized || cost > m_captureRoom) {
+            // gone, or over the budget however long it waited; the old
+            // thumbnail, if any, stays up until it is asked again once stale
+            e.capturedNs = now;
+            e.attempted = true;
+            if (sized)
+                ++m_stats.oversized;
+            else
+                ++m_stats.failures;
+        }
+        else if (m_loader) {
+            if ((int)m_loading.size() < kMaxInFlight && m_captureBytes + cost <= m_captureRoom &&
+                m_loader->Running()) {
+                e.capturedNs = now;
+                e.attempted = true;
+                Submit(id, cost);
+            }
+            else {
+                m_pending = true;
+            }
+        }
+        else if (m_capturesThisFrame < m_captureBudget) {
+            if (CaptureNow(id, e, cost)) {
+                ++m_capturesThisFrame;
+                e.capturedNs = now;
+                e.attempted = true;
+            }
+        }
+        else {
+            m_pending = true;
+        }
+    }
+
+    if (e.slot < 0)
+        return false;
+    const float iw = 1.0f / (float)m_tex.Width;
+    const float ih = 1.0f / (float)m_tex.Height;
+    const int x = CellX(e.slot), y = CellY(e.slot);
+    uv0 = ImVec2((float)x * iw, (float)y * ih);
+    uv1 = ImVec2((float)(x + e.w) * iw, (float)(y + e.h) * ih);
+    size = ImVec2((float)e.w, (float)e.h);
+    return true;
+}
+
+void ThumbnailCache::Clear() {
+    m_entries.clear();
+    std::fill(m_owner.begin(), m_owner.end(), (WindowId)0);
+}
+
+ThumbnailCache::Stats ThumbnailCache::GetStats() const {
+    Stats s = m_stats;
+    s.slots = m_owner.size();
+    s.entries = (size_t)std::count_if(m_owner.begin(), m_owner.end(), [](WindowId id) { return id != 0; });
+    s.retainedBytes = Retained();
+    s.peakBytes = std::max(s.peakBytes, s.retainedBytes);
+    s.budgetBytes = m_budget;
+    return s;
+}
+
+size_t ThumbnailCache::Retained() const {
+    return (size_t)m_tex.GetSizeInBytes() + m_scratch.Bytes() + m_captureBytes +
+           m_loading.size() * (size_t)m_cellW * m_cellH * 4;
+}
+
+void ThumbnailCache::Reserve(size_t bytes) {
+    m_captureBytes += bytes;
+    m_stats.peakBytes = std::max(m_stats.peakBytes, Retained());
+}
+
+// A free cell, or the least recently drawn one not drawn this frame; -1
+// when every cell is on screen
+int ThumbnailCache::TakeSlot(WindowId id) {
+    int slot = -1;
+    uint64_t oldest = m_frame;
+    for (size_t i = 0; i < m_owner.size(); ++i) {
+        if (m_owner[i] == 0) {
+            slot = (int)i;
+            break;
+        }
+        const uint64_t used = m_entries[m_owner[i]].lastUsed;
+        if (used < oldest) {
+            oldest = used;
+            slot = (int)i;
+        }
+    }
+    if (slot < 0)
+        return -1;
+    if (const WindowId victim = m_owner[(size_t)slot]) {
+        m_entries.erase(victim);
+        ++m_stats.evictions;
+    }
+    m_owner[(size_t)slot] = id;
+    return slot;
+}
+
+bool ThumbnailCache::Store(WindowId id, Entry& e, const uint32_t* pixels, int w, int h) {
+    if (e.slot < 0 && (e.slot = TakeSlot(id)) < 0)
+        return false;
+    const int x = CellX(e.slot), y = CellY(e.slot);
+    for (int row = 0; row < h; ++row)
+        std::copy(pixels + (size_t)row * w, pixels + (size_t)(row + 1) * w, (uint32_t*)m_tex.GetPixelsAt(x, y + row));
+    e.w = w;
+    e.h = h;
+    Upload(e);
+    return true;
+}
+
+// Captures on the UI thread and downscales straight into the cell; false,
+// without capturing, if there is no cell to put it in
+bool ThumbnailCache::CaptureNow(WindowId id, Entry& e, size_t cost) {
+    const bool refresh = e.slot >= 0;
+    if (refresh)
+        ++m_stats.refreshes;
+    else if ((e.slot = TakeSlot(id)) < 0)
+        return false;
+    Reserve(cost);     // until the capture is gone again
+    WindowImage img;   // lives only until downscaled
+    ++m_stats.captures;
+    if (!m_source->Capture(id, img) || !Usable(img)) {
+        m_captureBytes -= cost;
+        ++m_stats.failures;
+        if (!refresh) {
+            // the old thumbnail, if any, stays up; a new window gives its cell back
+            m_owner[(size_t)e.slot] = 0;
+            e.slot = -1;
+        }
+        return true;
+    }
+    m_stats.largestCapture = std::max(m_stats.largestCapture, img.rgba.size() * 4);
+    int w, h;
+    FitWithin(img.width, img.height, m_cellW, m_cellH, w, h);
+    const uint64_t start = SystemClock().NowNs();
+    DownscaleRgba(img.rgba.data(), img.width, img.height, (size_t)img.width,
+                  (uint32_t*)m_tex.GetPixelsAt(CellX(e.slot), CellY(e.slot)), w, h, (size_t)m_tex.Width,
+                  m_scratch);
+    m_stats.downscaleNs += SystemClock().NowNs() - start;
+    m_stats.sourcePixels += (uint64_t)img.width * img.height;
+    if (m_scratch.Bytes() > kScratchKeep)
+        m_scratch = DownscaleScratch();
+    m_captureBytes -= cost;
+    e.w = w;
+    e.h = h;
+    Upload(e);
+    return true;
+}
+
+void ThumbnailCache::Submit(WindowId id, size_t cost) {
+    m_loading.insert(id);
+    Reserve(cost);
+    m_loader->Submit([inbox = m_inbox, source = m_source, id, cost, cellW = m_cellW, cellH = m_cellH] {
+        Done d;
+        d.id = id;
+        d.reserved = cost;
+        {
+            WindowImage img;
+            d.ok = source->Capture(id, img) && Usable(img);
+            if (d.ok) {
+                d.captureBytes = img.rgba.size() * 4;
+                d.sourcePixels = (uint64_t)img.width * img.height;
+                FitWithin(img.width, img.height, cellW, cellH, d.thumb.width, d.thumb.height);
+                d.thumb.rgba.resize((size_t)d.thumb.width * d.thumb.height);
+                DownscaleScratch scratch;
+                const uint64_t start = SystemClock().NowNs();
+                DownscaleRgba(img.rgba.data(), img.width, img.height, (size_t)img.width,
+                              d.thumb.rgba.data(), d.thumb.width, d.thumb.height, (size_t)d.thumb.width, scratch);
+                d.downscaleNs = SystemClock().NowNs() - start;
+            }
+        }
+        std::function<void()> fn;
+        {
+            std::lock_guard<std::mutex> lock(inbox->mutex);
+            inbox->done.push_back(std::move(d));
+            fn = inbox->onDone;
+        }
+        if (fn)
+            fn();
+    });
+}
+
+void ThumbnailCache::Upload(const Entry& e) {
+    if (QueueTextureUpload(m_tex, CellX(e.slot), CellY(e.slot), e.w, e.h)) {
+        ++m_stats.uploadRects;
+        m_stats.uploadBytes += (size_t)e.w * e.h * 4;
+    }
+}
+
+// --- fake source ---
+
+void FakeThumbnailSource::SetSize(WindowId id, int width, int height) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_windows[id].width = width;
+    m_windows[id].height = height;
+}
+
+void FakeThumbnailSource::SetMissing(WindowId id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_windows[id].missing = true;
+}
+
+size_t FakeThumbnailSource::Captures() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_captures;
+}
+
+bool FakeThumbnailSource::Size(WindowId id, int& width, int& height) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Window& w = m_windows[id];
+    if (w.missing)
+        return false;
+    width = w.width;
+    height = w.height;
+    return true;
+}
+
+bool FakeThumbnailSource::Capture(WindowId id, WindowImage& out) {
+    Window w;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_captures;
+        Window& known = m_windows[id];
+        ++known.frame;
+        w = known;
+    }
+    if (w.missing)
+        return false;
+    out.width = w.width;
+    out.height = w.height;
+    out.rgba.resize((size_t)w.width * w.height);
+    const uint32_t blue = (uint32_t)((id * 37 + (uint64_t)w.frame * 8) & 0xFF) << 16;
+    for (int y = 0; y < w.height; ++y) {
+        const uint32_t green = (uint32_t)(y * 255 / w.height) << 8;
+        uint32_t* row = out.rgba.data() + (size_t)y * w.width;
+        for (int x = 0; x < w.width; ++x)
+            row[x] = 0xFF000000u | blue | green | (uint32_t)(x * 255 / w.width);
+    }
+    return true;
+}
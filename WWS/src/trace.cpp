@@ -0,0 +1,304 @@
+﻿// === src/trace.cpp ===
+#include "trace.h"
+
+#include <algorithm>
+#include <cinttypes>
+
+// --- ring ---
+
+void TraceRing::Write(const char* name, uint64_t beginNs, uint64_t endNs, uint64_t arg) {
+    const uint64_t h = m_head.load(std::memory_order_relaxed);
+    TraceRecord& r = m_records[h & (kCapacity - 1)];
+    r.beginNs = beginNs;
+    r.endNs = endNs;
+    r.name = name;
+    r.arg = arg;
+    m_head.store(h + 1, std::memory_order_release);
+}
+
+void TraceRing::Read(std::vector<TraceRecord>& out) const {
+    const uint64_t head = m_head.load(std::memory_order_acquire);
+    const uint64_t first = std::max(head > kCapacity ? head - kCapacity : 0,
+                                    m_floor.load(std::memory_order_acquire));
+    const size_t at = out.size();
+    for (uint64_t i = first; i < head; ++i)
+        out.push_back(m_records[i & (kCapacity - 1)]);
+
+    // the writer may have lapped us meanwhile; the slot it is on now and
+    // everything older than a full ring back can't be trusted
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t after = m_head.load(std::memory_order_relaxed);
+    const uint64_t valid = after + 1 > kCapacity ? after + 1 - kCapacity : 0;
+    if (valid > first) {
+        const size_t torn = (size_t)std::min(valid - first, head - first);
+        out.erase(out.begin() + (ptrdiff_t)at, out.begin() + (ptrdiff_t)(at + torn));
+    }
+}
+
+// --- histogram ---
+
+static int Log2(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(v);
+#else
+    int r = 0;
+    while (v >>= 1)
+        ++r;
+    return r;
+#endif
+}
+
+int LatencyHistogram::BucketOf(uint64_t ns) {
+    const uint64_t sub = 1u << kSubBits;
+    if (ns < sub)
+        return (int)ns;
+    const int e = Log2(ns);
+    return ((e - kSubBits + 1) << kSubBits) + (int)((ns >> (e - kSubBits)) & (sub - 1));
+}
+
+uint64_t LatencyHistogram::BucketMax(int bucket) {
+    const int sub = 1 << kSubBits;
+    if (bucket < sub)
+        return (uint64_t)bucket;
+    const int shift = (bucket >> kSubBits) - 1;
+    const uint64_t lower = (uint64_t)(sub + (bucket & (sub - 1))) << shift;
+    return lower + ((1ull << shift) - 1);
+}
+
+void LatencyHistogram::Record(uint64_t ns) {
+    m_buckets[BucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (ns > max && !m_max.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::Reset() {
+    for (auto& b : m_buckets)
+        b.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+    for (int i = 0; i < kBuckets; ++i)
+        if (uint64_t n = other.m_buckets[i].load(std::memory_order_relaxed))
+            m_buckets[i].fetch_add(n, std::memory_order_relaxed);
+    m_count.fetch_add(other.Count(), std::memory_order_relaxed);
+    m_sum.fetch_add(other.m_sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    m_max.store(std::max(MaxNs(), other.MaxNs()), std::memory_order_relaxed);
+}
+
+double LatencyHistogram::MeanNs() const {
+    const uint64_t n = Count();
+    return n ? (double)m_sum.load(std::memory_order_relaxed) / (double)n : 0.0;
+}
+
+uint64_t LatencyHistogram::PercentileNs(double q) const {
+    uint64_t total = 0;
+    for (const auto& b : m_buckets)
+        total += b.load(std::memory_order_relaxed);
+    if (total == 0)
+        return 0;
+    const uint64_t rank = std::max<uint64_t>(1, (uint64_t)(q * (double)total + 0.5));
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+            return std::min(BucketMax(i), MaxNs());
+    }
+    return MaxNs();
+}
+
+// --- tracer ---
+
+TraceRing& Tracer::ThisThread() {
+    // one cached ring per thread, for whichever tracer it last wrote to
+    thread_local const Tracer* t_owner = nullptr;
+    thread_local TraceRing*    t_ring = nullptr;
+    if (t_owner == this)
+        return *t_ring;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const std::thread::id self = std::this_thread::get_id();
+    TraceRing* ring = nullptr;
+    for (size_t i = 0; i < m_owners.size(); ++i)
+        if (m_owners[i] == self)
+            ring = m_rings[i].get();
+    if (!ring) {
+        m_rings.push_back(std::make_unique<TraceRing>((uint32_t)m_rings.size() + 1));
+        m_owners.push_back(self);
+        ring = m_rings.back().get();
+    }
+    t_owner = this;
+    t_ring = ring;
+    return *ring;
+}
+
+void Tracer::LatencyBegin(TraceLatency which, uint64_t startNs) {
+    uint64_t none = 0;
+    m_latency[which].pendingNs.compare_exchange_strong(none, startNs, std::memory_order_acq_rel);
+}
+
+void Tracer::LatencyEnd(TraceLatency which, uint64_t endNs) {
+    const uint64_t start = m_latency[which].pendingNs.exchange(0, std::memory_order_acq_rel);
+    if (start && endNs >= start)
+        RecordLatency(which, endNs - start, endNs);
+}
+
+void Tracer::LatencyCancel(TraceLatency which) {
+    m_latency[which].pendingNs.store(0, std::memory_order_release);
+}
+
+void Tracer::RecordLatency(TraceLatency which, uint64_t ns, uint64_t nowNs) {
+    Rolling& r = m_latency[which];
+    const uint64_t start = r.windowStartNs.load(std::memory_order_acquire);
+    if (start == 0 || (nowNs > start && nowNs - start >= kLatencyWindowNs)) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const uint64_t again = r.windowStartNs.load(std::memory_order_relaxed);
+        if (again == 0) {
+            r.windowStartNs.store(nowNs, std::memory_order_release);
+        }
+        else if (nowNs > again && nowNs - again >= kLatencyWindowNs) {
+            // the older generation makes way for the next window; after a
+            // whole window without records the current one is that old too
+            const uint64_t windows = (nowNs - again) / kLatencyWindowNs;
+            const int cur = r.current.load(std::memory_order_relaxed);
+            r.gens[cur ^ 1].Reset();
+            if (windows >= 2)
+                r.gens[cur].Reset();
+            r.current.store(cur ^ 1, std::memory_order_release);
+            r.windowStartNs.store(again + windows * kLatencyWindowNs, std::memory_order_release);
+        }
+    }
+    r.gens[r.current.load(std::memory_order_acquire)].Record(ns);
+}
+
+void Tracer::Latency(TraceLatency which, LatencyHistogram& out) const {
+    out.Reset();
+    out.Merge(m_latency[which].gens[0]);
+    out.Merge(m_latency[which].gens[1]);
+}
+
+const char* Tracer::LatencyName(TraceLatency which) {
+    switch (which) {
+    case TraceLatency_KeyToPresent:    return "key_to_present";
+    case TraceLatency_KeyToForeground: return "key_to_foreground";
+    default:                           return "?";
+    }
+}
+
+std::string Tracer::LatencyReport() const {
+    std::string out;
+    char line[256];
+    LatencyHistogram h;
+    for (int i = 0; i < TraceLatency_Count; ++i) {
+        Latency((TraceLatency)i, h);
+        std::snprintf(line, sizeof(line),
+            "%-18s count %6" PRIu64 "  mean %8.3f ms  p50 %8.3f  p90 %8.3f  p99 %8.3f  max %8.3f\n",
+            LatencyName((TraceLatency)i), h.Count(), h.MeanNs() / 1e6,
+            (double)h.PercentileNs(0.50) / 1e6, (double)h.PercentileNs(0.90) / 1e6,
+            (double)h.PercentileNs(0.99) / 1e6, (double)h.MaxNs() / 1e6);
+        out += line;
+    }
+    return out;
+}
+
+void Tracer::Clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& ring : m_rings)
+        ring->Discard();
+    for (Rolling& r : m_latency) {
+        r.gens[0].Reset();
+        r.gens[1].Reset();
+        r.pendingNs.store(0, std::memory_order_relaxed);
+        r.windowStartNs.store(0, std::memory_order_relaxed);
+    }
+}
+
+// --- export ---
+
+static void WriteJsonString(std::FILE* f, const char* s) {
+    std::fputc('"', f);
+    for (; s && *s; ++s) {
+        if (*s == '"' || *s == '\\')
+            std::fputc('\\', f);
+        if ((unsigned char)*s >= 0x20)
+            std::fputc(*s, f);
+    }
+    std::fputc('"', f);
+}
+
+void Tracer::WriteChromeJson(std::FILE* f) const {
+    std::vector<const TraceRing*> rings;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& ring : m_rings)
+            rings.push_back(ring.get());
+    }
+    std::vector<TraceRecord> records;
+    std::vector<std::pair<size_t, const TraceRing*>> ends;   // records per ring
+    for (const TraceRing* ring : rings) {
+        ring->Read(records);
+        ends.emplace_back(records.size(), ring);
+    }
+    uint64_t base = ~0ull;
+    for (const TraceRecord& r : records)
+        base = std::min(base, r.beginNs);
+
+    std::fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    bool first = true;
+    auto sep = [&] {
+        if (!first)
+            std::fputs(",\n", f);
+        first = false;
+    };
+    size_t i = 0;
+    for (const auto& [end, ring] : ends) {
+        sep();
+        std::fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", ring->Tid());
+        if (const char* name = ring->Name())
+            WriteJsonString(f, name);
+        else
+            std::fprintf(f, "\"thread %u\"", ring->Tid());
+        std::fputs("}}", f);
+        for (; i < end; ++i) {
+            const TraceRecord& r = records[i];
+            sep();
+            std::fputs("{\"name\":", f);
+            WriteJsonString(f, r.name);
+            const double ts = (double)(r.beginNs - base) / 1000.0;
+            if (r.endNs == r.beginNs)
+                std::fprintf(f, ",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f", ts);
+            else
+                std::fprintf(f, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f", ts,
+                    (double)(r.endNs - r.beginNs) / 1000.0);
+            std::fprintf(f, ",\"pid\":1,\"tid\":%u,\"args\":{\"arg\":%" PRIu64 "}}", ring->Tid(), r.arg);
+        }
+    }
+    std::fputs("\n]}\n", f);
+}
+
+bool Tracer::WriteChromeJson(const std::string& path) const {
+    std::FILE* f = std::fopen(path.c_str(), "w");
+    if (!f)
+        return false;
+    WriteChromeJson(f);
+    const bool ok = !std::ferror(f);
+    return (std::fclose(f) == 0) && ok;
+}
+
+Tracer& GetTracer() {
+    static Tracer g_tracer;
+    return g_tracer;
+}
+
+// --- scope ---
+
+TraceScope::TraceScope(const char* name, uint64_t arg)
+    : m_name(name), m_arg(arg), m_beginNs(SystemClock().NowNs()) {}
+
+TraceScope::~TraceScope() {
+    GetTracer().Span(m_name, m_beginNs, SystemClock().NowNs(), m_arg);
+}
@@ -0,0 +1,209 @@
+﻿// === src/utf8.cpp ===
+#include "utf8.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WWS_UTF8_SSE2 1
+#endif
+
+// --- wide to UTF-8 ---
+
+static char* PutUtf8(char* d, uint32_t cp) {
+    if (cp < 0x80) {
+        *d++ = (char)cp;
+    }
+    else if (cp < 0x800) {
+        *d++ = (char)(0xC0 | (cp >> 6));
+        *d++ = (char)(0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000) {
+        *d++ = (char)(0xE0 | (cp >> 12));
+        *d++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *d++ = (char)(0x80 | (cp & 0x3F));
+    }
+    else {
+        *d++ = (char)(0xF0 | (cp >> 18));
+        *d++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+        *d++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *d++ = (char)(0x80 | (cp & 0x3F));
+    }
+    return d;
+}
+
+void AppendUtf8(std::string& out, uint32_t cp) {
+    char buf[4];
+    out.append(buf, PutUtf8(buf, cp));
+}
+
+// Units from i until at least stop, one code point at a time; a surrogate
+// pair straddling stop is taken whole
+static char* WideToUtf8Scalar(const wchar_t* s, size_t& at, size_t stop, size_t len, char* d) {
+    size_t i = at;   // not at itself: the stores through d could alias it
+    for (; i < stop; ++i) {
+        uint32_t c = (uint32_t)s[i];
+        if (sizeof(wchar_t) == 2 && c >= 0xD800 && c < 0xDC00 && i + 1 < len) {
+            uint32_t lo = (uint32_t)s[i + 1];
+            if (lo >= 0xDC00 && lo < 0xE000) {
+                d = PutUtf8(d, 0x10000 + ((c - 0xD800) << 10) + (lo - 0xDC00));
+                ++i;
+                continue;
+            }
+        }
+        d = PutUtf8(d, c);
+    }
+    at = i;
+    return d;
+}
+
+#ifdef WWS_UTF8_SSE2
+// Eight units as 16-bit lanes; false if any is outside the BMP (wchar_t
+// is 32 bits outside Windows)
+static bool Load8(const wchar_t* s, __m128i& v) {
+    if (sizeof(wchar_t) == 2) {
+        v = _mm_loadu_si128((const __m128i*)s);
+        return true;
+    }
+    __m128i a = _mm_loadu_si128((const __m128i*)s);
+    __m128i b = _mm_loadu_si128((const __m128i*)s + 1);
+    const __m128i high = _mm_set1_epi32((int)0xFFFF0000u);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(_mm_or_si128(a, b), high), _mm_setzero_si128())) != 0xFFFF)
+        return false;
+    // packs_epi32 saturates; sign-extend the low halves so it keeps them as they are
+    a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+    b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+    v = _mm_packs_epi32(a, b);
+    return true;
+}
+#endif
+
+size_t Utf8FromWide(const wchar_t* s, size_t len, char* out, bool vectorized) {
+    char* d = out;
+    size_t i = 0;
+#ifdef WWS_UTF8_SSE2
+    // eight units at a time while they all take the same number of bytes
+    // (ASCII; Latin/Greek/Cyrillic/Hebrew/Arabic letters; the rest of the
+    // BMP). The first block that mixes them, or has a surrogate, sends the
+    // rest the plain way: text that mixes once tends to keep mixing, and
+    // sorting it out block by block costs more than it saves.
+    if (vectorized) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i low6 = _mm_set1_epi16(0x3F);
+        const __m128i cont = _mm_set1_epi16(0x80);
+        while (i + 8 <= len) {
+            __m128i v;
+            if (!Load8(s + i, v))
+                break;
+            const __m128i isAscii = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16((short)0xFF80)), zero);
+            const int ascii = _mm_movemask_epi8(isAscii);
+            if (ascii == 0xFFFF) {
+                _mm_storel_epi64((__m128i*)d, _mm_packus_epi16(v, v));
+                d += 8;
+                i += 8;
+                continue;
+            }
+            const __m128i top = _mm_and_si128(v, _mm_set1_epi16((short)0xF800));
+            const __m128i isSmall = _mm_cmpeq_epi16(top, zero);   // under U+0800
+            const int small = _mm_movemask_epi8(isSmall);
+            if (small == 0xFFFF && ascii == 0) {
+                // 110xxxxx 10xxxxxx, the lead byte in the low half of each lane
+                const __m128i lead = _mm_or_si128(_mm_srli_epi16(v, 6), _mm_set1_epi16(0xC0));
+                const __m128i tail = _mm_or_si128(_mm_and_si128(v, low6), cont);
+                _mm_storeu_si128((__m128i*)d, _mm_or_si128(lead, _mm_slli_epi16(tail, 8)));
+                d += 16;
+                i += 8;
+                continue;
+            }
+            const int surrogate = _mm_movemask_epi8(_mm_cmpeq_epi16(top, _mm_set1_epi16((short)0xD800)));
+            if (small == 0 && surrogate == 0) {
+                // 1110xxxx 10xxxxxx 10xxxxxx: the first two bytes per lane, the third apart
+                const __m128i lead = _mm_or_si128(_mm_srli_epi16(v, 12), _mm_set1_epi16(0xE0));
+                const __m128i mid = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(v, 6), low6), cont);
+                const __m128i tail = _mm_or_si128(_mm_and_si128(v, low6), cont);
+                alignas(16) uint16_t pairs[8];
+                alignas(16) uint8_t lasts[16];
+                _mm_store_si128((__m128i*)pairs, _mm_or_si128(lead, _mm_slli_epi16(mid, 8)));
+                _mm_store_si128((__m128i*)lasts, _mm_packus_epi16(tail, tail));
+                char* at = d;
+                for (int j = 0; j < 8; ++j, at += 3) {
+                    std::memcpy(at, &pairs[j], 2);
+                    at[2] = (char)lasts[j];
+                }
+                d = at;
+                i += 8;
+                continue;
+            }
+            break;
+        }
+    }
+#else
+    (void)vectorized;
+#endif
+    d = WideToUtf8Scalar(s, i, len, len, d);
+    return (size_t)(d - out);
+}
+
+bool Utf8Vectorized() {
+#ifdef WWS_UTF8_SSE2
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AppendUtf8(std::string& out, const wchar_t* s, size_t len) {
+    // room for the worst case, then back to what was written; neither
+    // allocates once out has the capacity
+    const size_t at = out.size();
+    out.resize(at + len * kUtf8PerWide);
+    out.resize(at + Utf8FromWide(s, len, &out[at]));
+}
+
+uint32_t DecodeUtf8(const char*& p, const char* end) {
+    const unsigned char* u = (const unsigned char*)p;
+    uint32_t c = *u;
+    int extra = c < 0x80 ? 0 : (c >> 5) == 0x6 ? 1 : (c >> 4) == 0xE ? 2 : (c >> 3) == 0x1E ? 3 : -1;
+    if (extra < 0 || end - p <= extra) {
+        ++p;
+        return 0xFFFD;
+    }
+    c &= extra ? (0x3Fu >> extra) : 0x7Fu;
+    for (int i = 1; i <= extra; ++i) {
+        if ((u[i] & 0xC0) != 0x80) {
+            ++p;
+            return 0xFFFD;
+        }
+        c = (c << 6) | (u[i] & 0x3F);
+    }
+    p += 1 + extra;
+    return c <= 0x10FFFF ? c : 0xFFFD;
+}
+
+std::wstring WideFromUtf8(const char* s, size_t len) {
+    std::wstring out;
+    out.reserve(len);
+    const char* end = s + len;
+    while (s < end) {
+        uint32_t c = DecodeUtf8(s, end);
+        if (sizeof(wchar_t) == 2 && c >= 0x10000) {
+            c -= 0x10000;
+            out += (wchar_t)(0xD800 + (c >> 10));
+            out += (wchar_t)(0xDC00 + (c & 0x3FF));
+        }
+        else {
+            out += (wchar_t)c;
+        }
+    }
+    return out;
+}
+
+size_t Utf8Prefix(const char* s, size_t len, size_t maxChars) {
+    size_t i = 0;
+    for (; i < len && maxChars; --maxChars) {
+        ++i;
+        while (i < len && ((unsigned char)s[i] & 0xC0) == 0x80)
+            ++i;
+    }
+    return i;
+}
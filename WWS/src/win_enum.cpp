@@ -1,50 +1,82 @@
 ﻿// === src/win_enum.cpp ===
 #include "win_enum.h"
+#include "window_rules.h"
 #include <windows.h>
 #include <algorithm>
-#include <cwctype>  // for iswspace()
+#include <mutex>
 
-static BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM lParam) {
-    // must be visible & not minimized
-    if (!IsWindowVisible(hwnd) || IsIconic(hwnd))
-        return TRUE;
+// Live answers for ClassifyWindow()
+struct Win32Window {
+    HWND hwnd;
 
-    // skip tool windows
-    LONG ex = GetWindowLongW(hwnd, GWL_EXSTYLE);
-    if (ex & WS_EX_TOOLWINDOW)
-        return TRUE;
+    bool     Visible() const     { return IsWindowVisible(hwnd) != FALSE; }
+    uint32_t ExStyle() const     { return (uint32_t)GetWindowLongW(hwnd, GWL_EXSTYLE); }
+    uint32_t Style() const       { return (uint32_t)GetWindowLongW(hwnd, GWL_STYLE); }
+    bool     IsRootOwner() const { return GetAncestor(hwnd, GA_ROOTOWNER) == hwnd; }
+    void     Title(std::wstring& title) const {
+        int len = GetWindowTextLengthW(hwnd);
+        title.assign(len, L' ');
+        if (len)
+            GetWindowTextW(hwnd, &title[0], len + 1);
+        title.resize(len);
+    }
+    void     ClassName(std::wstring& cls) const {
+        wchar_t buf[256];
+        int len = GetClassNameW(hwnd, buf, 256);
+        cls.assign(buf, len > 0 ? len : 0);
+    }
+    // only asked for when a rule needs it: this one opens the process
+    void     Exe(std::wstring& exe) const {
+        exe.clear();
+        DWORD pid = 0;
+        GetWindowThreadProcessId(hwnd, &pid);
+        HANDLE h = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+        if (!h)
+            return;
+        wchar_t path[MAX_PATH];
+        DWORD len = MAX_PATH;
+        if (QueryFullProcessImageNameW(h, 0, path, &len)) {
+            const wchar_t* name = path + len;
+            while (name > path && name[-1] != L'\\')
+                --name;
+            exe.assign(name, path + len);
+        }
+        CloseHandle(h);
+    }
+};
 
-    // skip owned windows; only top‑level
-    if (GetAncestor(hwnd, GA_ROOTOWNER) != hwnd)
-        return TRUE;
+// Everything EnumWindowsProc checks except IsIconic, so minimized windows
+// can still be tracked by the event source; the user's rules on top
+static WindowVerdict ClassifyWindow(HWND hwnd, const WindowRuleSet* rules, std::wstring& title) {
+    static thread_local WindowRuleSet::Scratch scratch;
+    return ClassifyWindow(Win32Window{ hwnd }, rules, title, scratch);
+}
 
-    // must have a caption style (real window)
-    LONG st = GetWindowLongW(hwnd, GWL_STYLE);
-    if (!(st & WS_CAPTION))
-        return TRUE;
+// EnumWindows state: where the windows go, and the rules for this pass
+template <class T>
+struct EnumPass {
+    std::vector<T>*      out;
+    const WindowRuleSet* rules;
+};
 
-    // require a non‑empty title
-    int len = GetWindowTextLengthW(hwnd);
-    if (len == 0)
+static BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM lParam) {
+    // must not be minimized
+    if (IsIconic(hwnd))
         return TRUE;
 
-    std::wstring title(len, L' ');
-    GetWindowTextW(hwnd, &title[0], len + 1);
-    title.resize(len);
-
-    // skip all‑whitespace titles
-    if (std::all_of(title.begin(), title.end(),
-        [](wchar_t c) { return iswspace(c) != 0; }))
+    auto* pass = reinterpret_cast<EnumPass<WindowInfo>*>(lParam);
+    std::wstring title;
+    if (ClassifyWindow(hwnd, pass->rules, title) == WindowVerdict::Reject)
         return TRUE;
-
-    auto* vec = reinterpret_cast<std::vector<WindowInfo>*>(lParam);
-    vec->push_back({ hwnd, title });
+    pass->out->push_back({ hwnd, std::move(title) });
     return TRUE;
 }
 
 std::vector<WindowInfo> GetOpenWindows() {
     std::vector<WindowInfo> r;
-    EnumWindows(EnumWindowsProc, reinterpret_cast<LPARAM>(&r));
+    const std::shared_ptr<const WindowRuleSet> rules = GetWindowSystem().Rules();
+    EnumPass<WindowInfo> pass{ &r, rules.get() };
+    EnumWindows(EnumWindowsProc, reinterpret_cast<LPARAM>(&pass));
     return r;
 }
 
@@ -67,3 +99,391 @@ void ForceSetForegroundWindow(HWND hWnd) {
     AttachThreadInput(fgThread, curThread, FALSE);
 }
 
+// --- window system ---
+
+static BOOL CALLBACK SnapshotWindowsProc(HWND hwnd, LPARAM lParam) {
+    auto* pass = reinterpret_cast<EnumPass<WindowRecord>*>(lParam);
+    std::wstring title;
+    const WindowVerdict verdict = ClassifyWindow(hwnd, pass->rules, title);
+    if (verdict == WindowVerdict::Reject)
+        return TRUE;
+    WindowRecord rec;
+    rec.id = (WindowId)(UINT_PTR)hwnd;
+    rec.title = std::move(title);
+    rec.minimized = IsIconic(hwnd) != FALSE;
+    rec.pinned = verdict == WindowVerdict::Pin;
+    DWORD pid = 0;
+    GetWindowThreadProcessId(hwnd, &pid);
+    rec.pid = pid;
+    pass->out->push_back(std::move(rec));
+    return TRUE;
+}
+
+bool Win32WindowSystem::Snapshot(std::vector<WindowRecord>& out) {
+    out.clear();
+    const std::shared_ptr<const WindowRuleSet> rules = Rules();
+    EnumPass<WindowRecord> pass{ &out, rules.get() };
+    // EnumWindows walks the z-order, topmost first
+    return EnumWindows(SnapshotWindowsProc, reinterpret_cast<LPARAM>(&pass)) != FALSE;
+}
+
+bool Win32WindowSystem::Activate(WindowId id) {
+    HWND hwnd = (HWND)(UINT_PTR)id;
+    if (!IsWindow(hwnd))
+        return false;
+    ForceSetForegroundWindow(hwnd);
+    return true;
+}
+
+// --- activation ---
+
+const char* Win32ActivationBackend::StrategyName(int strategy) const {
+    switch (strategy) {
+    case 0: return "set_foreground";
+    case 1: return "attach_input";
+    case 2: return "switch_to_this_window";
+    }
+    return "?";
+}
+
+bool Win32ActivationBackend::Attempt(WindowId id, int strategy, const ActivationToken& token) {
+    HWND hwnd = (HWND)(UINT_PTR)id;
+    if (!IsWindow(hwnd))
+        return false;
+    if (token.Cancelled())
+        return true;
+    switch (strategy) {
+    case 0:
+        if (IsIconic(hwnd))
+            ShowWindow(hwnd, SW_RESTORE);
+        SetForegroundWindow(hwnd);
+        break;
+    case 1: {
+        DWORD fgThread = GetWindowThreadProcessId(GetForegroundWindow(), nullptr);
+        DWORD curThread = GetCurrentThreadId();
+        // attaching to a hung thread can take a while; the activator may
+        // have moved on by the time it returns
+        AttachThreadInput(fgThread, curThread, TRUE);
+        if (!token.Cancelled()) {
+            if (IsIconic(hwnd))
+                ShowWindow(hwnd, SW_RESTORE);
+            BringWindowToTop(hwnd);
+            SetForegroundWindow(hwnd);
+        }
+        AttachThreadInput(fgThread, curThread, FALSE);
+        break;
+    }
+    default:
+        SwitchToThisWindow(hwnd, TRUE);
+        break;
+    }
+    return true;
+}
+
+WindowSystem& GetWindowSystem() {
+    static Win32WindowSystem g_ws;
+    return g_ws;
+}
+
+// --- event source ---
+
+static WindowEventSink*          g_sink = nullptr;
+static std::vector<HWINEVENTHOOK> g_eventHooks;
+
+static void Emit(WindowEventType type, HWND hwnd, std::wstring title = {},
+                 WindowVerdict verdict = WindowVerdict::Keep) {
+    DWORD pid = 0;
+    if (type == WindowEventType::Created)
+        GetWindowThreadProcessId(hwnd, &pid);
+    g_sink->OnWindowEvent({ type, (WindowId)(UINT_PTR)hwnd, std::move(title), pid,
+                            verdict == WindowVerdict::Pin });
+}
+
+static void CALLBACK WinEventProc(HWINEVENTHOOK, DWORD event, HWND hwnd,
+    LONG idObject, LONG idChild, DWORD, DWORD)
+{
+    if (!g_sink || !hwnd || idObject != OBJID_WINDOW || idChild != CHILDID_SELF)
+        return;
+    if (GetAncestor(hwnd, GA_ROOT) != hwnd)
+        return;
+
+    std::wstring title;
+    // hides and destroys, by far the most frequent, don't need the rules
+    auto classify = [&] { return ClassifyWindow(hwnd, GetWindowSystem().Rules().get(), title); };
+    WindowVerdict verdict;
+    switch (event) {
+    case EVENT_SYSTEM_FOREGROUND:
+        verdict = classify();
+        if (verdict != WindowVerdict::Reject) {
+            Emit(WindowEventType::Created, hwnd, std::move(title), verdict);
+            Emit(WindowEventType::Foreground, hwnd);
+        }
+        break;
+    case EVENT_OBJECT_CREATE:
+    case EVENT_OBJECT_SHOW:
+        // most windows get their title and styles before being shown, so
+        // CREATE is usually rejected here and SHOW picks them up
+        verdict = classify();
+        if (verdict != WindowVerdict::Reject) {
+            Emit(WindowEventType::Created, hwnd, std::move(title), verdict);
+            if (IsIconic(hwnd)) Emit(WindowEventType::Minimized, hwnd);
+        }
+        break;
+    case EVENT_OBJECT_HIDE:
+    case EVENT_OBJECT_DESTROY:
+        Emit(WindowEventType::Destroyed, hwnd);
+        break;
+    case EVENT_OBJECT_NAMECHANGE:
+        // a title can make a window switchable or (when blanked, or
+        // matched by an exclude rule) not, and pin or unpin it
+        verdict = classify();
+        if (verdict != WindowVerdict::Reject)
+            Emit(WindowEventType::NameChanged, hwnd, std::move(title), verdict);
+        else
+            Emit(WindowEventType::Destroyed, hwnd);
+        break;
+    case EVENT_SYSTEM_MINIMIZESTART:
+        Emit(WindowEventType::Minimized, hwnd);
+        break;
+    case EVENT_SYSTEM_MINIMIZEEND:
+        Emit(WindowEventType::Restored, hwnd);
+        break;
+    }
+}
+
+static BOOL CALLBACK SeedWindowsProc(HWND hwnd, LPARAM lParam) {
+    std::wstring title;
+    const WindowVerdict verdict = ClassifyWindow(hwnd, reinterpret_cast<const WindowRuleSet*>(lParam), title);
+    if (verdict != WindowVerdict::Reject) {
+        Emit(WindowEventType::Created, hwnd, std::move(title), verdict);
+        if (IsIconic(hwnd)) Emit(WindowEventType::Minimized, hwnd);
+    }
+    return TRUE;
+}
+
+bool Win32WindowEventSource::Start(WindowEventSink& sink) {
+    Stop();
+    g_sink = &sink;
+
+    // seed in z-order, which is the best MRU guess we have at startup
+    const std::shared_ptr<const WindowRuleSet> rules = GetWindowSystem().Rules();
+    EnumWindows(SeedWindowsProc, reinterpret_cast<LPARAM>(rules.get()));
+    HWND fg = GetForegroundWindow();
+    std::wstring title;
+    if (fg && ClassifyWindow(fg, rules.get(), title) != WindowVerdict::Reject)
+        Emit(WindowEventType::Foreground, fg);
+
+    // small ranges so we don't get every accessibility event in the system
+    static const DWORD ranges[][2] = {
+        { EVENT_SYSTEM_FOREGROUND,     EVENT_SYSTEM_FOREGROUND },
+        { EVENT_SYSTEM_MINIMIZESTART,  EVENT_SYSTEM_MINIMIZEEND },
+        { EVENT_OBJECT_CREATE,         EVENT_OBJECT_HIDE },
+        { EVENT_OBJECT_NAMECHANGE,     EVENT_OBJECT_NAMECHANGE },
+    };
+    for (auto& r : ranges) {
+        HWINEVENTHOOK h = SetWinEventHook(r[0], r[1], nullptr, WinEventProc, 0, 0,
+            WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+        if (!h) {
+            Stop();
+            return false;
+        }
+        g_eventHooks.push_back(h);
+    }
+    return true;
+}
+
+void Win32WindowEventSource::Stop() {
+    for (HWINEVENTHOOK h : g_eventHooks)
+        UnhookWinEvent(h);
+    g_eventHooks.clear();
+    g_sink = nullptr;
+}
+
+// --- process metadata ---
+
+namespace {
+struct ExitWatch {
+    HANDLE                      process;
+    HANDLE                      wait;
+    uint32_t                    pid;
+    uint64_t                    startTime;
+    ProcessInfoProvider::ExitFn onExit;
+};
+}
+
+static std::mutex               g_watchMutex;
+static std::vector<ExitWatch*>  g_watches;
+
+static void CALLBACK OnProcessExit(PVOID ctx, BOOLEAN) {
+    auto* w = static_cast<ExitWatch*>(ctx);
+    w->onExit(w->pid, w->startTime);
+    // CancelWatches owns the cleanup if it got here first
+    std::lock_guard<std::mutex> lock(g_watchMutex);
+    auto it = std::find(g_watches.begin(), g_watches.end(), w);
+    if (it == g_watches.end())
+        return;
+    g_watches.erase(it);
+    UnregisterWait(w->wait);
+    CloseHandle(w->process);
+    delete w;
+}
+
+bool Win32ProcessInfoProvider::Query(uint32_t pid, ProcessInfo& info) {
+    HANDLE h = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (!h)
+        return false;
+    FILETIME created, exited, kernel, user;
+    wchar_t path[MAX_PATH];
+    DWORD len = MAX_PATH;
+    bool ok = GetProcessTimes(h, &created, &exited, &kernel, &user) &&
+              QueryFullProcessImageNameW(h, 0, path, &len);
+    CloseHandle(h);
+    if (!ok)
+        return false;
+    info.pid = pid;
+    info.startTime = ((uint64_t)created.dwHighDateTime << 32) | created.dwLowDateTime;
+    info.exePath.assign(path, len);
+    info.exeName = ExeNameFromPath(info.exePath);
+    return true;
+}
+
+bool Win32ProcessInfoProvider::WatchExit(const ProcessInfo& info, ExitFn onExit) {
+    // the pid may have been freed, or handed to another process, since Query
+    HANDLE h = OpenProcess(SYNCHRONIZE | PROCESS_QUERY_LIMITED_INFORMATION, FALSE, info.pid);
+    FILETIME created, exited, kernel, user;
+    if (!h || !GetProcessTimes(h, &created, &exited, &kernel, &user) ||
+        (((uint64_t)created.dwHighDateTime << 32) | created.dwLowDateTime) != info.startTime) {
+        if (h) CloseHandle(h);
+        onExit(info.pid, info.startTime);
+        return true;
+    }
+    auto* w = new ExitWatch{ h, nullptr, info.pid, info.startTime, std::move(onExit) };
+    std::lock_guard<std::mutex> lock(g_watchMutex);
+    if (!RegisterWaitForSingleObject(&w->wait, h, OnProcessExit, w, INFINITE,
+        WT_EXECUTEONLYONCE | WT_EXECUTEINWAITTHREAD)) {
+        CloseHandle(h);
+        delete w;
+        return false;
+    }
+    g_watches.push_back(w);
+    return true;
+}
+
+void Win32ProcessInfoProvider::CancelWatches() {
+    std::vector<ExitWatch*> watches;
+    {
+        std::lock_guard<std::mutex> lock(g_watchMutex);
+        watches.swap(g_watches);
+    }
+    for (ExitWatch* w : watches) {
+        UnregisterWaitEx(w->wait, INVALID_HANDLE_VALUE);   // waits for a running callback
+        CloseHandle(w->process);
+        delete w;
+    }
+}
+
+// --- icons ---
+
+bool Win32IconProvider::Load(const std::wstring& exePath, int size, IconImage& out) {
+    HICON icon = nullptr;
+    UINT id = 0;
+    if (PrivateExtractIconsW(exePath.c_str(), 0, size, size, &icon, &id, 1, LR_DEFAULTCOLOR) != 1 || !icon)
+        return false;
+
+    ICONINFO ii{};
+    bool ok = false;
+    if (GetIconInfo(icon, &ii) && ii.hbmColor) {
+        BITMAP bm{};
+        GetObjectW(ii.hbmColor, sizeof(bm), &bm);
+        const int w = bm.bmWidth, h = bm.bmHeight;
+
+        BITMAPINFO bi{};
+        bi.bmiHeader.biSize = sizeof(bi.bmiHeader);
+        bi.bmiHeader.biWidth = w;
+        bi.bmiHeader.biHeight = -h;   // top-down
+        bi.bmiHeader.biPlanes = 1;
+        bi.bmiHeader.biBitCount = 32;
+        bi.bmiHeader.biCompression = BI_RGB;
+
+        out.width = w;
+        out.height = h;
+        out.rgba.resize((size_t)w * h);
+        HDC dc = GetDC(nullptr);
+        ok = GetDIBits(dc, ii.hbmColor, 0, h, out.rgba.data(), &bi, DIB_RGB_COLORS) == h;
+
+        // old icons have no alpha channel; take it from the AND mask instead
+        bool hasAlpha = std::any_of(out.rgba.begin(), out.rgba.end(),
+                                    [](uint32_t px) { return (px >> 24) != 0; });
+        if (ok && !hasAlpha && ii.hbmMask) {
+            std::vector<uint32_t> mask((size_t)w * h);
+            ok = GetDIBits(dc, ii.hbmMask, 0, h, mask.data(), &bi, DIB_RGB_COLORS) == h;
+            for (size_t i = 0; ok && i < mask.size(); ++i)
+                out.rgba[i] |= (mask[i] & 0xFFFFFF) ? 0 : 0xFF000000u;
+        }
+        ReleaseDC(nullptr, dc);
+
+        // BGRA -> RGBA
+        for (uint32_t& px : out.rgba)
+            px = (px & 0xFF00FF00u) | ((px >> 16) & 0xFF) | ((px & 0xFF) << 16);
+    }
+    if (ii.hbmColor) DeleteObject(ii.hbmColor);
+    if (ii.hbmMask)  DeleteObject(ii.hbmMask);
+    DestroyIcon(icon);
+    return ok;
+}
+
+// --- thumbnails ---
+
+#ifndef PW_RENDERFULLCONTENT
+#define PW_RENDERFULLCONTENT 0x00000002
+#endif
+
+bool Win32ThumbnailSource::Size(WindowId id, int& width, int& height) {
+    HWND hwnd = (HWND)(UINT_PTR)id;
+    RECT rc{};
+    if (!IsWindow(hwnd) || IsIconic(hwnd) || !GetWindowRect(hwnd, &rc))
+        return false;
+    width = rc.right - rc.left;
+    height = rc.bottom - rc.top;
+    return width > 0 && height > 0;
+}
+
+bool Win32ThumbnailSource::Capture(WindowId id, WindowImage& out) {
+    HWND hwnd = (HWND)(UINT_PTR)id;
+    int w, h;
+    if (!Size(id, w, h))
+        return false;
+
+    BITMAPINFO bi{};
+    bi.bmiHeader.biSize = sizeof(bi.bmiHeader);
+    bi.bmiHeader.biWidth = w;
+    bi.bmiHeader.biHeight = -h;   // top-down
+    bi.bmiHeader.biPlanes = 1;
+    bi.bmiHeader.biBitCount = 32;
+    bi.bmiHeader.biCompression = BI_RGB;
+
+    HDC screen = GetDC(nullptr);
+    HDC dc = CreateCompatibleDC(screen);
+    void* bits = nullptr;
+    HBITMAP bmp = CreateDIBSection(screen, &bi, DIB_RGB_COLORS, &bits, nullptr, 0);
+    bool ok = false;
+    if (dc && bmp) {
+        HGDIOBJ old = SelectObject(dc, bmp);
+        ok = PrintWindow(hwnd, dc, PW_RENDERFULLCONTENT) != FALSE;
+        GdiFlush();
+        if (ok) {
+            out.width = w;
+            out.height = h;
+            out.rgba.resize((size_t)w * h);
+            const uint32_t* px = (const uint32_t*)bits;
+            // BGRX -> RGBA, opaque
+            for (size_t i = 0; i < out.rgba.size(); ++i)
+                out.rgba[i] = 0xFF000000u | (px[i] & 0x0000FF00u) | ((px[i] >> 16) & 0xFF) | ((px[i] & 0xFF) << 16);
+        }
+        SelectObject(dc, old);
+    }
+    if (bmp) DeleteObject(bmp);
+    if (dc)  DeleteDC(dc);
+    ReleaseDC(nullptr, screen);
+    return ok;
+}
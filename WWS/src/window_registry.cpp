@@ -0,0 +1,294 @@
+﻿// === src/window_registry.cpp ===
+#include "window_registry.h"
+#include "window_snapshot.h"
+#include "frecency_store.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <utility>
+
+void WindowRegistry::OnWindowEvent(const WindowEvent& ev) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_index.find(ev.id);
+    uint32_t n = (it != m_index.end()) ? it->second : kNil;
+
+    switch (ev.type) {
+    case WindowEventType::Created:
+    case WindowEventType::NameChanged:
+        // first sighting lands behind everything we've already seen
+        if (n == kNil) n = Insert(ev.id);
+        m_nodes[n].rec.title = ev.title;
+        if (ev.pid) m_nodes[n].rec.pid = ev.pid;
+        SetPinned(m_nodes[n], ev.pinned);
+        if (m_frecency) SetKeys(m_nodes[n]);
+        break;
+
+    case WindowEventType::Destroyed:
+        if (n == kNil) return;
+        Remove(n);
+        break;
+
+    case WindowEventType::Foreground:
+        // the window manager confirming a switch we asked for
+        WWS_TRACE_INSTANT("foreground", ev.id);
+        WWS_TRACE_LATENCY_END(TraceLatency_KeyToForeground);
+        if (n == kNil) n = Insert(ev.id);
+        m_nodes[n].rec.minimized = false;
+        if (n != m_head) {
+            Unlink(n);
+            PushFront(n);
+            // a switch, not focus coming back: one slot write each for the
+            // title and the app (untitled windows aren't counted)
+            if (m_frecency)
+                m_frecency->Record({ m_nodes[n].pattern, m_nodes[n].app });
+        }
+        break;
+
+    case WindowEventType::Minimized:
+    case WindowEventType::Restored:
+        if (n == kNil) return;
+        m_nodes[n].rec.minimized = (ev.type == WindowEventType::Minimized);
+        break;
+    }
+    ++m_version;
+}
+
+void WindowRegistry::Snapshot(std::vector<WindowRecord>& out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Order();
+    out.clear();
+    for (uint32_t n : m_order)
+        out.push_back(m_nodes[n].rec);
+}
+
+void WindowRegistry::Snapshot(WindowSnapshot& out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Order();
+    out.Clear();
+    for (uint32_t n : m_order) {
+        const WindowRecord& w = m_nodes[n].rec;
+        out.Add(w.id, w.title, w.pid);
+    }
+}
+
+std::vector<WindowRecord> WindowRegistry::Snapshot() const {
+    std::vector<WindowRecord> r;
+    Snapshot(r);
+    return r;
+}
+
+WindowId WindowRegistry::At(size_t index) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if ((!m_frecencyOrder || !m_frecency) && !m_pinned) {
+        for (uint32_t n = m_head; n != kNil; n = m_nodes[n].next) {
+            if (m_nodes[n].rec.minimized)
+                continue;
+            if (index-- == 0)
+                return m_nodes[n].rec.id;
+        }
+        return 0;
+    }
+    Order();
+    return index < m_order.size() ? m_nodes[m_order[index]].rec.id : 0;
+}
+
+WindowId WindowRegistry::MruAt(size_t mruIndex) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (uint32_t n = m_head; n != kNil; n = m_nodes[n].next) {
+        if (m_nodes[n].rec.minimized)
+            continue;
+        if (mruIndex-- == 0)
+            return m_nodes[n].rec.id;
+    }
+    return 0;
+}
+
+void WindowRegistry::Order() const {
+    m_order.clear();
+    for (uint32_t n = m_head; n != kNil; n = m_nodes[n].next)
+        if (!m_nodes[n].rec.minimized)
+            m_order.push_back(n);
+    const bool frecency = m_frecencyOrder && m_frecency;
+    if (m_order.size() < 3 || (!frecency && !m_pinned))
+        return;
+    // the active window stays on top; Tap and the overlay's default
+    // selection still mean "the one before it". Pins come next.
+    m_ranked.clear();
+    for (size_t i = 1; i < m_order.size(); ++i) {
+        const Node& node = m_nodes[m_order[i]];
+        const double rank = frecency ? m_frecency->Rank({ node.pattern, node.app }) : 0.0;
+        m_ranked.push_back({ rank, (uint32_t)i, m_order[i], node.rec.pinned });
+    }
+    std::sort(m_ranked.begin(), m_ranked.end(), [](const Ranked& a, const Ranked& b) {
+        if (a.pinned != b.pinned)
+            return a.pinned;
+        return a.rank != b.rank ? a.rank > b.rank : a.mru < b.mru;
+    });
+    for (size_t i = 0; i < m_ranked.size(); ++i)
+        m_order[i + 1] = m_ranked[i].node;
+}
+
+void WindowRegistry::SetFrecency(FrecencyStore* store) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_frecency = store;
+    if (store)
+        for (Node& node : m_nodes)
+            SetKeys(node);
+    ++m_version;
+}
+
+void WindowRegistry::SetFrecencyOrder(bool on) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_frecencyOrder == on)
+        return;
+    m_frecencyOrder = on;
+    ++m_version;
+}
+
+bool WindowRegistry::FrecencyOrder() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_frecencyOrder;
+}
+
+void WindowRegistry::Reconcile(const std::vector<WindowRecord>& current) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<bool> seen(m_nodes.size());
+    for (const WindowRecord& w : current) {
+        auto it = m_index.find(w.id);
+        const uint32_t n = (it != m_index.end()) ? it->second : Insert(w.id);
+        if (n >= seen.size())
+            seen.resize(n + 1);
+        seen[n] = true;
+        Node& node = m_nodes[n];
+        node.rec.title = w.title;
+        node.rec.minimized = w.minimized;
+        if (w.pid) node.rec.pid = w.pid;
+        SetPinned(node, w.pinned);
+        if (m_frecency) SetKeys(node);
+    }
+    for (uint32_t n = m_head; n != kNil;) {
+        const uint32_t next = m_nodes[n].next;
+        if (!seen[n])
+            Remove(n);
+        n = next;
+    }
+    ++m_version;
+}
+
+void WindowRegistry::Remove(uint32_t n) {
+    Unlink(n);
+    SetPinned(m_nodes[n], false);
+    m_index.erase(m_nodes[n].rec.id);
+    m_nodes[n].rec = WindowRecord{};
+    m_nodes[n].pattern = m_nodes[n].app = 0;
+    m_free.push_back(n);
+}
+
+void WindowRegistry::SetPinned(Node& node, bool pinned) {
+    if (node.rec.pinned == pinned)
+        return;
+    node.rec.pinned = pinned;
+    if (pinned) ++m_pinned;
+    else        --m_pinned;
+}
+
+void WindowRegistry::SetKeys(Node& node) {
+    const FrecencyKeys keys = FrecencyKeys::FromTitle(node.rec.title);
+    node.pattern = keys.pattern;
+    node.app = keys.app;
+}
+
+size_t WindowRegistry::Size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_index.size();
+}
+
+uint64_t WindowRegistry::Version() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_version;
+}
+
+void WindowRegistry::Clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_nodes.clear();
+    m_free.clear();
+    m_index.clear();
+    m_head = m_tail = kNil;
+    m_pinned = 0;
+    ++m_version;
+}
+
+uint32_t WindowRegistry::Insert(WindowId id) {
+    uint32_t n;
+    if (!m_free.empty()) {
+        n = m_free.back();
+        m_free.pop_back();
+    }
+    else {
+        n = (uint32_t)m_nodes.size();
+        m_nodes.emplace_back();
+    }
+    m_nodes[n].rec.id = id;
+    m_nodes[n].prev = m_tail;
+    m_nodes[n].next = kNil;
+    if (m_tail != kNil) m_nodes[m_tail].next = n;
+    else                m_head = n;
+    m_tail = n;
+    m_index.emplace(id, n);
+    return n;
+}
+
+void WindowRegistry::Unlink(uint32_t n) {
+    Node& node = m_nodes[n];
+    if (node.prev != kNil) m_nodes[node.prev].next = node.next;
+    else                   m_head = node.next;
+    if (node.next != kNil) m_nodes[node.next].prev = node.prev;
+    else                   m_tail = node.prev;
+    node.prev = node.next = kNil;
+}
+
+void WindowRegistry::PushFront(uint32_t n) {
+    m_nodes[n].prev = kNil;
+    m_nodes[n].next = m_head;
+    if (m_head != kNil) m_nodes[m_head].prev = n;
+    else                m_tail = n;
+    m_head = n;
+}
+
+// --- fake source ---
+
+void FakeWindowEventSource::Create(WindowId id, std::wstring title, uint32_t pid, bool pinned) {
+    m_pinned[id] = pinned;
+    Emit({ WindowEventType::Created, id, std::move(title), pid, pinned });
+}
+
+void FakeWindowEventSource::Destroy(WindowId id) {
+    m_pinned.erase(id);
+    Emit({ WindowEventType::Destroyed, id, {} });
+}
+
+void FakeWindowEventSource::Focus(WindowId id) {
+    Emit({ WindowEventType::Foreground, id, {} });
+}
+
+void FakeWindowEventSource::Rename(WindowId id, std::wstring title) {
+    auto it = m_pinned.find(id);
+    Emit({ WindowEventType::NameChanged, id, std::move(title), 0, it != m_pinned.end() && it->second });
+}
+
+void FakeWindowEventSource::Minimize(WindowId id) {
+    Emit({ WindowEventType::Minimized, id, {} });
+}
+
+void FakeWindowEventSource::Restore(WindowId id) {
+    Emit({ WindowEventType::Restored, id, {} });
+}
+
+void FakeWindowEventSource::Emit(WindowEvent ev) {
+    if (m_sink) m_sink->OnWindowEvent(ev);
+}
+
+WindowRegistry& GetWindowRegistry() {
+    static WindowRegistry g_registry;
+    return g_registry;
+}
@@ -0,0 +1,237 @@
+﻿// === src/window_rules.cpp ===
+#include "window_rules.h"
+#include "utf8.h"
+
+#include <deque>
+#include <map>
+#include <utility>
+
+const char* WindowRuleActionName(WindowRuleAction action) {
+    switch (action) {
+    case WindowRuleAction::Include: return "include";
+    case WindowRuleAction::Exclude: return "exclude";
+    case WindowRuleAction::Pin:     return "pin";
+    }
+    return "?";
+}
+
+bool operator==(const WindowRule& a, const WindowRule& b) {
+    return a.action == b.action && a.title == b.title && a.windowClass == b.windowClass &&
+           a.exe == b.exe && a.styleMask == b.styleMask && a.style == b.style &&
+           a.exStyleMask == b.exStyleMask && a.exStyle == b.exStyle;
+}
+
+static wchar_t FoldAscii(wchar_t c) {
+    return (c >= L'A' && c <= L'Z') ? (wchar_t)(c - L'A' + L'a') : c;
+}
+
+WindowRuleSet::WindowRuleSet(std::vector<WindowRule> rules) {
+    for (WindowRule& r : rules) {
+        if (r.title.empty() && r.windowClass.empty() && r.exe.empty() && !r.styleMask && !r.exStyleMask)
+            continue;
+        m_rules.push_back(std::move(r));
+    }
+    const size_t n = m_rules.size();
+    m_words = (n + 63) / 64;
+    auto newSet = [this] {
+        const size_t at = m_bits.size();
+        m_bits.resize(at + m_words);
+        return at;
+    };
+    auto add = [this](size_t set, size_t rule) { m_bits[set + rule / 64] |= 1ull << (rule % 64); };
+
+    m_untested = newSet();
+    for (size_t& set : m_needs)
+        set = newSet();
+    m_changesKept = newSet();
+    m_changesRejected = newSet();
+
+    // --- style tests, one per distinct (mask, value) pair ---
+    for (size_t i = 0; i < n; ++i) {
+        const WindowRule& r = m_rules[i];
+        if (r.action != WindowRuleAction::Include) add(m_changesKept, i);
+        if (r.action != WindowRuleAction::Exclude) add(m_changesRejected, i);
+        if (!r.styleMask && !r.exStyleMask) {
+            add(m_untested, i);
+            continue;
+        }
+        const uint32_t style = r.style & r.styleMask, exStyle = r.exStyle & r.exStyleMask;
+        StyleTest* test = nullptr;
+        for (StyleTest& t : m_styleTests)
+            if (t.styleMask == r.styleMask && t.style == style && t.exStyleMask == r.exStyleMask && t.exStyle == exStyle)
+                test = &t;
+        if (!test) {
+            m_styleTests.push_back({ r.styleMask, style, r.exStyleMask, exStyle, newSet() });
+            test = &m_styleTests.back();
+        }
+        add(test->rules, i);
+    }
+
+    // --- patterns: every (field, folded text) once, with the rules that need it ---
+    std::map<std::pair<uint8_t, std::wstring>, uint32_t> ids;
+    std::vector<std::wstring> texts;
+    std::vector<std::vector<uint32_t>> rulesOf;
+    for (size_t i = 0; i < n; ++i) {
+        const std::string* fields[kFieldCount] = { &m_rules[i].title, &m_rules[i].windowClass, &m_rules[i].exe };
+        for (uint8_t f = 0; f < kFieldCount; ++f) {
+            if (fields[f]->empty())
+                continue;
+            std::wstring text = WideFromUtf8(fields[f]->data(), fields[f]->size());
+            for (wchar_t& c : text)
+                c = FoldAscii(c);
+            auto it = ids.emplace(std::make_pair(f, text), (uint32_t)texts.size()).first;
+            if (it->second == texts.size()) {
+                texts.push_back(std::move(text));
+                m_patternField.push_back(f);
+                rulesOf.emplace_back();
+            }
+            rulesOf[it->second].push_back((uint32_t)i);
+            add(m_needs[f], i);
+        }
+    }
+    for (const std::vector<uint32_t>& r : rulesOf) {
+        m_patternRuleStart.push_back((uint32_t)m_patternRules.size());
+        m_patternRules.insert(m_patternRules.end(), r.begin(), r.end());
+    }
+    m_patternRuleStart.push_back((uint32_t)m_patternRules.size());
+
+    // --- character classes: one per character the patterns use, 0 for the rest ---
+    std::map<wchar_t, uint32_t> wide;
+    for (const std::wstring& text : texts) {
+        for (wchar_t c : text) {
+            if ((uint32_t)c < 128) {
+                if (!m_ascii[c]) {
+                    m_ascii[c] = (uint16_t)m_classes;
+                    if (c >= L'a' && c <= L'z')
+                        m_ascii[c - L'a' + L'A'] = (uint16_t)m_classes;
+                    ++m_classes;
+                }
+            }
+            else if (wide.emplace(c, (uint32_t)m_classes).second) {
+                ++m_classes;
+            }
+        }
+    }
+    m_wide.assign(wide.begin(), wide.end());
+
+    // --- the trie, then failure links folded into a full transition table ---
+    const size_t C = m_classes;
+    m_next.assign(C, 0);
+    std::vector<std::vector<uint32_t>> out(1);
+    for (uint32_t p = 0; p < texts.size(); ++p) {
+        uint32_t s = 0;
+        for (wchar_t c : texts[p]) {
+            const uint32_t cls = ClassOf(c);
+            if (!m_next[s * C + cls]) {
+                m_next[s * C + cls] = (uint32_t)m_states++;
+                m_next.resize(m_states * C, 0);
+                out.emplace_back();
+            }
+            s = m_next[s * C + cls];
+        }
+        out[s].push_back(p);
+    }
+    std::vector<uint32_t> fail(m_states, 0);
+    std::deque<uint32_t> queue;
+    for (size_t c = 0; c < C; ++c)
+        if (m_next[c])
+            queue.push_back(m_next[c]);
+    while (!queue.empty()) {
+        const uint32_t u = queue.front();
+        queue.pop_front();
+        for (size_t c = 0; c < C; ++c) {
+            const uint32_t v = m_next[u * C + c];
+            if (!v) {
+                m_next[u * C + c] = m_next[fail[u] * C + c];
+                continue;
+            }
+            fail[v] = m_next[fail[u] * C + c];
+            out[v].insert(out[v].end(), out[fail[v]].begin(), out[fail[v]].end());
+            queue.push_back(v);
+        }
+    }
+    for (const std::vector<uint32_t>& o : out) {
+        m_outStart.push_back((uint32_t)m_out.size());
+        m_out.insert(m_out.end(), o.begin(), o.end());
+    }
+    m_outStart.push_back((uint32_t)m_out.size());
+}
+
+uint32_t WindowRuleSet::ClassOf(wchar_t c) const {
+    if ((uint32_t)c < 128)
+        return m_ascii[c];
+    size_t lo = 0, hi = m_wide.size();
+    while (lo < hi) {
+        const size_t mid = (lo + hi) / 2;
+        if (m_wide[mid].first < c) lo = mid + 1;
+        else                       hi = mid;
+    }
+    return (lo < m_wide.size() && m_wide[lo].first == c) ? m_wide[lo].second : 0;
+}
+
+bool WindowRuleSet::Begin(uint32_t style, uint32_t exStyle, bool builtIn, Scratch& s) const {
+    s.alive.assign(m_bits.begin() + m_untested, m_bits.begin() + m_untested + m_words);
+    s.hit.resize(m_words);
+    for (const StyleTest& t : m_styleTests) {
+        if ((style & t.styleMask) != t.style || (exStyle & t.exStyleMask) != t.exStyle)
+            continue;
+        for (size_t w = 0; w < m_words; ++w)
+            s.alive[w] |= m_bits[t.rules + w];
+    }
+    return Open(builtIn, s);
+}
+
+bool WindowRuleSet::Open(bool builtIn, const Scratch& s) const {
+    // rules that would only repeat the built-in verdict can't change anything
+    const uint64_t* changes = &m_bits[builtIn ? m_changesKept : m_changesRejected];
+    for (size_t w = 0; w < m_words; ++w)
+        if (s.alive[w] & changes[w])
+            return true;
+    return false;
+}
+
+bool WindowRuleSet::Needs(Field f, const Scratch& s) const {
+    const uint64_t* needs = &m_bits[m_needs[f]];
+    for (size_t w = 0; w < m_words; ++w)
+        if (s.alive[w] & needs[w])
+            return true;
+    return false;
+}
+
+bool WindowRuleSet::Match(Field f, const std::wstring& text, bool builtIn, Scratch& s) const {
+    std::fill(s.hit.begin(), s.hit.end(), 0);
+    const uint32_t* next = m_next.data();
+    const size_t C = m_classes;
+    uint32_t state = 0;
+    for (wchar_t c : text) {
+        state = next[state * C + ClassOf(c)];
+        for (uint32_t k = m_outStart[state]; k < m_outStart[state + 1]; ++k) {
+            const uint32_t p = m_out[k];
+            if (m_patternField[p] != f)
+                continue;
+            for (uint32_t r = m_patternRuleStart[p]; r < m_patternRuleStart[p + 1]; ++r)
+                s.hit[m_patternRules[r] / 64] |= 1ull << (m_patternRules[r] % 64);
+        }
+    }
+    // rules with a pattern here live on only if it was found
+    const uint64_t* needs = &m_bits[m_needs[f]];
+    for (size_t w = 0; w < m_words; ++w)
+        s.alive[w] &= s.hit[w] | ~needs[w];
+    return Open(builtIn, s);
+}
+
+WindowVerdict WindowRuleSet::Decide(bool builtIn, const Scratch& s) const {
+    for (size_t w = 0; w < m_words; ++w) {
+        if (!s.alive[w])
+            continue;
+        size_t bit = 0;
+        while (!((s.alive[w] >> bit) & 1))
+            ++bit;
+        switch (m_rules[w * 64 + bit].action) {
+        case WindowRuleAction::Include: return WindowVerdict::Keep;
+        case WindowRuleAction::Exclude: return WindowVerdict::Reject;
+        case WindowRuleAction::Pin:     return WindowVerdict::Pin;
+        }
+    }
+    return builtIn ? WindowVerdict::Keep : WindowVerdict::Reject;
+}
@@ -0,0 +1,81 @@
+﻿// === src/window_snapshot.cpp ===
+#include "window_snapshot.h"
+#include "process_cache.h"
+#include "utf8.h"
+
+#include <atomic>
+
+uint64_t WindowSnapshot::NextGeneration() {
+    static std::atomic<uint64_t> generations{ 0 };
+    return ++generations;
+}
+
+void WindowSnapshot::Clear() {
+    m_generation = NextGeneration();
+    m_arena.clear();
+    m_rows.clear();
+    m_process.clear();
+}
+
+void WindowSnapshot::Add(WindowId id, const std::wstring& title, uint32_t pid) {
+    Row r;
+    r.id = id;
+    r.pid = pid;
+    r.title.offset = (uint32_t)m_arena.size();
+    AppendUtf8(m_arena, title);
+    r.title.len = (uint32_t)m_arena.size() - r.title.offset;
+    r.display = r.title;
+
+    // "page - app" reads better as "app - page"
+    const char* t = m_arena.data() + r.title.offset;
+    const char* dash = nullptr;
+    for (uint32_t i = 0; i + 3 <= r.title.len; ++i) {
+        if (t[i] == ' ' && t[i + 1] == '-' && t[i + 2] == ' ') {
+            dash = t + i;
+            break;
+        }
+    }
+    if (dash) {
+        const uint32_t page = (uint32_t)(dash - t);
+        const uint32_t app = r.title.len - page - 3;
+        // make room first: the copies below read from the arena itself
+        m_arena.reserve(m_arena.size() + r.title.len);
+        r.display.offset = (uint32_t)m_arena.size();
+        r.display.len = r.title.len;
+        m_arena.append(m_arena.data() + r.title.offset + page + 3, app);
+        m_arena.append(" - ", 3);
+        m_arena.append(m_arena.data() + r.title.offset, page);
+    }
+
+    m_rows.push_back(r);
+    m_process.emplace_back();
+}
+
+void WindowSnapshot::SetProcess(size_t i, std::shared_ptr<const ProcessInfo> info) {
+    Row& r = m_rows[i];
+    r.exe.offset = (uint32_t)m_arena.size();
+    if (info)
+        AppendUtf8(m_arena, info->exeName);
+    r.exe.len = (uint32_t)m_arena.size() - r.exe.offset;
+    m_process[i] = std::move(info);
+}
+
+bool WindowSnapshot::Resolve(ProcessCache& cache) {
+    bool changed = false;
+    for (size_t i = 0; i < m_rows.size(); ++i) {
+        if (!m_rows[i].pid || m_process[i])
+            continue;
+        if (auto info = cache.Lookup(m_rows[i].pid)) {
+            SetProcess(i, std::move(info));
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+size_t WindowSnapshot::Find(WindowId id) const {
+    for (size_t i = 0; i < m_rows.size(); ++i)
+        if (m_rows[i].id == id)
+            return i;
+    return m_rows.size();
+}
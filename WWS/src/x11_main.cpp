@@ -0,0 +1,218 @@
+﻿// === src/x11_main.cpp ===
+// The overlay on X11 desktops (GLFW + OpenGL 3). There is no global
+// keyboard hook here: bind wws_x11_overlay to a key in the window
+// manager. It lists the windows with the previous one selected; type to
+// filter, Tab/arrows move, Enter switches, Escape (or clicking away) cancels.
+#include "x11_window_system.h"
+#include "window_registry.h"
+#include "frame_scheduler.h"
+#include "process_cache.h"
+#include "settings.h"
+#include "overlay_model.h"
+#include "glyph_cache.h"
+#include "trace.h"
+#include "imgui.h"
+#include "imgui_impl_glfw.h"
+#include "imgui_impl_opengl3.h"
+#include <GLFW/glfw3.h>
+#include <cstdio>
+#include <cstdlib>
+
+static OverlayModel  g_model;
+static GlyphCache    g_glyphs;
+static TitleFitCache g_titleFits;
+static bool          g_done = false;
+static WindowId      g_commit = 0;
+
+static void FilterInput(wchar_t ch) {
+    if (g_model.Input(ch))
+        GetFrameScheduler().MarkDirty(FrameReason_Selection);
+}
+
+static void MoveSelection(int delta) {
+    g_model.Advance(delta);
+    GetFrameScheduler().MarkDirty(FrameReason_Selection);
+}
+
+// --- GLFW callbacks (ImGui's backend chains to these) ---
+
+static void OnKey(GLFWwindow*, int key, int, int action, int mods) {
+    if (action == GLFW_RELEASE)
+        return;
+    switch (key) {
+    case GLFW_KEY_ESCAPE:    g_done = true; break;
+    case GLFW_KEY_BACKSPACE: FilterInput(L'\b'); break;
+    case GLFW_KEY_DOWN:      MoveSelection(1); break;
+    case GLFW_KEY_UP:        MoveSelection(-1); break;
+    case GLFW_KEY_TAB:       MoveSelection((mods & GLFW_MOD_SHIFT) ? -1 : 1); break;
+    case GLFW_KEY_ENTER:
+    case GLFW_KEY_KP_ENTER:
+        g_commit = g_model.Selected();
+        g_done = true;
+        break;
+    }
+    GetFrameScheduler().MarkDirty(FrameReason_Input);
+}
+
+static void OnChar(GLFWwindow*, unsigned int codepoint) {
+    if (codepoint >= 0x20)
+        FilterInput((wchar_t)codepoint);
+}
+
+static void OnFocus(GLFWwindow*, int focused) {
+    if (!focused)
+        g_done = true;
+}
+
+static void OnRefresh(GLFWwindow*) {
+    GetFrameScheduler().MarkDirty(FrameReason_Resize);
+}
+
+// present false draws without showing anything (the warm-up frame)
+static void RenderFrame(GLFWwindow* window, int width, int height, bool present = true) {
+    WWS_TRACE_SCOPE("frame");
+    ImGui_ImplOpenGL3_NewFrame();
+    ImGui_ImplGlfw_NewFrame();
+    ImGui::NewFrame();
+
+    const float pad = 10.0f;
+    ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f));
+    ImGui::SetNextWindowSize(ImVec2((float)width, (float)height));
+    ImGui::Begin("Overlay", nullptr,
+        ImGuiWindowFlags_NoTitleBar |
+        ImGuiWindowFlags_NoResize |
+        ImGuiWindowFlags_NoMove |
+        ImGuiWindowFlags_NoScrollbar);
+
+    if (g_model.ResolveProcesses(GetProcessCache()))
+        g_glyphs.Prepare(g_model.Windows());
+
+    const auto& rows = g_model.Rows();
+    ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.6f, 1.0f), "Filter: %s  (%d/%d)",
+        g_model.QueryUtf8().c_str(), (int)rows.size(), (int)g_model.Windows().Size());
+
+    OverlayListLayout layout;
+    layout.width = (float)width - pad * 2;
+    layout.exeWidth = 120.0f;
+    layout.maxTitle = kMaxTitle;   // the width cuts them
+    layout.fits = &g_titleFits;
+    DrawWindowList("##List", g_model.Windows(), rows, g_model.List(), layout, ImGui::GetContentRegionAvail().y);
+
+    ImGui::End();
+    ImGui::Render();
+
+    int fbW, fbH;
+    glfwGetFramebufferSize(window, &fbW, &fbH);
+    glViewport(0, 0, fbW, fbH);
+    glClearColor(30 / 255.0f, 30 / 255.0f, 30 / 255.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    if (!present)
+        return;
+    WWS_TRACE_SCOPE("present");
+    glfwSwapBuffers(window);
+}
+
+int main() {
+    WWS_TRACE_THREAD("ui");
+    WindowSystem& ws = GetWindowSystem();
+    ws.SetRules(LoadSettings().windowRules);
+    std::vector<WindowRecord> windows;
+    if (!ws.Snapshot(windows)) {
+        std::fprintf(stderr, "wws_x11_overlay: cannot reach the X server (is DISPLAY set?)\n");
+        return 1;
+    }
+    // topmost first is the closest thing to MRU order X11 has; drop
+    // minimized windows, like the registry snapshot does on Windows, and
+    // list pinned ones right after the active one
+    WindowSnapshot& snapshot = g_model.Back();
+    for (int pass = 0; pass < 3; ++pass) {
+        for (size_t i = 0; i < windows.size(); ++i) {
+            const WindowRecord& w = windows[i];
+            const int want = (i == 0) ? 0 : (w.pinned ? 1 : 2);
+            if (!w.minimized && want == pass)
+                snapshot.Add(w.id, w.title, w.pid);
+        }
+    }
+
+    ProcfsProcessInfoProvider processInfo;
+    GetProcessCache().SetUpdateCallback([] {
+        GetFrameScheduler().MarkDirty(FrameReason_Snapshot);
+        glfwPostEmptyEvent();
+    });
+    GetProcessCache().Start(processInfo);
+
+    if (!glfwInit())
+        return 1;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    glfwWindowHint(GLFW_DECORATED, GLFW_FALSE);
+    glfwWindowHint(GLFW_FLOATING, GLFW_TRUE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    const int width = 640, height = 480;
+    GLFWwindow* window = glfwCreateWindow(width, height, "WWS", nullptr, nullptr);
+    if (!window) {
+        glfwTerminate();
+        return 1;
+    }
+    if (const GLFWvidmode* mode = glfwGetVideoMode(glfwGetPrimaryMonitor()))
+        glfwSetWindowPos(window, (mode->width - width) / 2, (mode->height - height) / 2);
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(1);
+    glfwSetKeyCallback(window, OnKey);
+    glfwSetCharCallback(window, OnChar);
+    glfwSetWindowFocusCallback(window, OnFocus);
+    glfwSetWindowRefreshCallback(window, OnRefresh);
+
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGui::GetIO().IniFilename = nullptr;
+    ImGui::StyleColorsDark();
+    ImGui_ImplGlfw_InitForOpenGL(window, true);
+    ImGui_ImplOpenGL3_Init("#version 130");
+    g_glyphs.Attach();
+
+    // the glyphs, font texture and GL objects are all made by one frame
+    // nobody sees, so the first visible one only draws
+    g_model.Show(GetProcessCache());
+    g_glyphs.Prepare(g_model.Windows());
+    RenderFrame(window, width, height, false);
+    glfwShowWindow(window);
+    glfwFocusWindow(window);
+
+    // render on demand, as on Windows
+    FrameScheduler& frames = GetFrameScheduler();
+    frames.MarkDirty(FrameReason_Snapshot);
+    while (!g_done && !glfwWindowShouldClose(window)) {
+        uint64_t waitNs = frames.TimeUntilFrameNs();
+        if (waitNs == FrameScheduler::kNever)
+            glfwWaitEvents();
+        else if (waitNs)
+            glfwWaitEventsTimeout((double)waitNs / 1e9);
+        else
+            glfwPollEvents();
+        frames.NoteWakeup();
+        if (!g_done && frames.BeginFrame()) {
+            RenderFrame(window, width, height);
+            frames.EndFrame(true);
+        }
+    }
+
+    GetProcessCache().Stop();
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui_ImplGlfw_Shutdown();
+    g_glyphs.Detach();
+    ImGui::DestroyContext();
+    glfwDestroyWindow(window);
+    glfwTerminate();
+
+    // our own window is gone by now, so the WM hands focus straight over
+    if (g_commit)
+        ws.Activate(g_commit);
+#ifdef WWS_ENABLE_TRACING
+    const char* tracePath = std::getenv("WWS_TRACE");
+    GetTracer().WriteChromeJson(tracePath ? tracePath : "wws_trace.json");
+#endif
+    return 0;
+}
@@ -0,0 +1,420 @@
+﻿// === src/x11_window_system.cpp ===
+#include "x11_window_system.h"
+#include "window_rules.h"
+#include "utf8.h"
+
+#include <limits.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+static constexpr uint32_t kMaxClients = 4096;    // longs of _NET_CLIENT_LIST_STACKING
+static constexpr uint32_t kMaxTitle = 1024;      // longs (4 KiB) of a title
+static constexpr uint32_t kMaxStates = 32;
+
+static const char* const kAtomNames[X11WindowSystem::kAtomCount] = {
+    "_NET_CLIENT_LIST_STACKING", "_NET_ACTIVE_WINDOW", "_NET_WM_NAME", "_NET_WM_PID",
+    "_NET_WM_STATE", "_NET_WM_STATE_HIDDEN", "_NET_WM_STATE_SKIP_TASKBAR",
+    "_NET_WM_WINDOW_TYPE", "_NET_WM_WINDOW_TYPE_NORMAL", "_NET_WM_WINDOW_TYPE_DIALOG",
+    "UTF8_STRING",
+};
+
+// Properties fetched for every client, in request order
+enum ClientProp { PropNetName, PropName, PropPid, PropState, PropType, PropTransient, PropClass, kPropCount };
+
+// --- connection ---
+
+bool X11WindowSystem::Connect(const char* display) {
+    Disconnect();
+    int screen = 0;
+    m_conn = xcb_connect(display, &screen);
+    if (xcb_connection_has_error(m_conn)) {
+        xcb_disconnect(m_conn);
+        m_conn = nullptr;
+        return false;
+    }
+    xcb_screen_iterator_t it = xcb_setup_roots_iterator(xcb_get_setup(m_conn));
+    for (int i = 0; i < screen; ++i)
+        xcb_screen_next(&it);
+    m_root = it.data->root;
+
+    // all the atoms in one round-trip
+    xcb_intern_atom_cookie_t cookies[kAtomCount];
+    for (int i = 0; i < kAtomCount; ++i)
+        cookies[i] = xcb_intern_atom(m_conn, 0, (uint16_t)std::strlen(kAtomNames[i]), kAtomNames[i]);
+    for (int i = 0; i < kAtomCount; ++i) {
+        xcb_generic_error_t* err = nullptr;
+        xcb_intern_atom_reply_t* r = xcb_intern_atom_reply(m_conn, cookies[i], &err);
+        m_atoms[i] = r ? r->atom : (xcb_atom_t)XCB_ATOM_NONE;
+        std::free(r);
+        std::free(err);
+    }
+    CountRoundTrip();
+    return true;
+}
+
+void X11WindowSystem::Disconnect() {
+    m_events.Stop();
+    if (m_conn)
+        xcb_disconnect(m_conn);
+    m_conn = nullptr;
+    m_root = 0;
+}
+
+// --- snapshot ---
+
+namespace {
+// One client's fetched properties, answering ClassifyWindow()
+struct X11Window {
+    xcb_get_property_reply_t* props[kPropCount];
+    const X11WindowSystem*    ws;
+
+    template <class T>
+    const T* Values(ClientProp p, int& count) const {
+        const xcb_get_property_reply_t* r = props[p];
+        count = (r && r->format == sizeof(T) * 8) ? xcb_get_property_value_length(r) / (int)sizeof(T) : 0;
+        return count ? (const T*)xcb_get_property_value(r) : nullptr;
+    }
+    bool HasState(xcb_atom_t atom) const {
+        int n;
+        const xcb_atom_t* states = Values<xcb_atom_t>(PropState, n);
+        return std::find(states, states + n, atom) != states + n;
+    }
+
+    // everything the window manager lists is mapped; minimized windows
+    // are tracked too (see Minimized())
+    bool Visible() const { return true; }
+    // docks, menus, splash screens etc. and skip-taskbar windows count as tool windows
+    uint32_t ExStyle() const {
+        if (HasState(ws->AtomOf(X11WindowSystem::NetWmStateSkipTaskbar)))
+            return ws::ExToolWindow;
+        int n;
+        const xcb_atom_t* types = Values<xcb_atom_t>(PropType, n);
+        if (n == 0 || types[0] == ws->AtomOf(X11WindowSystem::NetWmWindowTypeNormal) ||
+            types[0] == ws->AtomOf(X11WindowSystem::NetWmWindowTypeDialog))
+            return 0;
+        return ws::ExToolWindow;
+    }
+    // decorations are the window manager's call, not the client's
+    uint32_t Style() const { return ws::Caption; }
+    bool IsRootOwner() const {
+        int n;
+        const xcb_window_t* owner = Values<xcb_window_t>(PropTransient, n);
+        return n == 0 || owner[0] == XCB_WINDOW_NONE || owner[0] == ws->Root();
+    }
+    void Title(std::wstring& title) const {
+        // _NET_WM_NAME is UTF-8; plain WM_NAME is Latin-1
+        const xcb_get_property_reply_t* r = props[PropNetName];
+        if (r && r->format == 8 && xcb_get_property_value_length(r) > 0) {
+            title = WideFromUtf8((const char*)xcb_get_property_value(r), (size_t)xcb_get_property_value_length(r));
+            return;
+        }
+        int n;
+        const uint8_t* name = Values<uint8_t>(PropName, n);
+        title.assign(name, name + n);
+    }
+
+    // WM_CLASS is "instance\0class\0"; rules match the class
+    void ClassName(std::wstring& out) const {
+        int n;
+        const char* v = Values<char>(PropClass, n);
+        const char* end = v + n;
+        const char* cls = v ? std::find(v, end, '\0') : end;
+        cls = (cls == end) ? v : cls + 1;
+        out.assign(cls, std::find(cls, end, '\0'));
+    }
+    // The executable's file name, from /proc (empty for remote clients)
+    void Exe(std::wstring& out) const {
+        out.clear();
+        const uint32_t pid = Pid();
+        if (!pid)
+            return;
+        char link[64], path[PATH_MAX];
+        std::snprintf(link, sizeof(link), "/proc/%u/exe", pid);
+        const ssize_t len = readlink(link, path, sizeof(path));
+        if (len <= 0)
+            return;
+        const char* name = path + len;
+        while (name > path && name[-1] != '/')
+            --name;
+        out = WideFromUtf8(name, (size_t)(path + len - name));
+    }
+
+    bool Minimized() const { return HasState(ws->AtomOf(X11WindowSystem::NetWmStateHidden)); }
+    uint32_t Pid() const {
+        int n;
+        const uint32_t* pid = Values<uint32_t>(PropPid, n);
+        return n ? pid[0] : 0;
+    }
+};
+}
+
+bool X11WindowSystem::Snapshot(std::vector<WindowRecord>& out) {
+    out.clear();
+    if (!m_conn || xcb_connection_has_error(m_conn))
+        return false;
+
+    // round-trip 1: who is there, and who is active
+    xcb_get_property_cookie_t listCookie = xcb_get_property(m_conn, 0, m_root,
+        m_atoms[NetClientListStacking], XCB_ATOM_WINDOW, 0, kMaxClients);
+    xcb_get_property_cookie_t activeCookie = xcb_get_property(m_conn, 0, m_root,
+        m_atoms[NetActiveWindow], XCB_ATOM_WINDOW, 0, 1);
+    xcb_generic_error_t* err = nullptr;
+    xcb_get_property_reply_t* list = xcb_get_property_reply(m_conn, listCookie, &err);
+    std::free(err);
+    err = nullptr;
+    xcb_get_property_reply_t* active = xcb_get_property_reply(m_conn, activeCookie, &err);
+    std::free(err);
+    CountRoundTrip();
+
+    WindowId activeId = 0;
+    if (active && active->format == 32 && xcb_get_property_value_length(active) >= 4)
+        activeId = *(const xcb_window_t*)xcb_get_property_value(active);
+    m_active.store(activeId, std::memory_order_relaxed);
+    std::free(active);
+
+    std::vector<xcb_window_t> clients;
+    if (list && list->format == 32) {
+        const xcb_window_t* w = (const xcb_window_t*)xcb_get_property_value(list);
+        clients.assign(w, w + xcb_get_property_value_length(list) / 4);
+    }
+    std::free(list);
+    if (clients.empty())
+        return true;
+
+    // round-trip 2: every property of every client requested before any
+    // reply is waited for
+    std::vector<xcb_get_property_cookie_t> cookies(clients.size() * kPropCount);
+    for (size_t i = 0; i < clients.size(); ++i) {
+        xcb_get_property_cookie_t* c = &cookies[i * kPropCount];
+        const xcb_window_t w = clients[i];
+        c[PropNetName]   = xcb_get_property(m_conn, 0, w, m_atoms[NetWmName], m_atoms[Utf8String], 0, kMaxTitle);
+        c[PropName]      = xcb_get_property(m_conn, 0, w, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 0, kMaxTitle);
+        c[PropPid]       = xcb_get_property(m_conn, 0, w, m_atoms[NetWmPid], XCB_ATOM_CARDINAL, 0, 1);
+        c[PropState]     = xcb_get_property(m_conn, 0, w, m_atoms[NetWmState], XCB_ATOM_ATOM, 0, kMaxStates);
+        c[PropType]      = xcb_get_property(m_conn, 0, w, m_atoms[NetWmWindowType], XCB_ATOM_ATOM, 0, 8);
+        c[PropTransient] = xcb_get_property(m_conn, 0, w, XCB_ATOM_WM_TRANSIENT_FOR, XCB_ATOM_WINDOW, 0, 1);
+        c[PropClass]     = xcb_get_property(m_conn, 0, w, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 0, 64);
+    }
+    xcb_flush(m_conn);
+
+    // the list is bottom-to-top; collect in order (replies come in order),
+    // then flip so the topmost is first
+    std::wstring title;
+    X11Window win;
+    const std::shared_ptr<const WindowRuleSet> rules = Rules();
+    WindowRuleSet::Scratch scratch;
+    win.ws = this;
+    for (size_t i = 0; i < clients.size(); ++i) {
+        for (int p = 0; p < kPropCount; ++p) {
+            err = nullptr;
+            win.props[p] = xcb_get_property_reply(m_conn, cookies[i * kPropCount + p], &err);
+            std::free(err);
+        }
+        // no reply at all means BadWindow: it closed in the meantime
+        const bool exists = win.props[PropType] != nullptr;
+        const WindowVerdict verdict = exists ? ClassifyWindow(win, rules.get(), title, scratch)
+                                             : WindowVerdict::Reject;
+        if (verdict != WindowVerdict::Reject) {
+            WindowRecord rec;
+            rec.id = clients[i];
+            rec.title = std::move(title);
+            rec.pinned = verdict == WindowVerdict::Pin;
+            rec.minimized = win.Minimized();
+            rec.pid = win.Pid();
+            out.push_back(std::move(rec));
+        }
+        for (int p = 0; p < kPropCount; ++p)
+            std::free(win.props[p]);
+    }
+    CountRoundTrip();
+    std::reverse(out.begin(), out.end());
+    return true;
+}
+
+bool X11WindowSystem::Activate(WindowId id) {
+    if (!m_conn)
+        return false;
+    xcb_client_message_event_t ev{};
+    ev.response_type = XCB_CLIENT_MESSAGE;
+    ev.format = 32;
+    ev.window = (xcb_window_t)id;
+    ev.type = m_atoms[NetActiveWindow];
+    ev.data.data32[0] = 2;                  // source: a pager, i.e. the user asked
+    ev.data.data32[1] = XCB_CURRENT_TIME;
+    ev.data.data32[2] = 0;
+    xcb_send_event(m_conn, 0, m_root,
+        XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY, (const char*)&ev);
+    return xcb_flush(m_conn) > 0;
+}
+
+// --- event source ---
+
+static void WatchProperties(xcb_connection_t* conn, xcb_window_t w) {
+    const uint32_t mask = XCB_EVENT_MASK_PROPERTY_CHANGE;
+    xcb_change_window_attributes(conn, w, XCB_CW_EVENT_MASK, &mask);
+}
+
+// An event that carries no title
+static WindowEvent Event(WindowEventType type, WindowId id) {
+    WindowEvent ev;
+    ev.type = type;
+    ev.id = id;
+    return ev;
+}
+
+bool X11WindowEventSource::Start(WindowEventSink& sink) {
+    Stop();
+    xcb_connection_t* conn = m_ws.Connection();
+    if (!conn || pipe(m_wake) != 0)
+        return false;
+    m_sink = &sink;
+    WatchProperties(conn, m_ws.Root());
+    // seed: Created in stacking order (topmost is the best MRU guess), then
+    // Foreground for the active one
+    Refresh();
+    m_thread = std::thread(&X11WindowEventSource::ThreadMain, this);
+    return true;
+}
+
+void X11WindowEventSource::Stop() {
+    if (m_thread.joinable()) {
+        char c = 0;
+        (void)!write(m_wake[1], &c, 1);
+        m_thread.join();
+    }
+    for (int& fd : m_wake) {
+        if (fd >= 0)
+            close(fd);
+        fd = -1;
+    }
+    m_sink = nullptr;
+    m_known.clear();
+    m_active = 0;
+}
+
+void X11WindowEventSource::ThreadMain() {
+    xcb_connection_t* conn = m_ws.Connection();
+    const xcb_atom_t watched[] = {
+        m_ws.AtomOf(X11WindowSystem::NetClientListStacking), m_ws.AtomOf(X11WindowSystem::NetActiveWindow),
+        m_ws.AtomOf(X11WindowSystem::NetWmName), m_ws.AtomOf(X11WindowSystem::NetWmState), XCB_ATOM_WM_NAME,
+    };
+    pollfd fds[2] = { { xcb_get_file_descriptor(conn), POLLIN, 0 }, { m_wake[0], POLLIN, 0 } };
+    for (;;) {
+        // a burst of changes (a window opening sets half a dozen properties)
+        // is one refresh
+        bool dirty = false;
+        while (xcb_generic_event_t* ev = xcb_poll_for_event(conn)) {
+            if ((ev->response_type & 0x7F) == XCB_PROPERTY_NOTIFY) {
+                xcb_atom_t atom = ((xcb_property_notify_event_t*)ev)->atom;
+                dirty |= std::find(std::begin(watched), std::end(watched), atom) != std::end(watched);
+            }
+            std::free(ev);
+        }
+        if (dirty) {
+            Refresh();
+            continue;
+        }
+        if (xcb_connection_has_error(conn))
+            return;
+        if (poll(fds, 2, -1) < 0 || (fds[1].revents & POLLIN))
+            return;
+    }
+}
+
+void X11WindowEventSource::Refresh() {
+    if (!m_ws.Snapshot(m_snapshot))
+        return;
+
+    size_t seen = 0;
+    for (WindowRecord& rec : m_snapshot) {
+        auto it = m_known.find(rec.id);
+        if (it == m_known.end()) {
+            WatchProperties(m_ws.Connection(), (xcb_window_t)rec.id);
+            m_sink->OnWindowEvent({ WindowEventType::Created, rec.id, rec.title, rec.pid, rec.pinned });
+            if (rec.minimized)
+                m_sink->OnWindowEvent(Event(WindowEventType::Minimized, rec.id));
+            m_known.emplace(rec.id, Known{ std::move(rec.title), rec.minimized, rec.pinned });
+            ++seen;
+            continue;
+        }
+        Known& k = it->second;
+        if (k.title != rec.title || k.pinned != rec.pinned) {
+            m_sink->OnWindowEvent({ WindowEventType::NameChanged, rec.id, rec.title, 0, rec.pinned });
+            k.title = std::move(rec.title);
+            k.pinned = rec.pinned;
+        }
+        if (k.minimized != rec.minimized) {
+            m_sink->OnWindowEvent(Event(rec.minimized ? WindowEventType::Minimized : WindowEventType::Restored, rec.id));
+            k.minimized = rec.minimized;
+        }
+        ++seen;
+    }
+    xcb_flush(m_ws.Connection());
+
+    // anything not in this snapshot is gone
+    if (seen != m_known.size()) {
+        std::vector<WindowId> current;
+        current.reserve(m_snapshot.size());
+        for (const WindowRecord& rec : m_snapshot)
+            current.push_back(rec.id);
+        std::sort(current.begin(), current.end());
+        for (auto it = m_known.begin(); it != m_known.end(); ) {
+            if (std::binary_search(current.begin(), current.end(), it->first)) {
+                ++it;
+                continue;
+            }
+            m_sink->OnWindowEvent(Event(WindowEventType::Destroyed, it->first));
+            it = m_known.erase(it);
+        }
+    }
+
+    WindowId active = m_ws.Active();
+    if (active != m_active && m_known.count(active))
+        m_sink->OnWindowEvent(Event(WindowEventType::Foreground, active));
+    m_active = active;
+}
+
+WindowSystem& GetWindowSystem() {
+    static X11WindowSystem g_ws;
+    static bool g_connected = g_ws.Connect();   // $DISPLAY, on first use
+    (void)g_connected;
+    return g_ws;
+}
+
+// --- process metadata ---
+
+bool ProcfsProcessInfoProvider::Query(uint32_t pid, ProcessInfo& info) {
+    const std::string dir = "/proc/" + std::to_string(pid);
+    char path[4096];
+    ssize_t len = readlink((dir + "/exe").c_str(), path, sizeof(path));
+    if (len <= 0)
+        return false;
+
+    // field 22 is the start time; the name in field 2 may contain spaces
+    // and parentheses, so count from the last ')'
+    std::ifstream stat(dir + "/stat");
+    std::string line;
+    if (!std::getline(stat, line))
+        return false;
+    size_t paren = line.rfind(')');
+    if (paren == std::string::npos)
+        return false;
+    std::istringstream fields(line.substr(paren + 2));
+    std::string field;
+    for (int i = 3; i < 22 && fields >> field; ++i) {}
+    uint64_t start = 0;
+    if (!(fields >> start))
+        return false;
+
+    info.pid = pid;
+    info.startTime = start;
+    info.exePath = WideFromUtf8(path, (size_t)len);
+    info.exeName = ExeNameFromPath(info.exePath);
+    return true;
+}
@@ -0,0 +1,138 @@
+﻿// === tools/replay.cpp ===
+// Pushes a recorded key trace through SwitcherMachine at full speed and
+// reports the decisions it made plus the cost per event.
+//
+//   wws_replay <trace> [options]
+//   wws_replay --generate <trace> <events> [--seed N]
+//
+// Options:
+//   --initiator <vk>    default 0xA4 (Left Alt)
+//   --modifier <vk>     default 0xA0 (Left Shift)
+//   --tap <ms>          tapTimeoutMs, default 300
+//   --overlay <ms>      overlayTimeoutMs, default 500
+//   --repeat <n>        replay the trace n times back to back
+//   --decisions <file>  write one line per action, for diffing against a golden file
+#include "key_trace.h"
+#include "switcher.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static constexpr uint64_t kMs = 1000000;
+
+static void Usage() {
+    std::fprintf(stderr,
+        "usage: wws_replay <trace> [--initiator vk] [--modifier vk] [--tap ms]\n"
+        "                  [--overlay ms] [--repeat n] [--decisions file]\n"
+        "       wws_replay --generate <trace> <events> [--seed n]\n");
+}
+
+// --- replay ---
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        Usage();
+        return 2;
+    }
+
+    if (std::strcmp(argv[1], "--generate") == 0) {
+        if (argc < 4) {
+            Usage();
+            return 2;
+        }
+        uint32_t seed = 1;
+        for (int i = 4; i + 1 < argc; i += 2)
+            if (std::strcmp(argv[i], "--seed") == 0)
+                seed = (uint32_t)std::strtoul(argv[i + 1], nullptr, 0);
+        auto events = GenerateKeyTrace((size_t)std::strtoull(argv[3], nullptr, 0), seed);
+        if (!WriteKeyTrace(argv[2], events)) {
+            std::fprintf(stderr, "cannot write %s\n", argv[2]);
+            return 1;
+        }
+        std::printf("wrote %zu events to %s\n", events.size(), argv[2]);
+        return 0;
+    }
+
+    SwitcherConfig cfg;
+    int repeat = 1;
+    const char* decisionsPath = nullptr;
+    for (int i = 2; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            Usage();
+            return 2;
+        }
+        const char* opt = argv[i];
+        const char* val = argv[++i];
+        if      (!std::strcmp(opt, "--initiator")) cfg.initiator = (uint16_t)std::strtoul(val, nullptr, 0);
+        else if (!std::strcmp(opt, "--modifier"))  cfg.modifier = (uint16_t)std::strtoul(val, nullptr, 0);
+        else if (!std::strcmp(opt, "--tap"))       cfg.tapTimeoutMs = std::atoi(val);
+        else if (!std::strcmp(opt, "--overlay"))   cfg.overlayTimeoutMs = std::atoi(val);
+        else if (!std::strcmp(opt, "--repeat"))    repeat = std::atoi(val);
+        else if (!std::strcmp(opt, "--decisions")) decisionsPath = val;
+        else {
+            Usage();
+            return 2;
+        }
+    }
+
+    std::vector<KeyEvent> events;
+    if (!ReadKeyTrace(argv[1], events)) {
+        std::fprintf(stderr, "cannot read trace %s\n", argv[1]);
+        return 1;
+    }
+    if (events.empty()) {
+        std::fprintf(stderr, "trace is empty\n");
+        return 1;
+    }
+
+    // classification is config dependent, so it happens here and not in the file
+    for (auto& ev : events)
+        ev.cls = SwitcherMachine::Classify(ev.vk, cfg);
+
+    FILE* decisions = nullptr;
+    if (decisionsPath && !(decisions = std::fopen(decisionsPath, "w"))) {
+        std::fprintf(stderr, "cannot write %s\n", decisionsPath);
+        return 1;
+    }
+
+    // each repetition is shifted in time so the clock keeps moving forward
+    const uint64_t span = events.back().timeNs - events.front().timeNs + 1000 * kMs;
+
+    SwitcherMachine machine(cfg);
+    SwitcherAction actions[SwitcherMachine::kMaxActions];
+    uint64_t counts[6] = {};
+    uint64_t total = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; ++r) {
+        const uint64_t offset = span * (uint64_t)r;
+        for (size_t i = 0; i < events.size(); ++i) {
+            KeyEvent ev = events[i];
+            ev.timeNs += offset;
+            int n = machine.OnKey(ev, actions);
+            for (int k = 0; k < n; ++k) {
+                ++counts[(int)actions[k].type];
+                if (decisions)
+                    std::fprintf(decisions, "%llu %s %d\n",
+                        (unsigned long long)ev.timeNs, SwitcherActionName(actions[k].type), actions[k].index);
+            }
+        }
+        total += events.size();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    if (decisions)
+        std::fclose(decisions);
+
+    double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+    std::printf("events        %llu\n", (unsigned long long)total);
+    for (int t = 0; t < 6; ++t)
+        std::printf("%-14s%llu\n", SwitcherActionName((SwitcherActionType)t), (unsigned long long)counts[t]);
+    std::printf("total         %.3f ms\n", ns / 1e6);
+    std::printf("ns/event      %.2f%s\n", ns / (double)total,
+        decisions ? " (includes writing decisions)" : "");
+    return 0;
+}